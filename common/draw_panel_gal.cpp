@@ -29,6 +29,7 @@
 #include <wx/colour.h>
 #include <wx/filename.h>
 
+#include <macros.h>
 #include <class_draw_panel_gal.h>
 #include <view/view.h>
 #include <view/wx_view_controls.h>
@@ -42,10 +43,12 @@
 #include <tool/tool_manager.h>
 
 #include <boost/foreach.hpp>
+#include <cmath>
 
 #ifdef __WXDEBUG__
 #include <profile.h>
 #endif /* __WXDEBUG__ */
+#include <profile_trace.h>
 
 EDA_DRAW_PANEL_GAL::EDA_DRAW_PANEL_GAL( wxWindow* aParentWindow, wxWindowID aWindowId,
                                         const wxPoint& aPosition, const wxSize& aSize,
@@ -118,12 +121,19 @@ void EDA_DRAW_PANEL_GAL::onPaint( wxPaintEvent& WXUNUSED( aEvent ) )
 
     if( !m_drawing )
     {
+        PROF_SCOPE( "EDA_DRAW_PANEL_GAL::onPaint" );
+        bool profilingOverlay = PROF_TRACE::Instance().IsOverlayEnabled();
+
         m_drawing = true;
 
         m_view->UpdateItems();
         m_gal->BeginDrawing();
         m_gal->ClearScreen( m_painter->GetSettings()->GetBackgroundColor() );
 
+        // The overlay is refreshed with every frame to display the current statistics
+        if( profilingOverlay )
+            m_view->MarkTargetDirty( KIGFX::TARGET_OVERLAY );
+
         if( m_view->IsDirty() )
         {
             m_view->ClearTargets();
@@ -135,10 +145,64 @@ void EDA_DRAW_PANEL_GAL::onPaint( wxPaintEvent& WXUNUSED( aEvent ) )
             m_view->Redraw();
         }
 
+        if( profilingOverlay )
+            drawProfilingOverlay();
+
         m_gal->DrawCursor( m_viewControls->GetCursorPosition() );
         m_gal->EndDrawing();
 
         m_drawing = false;
+
+        // Items are recached in batches, keep on refreshing until all of them are up to date
+        if( m_view->HasPendingUpdates() )
+            Refresh();
+    }
+}
+
+
+void EDA_DRAW_PANEL_GAL::drawProfilingOverlay()
+{
+    const double FONT_SIZE = 10.0;      // in pixels
+    const double MARGIN    = 10.0;      // in pixels
+
+    std::vector<PROF_TRACE_SUMMARY> summary;
+    PROF_TRACE::Instance().GetSummary( summary );
+
+    // Text is drawn in world coordinates, so sizes are converted from pixels
+    double pixel = std::abs( m_view->ToWorld( VECTOR2D( 1.0, 1.0 ), false ).x );
+
+    m_gal->SetTarget( KIGFX::TARGET_OVERLAY );
+    m_gal->SetIsStroke( true );
+    m_gal->SetIsFill( false );
+    m_gal->SetStrokeColor( KIGFX::COLOR4D( 1.0, 1.0, 1.0, 0.8 ) );
+    m_gal->SetLineWidth( pixel );
+    m_gal->SetGlyphSize( VECTOR2D( FONT_SIZE * pixel, FONT_SIZE * pixel ) );
+    m_gal->SetBold( false );
+    m_gal->SetItalic( false );
+    m_gal->SetMirrored( false );
+    m_gal->SetHorizontalJustify( GR_TEXT_HJUSTIFY_LEFT );
+    m_gal->SetVerticalJustify( GR_TEXT_VJUSTIFY_TOP );
+
+    for( unsigned int i = 0; i < summary.size(); ++i )
+    {
+        const PROF_TRACE_SUMMARY& entry = summary[i];
+        wxString name = wxString::FromUTF8( entry.name.c_str() );
+        wxString line;
+
+        if( entry.counter )
+        {
+            line.Printf( wxT( "%s: %lld (max %lld)" ), GetChars( name ),
+                         (long long) entry.last, (long long) entry.max );
+        }
+        else
+        {
+            line.Printf( wxT( "%s: %.2f ms (avg %.2f ms, max %.2f ms, %u calls)" ),
+                         GetChars( name ), entry.last / 1000.0, entry.total / 1000.0 / entry.count,
+                         entry.max / 1000.0, entry.count );
+        }
+
+        VECTOR2D position( MARGIN, MARGIN + i * FONT_SIZE * 1.5 );
+        m_gal->StrokeText( line, m_view->ToWorld( position ), 0.0 );
     }
 }
 
@@ -30,6 +30,7 @@
 
 #include <gal/cairo/cairo_compositor.h>
 #include <wx/log.h>
+#include <algorithm>
 
 using namespace KIGFX;
 
@@ -123,6 +124,25 @@ void CAIRO_COMPOSITOR::ClearBuffer()
 }
 
 
+void CAIRO_COMPOSITOR::ClearBuffer( const BOX2I& aArea )
+{
+    int left    = std::max( aArea.GetLeft(), 0 );
+    int top     = std::max( aArea.GetTop(), 0 );
+    int right   = std::min( aArea.GetRight(), (int) m_width );
+    int bottom  = std::min( aArea.GetBottom(), (int) m_height );
+
+    if( right <= left || bottom <= top )
+        return;
+
+    // Clear the pixel storage row by row
+    unsigned char* pixels = (unsigned char*) m_buffers[m_current].bitmap.get();
+    const unsigned int rowSize = ( right - left ) * sizeof(int);
+
+    for( int y = top; y < bottom; ++y )
+        memset( pixels + y * m_stride + left * sizeof(int), 0x00, rowSize );
+}
+
+
 void CAIRO_COMPOSITOR::DrawBuffer( unsigned int aBufferHandle )
 {
     wxASSERT_MSG( aBufferHandle <= usedBuffers(), wxT( "Tried to use a not existing buffer" ) );
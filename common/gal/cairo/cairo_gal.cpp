@@ -33,52 +33,32 @@
 
 #include <limits>
 
+#ifdef USE_OPENMP
+#include <omp.h>
+#endif /* USE_OPENMP */
+
 using namespace KIGFX;
 
 
-const float CAIRO_GAL::LAYER_ALPHA = 0.8;
+const float CAIRO_GAL_BASE::LAYER_ALPHA = 0.8;
 
 
-CAIRO_GAL::CAIRO_GAL( wxWindow* aParent, wxEvtHandler* aMouseListener,
-        wxEvtHandler* aPaintListener, const wxString& aName ) :
-    wxWindow( aParent, wxID_ANY, wxDefaultPosition, wxDefaultSize, wxEXPAND, aName )
+CAIRO_GAL_BASE::CAIRO_GAL_BASE( const VECTOR2I& aScreenSize )
 {
-    parentWindow  = aParent;
-    mouseListener = aMouseListener;
-    paintListener = aPaintListener;
-
     // Initialize the flags
     isGrouping          = false;
     isInitialized       = false;
-    isDeleteSavedPixels = false;
     validCompositor     = false;
+    isClipping          = false;
     groupCounter        = 0;
 
-    // Connecting the event handlers
-    Connect( wxEVT_PAINT,       wxPaintEventHandler( CAIRO_GAL::onPaint ) );
-
-    // Mouse events are skipped to the parent
-    Connect( wxEVT_MOTION,          wxMouseEventHandler( CAIRO_GAL::skipMouseEvent ) );
-    Connect( wxEVT_LEFT_DOWN,       wxMouseEventHandler( CAIRO_GAL::skipMouseEvent ) );
-    Connect( wxEVT_LEFT_UP,         wxMouseEventHandler( CAIRO_GAL::skipMouseEvent ) );
-    Connect( wxEVT_LEFT_DCLICK,     wxMouseEventHandler( CAIRO_GAL::skipMouseEvent ) );
-    Connect( wxEVT_MIDDLE_DOWN,     wxMouseEventHandler( CAIRO_GAL::skipMouseEvent ) );
-    Connect( wxEVT_MIDDLE_UP,       wxMouseEventHandler( CAIRO_GAL::skipMouseEvent ) );
-    Connect( wxEVT_MIDDLE_DCLICK,   wxMouseEventHandler( CAIRO_GAL::skipMouseEvent ) );
-    Connect( wxEVT_RIGHT_DOWN,      wxMouseEventHandler( CAIRO_GAL::skipMouseEvent ) );
-    Connect( wxEVT_RIGHT_UP,        wxMouseEventHandler( CAIRO_GAL::skipMouseEvent ) );
-    Connect( wxEVT_RIGHT_DCLICK,    wxMouseEventHandler( CAIRO_GAL::skipMouseEvent ) );
-    Connect( wxEVT_MOUSEWHEEL,      wxMouseEventHandler( CAIRO_GAL::skipMouseEvent ) );
-#if defined _WIN32 || defined _WIN64
-    Connect( wxEVT_ENTER_WINDOW,    wxMouseEventHandler( CAIRO_GAL::skipMouseEvent ) );
-#endif
-
-    SetSize( aParent->GetSize() );
-    screenSize = VECTOR2I( aParent->GetSize() );
+#ifdef USE_OPENMP
+    tileCount = omp_get_max_threads();
+#else
+    tileCount = 1;
+#endif /* USE_OPENMP */
 
-    cursorPixels = NULL;
-    cursorPixelsSaved = NULL;
-    initCursor();
+    screenSize = aScreenSize;
 
     // Grid color settings are different in Cairo and OpenGL
     SetGridColor( COLOR4D( 0.1, 0.1, 0.1, 0.8 ) );
@@ -90,19 +70,16 @@ CAIRO_GAL::CAIRO_GAL( wxWindow* aParent, wxEvtHandler* aMouseListener,
 }
 
 
-CAIRO_GAL::~CAIRO_GAL()
+CAIRO_GAL_BASE::~CAIRO_GAL_BASE()
 {
     deinitSurface();
     deleteBitmaps();
 
-    delete cursorPixels;
-    delete cursorPixelsSaved;
-
     ClearCache();
 }
 
 
-void CAIRO_GAL::BeginDrawing()
+void CAIRO_GAL_BASE::BeginDrawing()
 {
     initSurface();
 
@@ -117,48 +94,26 @@ void CAIRO_GAL::BeginDrawing()
 }
 
 
-void CAIRO_GAL::EndDrawing()
+void CAIRO_GAL_BASE::EndDrawing()
 {
     // Force remaining objects to be drawn
     Flush();
+    flushGroups();
 
     // Cairo grouping prevents display of overlapping items on the same layer in the lighter color
-    cairo_pop_group_to_source( currentContext );
-    cairo_paint_with_alpha( currentContext, LAYER_ALPHA );
+    paintLayer();
 
     // Merge buffers on the screen
     compositor->DrawBuffer( mainBuffer );
     compositor->DrawBuffer( overlayBuffer );
 
-    // This code was taken from the wxCairo example - it's not the most efficient one
-    // Here is a good place for optimizations
-
-    // Now translate the raw context data from the format stored
-    // by cairo into a format understood by wxImage.
-    unsigned char* wxOutputPtr = wxOutput;
-
-    for( size_t count = 0; count < bufferSize; count++ )
-    {
-        unsigned int value = bitmapBuffer[count];
-        *wxOutputPtr++ = ( value >> 16 ) & 0xff;  // Red pixel
-        *wxOutputPtr++ = ( value >> 8 ) & 0xff;   // Green pixel
-        *wxOutputPtr++ = value & 0xff;            // Blue pixel
-    }
-
-    wxImage      img( screenSize.x, screenSize.y, (unsigned char*) wxOutput, true );
-    wxBitmap     bmp( img );
-    wxClientDC   client_dc( this );
-    wxBufferedDC dc;
-    dc.Init( &client_dc, bmp );
-
-    // Now it is the time to blit the mouse cursor
-    blitCursor( dc );
+    isClipping = false;
 
     deinitSurface();
 }
 
 
-void CAIRO_GAL::DrawLine( const VECTOR2D& aStartPoint, const VECTOR2D& aEndPoint )
+void CAIRO_GAL_BASE::DrawLine( const VECTOR2D& aStartPoint, const VECTOR2D& aEndPoint )
 {
     cairo_move_to( currentContext, aStartPoint.x, aStartPoint.y );
     cairo_line_to( currentContext, aEndPoint.x, aEndPoint.y );
@@ -166,7 +121,7 @@ void CAIRO_GAL::DrawLine( const VECTOR2D& aStartPoint, const VECTOR2D& aEndPoint
 }
 
 
-void CAIRO_GAL::DrawSegment( const VECTOR2D& aStartPoint, const VECTOR2D& aEndPoint,
+void CAIRO_GAL_BASE::DrawSegment( const VECTOR2D& aStartPoint, const VECTOR2D& aEndPoint,
                              double aWidth )
 {
     if( isFillEnabled )
@@ -205,7 +160,7 @@ void CAIRO_GAL::DrawSegment( const VECTOR2D& aStartPoint, const VECTOR2D& aEndPo
 }
 
 
-void CAIRO_GAL::DrawCircle( const VECTOR2D& aCenterPoint, double aRadius )
+void CAIRO_GAL_BASE::DrawCircle( const VECTOR2D& aCenterPoint, double aRadius )
 {
     // A circle is drawn using an arc
     cairo_new_sub_path( currentContext );
@@ -215,7 +170,7 @@ void CAIRO_GAL::DrawCircle( const VECTOR2D& aCenterPoint, double aRadius )
 }
 
 
-void CAIRO_GAL::DrawArc( const VECTOR2D& aCenterPoint, double aRadius, double aStartAngle,
+void CAIRO_GAL_BASE::DrawArc( const VECTOR2D& aCenterPoint, double aRadius, double aStartAngle,
                          double aEndAngle )
 {
     SWAP( aStartAngle, >, aEndAngle );
@@ -240,7 +195,7 @@ void CAIRO_GAL::DrawArc( const VECTOR2D& aCenterPoint, double aRadius, double aS
 }
 
 
-void CAIRO_GAL::DrawRectangle( const VECTOR2D& aStartPoint, const VECTOR2D& aEndPoint )
+void CAIRO_GAL_BASE::DrawRectangle( const VECTOR2D& aStartPoint, const VECTOR2D& aEndPoint )
 {
     // Calculate the diagonal points
     VECTOR2D diagonalPointA( aEndPoint.x,  aStartPoint.y );
@@ -257,7 +212,7 @@ void CAIRO_GAL::DrawRectangle( const VECTOR2D& aStartPoint, const VECTOR2D& aEnd
 }
 
 
-void CAIRO_GAL::DrawPolyline( std::deque<VECTOR2D>& aPointList )
+void CAIRO_GAL_BASE::DrawPolyline( std::deque<VECTOR2D>& aPointList )
 {
     // Iterate over the point list and draw the segments
     std::deque<VECTOR2D>::const_iterator it = aPointList.begin();
@@ -273,7 +228,7 @@ void CAIRO_GAL::DrawPolyline( std::deque<VECTOR2D>& aPointList )
 }
 
 
-void CAIRO_GAL::DrawPolygon( const std::deque<VECTOR2D>& aPointList )
+void CAIRO_GAL_BASE::DrawPolygon( const std::deque<VECTOR2D>& aPointList )
 {
     // Iterate over the point list and draw the polygon
     std::deque<VECTOR2D>::const_iterator it = aPointList.begin();
@@ -289,7 +244,7 @@ void CAIRO_GAL::DrawPolygon( const std::deque<VECTOR2D>& aPointList )
 }
 
 
-void CAIRO_GAL::DrawCurve( const VECTOR2D& aStartPoint, const VECTOR2D& aControlPointA,
+void CAIRO_GAL_BASE::DrawCurve( const VECTOR2D& aStartPoint, const VECTOR2D& aControlPointA,
                            const VECTOR2D& aControlPointB, const VECTOR2D& aEndPoint )
 {
     cairo_move_to( currentContext, aStartPoint.x, aStartPoint.y );
@@ -301,7 +256,7 @@ void CAIRO_GAL::DrawCurve( const VECTOR2D& aStartPoint, const VECTOR2D& aControl
 }
 
 
-void CAIRO_GAL::ResizeScreen( int aWidth, int aHeight )
+void CAIRO_GAL_BASE::ResizeScreen( int aWidth, int aHeight )
 {
     screenSize = VECTOR2I( aWidth, aHeight );
 
@@ -313,30 +268,19 @@ void CAIRO_GAL::ResizeScreen( int aWidth, int aHeight )
         compositor->Resize( aWidth, aHeight );
 
     validCompositor = false;
-
-    SetSize( wxSize( aWidth, aHeight ) );
-}
-
-
-bool CAIRO_GAL::Show( bool aShow )
-{
-    bool s = wxWindow::Show( aShow );
-
-    if( aShow )
-        wxWindow::Raise();
-
-    return s;
 }
 
 
-void CAIRO_GAL::Flush()
+void CAIRO_GAL_BASE::Flush()
 {
     storePath();
 }
 
 
-void CAIRO_GAL::ClearScreen( const COLOR4D& aColor )
+void CAIRO_GAL_BASE::ClearScreen( const COLOR4D& aColor )
 {
+    flushGroups();
+
     backgroundColor = aColor;
     cairo_set_source_rgb( currentContext, aColor.r, aColor.g, aColor.b );
     cairo_rectangle( currentContext, 0.0, 0.0, screenSize.x, screenSize.y );
@@ -344,7 +288,7 @@ void CAIRO_GAL::ClearScreen( const COLOR4D& aColor )
 }
 
 
-void CAIRO_GAL::SetIsFill( bool aIsFillEnabled )
+void CAIRO_GAL_BASE::SetIsFill( bool aIsFillEnabled )
 {
     storePath();
     isFillEnabled = aIsFillEnabled;
@@ -359,7 +303,7 @@ void CAIRO_GAL::SetIsFill( bool aIsFillEnabled )
 }
 
 
-void CAIRO_GAL::SetIsStroke( bool aIsStrokeEnabled )
+void CAIRO_GAL_BASE::SetIsStroke( bool aIsStrokeEnabled )
 {
     storePath();
     isStrokeEnabled = aIsStrokeEnabled;
@@ -374,7 +318,7 @@ void CAIRO_GAL::SetIsStroke( bool aIsStrokeEnabled )
 }
 
 
-void CAIRO_GAL::SetStrokeColor( const COLOR4D& aColor )
+void CAIRO_GAL_BASE::SetStrokeColor( const COLOR4D& aColor )
 {
     storePath();
     strokeColor = aColor;
@@ -392,7 +336,7 @@ void CAIRO_GAL::SetStrokeColor( const COLOR4D& aColor )
 }
 
 
-void CAIRO_GAL::SetFillColor( const COLOR4D& aColor )
+void CAIRO_GAL_BASE::SetFillColor( const COLOR4D& aColor )
 {
     storePath();
     fillColor = aColor;
@@ -410,7 +354,7 @@ void CAIRO_GAL::SetFillColor( const COLOR4D& aColor )
 }
 
 
-void CAIRO_GAL::SetLineWidth( double aLineWidth )
+void CAIRO_GAL_BASE::SetLineWidth( double aLineWidth )
 {
     storePath();
 
@@ -434,23 +378,23 @@ void CAIRO_GAL::SetLineWidth( double aLineWidth )
 }
 
 
-void CAIRO_GAL::SetLayerDepth( double aLayerDepth )
+void CAIRO_GAL_BASE::SetLayerDepth( double aLayerDepth )
 {
     super::SetLayerDepth( aLayerDepth );
 
     if( isInitialized )
     {
         storePath();
+        flushGroups();
 
-        cairo_pop_group_to_source( currentContext );
-        cairo_paint_with_alpha( currentContext, LAYER_ALPHA );
+        paintLayer();
 
         cairo_push_group( currentContext );
     }
 }
 
 
-void CAIRO_GAL::Transform( const MATRIX3x3D& aTransformation )
+void CAIRO_GAL_BASE::Transform( const MATRIX3x3D& aTransformation )
 {
     cairo_matrix_t cairoTransformation;
 
@@ -466,7 +410,7 @@ void CAIRO_GAL::Transform( const MATRIX3x3D& aTransformation )
 }
 
 
-void CAIRO_GAL::Rotate( double aAngle )
+void CAIRO_GAL_BASE::Rotate( double aAngle )
 {
     storePath();
 
@@ -484,7 +428,7 @@ void CAIRO_GAL::Rotate( double aAngle )
 }
 
 
-void CAIRO_GAL::Translate( const VECTOR2D& aTranslation )
+void CAIRO_GAL_BASE::Translate( const VECTOR2D& aTranslation )
 {
     storePath();
 
@@ -503,7 +447,7 @@ void CAIRO_GAL::Translate( const VECTOR2D& aTranslation )
 }
 
 
-void CAIRO_GAL::Scale( const VECTOR2D& aScale )
+void CAIRO_GAL_BASE::Scale( const VECTOR2D& aScale )
 {
     storePath();
 
@@ -522,7 +466,7 @@ void CAIRO_GAL::Scale( const VECTOR2D& aScale )
 }
 
 
-void CAIRO_GAL::Save()
+void CAIRO_GAL_BASE::Save()
 {
     storePath();
 
@@ -539,7 +483,7 @@ void CAIRO_GAL::Save()
 }
 
 
-void CAIRO_GAL::Restore()
+void CAIRO_GAL_BASE::Restore()
 {
     storePath();
 
@@ -556,7 +500,7 @@ void CAIRO_GAL::Restore()
 }
 
 
-int CAIRO_GAL::BeginGroup()
+int CAIRO_GAL_BASE::BeginGroup()
 {
     initSurface();
 
@@ -574,7 +518,7 @@ int CAIRO_GAL::BeginGroup()
 }
 
 
-void CAIRO_GAL::EndGroup()
+void CAIRO_GAL_BASE::EndGroup()
 {
     storePath();
     isGrouping = false;
@@ -583,98 +527,290 @@ void CAIRO_GAL::EndGroup()
 }
 
 
-void CAIRO_GAL::DrawGroup( int aGroupNumber )
+void CAIRO_GAL_BASE::DrawGroup( int aGroupNumber )
+{
+    storePath();
+
+    REPLAY_STATE state = { isFillEnabled, isStrokeEnabled, fillColor, strokeColor };
+    const GROUP& group = groups[aGroupNumber];
+
+    if( tileCount > 1 && !isGrouping && isInitialized )
+    {
+        // Rasterization is deferred, so a number of groups can be split into tiles and drawn
+        // in parallel by flushGroups(). Only the context state and attributes are updated now,
+        // as if the group was drawn.
+        DEFERRED_GROUP deferred;
+        deferred.group = &group;
+        deferred.state = state;
+        deferred.lineWidth = cairo_get_line_width( currentContext );
+        deferred.top = std::numeric_limits<double>::max();
+        deferred.bottom = -std::numeric_limits<double>::max();
+        cairo_get_matrix( currentContext, &deferred.matrix );
+
+        // Replaying also finds the group extents, so tiles may skip groups that miss them
+        replayGroup( currentContext, group, state, false, &deferred );
+        deferredGroups.push_back( deferred );
+    }
+    else
+    {
+        replayGroup( currentContext, group, state, true );
+    }
+
+    isFillEnabled   = state.isFillEnabled;
+    isStrokeEnabled = state.isStrokeEnabled;
+    fillColor       = state.fillColor;
+    strokeColor     = state.strokeColor;
+}
+
+
+void CAIRO_GAL_BASE::replayGroup( cairo_t* aContext, const GROUP& aGroup, REPLAY_STATE& aState,
+                                  bool aDraw, DEFERRED_GROUP* aDeferred )
 {
     // This method implements a small Virtual Machine - all stored commands
     // are executed; nested calling is also possible
 
-    storePath();
-
-    for( GROUP::iterator it = groups[aGroupNumber].begin();
-         it != groups[aGroupNumber].end(); ++it )
+    for( GROUP::const_iterator it = aGroup.begin(); it != aGroup.end(); ++it )
     {
         switch( it->command )
         {
         case CMD_SET_FILL:
-            isFillEnabled = it->boolArgument;
+            aState.isFillEnabled = it->boolArgument;
             break;
 
         case CMD_SET_STROKE:
-            isStrokeEnabled = it->boolArgument;
+            aState.isStrokeEnabled = it->boolArgument;
             break;
 
         case CMD_SET_FILLCOLOR:
-            fillColor = COLOR4D( it->arguments[0], it->arguments[1], it->arguments[2],
-                                 it->arguments[3] );
+            aState.fillColor = COLOR4D( it->arguments[0], it->arguments[1], it->arguments[2],
+                                        it->arguments[3] );
             break;
 
         case CMD_SET_STROKECOLOR:
-            strokeColor = COLOR4D( it->arguments[0], it->arguments[1], it->arguments[2],
-                                   it->arguments[3] );
+            aState.strokeColor = COLOR4D( it->arguments[0], it->arguments[1], it->arguments[2],
+                                          it->arguments[3] );
             break;
 
         case CMD_SET_LINE_WIDTH:
             {
                 // Make lines appear at least 1 pixel wide, no matter of zoom
                 double x = 1.0, y = 1.0;
-                cairo_device_to_user_distance( currentContext, &x, &y );
+                cairo_device_to_user_distance( aContext, &x, &y );
                 double minWidth = std::min( fabs( x ), fabs( y ) );
-                cairo_set_line_width( currentContext, std::max( it->arguments[0], minWidth ) );
+                cairo_set_line_width( aContext, std::max( it->arguments[0], minWidth ) );
             }
             break;
 
 
         case CMD_STROKE_PATH:
-            cairo_set_source_rgb( currentContext, strokeColor.r, strokeColor.g, strokeColor.b );
-            cairo_append_path( currentContext, it->cairoPath );
-            cairo_stroke( currentContext );
+            if( aDraw )
+            {
+                cairo_set_source_rgb( aContext, aState.strokeColor.r, aState.strokeColor.g,
+                                      aState.strokeColor.b );
+                cairo_append_path( aContext, it->cairoPath );
+                cairo_stroke( aContext );
+            }
+            else if( aDeferred )
+            {
+                updateExtents( aContext, it->cairoPath, true, *aDeferred );
+            }
             break;
 
         case CMD_FILL_PATH:
-            cairo_set_source_rgb( currentContext, fillColor.r, fillColor.g, fillColor.b );
-            cairo_append_path( currentContext, it->cairoPath );
-            cairo_fill( currentContext );
+            if( aDraw )
+            {
+                cairo_set_source_rgb( aContext, aState.fillColor.r, aState.fillColor.g,
+                                      aState.fillColor.b );
+                cairo_append_path( aContext, it->cairoPath );
+                cairo_fill( aContext );
+            }
+            else if( aDeferred )
+            {
+                updateExtents( aContext, it->cairoPath, false, *aDeferred );
+            }
             break;
 
         case CMD_TRANSFORM:
             cairo_matrix_t matrix;
             cairo_matrix_init( &matrix, it->arguments[0], it->arguments[1], it->arguments[2],
                                it->arguments[3], it->arguments[4], it->arguments[5] );
-            cairo_transform( currentContext, &matrix );
+            cairo_transform( aContext, &matrix );
             break;
 
         case CMD_ROTATE:
-            cairo_rotate( currentContext, it->arguments[0] );
+            cairo_rotate( aContext, it->arguments[0] );
             break;
 
         case CMD_TRANSLATE:
-            cairo_translate( currentContext, it->arguments[0], it->arguments[1] );
+            cairo_translate( aContext, it->arguments[0], it->arguments[1] );
             break;
 
         case CMD_SCALE:
-            cairo_scale( currentContext, it->arguments[0], it->arguments[1] );
+            cairo_scale( aContext, it->arguments[0], it->arguments[1] );
             break;
 
         case CMD_SAVE:
-            cairo_save( currentContext );
+            cairo_save( aContext );
             break;
 
         case CMD_RESTORE:
-            cairo_restore( currentContext );
+            cairo_restore( aContext );
             break;
 
         case CMD_CALL_GROUP:
-            DrawGroup( it->intArgument );
+            {
+                std::map<int, GROUP>::const_iterator called = groups.find( it->intArgument );
+
+                if( called != groups.end() )
+                    replayGroup( aContext, called->second, aState, aDraw, aDeferred );
+            }
             break;
         }
     }
 }
 
 
-void CAIRO_GAL::ChangeGroupColor( int aGroupNumber, const COLOR4D& aNewColor )
+void CAIRO_GAL_BASE::updateExtents( cairo_t* aContext, cairo_path_t* aPath, bool aStroke,
+                                    DEFERRED_GROUP& aDeferred )
+{
+    double x1, y1, x2, y2;
+
+    cairo_append_path( aContext, aPath );
+    cairo_path_extents( aContext, &x1, &y1, &x2, &y2 );
+    cairo_new_path( aContext );
+
+    if( aStroke )
+    {
+        // Joins and caps are round, they do not reach further than the line width
+        double margin = cairo_get_line_width( aContext );
+
+        x1 -= margin;
+        y1 -= margin;
+        x2 += margin;
+        y2 += margin;
+    }
+
+    // The context might be rotated, so every corner has to be checked
+    double xs[4] = { x1, x2, x1, x2 };
+    double ys[4] = { y1, y1, y2, y2 };
+
+    for( int i = 0; i < 4; ++i )
+    {
+        cairo_user_to_device( aContext, &xs[i], &ys[i] );
+        aDeferred.top    = std::min( aDeferred.top, ys[i] );
+        aDeferred.bottom = std::max( aDeferred.bottom, ys[i] );
+    }
+}
+
+
+void CAIRO_GAL_BASE::flushGroups()
+{
+    if( deferredGroups.empty() )
+        return;
+
+    cairo_surface_t* target = cairo_get_group_target( currentContext );
+    int tiles = deferredGroups.size() < MIN_TILED_GROUPS ? 1 : tileCount;
+
+    // Tiles need direct access to the pixels
+    if( cairo_surface_get_type( target ) != CAIRO_SURFACE_TYPE_IMAGE )
+        tiles = 1;
+
+    cairo_antialias_t antialias = cairo_get_antialias( currentContext );
+    cairo_line_join_t lineJoin  = cairo_get_line_join( currentContext );
+    cairo_line_cap_t  lineCap   = cairo_get_line_cap( currentContext );
+
+    unsigned char*  pixels       = NULL;
+    cairo_format_t  format       = CAIRO_FORMAT_ARGB32;
+    int             targetWidth  = 0;
+    int             targetHeight = 0;
+    int             targetStride = 0;
+    double          offsetX      = 0.0;
+    double          offsetY      = 0.0;
+
+    if( tiles > 1 )
+    {
+        cairo_surface_flush( target );
+        pixels       = cairo_image_surface_get_data( target );
+        format       = cairo_image_surface_get_format( target );
+        targetWidth  = cairo_image_surface_get_width( target );
+        targetHeight = cairo_image_surface_get_height( target );
+        targetStride = cairo_image_surface_get_stride( target );
+        cairo_surface_get_device_offset( target, &offsetX, &offsetY );
+
+        tiles = std::min( tiles, targetHeight );
+    }
+
+#ifdef USE_OPENMP
+    #pragma omp parallel for schedule( static, 1 ) if( tiles > 1 )
+#endif /* USE_OPENMP */
+    for( int i = 0; i < tiles; ++i )
+    {
+        cairo_surface_t* tileSurface;
+
+        if( tiles > 1 )
+        {
+            // Each tile is a horizontal band of the target, it has its own surface sharing
+            // the target pixel storage, so tiles do not interfere with each other
+            int top    = targetHeight * i / tiles;
+            int bottom = targetHeight * ( i + 1 ) / tiles;
+
+            tileSurface = cairo_image_surface_create_for_data( pixels + top * targetStride,
+                                                               format, targetWidth,
+                                                               bottom - top, targetStride );
+            cairo_surface_set_device_offset( tileSurface, offsetX, offsetY - top );
+        }
+        else
+        {
+            tileSurface = cairo_surface_reference( target );
+        }
+
+        // Band covered by the tile (device coordinates), groups that miss it are skipped;
+        // a pixel of margin is left for antialiasing and lines widened to be visible
+        double bandTop    = -std::numeric_limits<double>::max();
+        double bandBottom = std::numeric_limits<double>::max();
+
+        if( tiles > 1 )
+        {
+            bandTop    = targetHeight * i / tiles - offsetY - 1.0;
+            bandBottom = targetHeight * ( i + 1 ) / tiles - offsetY + 1.0;
+        }
+
+        cairo_t* tileContext = cairo_create( tileSurface );
+        cairo_set_antialias( tileContext, antialias );
+        cairo_set_line_join( tileContext, lineJoin );
+        cairo_set_line_cap( tileContext, lineCap );
+
+        for( std::vector<DEFERRED_GROUP>::const_iterator it = deferredGroups.begin();
+             it != deferredGroups.end(); ++it )
+        {
+            if( it->bottom < bandTop || it->top > bandBottom )
+                continue;
+
+            REPLAY_STATE state = it->state;
+
+            cairo_set_matrix( tileContext, &it->matrix );
+            cairo_set_line_width( tileContext, it->lineWidth );
+            replayGroup( tileContext, *it->group, state, true );
+        }
+
+        cairo_destroy( tileContext );
+        cairo_surface_destroy( tileSurface );
+    }
+
+    if( tiles > 1 )
+        cairo_surface_mark_dirty( target );
+
+    deferredGroups.clear();
+}
+
+
+void CAIRO_GAL_BASE::ChangeGroupColor( int aGroupNumber, const COLOR4D& aNewColor )
 {
     storePath();
 
+    // Deferred calls have to be drawn using the old color
+    flushGroups();
+
     for( GROUP::iterator it = groups[aGroupNumber].begin();
          it != groups[aGroupNumber].end(); ++it )
     {
@@ -689,17 +825,20 @@ void CAIRO_GAL::ChangeGroupColor( int aGroupNumber, const COLOR4D& aNewColor )
 }
 
 
-void CAIRO_GAL::ChangeGroupDepth( int aGroupNumber, int aDepth )
+void CAIRO_GAL_BASE::ChangeGroupDepth( int aGroupNumber, int aDepth )
 {
     // Cairo does not have any possibilities to change the depth coordinate of stored items,
     // it depends only on the order of drawing
 }
 
 
-void CAIRO_GAL::DeleteGroup( int aGroupNumber )
+void CAIRO_GAL_BASE::DeleteGroup( int aGroupNumber )
 {
     storePath();
 
+    // Deferred groups may refer to the deleted group
+    flushGroups();
+
     // Delete the Cairo paths
     std::deque<GROUP_ELEMENT>::iterator it, end;
 
@@ -716,7 +855,7 @@ void CAIRO_GAL::DeleteGroup( int aGroupNumber )
 }
 
 
-void CAIRO_GAL::ClearCache()
+void CAIRO_GAL_BASE::ClearCache()
 {
     for( int i = groups.size() - 1; i >= 0; --i )
     {
@@ -725,8 +864,10 @@ void CAIRO_GAL::ClearCache()
 }
 
 
-void CAIRO_GAL::SaveScreen()
+void CAIRO_GAL_BASE::SaveScreen()
 {
+    flushGroups();
+
     // Copy the current bitmap to the backup buffer
     int offset = 0;
 
@@ -741,8 +882,10 @@ void CAIRO_GAL::SaveScreen()
 }
 
 
-void CAIRO_GAL::RestoreScreen()
+void CAIRO_GAL_BASE::RestoreScreen()
 {
+    flushGroups();
+
     int offset = 0;
 
     for( int j = 0; j < screenSize.y; j++ )
@@ -756,7 +899,7 @@ void CAIRO_GAL::RestoreScreen()
 }
 
 
-void CAIRO_GAL::SetTarget( RENDER_TARGET aTarget )
+void CAIRO_GAL_BASE::SetTarget( RENDER_TARGET aTarget )
 {
     // If the compositor is not set, that means that there is a recaching process going on
     // and we do not need the compositor now
@@ -767,9 +910,9 @@ void CAIRO_GAL::SetTarget( RENDER_TARGET aTarget )
     if( isInitialized )
     {
         storePath();
+        flushGroups();
 
-        cairo_pop_group_to_source( currentContext );
-        cairo_paint_with_alpha( currentContext, LAYER_ALPHA );
+        paintLayer();
     }
 
     switch( aTarget )
@@ -792,14 +935,16 @@ void CAIRO_GAL::SetTarget( RENDER_TARGET aTarget )
 }
 
 
-RENDER_TARGET CAIRO_GAL::GetTarget() const
+RENDER_TARGET CAIRO_GAL_BASE::GetTarget() const
 {
     return currentTarget;
 }
 
 
-void CAIRO_GAL::ClearTarget( RENDER_TARGET aTarget )
+void CAIRO_GAL_BASE::ClearTarget( RENDER_TARGET aTarget )
 {
+    flushGroups();
+
     // Save the current state
     unsigned int currentBuffer = compositor->GetBuffer();
 
@@ -817,21 +962,30 @@ void CAIRO_GAL::ClearTarget( RENDER_TARGET aTarget )
         break;
     }
 
-    compositor->ClearBuffer();
+    if( isClipping )
+        compositor->ClearBuffer( clipArea );
+    else
+        compositor->ClearBuffer();
 
     // Restore the previous state
     compositor->SetBuffer( currentBuffer );
 }
 
 
-void CAIRO_GAL::SetCursorSize( unsigned int aCursorSize )
+void CAIRO_GAL_BASE::SetClipArea( const BOX2D& aArea )
 {
-    GAL::SetCursorSize( aCursorSize );
-    initCursor();
+    clipArea = computeScreenArea( aArea );
+    isClipping = true;
+}
+
+
+void CAIRO_GAL_BASE::ResetClipArea()
+{
+    isClipping = false;
 }
 
 
-void CAIRO_GAL::DrawCursor( const VECTOR2D& aCursorPosition )
+void CAIRO_GAL_BASE::DrawCursor( const VECTOR2D& aCursorPosition )
 {
     // Now we should only store the position of the mouse cursor
     // The real drawing routines are in blitCursor()
@@ -840,8 +994,10 @@ void CAIRO_GAL::DrawCursor( const VECTOR2D& aCursorPosition )
 }
 
 
-void CAIRO_GAL::drawGridLine( const VECTOR2D& aStartPoint, const VECTOR2D& aEndPoint )
+void CAIRO_GAL_BASE::drawGridLine( const VECTOR2D& aStartPoint, const VECTOR2D& aEndPoint )
 {
+    flushGroups();
+
     cairo_move_to( currentContext, aStartPoint.x, aStartPoint.y );
     cairo_line_to( currentContext, aEndPoint.x, aEndPoint.y );
     cairo_set_source_rgb( currentContext, gridColor.r, gridColor.g, gridColor.b );
@@ -849,7 +1005,7 @@ void CAIRO_GAL::drawGridLine( const VECTOR2D& aStartPoint, const VECTOR2D& aEndP
 }
 
 
-void CAIRO_GAL::storePath()
+void CAIRO_GAL_BASE::storePath()
 {
     if( isElementAdded )
     {
@@ -857,6 +1013,9 @@ void CAIRO_GAL::storePath()
 
         if( !isGrouping )
         {
+            // Deferred groups were drawn earlier, so they have to go first
+            flushGroups();
+
             if( isFillEnabled )
             {
                 cairo_set_source_rgb( currentContext, fillColor.r, fillColor.g, fillColor.b );
@@ -897,98 +1056,48 @@ void CAIRO_GAL::storePath()
 }
 
 
-void CAIRO_GAL::onPaint( wxPaintEvent& WXUNUSED( aEvent ) )
+void CAIRO_GAL_BASE::allocateBitmaps()
 {
-    PostPaint();
-}
-
+    // Create buffer, use the system independent Cairo context backend
+    stride     = cairo_format_stride_for_width( GAL_FORMAT, screenSize.x );
+    bufferSize = stride * screenSize.y;
 
-void CAIRO_GAL::skipMouseEvent( wxMouseEvent& aEvent )
-{
-    // Post the mouse event to the event listener registered in constructor, if any
-    if( mouseListener )
-        wxPostEvent( mouseListener, aEvent );
+    bitmapBuffer        = new unsigned int[bufferSize];
+    bitmapBufferBackup  = new unsigned int[bufferSize];
 }
 
 
-void CAIRO_GAL::initCursor()
+void CAIRO_GAL_BASE::deleteBitmaps()
 {
-    if( cursorPixels )
-        delete cursorPixels;
-
-    if( cursorPixelsSaved )
-        delete cursorPixelsSaved;
-
-    cursorPixels      = new wxBitmap( cursorSize, cursorSize );
-    cursorPixelsSaved = new wxBitmap( cursorSize, cursorSize );
-
-    wxMemoryDC cursorShape( *cursorPixels );
-
-    cursorShape.SetBackground( *wxTRANSPARENT_BRUSH );
-    wxColour color( cursorColor.r * cursorColor.a * 255, cursorColor.g * cursorColor.a * 255,
-                    cursorColor.b * cursorColor.a * 255, 255 );
-    wxPen pen = wxPen( color );
-    cursorShape.SetPen( pen );
-    cursorShape.Clear();
-
-    cursorShape.DrawLine( 0, cursorSize / 2, cursorSize, cursorSize / 2 );
-    cursorShape.DrawLine( cursorSize / 2, 0, cursorSize / 2, cursorSize );
+    delete[] bitmapBuffer;
+    delete[] bitmapBufferBackup;
 }
 
 
-void CAIRO_GAL::blitCursor( wxBufferedDC& clientDC )
+void CAIRO_GAL_BASE::paintLayer()
 {
-    if( !isCursorEnabled )
-        return;
-
-    wxMemoryDC cursorSave( *cursorPixelsSaved );
-    wxMemoryDC cursorShape( *cursorPixels );
+    cairo_pop_group_to_source( currentContext );
 
-    if( !isDeleteSavedPixels )
+    if( isClipping )
     {
-        // Restore pixels that were overpainted by the previous cursor
-        clientDC.Blit( savedCursorPosition.x, savedCursorPosition.y,
-                       cursorSize, cursorSize, &cursorSave, 0, 0 );
+        // Items are drawn as a whole, so the clipping is applied when the layer is painted
+        cairo_save( currentContext );
+        cairo_identity_matrix( currentContext );
+        cairo_new_path( currentContext );
+        cairo_rectangle( currentContext, clipArea.GetX(), clipArea.GetY(),
+                         clipArea.GetWidth(), clipArea.GetHeight() );
+        cairo_clip( currentContext );
+        cairo_paint_with_alpha( currentContext, LAYER_ALPHA );
+        cairo_restore( currentContext );
     }
     else
     {
-        isDeleteSavedPixels = false;
+        cairo_paint_with_alpha( currentContext, LAYER_ALPHA );
     }
-
-    // Store pixels that are going to be overpainted
-    VECTOR2D cursorScreen = ToScreen( cursorPosition ) - cursorSize / 2;
-    cursorSave.Blit( 0, 0, cursorSize, cursorSize, &clientDC, cursorScreen.x, cursorScreen.y );
-
-    // Draw the cursor
-    clientDC.Blit( cursorScreen.x, cursorScreen.y, cursorSize, cursorSize,
-                   &cursorShape, 0, 0, wxOR );
-
-    savedCursorPosition.x = (wxCoord) cursorScreen.x;
-    savedCursorPosition.y = (wxCoord) cursorScreen.y;
-}
-
-
-void CAIRO_GAL::allocateBitmaps()
-{
-    // Create buffer, use the system independent Cairo context backend
-    stride     = cairo_format_stride_for_width( GAL_FORMAT, screenSize.x );
-    bufferSize = stride * screenSize.y;
-
-    bitmapBuffer        = new unsigned int[bufferSize];
-    bitmapBufferBackup  = new unsigned int[bufferSize];
-    wxOutput            = new unsigned char[bufferSize * 3];
-}
-
-
-void CAIRO_GAL::deleteBitmaps()
-{
-    delete[] bitmapBuffer;
-    delete[] bitmapBufferBackup;
-    delete[] wxOutput;
 }
 
 
-void CAIRO_GAL::initSurface()
+void CAIRO_GAL_BASE::initSurface()
 {
     if( isInitialized )
         return;
@@ -1027,16 +1136,17 @@ void CAIRO_GAL::initSurface()
 
     lineWidth = 0;
 
-    isDeleteSavedPixels = true;
     isInitialized = true;
 }
 
 
-void CAIRO_GAL::deinitSurface()
+void CAIRO_GAL_BASE::deinitSurface()
 {
     if( !isInitialized )
         return;
 
+    flushGroups();
+
     // Destroy Cairo objects
     cairo_destroy( context );
     cairo_surface_destroy( surface );
@@ -1045,7 +1155,7 @@ void CAIRO_GAL::deinitSurface()
 }
 
 
-void CAIRO_GAL::setCompositor()
+void CAIRO_GAL_BASE::setCompositor()
 {
     // Recreate the compositor with the new Cairo context
     compositor.reset( new CAIRO_COMPOSITOR( &currentContext ) );
@@ -1059,7 +1169,7 @@ void CAIRO_GAL::setCompositor()
 }
 
 
-unsigned int CAIRO_GAL::getNewGroupNumber()
+unsigned int CAIRO_GAL_BASE::getNewGroupNumber()
 {
     wxASSERT_MSG( groups.size() < std::numeric_limits<unsigned int>::max(),
                   wxT( "There are no free slots to store a group" ) );
@@ -1071,3 +1181,213 @@ unsigned int CAIRO_GAL::getNewGroupNumber()
 
     return groupCounter++;
 }
+
+
+CAIRO_GAL::CAIRO_GAL( wxWindow* aParent, wxEvtHandler* aMouseListener,
+        wxEvtHandler* aPaintListener, const wxString& aName ) :
+    CAIRO_GAL_BASE( VECTOR2I( aParent->GetSize() ) ),
+    wxWindow( aParent, wxID_ANY, wxDefaultPosition, wxDefaultSize, wxEXPAND, aName )
+{
+    parentWindow  = aParent;
+    mouseListener = aMouseListener;
+    paintListener = aPaintListener;
+
+    isDeleteSavedPixels = false;
+
+    // Connecting the event handlers
+    Connect( wxEVT_PAINT,       wxPaintEventHandler( CAIRO_GAL::onPaint ) );
+
+    // Mouse events are skipped to the parent
+    Connect( wxEVT_MOTION,          wxMouseEventHandler( CAIRO_GAL::skipMouseEvent ) );
+    Connect( wxEVT_LEFT_DOWN,       wxMouseEventHandler( CAIRO_GAL::skipMouseEvent ) );
+    Connect( wxEVT_LEFT_UP,         wxMouseEventHandler( CAIRO_GAL::skipMouseEvent ) );
+    Connect( wxEVT_LEFT_DCLICK,     wxMouseEventHandler( CAIRO_GAL::skipMouseEvent ) );
+    Connect( wxEVT_MIDDLE_DOWN,     wxMouseEventHandler( CAIRO_GAL::skipMouseEvent ) );
+    Connect( wxEVT_MIDDLE_UP,       wxMouseEventHandler( CAIRO_GAL::skipMouseEvent ) );
+    Connect( wxEVT_MIDDLE_DCLICK,   wxMouseEventHandler( CAIRO_GAL::skipMouseEvent ) );
+    Connect( wxEVT_RIGHT_DOWN,      wxMouseEventHandler( CAIRO_GAL::skipMouseEvent ) );
+    Connect( wxEVT_RIGHT_UP,        wxMouseEventHandler( CAIRO_GAL::skipMouseEvent ) );
+    Connect( wxEVT_RIGHT_DCLICK,    wxMouseEventHandler( CAIRO_GAL::skipMouseEvent ) );
+    Connect( wxEVT_MOUSEWHEEL,      wxMouseEventHandler( CAIRO_GAL::skipMouseEvent ) );
+#if defined _WIN32 || defined _WIN64
+    Connect( wxEVT_ENTER_WINDOW,    wxMouseEventHandler( CAIRO_GAL::skipMouseEvent ) );
+#endif
+
+    SetSize( aParent->GetSize() );
+
+    cursorPixels = NULL;
+    cursorPixelsSaved = NULL;
+    initCursor();
+
+    wxOutput = new unsigned char[bufferSize * 3];
+}
+
+
+CAIRO_GAL::~CAIRO_GAL()
+{
+    delete[] wxOutput;
+
+    delete cursorPixels;
+    delete cursorPixelsSaved;
+}
+
+
+void CAIRO_GAL::BeginDrawing()
+{
+    CAIRO_GAL_BASE::BeginDrawing();
+
+    // The whole frame is going to be redrawn, so the pixels saved under the cursor are stale
+    isDeleteSavedPixels = true;
+}
+
+
+void CAIRO_GAL::EndDrawing()
+{
+    CAIRO_GAL_BASE::EndDrawing();
+
+    // This code was taken from the wxCairo example - it's not the most efficient one
+    // Here is a good place for optimizations
+
+    // Now translate the raw context data from the format stored
+    // by cairo into a format understood by wxImage.
+    unsigned char* wxOutputPtr = wxOutput;
+
+    for( size_t count = 0; count < bufferSize; count++ )
+    {
+        unsigned int value = bitmapBuffer[count];
+        *wxOutputPtr++ = ( value >> 16 ) & 0xff;  // Red pixel
+        *wxOutputPtr++ = ( value >> 8 ) & 0xff;   // Green pixel
+        *wxOutputPtr++ = value & 0xff;            // Blue pixel
+    }
+
+    wxImage      img( screenSize.x, screenSize.y, (unsigned char*) wxOutput, true );
+    wxBitmap     bmp( img );
+    wxClientDC   client_dc( this );
+    wxBufferedDC dc;
+    dc.Init( &client_dc, bmp );
+
+    // Now it is the time to blit the mouse cursor
+    blitCursor( dc );
+}
+
+
+void CAIRO_GAL::ResizeScreen( int aWidth, int aHeight )
+{
+    CAIRO_GAL_BASE::ResizeScreen( aWidth, aHeight );
+
+    delete[] wxOutput;
+    wxOutput = new unsigned char[bufferSize * 3];
+
+    SetSize( wxSize( aWidth, aHeight ) );
+}
+
+
+bool CAIRO_GAL::Show( bool aShow )
+{
+    bool s = wxWindow::Show( aShow );
+
+    if( aShow )
+        wxWindow::Raise();
+
+    return s;
+}
+
+
+void CAIRO_GAL::SetCursorSize( unsigned int aCursorSize )
+{
+    GAL::SetCursorSize( aCursorSize );
+    initCursor();
+}
+
+
+void CAIRO_GAL::onPaint( wxPaintEvent& WXUNUSED( aEvent ) )
+{
+    PostPaint();
+}
+
+
+void CAIRO_GAL::skipMouseEvent( wxMouseEvent& aEvent )
+{
+    // Post the mouse event to the event listener registered in constructor, if any
+    if( mouseListener )
+        wxPostEvent( mouseListener, aEvent );
+}
+
+
+void CAIRO_GAL::initCursor()
+{
+    if( cursorPixels )
+        delete cursorPixels;
+
+    if( cursorPixelsSaved )
+        delete cursorPixelsSaved;
+
+    cursorPixels      = new wxBitmap( cursorSize, cursorSize );
+    cursorPixelsSaved = new wxBitmap( cursorSize, cursorSize );
+
+    wxMemoryDC cursorShape( *cursorPixels );
+
+    cursorShape.SetBackground( *wxTRANSPARENT_BRUSH );
+    wxColour color( cursorColor.r * cursorColor.a * 255, cursorColor.g * cursorColor.a * 255,
+                    cursorColor.b * cursorColor.a * 255, 255 );
+    wxPen pen = wxPen( color );
+    cursorShape.SetPen( pen );
+    cursorShape.Clear();
+
+    cursorShape.DrawLine( 0, cursorSize / 2, cursorSize, cursorSize / 2 );
+    cursorShape.DrawLine( cursorSize / 2, 0, cursorSize / 2, cursorSize );
+}
+
+
+void CAIRO_GAL::blitCursor( wxBufferedDC& clientDC )
+{
+    if( !isCursorEnabled )
+        return;
+
+    wxMemoryDC cursorSave( *cursorPixelsSaved );
+    wxMemoryDC cursorShape( *cursorPixels );
+
+    if( !isDeleteSavedPixels )
+    {
+        // Restore pixels that were overpainted by the previous cursor
+        clientDC.Blit( savedCursorPosition.x, savedCursorPosition.y,
+                       cursorSize, cursorSize, &cursorSave, 0, 0 );
+    }
+    else
+    {
+        isDeleteSavedPixels = false;
+    }
+
+    // Store pixels that are going to be overpainted
+    VECTOR2D cursorScreen = ToScreen( cursorPosition ) - cursorSize / 2;
+    cursorSave.Blit( 0, 0, cursorSize, cursorSize, &clientDC, cursorScreen.x, cursorScreen.y );
+
+    // Draw the cursor
+    clientDC.Blit( cursorScreen.x, cursorScreen.y, cursorSize, cursorSize,
+                   &cursorShape, 0, 0, wxOR );
+
+    savedCursorPosition.x = (wxCoord) cursorScreen.x;
+    savedCursorPosition.y = (wxCoord) cursorScreen.y;
+}
+
+
+CAIRO_OFFSCREEN_GAL::CAIRO_OFFSCREEN_GAL( int aWidth, int aHeight ) :
+    CAIRO_GAL_BASE( VECTOR2I( aWidth, aHeight ) )
+{
+}
+
+
+bool CAIRO_OFFSCREEN_GAL::SaveImage( const std::string& aFileName ) const
+{
+#ifdef CAIRO_HAS_PNG_FUNCTIONS
+    cairo_surface_t* image = cairo_image_surface_create_for_data( (unsigned char*) bitmapBuffer,
+                                                                  GAL_FORMAT, screenSize.x,
+                                                                  screenSize.y, stride );
+    cairo_status_t status = cairo_surface_write_to_png( image, aFileName.c_str() );
+    cairo_surface_destroy( image );
+
+    return status == CAIRO_STATUS_SUCCESS;
+#else
+    return false;
+#endif /* CAIRO_HAS_PNG_FUNCTIONS */
+}
@@ -25,6 +25,8 @@
  */
 
 #include <wx/log.h>
+#include <algorithm>
+#include <cmath>
 
 #include <gal/graphics_abstraction_layer.h>
 #include <gal/definitions.h>
@@ -246,3 +248,44 @@ VECTOR2D GAL::GetGridPoint( const VECTOR2D& aPoint ) const
     return VECTOR2D( round( ( aPoint.x - gridOffset.x ) / gridSize.x ) * gridSize.x + gridOffset.x,
                      round( ( aPoint.y - gridOffset.y ) / gridSize.y ) * gridSize.y + gridOffset.y );
 }
+
+
+void GAL::DrawTriangles( const std::vector<VECTOR2D>& aTriangles )
+{
+    wxASSERT( aTriangles.size() % 3 == 0 );
+
+    std::deque<VECTOR2D> triangle( 3 );
+
+    for( unsigned int i = 0; i + 2 < aTriangles.size(); i += 3 )
+    {
+        triangle[0] = aTriangles[i];
+        triangle[1] = aTriangles[i + 1];
+        triangle[2] = aTriangles[i + 2];
+
+        DrawPolygon( triangle );
+    }
+}
+
+
+BOX2I GAL::computeScreenArea( const BOX2D& aArea ) const
+{
+    VECTOR2D a = ToScreen( aArea.GetOrigin() );
+    VECTOR2D b = ToScreen( aArea.GetEnd() );
+
+    // Margin for antialiased edges; limits are applied before conversion to integers, as
+    // areas covering huge items could overflow
+    const double margin = 2.0;
+
+    int left    = (int) std::max( floor( std::min( a.x, b.x ) ) - margin, 0.0 );
+    int top     = (int) std::max( floor( std::min( a.y, b.y ) ) - margin, 0.0 );
+    int right   = (int) std::min( ceil( std::max( a.x, b.x ) ) + margin, (double) screenSize.x );
+    int bottom  = (int) std::min( ceil( std::max( a.y, b.y ) ) + margin, (double) screenSize.y );
+
+    if( right < left )
+        right = left;
+
+    if( bottom < top )
+        bottom = top;
+
+    return BOX2I( VECTOR2I( left, top ), VECTOR2I( right - left, bottom - top ) );
+}
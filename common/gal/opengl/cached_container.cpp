@@ -35,18 +35,25 @@
 #include <gal/opengl/shader.h>
 #include <confirm.h>
 #include <wx/log.h>
-#include <list>
+#include <cstring>
 #ifdef __WXDEBUG__
 #include <profile.h>
 #endif /* __WXDEBUG__ */
 
 using namespace KIGFX;
 
+const double CACHED_CONTAINER::COMPACTION_THRESHOLD = 0.5;
+const unsigned int CACHED_CONTAINER::COMPACTION_STEP = 16384;
+
 CACHED_CONTAINER::CACHED_CONTAINER( unsigned int aSize ) :
-    VERTEX_CONTAINER( aSize ), m_item( NULL )
+    VERTEX_CONTAINER( aSize ), m_item( NULL ), m_chunkSize( 0 ), m_chunkOffset( 0 ),
+    m_itemSize( 0 )
 {
+    memset( &m_stats, 0, sizeof( m_stats ) );
+
     // In the beginning there is only free space
-    m_freeChunks.insert( CHUNK( aSize, 0 ) );
+    m_freeSpace = 0;
+    addFreeChunk( 0, aSize );
 }
 
 
@@ -78,14 +85,15 @@ void CACHED_CONTAINER::FinishItem()
     if( m_itemSize < m_chunkSize )
     {
         // There is some not used but reserved memory left, so we should return it to the pool
-        int itemOffset = m_item->GetOffset();
-
-        // Add the not used memory back to the pool
-        m_freeChunks.insert( CHUNK( m_chunkSize - m_itemSize, itemOffset + m_itemSize ) );
-        m_freeSpace += ( m_chunkSize - m_itemSize );
-        // mergeFreeChunks();   // veery slow and buggy
+        addFreeChunk( m_chunkOffset + m_itemSize, m_chunkSize - m_itemSize );
+        m_chunkSize = m_itemSize;
     }
 
+    // Free chunks are merged when they are returned to the pool, but items still leave holes
+    // between them. They are removed a bit at a time, so there are no long pauses.
+    if( GetFragmentation() > COMPACTION_THRESHOLD )
+        compact( COMPACTION_STEP );
+
 #if CACHED_CONTAINER_TEST > 1
     wxLogDebug( wxT( "Finishing item 0x%08lx (size %d)" ), (long) m_item, m_itemSize );
     test();
@@ -107,9 +115,7 @@ VERTEX* CACHED_CONTAINER::Allocate( unsigned int aSize )
 
         // Reserve a bigger memory chunk for the current item and
         // make it multiple of 3 to store triangles
-        m_chunkSize = ( 2 * m_itemSize ) + aSize + ( 3 - aSize % 3 );
-        // Save the current size before reallocating
-        m_chunkOffset = reallocate( m_chunkSize );
+        m_chunkOffset = reallocate( ( 2 * m_itemSize ) + aSize + ( 3 - aSize % 3 ) );
 
         if( m_chunkOffset > m_currentSize )
         {
@@ -153,8 +159,8 @@ void CACHED_CONTAINER::Delete( VERTEX_ITEM* aItem )
     // Insert a free memory chunk entry in the place where item was stored
     if( size > 0 )
     {
-        m_freeChunks.insert( CHUNK( size, offset ) );
-        m_freeSpace += size;
+        addFreeChunk( offset, size );
+        m_itemOffsets.erase( offset );
         // Indicate that the item is not stored in the container anymore
         aItem->setSize( 0 );
     }
@@ -165,9 +171,10 @@ void CACHED_CONTAINER::Delete( VERTEX_ITEM* aItem )
     test();
 #endif
 
-    // Dynamic memory freeing, there is no point in holding
-    // a large amount of memory when there is no use for it
-    if( m_freeSpace > ( m_currentSize / 2 ) && m_currentSize > m_initialSize )
+    // Dynamic memory freeing, there is no point in holding a large amount of memory when there
+    // is no use for it. The container is shrunk only when it is used in less than a quarter,
+    // so it does not keep on growing and shrinking when items are added and removed.
+    if( m_freeSpace > ( m_currentSize / 4 ) * 3 && m_currentSize > m_initialSize )
     {
         resizeContainer( m_currentSize / 2 );
     }
@@ -181,9 +188,9 @@ void CACHED_CONTAINER::Clear()
                                                 m_initialSize * sizeof( VERTEX ) ) );
 
     // Reset state variables
-    m_freeSpace     = m_initialSize;
     m_currentSize   = m_initialSize;
     m_failed = false;
+    memset( &m_stats, 0, sizeof( m_stats ) );
 
     // Set the size of all the stored VERTEX_ITEMs to 0, so it is clear that they are not held
     // in the container anymore
@@ -195,11 +202,13 @@ void CACHED_CONTAINER::Clear()
     }
 
     m_items.clear();
-
+    m_itemOffsets.clear();
 
     // Now there is only free space left
     m_freeChunks.clear();
-    m_freeChunks.insert( CHUNK( m_freeSpace, 0 ) );
+    m_freeChunkOffsets.clear();
+    m_freeSpace = 0;
+    addFreeChunk( 0, m_initialSize );
 }
 
 
@@ -211,6 +220,16 @@ VERTEX* CACHED_CONTAINER::GetVertices( const VERTEX_ITEM* aItem ) const
 }
 
 
+double CACHED_CONTAINER::GetFragmentation() const
+{
+    if( m_freeSpace == 0 || m_freeChunks.empty() )
+        return 0.0;
+
+    // The last chunk is the biggest one
+    return 1.0 - (double) getChunkSize( *m_freeChunks.rbegin() ) / m_freeSpace;
+}
+
+
 unsigned int CACHED_CONTAINER::reallocate( unsigned int aSize )
 {
     wxASSERT( aSize > 0 );
@@ -240,8 +259,8 @@ unsigned int CACHED_CONTAINER::reallocate( unsigned int aSize )
             return UINT_MAX;
     }
 
-    // Look for the free space chunk of at least given size
-    FREE_CHUNK_MAP::iterator newChunk = m_freeChunks.lower_bound( aSize );
+    // Look for the smallest free chunk of at least given size
+    FREE_CHUNK_SET::iterator newChunk = m_freeChunks.lower_bound( CHUNK( aSize, 0 ) );
 
     if( newChunk == m_freeChunks.end() )
     {
@@ -251,18 +270,17 @@ unsigned int CACHED_CONTAINER::reallocate( unsigned int aSize )
             return UINT_MAX;
 
         // Update the current offset
-        m_chunkOffset = m_item->GetOffset();
+        if( m_itemSize > 0 )
+            m_chunkOffset = m_item->GetOffset();
 
-        // We can take the first free chunk, as there is only one after defragmentation
+        // There is only one free chunk after defragmentation
         // and we can be sure that it provides enough space to store the object
         newChunk = m_freeChunks.begin();
     }
 
-    // Parameters of the allocated cuhnk
-    unsigned int chunkSize   = newChunk->first;
-    unsigned int chunkOffset = newChunk->second;
+    // Remove the allocated chunk from the free space pool
+    unsigned int chunkOffset = takeFreeChunk( newChunk, aSize );
 
-    wxASSERT( chunkSize >= aSize );
     wxASSERT( chunkOffset < m_currentSize );
 
     // Check if the item was previously stored in the container
@@ -270,31 +288,21 @@ unsigned int CACHED_CONTAINER::reallocate( unsigned int aSize )
     {
 #if CACHED_CONTAINER_TEST > 3
         wxLogDebug( wxT( "Moving 0x%08x from 0x%08x to 0x%08x" ),
-                    (int) m_item, oldChunkOffset, chunkOffset );
+                    (int) m_item, m_chunkOffset, chunkOffset );
 #endif
         // The item was reallocated, so we have to copy all the old data to the new place
         memcpy( &m_vertices[chunkOffset], &m_vertices[m_chunkOffset],
                 m_itemSize * VertexSize );
 
-        // Free the space previously used by the chunk
-        wxASSERT( m_itemSize > 0 );
-        m_freeChunks.insert( CHUNK( m_itemSize, m_chunkOffset ) );
-        m_freeSpace += m_itemSize;
-    }
-
-    // Remove the allocated chunk from the free space pool
-    m_freeChunks.erase( newChunk );
-
-    // If there is some space left, return it to the pool - add an entry for it
-    if( chunkSize > aSize )
-    {
-        m_freeChunks.insert( CHUNK( chunkSize - aSize, chunkOffset + aSize ) );
+        // Free the space previously reserved for the item
+        m_itemOffsets.erase( m_chunkOffset );
+        addFreeChunk( m_chunkOffset, m_chunkSize );
+        ++m_stats.reallocations;
     }
 
-    m_freeSpace -= aSize;
-    // mergeFreeChunks();   // veery slow and buggy
-
+    m_itemOffsets[chunkOffset] = m_item;
     m_item->setOffset( chunkOffset );
+    m_chunkSize = aSize;
 
     return chunkOffset;
 }
@@ -309,44 +317,53 @@ bool CACHED_CONTAINER::defragment( VERTEX* aTarget )
     prof_start( &totalTime, false );
 #endif
 
+    // Items are processed in the order of their offsets, so they may be moved towards
+    // the beginning of the current container without overwriting any data
     if( aTarget == NULL )
-    {
-        // No target was specified, so we have to reallocate our own space
-        aTarget = static_cast<VERTEX*>( malloc( m_currentSize * sizeof( VERTEX ) ) );
+        aTarget = m_vertices;
 
-        if( aTarget == NULL )
-        {
-            DisplayError( NULL, wxT( "Run out of memory" ) );
-            return false;
-        }
-    }
-
-    int newOffset = 0;
-    ITEMS::iterator it, it_end;
+    unsigned int newOffset = 0;
+    ITEM_OFFSET_MAP newOffsets;
+    ITEM_OFFSET_MAP::iterator it, it_end;
 
-    for( it = m_items.begin(), it_end = m_items.end(); it != it_end; ++it )
+    for( it = m_itemOffsets.begin(), it_end = m_itemOffsets.end(); it != it_end; ++it )
     {
-        VERTEX_ITEM* item = *it;
-        int itemOffset    = item->GetOffset();
-        int itemSize      = item->GetSize();
+        VERTEX_ITEM* item = it->second;
+        unsigned int itemOffset = it->first;
+        unsigned int itemSize   = item->GetSize();
 
-        // Move an item to the new container
-        memcpy( &aTarget[newOffset], &m_vertices[itemOffset], itemSize * VertexSize );
+        // Move an item to the new place
+        if( aTarget != m_vertices || itemOffset != newOffset )
+            memmove( &aTarget[newOffset], &m_vertices[itemOffset], itemSize * VertexSize );
 
         // Update new offset
         item->setOffset( newOffset );
+        newOffsets.insert( newOffsets.end(), std::make_pair( newOffset, item ) );
 
         // Move to the next free space
         newOffset += itemSize;
     }
 
-    free( m_vertices );
-    m_vertices = aTarget;
+    m_itemOffsets.swap( newOffsets );
+
+    if( aTarget != m_vertices )
+    {
+        free( m_vertices );
+        m_vertices = aTarget;
+    }
+
+    // Space reserved for the current item, but not used yet, is released as well
+    m_chunkSize = m_itemSize;
 
     // Now there is only one big chunk of free memory
     m_freeChunks.clear();
-    wxASSERT( m_freeSpace > 0 );
-    m_freeChunks.insert( CHUNK( m_freeSpace, m_currentSize - m_freeSpace ) );
+    m_freeChunkOffsets.clear();
+    m_freeSpace = 0;
+
+    if( newOffset < m_currentSize )
+        addFreeChunk( newOffset, m_currentSize - newOffset );
+
+    ++m_stats.defragmentations;
 
 #if CACHED_CONTAINER_TEST > 0
     prof_end( &totalTime );
@@ -359,63 +376,50 @@ bool CACHED_CONTAINER::defragment( VERTEX* aTarget )
 }
 
 
-void CACHED_CONTAINER::mergeFreeChunks()
+void CACHED_CONTAINER::compact( unsigned int aMaxVertices )
 {
-    if( m_freeChunks.size() <= 1 ) // There are no chunks that can be merged
-        return;
+    // Number of free chunks checked when looking for a place before an item
+    const int MAX_CANDIDATES = 16;
 
-#if CACHED_CONTAINER_TEST > 0
-    prof_counter totalTime;
-    prof_start( &totalTime, false );
-#endif
-
-    // Reversed free chunks map - this one stores chunk size with its offset as the key
-    std::list<CHUNK> freeChunks;
+    unsigned int moved = 0;
 
-    FREE_CHUNK_MAP::const_iterator it, it_end;
-
-    for( it = m_freeChunks.begin(), it_end = m_freeChunks.end(); it != it_end; ++it )
+    while( moved < aMaxVertices && !m_itemOffsets.empty() &&
+           GetFragmentation() > COMPACTION_THRESHOLD )
     {
-        freeChunks.push_back( std::make_pair( it->second, it->first ) );
-    }
+        // Take the last item in the container..
+        ITEM_OFFSET_MAP::iterator last = --m_itemOffsets.end();
+        unsigned int offset = last->first;
+        VERTEX_ITEM* item   = last->second;
+        unsigned int size   = item->GetSize();
 
-    m_freeChunks.clear();
-    freeChunks.sort();
+        wxASSERT( size > 0 );
 
-    std::list<CHUNK>::const_iterator itf, itf_end;
-    unsigned int offset = freeChunks.front().first;
-    unsigned int size   = freeChunks.front().second;
-    freeChunks.pop_front();
+        // ..and look for a free chunk placed before it that is able to store the item
+        FREE_CHUNK_SET::iterator chunk = m_freeChunks.lower_bound( CHUNK( size, 0 ) );
 
-    for( itf = freeChunks.begin(), itf_end = freeChunks.end(); itf != itf_end; ++itf )
-    {
-        if( itf->first == offset + size )
-        {
-            // These chunks can be merged, so just increase the current chunk size and go on
-            size += itf->second;
-        }
-        else
-        {
-            // These chunks cannot be merged
-            // So store the previous one
-            m_freeChunks.insert( std::make_pair( size, offset ) );
-            // and let's check the next chunk
-            offset = itf->first;
-            size   = itf->second;
+        for( int i = 0; i < MAX_CANDIDATES && chunk != m_freeChunks.end()
+                        && getChunkOffset( *chunk ) > offset; ++i )
+            ++chunk;
 
-        }
-    }
+        if( chunk == m_freeChunks.end() || getChunkOffset( *chunk ) > offset )
+            break;
 
-    // Add the last one
-    m_freeChunks.insert( std::make_pair( size, offset ) );
+        unsigned int newOffset = takeFreeChunk( chunk, size );
+        memcpy( &m_vertices[newOffset], &m_vertices[offset], size * VertexSize );
 
-#if CACHED_CONTAINER_TEST > 0
-    prof_end( &totalTime );
+        m_itemOffsets.erase( last );
+        addFreeChunk( offset, size );
 
-    wxLogDebug( wxT( "Merged free chunks / %.1f ms" ), (double) totalTime.value / 1000.0 );
-#endif
+        m_itemOffsets[newOffset] = item;
+        item->setOffset( newOffset );
 
-    test();
+        moved += size;
+        ++m_stats.compactedItems;
+        m_stats.compactedVertices += size;
+    }
+
+    if( moved > 0 )
+        m_dirty = true;
 }
 
 
@@ -436,7 +440,10 @@ bool CACHED_CONTAINER::resizeContainer( unsigned int aNewSize )
         if( reservedSpace() > aNewSize )
             return false;
 
-        newContainer = static_cast<VERTEX*>( malloc( aNewSize * sizeof( VERTEX ) ) );
+        // Move all the data to the beginning, so the end of the container may be released
+        defragment();
+
+        newContainer = static_cast<VERTEX*>( realloc( m_vertices, aNewSize * sizeof( VERTEX ) ) );
 
         if( newContainer == NULL )
         {
@@ -444,13 +451,14 @@ bool CACHED_CONTAINER::resizeContainer( unsigned int aNewSize )
             return false;
         }
 
-        // Defragment directly to the new, smaller container
-        defragment( newContainer );
+        // We have to correct free chunks after defragmentation
+        unsigned int used = reservedSpace();
 
-        // We have to correct freeChunks after defragmentation
         m_freeChunks.clear();
-        wxASSERT( aNewSize - reservedSpace() > 0 );
-        m_freeChunks.insert( CHUNK( aNewSize - reservedSpace(), reservedSpace() ) );
+        m_freeChunkOffsets.clear();
+        m_freeSpace = 0;
+        wxASSERT( aNewSize - used > 0 );
+        addFreeChunk( used, aNewSize - used );
     }
     else
     {
@@ -464,18 +472,73 @@ bool CACHED_CONTAINER::resizeContainer( unsigned int aNewSize )
         }
 
         // Add an entry for the new memory chunk at the end of the container
-        m_freeChunks.insert( CHUNK( aNewSize - m_currentSize, m_currentSize ) );
+        addFreeChunk( m_currentSize, aNewSize - m_currentSize );
     }
 
     m_vertices = newContainer;
-
-    m_freeSpace   += ( aNewSize - m_currentSize );
     m_currentSize = aNewSize;
+    ++m_stats.resizes;
 
     return true;
 }
 
 
+void CACHED_CONTAINER::addFreeChunk( unsigned int aOffset, unsigned int aSize )
+{
+    wxASSERT( aSize > 0 );
+
+    m_freeSpace += aSize;
+
+    // Merge with the following chunk
+    FREE_CHUNK_MAP::iterator next = m_freeChunkOffsets.find( aOffset + aSize );
+
+    if( next != m_freeChunkOffsets.end() )
+    {
+        aSize += next->second;
+        m_freeChunks.erase( CHUNK( next->second, next->first ) );
+        m_freeChunkOffsets.erase( next );
+    }
+
+    // Merge with the preceding chunk
+    FREE_CHUNK_MAP::iterator prev = m_freeChunkOffsets.lower_bound( aOffset );
+
+    if( prev != m_freeChunkOffsets.begin() )
+    {
+        --prev;
+
+        if( prev->first + prev->second == aOffset )
+        {
+            aOffset = prev->first;
+            aSize += prev->second;
+            m_freeChunks.erase( CHUNK( prev->second, prev->first ) );
+            m_freeChunkOffsets.erase( prev );
+        }
+    }
+
+    m_freeChunks.insert( CHUNK( aSize, aOffset ) );
+    m_freeChunkOffsets[aOffset] = aSize;
+}
+
+
+unsigned int CACHED_CONTAINER::takeFreeChunk( FREE_CHUNK_SET::iterator aChunk, unsigned int aSize )
+{
+    unsigned int chunkSize   = getChunkSize( *aChunk );
+    unsigned int chunkOffset = getChunkOffset( *aChunk );
+
+    wxASSERT( chunkSize >= aSize );
+
+    m_freeChunks.erase( aChunk );
+    m_freeChunkOffsets.erase( chunkOffset );
+    m_freeSpace -= chunkSize;
+
+    // If there is some space left, return it to the pool
+    if( chunkSize > aSize )
+        addFreeChunk( chunkOffset + aSize, chunkSize - aSize );
+
+    return chunkOffset;
+}
+
+
 unsigned int CACHED_CONTAINER::getPowerOf2( unsigned int aNumber ) const
 {
     unsigned int power = 1;
@@ -490,14 +553,14 @@ unsigned int CACHED_CONTAINER::getPowerOf2( unsigned int aNumber ) const
 #ifdef CACHED_CONTAINER_TEST
 void CACHED_CONTAINER::showFreeChunks()
 {
-    FreeChunkMap::iterator it;
+    FREE_CHUNK_MAP::iterator it;
 
     wxLogDebug( wxT( "Free chunks:" ) );
 
-    for( it = m_freeChunks.begin(); it != m_freeChunks.end(); ++it )
+    for( it = m_freeChunkOffsets.begin(); it != m_freeChunkOffsets.end(); ++it )
     {
-        unsigned int offset = getChunkOffset( *it );
-        unsigned int size   = getChunkSize( *it );
+        unsigned int offset = it->first;
+        unsigned int size   = it->second;
         wxASSERT( size > 0 );
 
         wxLogDebug( wxT( "[0x%08x-0x%08x] (size %d)" ),
@@ -508,13 +571,13 @@ void CACHED_CONTAINER::showFreeChunks()
 
 void CACHED_CONTAINER::showReservedChunks()
 {
-    Items::iterator it;
+    ITEM_OFFSET_MAP::iterator it;
 
     wxLogDebug( wxT( "Reserved chunks:" ) );
 
-    for( it = m_items.begin(); it != m_items.end(); ++it )
+    for( it = m_itemOffsets.begin(); it != m_itemOffsets.end(); ++it )
     {
-        VERTEX_ITEM* item   = *it;
+        VERTEX_ITEM* item   = it->second;
         unsigned int offset = item->GetOffset();
         unsigned int size   = item->GetSize();
         wxASSERT( size > 0 );
@@ -529,21 +592,26 @@ void CACHED_CONTAINER::test()
 {
     // Free space check
     unsigned int freeSpace = 0;
-    FreeChunkMap::iterator itf;
+    FREE_CHUNK_MAP::iterator itf;
+    unsigned int lastEnd = UINT_MAX;
 
-    for( itf = m_freeChunks.begin(); itf != m_freeChunks.end(); ++itf )
-        freeSpace += getChunkSize( *itf );
+    for( itf = m_freeChunkOffsets.begin(); itf != m_freeChunkOffsets.end(); ++itf )
+    {
+        freeSpace += itf->second;
+
+        // Neighbouring free chunks should have been merged
+        wxASSERT( itf->first != lastEnd );
+        lastEnd = itf->first + itf->second;
+    }
 
     wxASSERT( freeSpace == m_freeSpace );
+    wxASSERT( m_freeChunks.size() == m_freeChunkOffsets.size() );
 
-    // Reserved space check
-    /*unsigned int reservedSpace = 0;
-    Items::iterator itr;
-    for( itr = m_items.begin(); itr != m_items.end(); ++itr )
-        reservedSpace += ( *itr )->GetSize();
-    reservedSpace += m_itemSize;    // Add the current chunk size
+    // Offsets check
+    ITEM_OFFSET_MAP::iterator iti;
 
-    wxASSERT( ( freeSpace + reservedSpace ) == m_currentSize );*/
+    for( iti = m_itemOffsets.begin(); iti != m_itemOffsets.end(); ++iti )
+        wxASSERT( iti->second->GetOffset() == iti->first );
 
     // Overlapping check TBD
 }
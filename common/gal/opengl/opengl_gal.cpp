@@ -68,6 +68,7 @@ OPENGL_GAL::OPENGL_GAL( wxWindow* aParent, wxEvtHandler* aMouseListener,
     isFramebufferInitialized = false;
     isShaderInitialized      = false;
     isGrouping               = false;
+    isClipping               = false;
     groupCounter             = 0;
 
     // Connecting the event handlers
@@ -223,6 +224,10 @@ void OPENGL_GAL::BeginDrawing()
 
 void OPENGL_GAL::EndDrawing()
 {
+    // Items are rendered only now, so this is the moment when the clip area is applied
+    if( isClipping )
+        setScissor( true );
+
     // Cached & non-cached containers are rendered to the same buffer
     compositor.SetBuffer( mainBuffer );
     nonCachedManager.EndDrawing();
@@ -232,6 +237,12 @@ void OPENGL_GAL::EndDrawing()
     compositor.SetBuffer( overlayBuffer );
     overlayManager.EndDrawing();
 
+    if( isClipping )
+    {
+        setScissor( false );
+        isClipping = false;
+    }
+
     // Be sure that the framebuffer is not colorized (happens on specific GPU&drivers combinations)
     glColor4d( 1.0, 1.0, 1.0, 1.0 );
 
@@ -528,6 +539,30 @@ void OPENGL_GAL::DrawPolygon( const std::deque<VECTOR2D>& aPointList )
 }
 
 
+void OPENGL_GAL::DrawTriangles( const std::vector<VECTOR2D>& aTriangles )
+{
+    wxASSERT( aTriangles.size() % 3 == 0 );
+
+    if( aTriangles.empty() )
+        return;
+
+    currentManager->Shader( SHADER_NONE );
+    currentManager->Color( fillColor.r, fillColor.g, fillColor.b, fillColor.a );
+
+    // Triangles do not need tesselation, so all the vertices are added at once
+    std::vector<VERTEX> vertices( aTriangles.size() );
+
+    for( unsigned int i = 0; i < aTriangles.size(); ++i )
+    {
+        vertices[i].x = aTriangles[i].x;
+        vertices[i].y = aTriangles[i].y;
+        vertices[i].z = layerDepth;
+    }
+
+    currentManager->Vertices( &vertices[0], vertices.size() );
+}
+
+
 void OPENGL_GAL::DrawCurve( const VECTOR2D& aStartPoint, const VECTOR2D& aControlPointA,
                             const VECTOR2D& aControlPointB, const VECTOR2D& aEndPoint )
 {
@@ -666,7 +701,20 @@ void OPENGL_GAL::EndGroup()
 
 void OPENGL_GAL::DrawGroup( int aGroupNumber )
 {
-    cachedManager.DrawItem( *groups[aGroupNumber] );
+    const VERTEX_ITEM& item = *groups[aGroupNumber];
+
+    if( !currentManager->IsTransformed() )
+    {
+        cachedManager.DrawItem( item );
+        return;
+    }
+
+    // Cached vertices are drawn as they are stored, so a transformed group (an instance of
+    // a shape drawn in many places) is copied to a buffer refilled every frame
+    VERTEX_MANAGER& target = ( currentManager == &overlayManager ) ? overlayManager
+                                                                   : nonCachedManager;
+
+    target.PutItem( cachedManager, item, currentManager->GetTransformation() );
 }
 
 
@@ -755,13 +803,47 @@ void OPENGL_GAL::ClearTarget( RENDER_TARGET aTarget )
         break;
     }
 
+    if( isClipping )
+        setScissor( true );
+
     compositor.ClearBuffer();
 
+    if( isClipping )
+        setScissor( false );
+
     // Restore the previous state
     compositor.SetBuffer( oldTarget );
 }
 
 
+void OPENGL_GAL::SetClipArea( const BOX2D& aArea )
+{
+    clipArea = computeScreenArea( aArea );
+    isClipping = true;
+}
+
+
+void OPENGL_GAL::ResetClipArea()
+{
+    isClipping = false;
+}
+
+
+void OPENGL_GAL::setScissor( bool aEnable )
+{
+    if( aEnable )
+    {
+        // The projection maps screen coordinates directly to the framebuffer coordinates
+        glEnable( GL_SCISSOR_TEST );
+        glScissor( clipArea.GetX(), clipArea.GetY(), clipArea.GetWidth(), clipArea.GetHeight() );
+    }
+    else
+    {
+        glDisable( GL_SCISSOR_TEST );
+    }
+}
+
+
 void OPENGL_GAL::DrawCursor( const VECTOR2D& aCursorPosition )
 {
     // Now we should only store the position of the mouse cursor
@@ -147,6 +147,55 @@ VERTEX* VERTEX_MANAGER::GetVertices( const VERTEX_ITEM& aItem ) const
 }
 
 
+void VERTEX_MANAGER::PutItem( const VERTEX_MANAGER& aSource, const VERTEX_ITEM& aItem,
+                              const glm::mat4& aTransform ) const
+{
+    unsigned int size = aItem.GetSize();
+
+    if( size == 0 )
+        return;
+
+    const VERTEX* source = aSource.GetVertices( aItem );
+    VERTEX* target = m_container->Allocate( size );
+
+    if( target == NULL )
+    {
+        DisplayError( NULL, wxT( "Vertex allocation error" ) );
+        return;
+    }
+
+    // Widths and radii stored as shader parameters follow the (uniform) scale of the transform
+    GLfloat scale = glm::length( aTransform * glm::vec4( 1.0f, 0.0f, 0.0f, 0.0f ) );
+
+    for( unsigned int i = 0; i < size; ++i )
+    {
+        target[i] = source[i];
+
+        // Depth is kept, as it identifies the layer
+        glm::vec4 position = aTransform * glm::vec4( source[i].x, source[i].y, 0.0f, 1.0f );
+
+        target[i].x = position.x;
+        target[i].y = position.y;
+
+        // Line vertices store the line width vector, which is rotated and scaled but not translated
+        if( source[i].shader[0] == SHADER_LINE )
+        {
+            glm::vec4 width = aTransform * glm::vec4( source[i].shader[1], source[i].shader[2],
+                                                      0.0f, 0.0f );
+
+            target[i].shader[1] = width.x;
+            target[i].shader[2] = width.y;
+            target[i].shader[3] *= scale;
+        }
+        else if( source[i].shader[0] == SHADER_STROKED_CIRCLE )
+        {
+            target[i].shader[2] *= scale;
+            target[i].shader[3] *= scale;
+        }
+    }
+}
+
+
 void VERTEX_MANAGER::SetShader( SHADER& aShader ) const
 {
     m_gpu->SetShader( aShader );
@@ -30,11 +30,16 @@
 #include <gal/graphics_abstraction_layer.h>
 #include <wx/string.h>
 
+#include <cmath>
+
 using namespace KIGFX;
 
 const double STROKE_FONT::OVERBAR_HEIGHT = 0.45;
 const double STROKE_FONT::BOLD_FACTOR = 1.3;
 const double STROKE_FONT::HERSHEY_SCALE = 1.0 / 21.0;
+const double STROKE_FONT::LOD_HIDE_SIZE = 1.0;
+const double STROKE_FONT::LOD_BOX_SIZE = 4.0;
+const unsigned int STROKE_FONT::LINE_CACHE_SIZE = 4096;
 
 STROKE_FONT::STROKE_FONT( GAL* aGal ) :
     m_gal( aGal ),
@@ -54,6 +59,7 @@ bool STROKE_FONT::LoadNewStrokeFont( const char* const aNewStrokeFont[], int aNe
 {
     m_glyphs.clear();
     m_glyphBoundingBoxes.clear();
+    m_lineCache.clear();
     m_glyphs.resize( aNewStrokeFontSize );
     m_glyphBoundingBoxes.resize( aNewStrokeFontSize );
 
@@ -154,6 +160,20 @@ void STROKE_FONT::Draw( const UTF8& aText, const VECTOR2D& aPosition, double aRo
     if( aText.empty() )
         return;
 
+    // Level of details: texts too small to be read are drawn as boxes or not drawn at all.
+    // Cached items may be displayed at any zoom level, so they are always drawn in full.
+    bool asBox = false;
+
+    if( !m_gal->IsGrouping() )
+    {
+        double pixelSize = std::fabs( m_glyphSize.y ) * m_gal->GetWorldScale();
+
+        if( pixelSize < LOD_HIDE_SIZE )
+            return;
+
+        asBox = pixelSize < LOD_BOX_SIZE;
+    }
+
     // Context needs to be saved before any transformations
     m_gal->Save();
 
@@ -213,7 +233,7 @@ void STROKE_FONT::Draw( const UTF8& aText, const VECTOR2D& aPosition, double aRo
     {
         size_t length = newlinePos - begin;
 
-        drawSingleLineText( aText.substr( begin, length ) );
+        drawSingleLineText( aText.substr( begin, length ), asBox );
         m_gal->Translate( VECTOR2D( 0.0, lineHeight ) );
 
         begin = newlinePos + 1;
@@ -222,22 +242,26 @@ void STROKE_FONT::Draw( const UTF8& aText, const VECTOR2D& aPosition, double aRo
 
     // Draw the last (or the only one) line
     if( !aText.empty() )
-        drawSingleLineText( aText.substr( begin ) );
+        drawSingleLineText( aText.substr( begin ), asBox );
 
     m_gal->Restore();
 }
 
 
-void STROKE_FONT::drawSingleLineText( const UTF8& aText )
+void STROKE_FONT::drawSingleLineText( const UTF8& aText, bool aAsBox )
 {
-    // By default the overbar is turned off
-    m_overbar = false;
+    LINE_STROKES* line = NULL;
+    double textWidth;
 
-    double      xOffset;
-    VECTOR2D    glyphSize( m_glyphSize );
-
-    // Compute the text size
-    VECTOR2D textSize = computeTextSize( aText );
+    if( aAsBox )
+    {
+        textWidth = computeTextSize( aText ).x;
+    }
+    else
+    {
+        line = &getLineStrokes( aText );
+        textWidth = line->width;
+    }
 
     m_gal->Save();
 
@@ -245,29 +269,100 @@ void STROKE_FONT::drawSingleLineText( const UTF8& aText )
     switch( m_horizontalJustify )
     {
     case GR_TEXT_HJUSTIFY_CENTER:
-        m_gal->Translate( VECTOR2D( -textSize.x / 2.0, 0 ) );
+        m_gal->Translate( VECTOR2D( -textWidth / 2.0, 0 ) );
         break;
 
     case GR_TEXT_HJUSTIFY_RIGHT:
         if( !m_mirrored )
-            m_gal->Translate( VECTOR2D( -textSize.x, 0 ) );
+            m_gal->Translate( VECTOR2D( -textWidth, 0 ) );
         break;
 
     case GR_TEXT_HJUSTIFY_LEFT:
         if( m_mirrored )
-            m_gal->Translate( VECTOR2D( -textSize.x, 0 ) );
+            m_gal->Translate( VECTOR2D( -textWidth, 0 ) );
         break;
 
     default:
         break;
     }
 
+    if( aAsBox )
+    {
+        m_gal->DrawRectangle( VECTOR2D( 0.0, 0.0 ), VECTOR2D( textWidth, -m_glyphSize.y ) );
+    }
+    else
+    {
+        for( GLYPH::iterator it = line->strokes.begin(); it != line->strokes.end(); ++it )
+            m_gal->DrawPolyline( *it );
+    }
+
+    m_gal->Restore();
+}
+
+
+bool STROKE_FONT::LINE_KEY::operator<( const LINE_KEY& aOther ) const
+{
+    if( glyphSize.x != aOther.glyphSize.x )
+        return glyphSize.x < aOther.glyphSize.x;
+
+    if( glyphSize.y != aOther.glyphSize.y )
+        return glyphSize.y < aOther.glyphSize.y;
+
+    if( interline != aOther.interline )
+        return interline < aOther.interline;
+
+    if( italic != aOther.italic )
+        return italic < aOther.italic;
+
+    if( mirrored != aOther.mirrored )
+        return mirrored < aOther.mirrored;
+
+    return text < aOther.text;
+}
+
+
+STROKE_FONT::LINE_STROKES& STROKE_FONT::getLineStrokes( const UTF8& aText )
+{
+    LINE_KEY key;
+    key.text        = aText;
+    key.glyphSize   = m_glyphSize;
+    key.interline   = getInterline();
+    key.italic      = m_italic;
+    key.mirrored    = m_mirrored;
+
+    LINE_CACHE::iterator it = m_lineCache.find( key );
+
+    if( it != m_lineCache.end() )
+        return it->second;
+
+    // Drop everything when the cache is full, texts displayed at the moment
+    // will be converted again during the next redraw
+    if( m_lineCache.size() >= LINE_CACHE_SIZE )
+        m_lineCache.clear();
+
+    LINE_STROKES& line = m_lineCache[key];
+    layoutLine( aText, line );
+
+    return line;
+}
+
+
+void STROKE_FONT::layoutLine( const UTF8& aText, LINE_STROKES& aLine )
+{
+    // By default the overbar is turned off
+    m_overbar = false;
+
+    double      xOffset;
+    VECTOR2D    glyphSize( m_glyphSize );
+
+    aLine.width = computeTextSize( aText ).x;
+
     if( m_mirrored )
     {
         // In case of mirrored text invert the X scale of points and their X direction
         // (m_glyphSize.x) and start drawing from the position where text normally should end
         // (textSize.x)
-        xOffset = textSize.x;
+        xOffset = aLine.width;
         glyphSize.x = -m_glyphSize.x;
     }
     else
@@ -294,24 +389,26 @@ void STROKE_FONT::drawSingleLineText( const UTF8& aText )
         if( dd >= (int) m_glyphBoundingBoxes.size() || dd < 0 )
             dd = '?' - ' ';
 
-        GLYPH& glyph = m_glyphs[dd];
-        BOX2D& bbox  = m_glyphBoundingBoxes[dd];
+        const GLYPH& glyph = m_glyphs[dd];
+        const BOX2D& bbox  = m_glyphBoundingBoxes[dd];
 
         if( m_overbar )
         {
-            VECTOR2D startOverbar( xOffset, -getInterline() * OVERBAR_HEIGHT );
-            VECTOR2D endOverbar( xOffset + glyphSize.x * bbox.GetEnd().x,
-                                 -getInterline() * OVERBAR_HEIGHT );
+            std::deque<VECTOR2D> overbar;
+            overbar.push_back( VECTOR2D( xOffset, -getInterline() * OVERBAR_HEIGHT ) );
+            overbar.push_back( VECTOR2D( xOffset + glyphSize.x * bbox.GetEnd().x,
+                                         -getInterline() * OVERBAR_HEIGHT ) );
 
-            m_gal->DrawLine( startOverbar, endOverbar );
+            aLine.strokes.push_back( overbar );
         }
 
-        for( GLYPH::iterator pointListIt = glyph.begin(); pointListIt != glyph.end();
+        for( GLYPH::const_iterator pointListIt = glyph.begin(); pointListIt != glyph.end();
              ++pointListIt )
         {
-            std::deque<VECTOR2D> pointListScaled;
+            aLine.strokes.push_back( std::deque<VECTOR2D>() );
+            std::deque<VECTOR2D>& pointListScaled = aLine.strokes.back();
 
-            for( std::deque<VECTOR2D>::iterator pointIt = pointListIt->begin();
+            for( std::deque<VECTOR2D>::const_iterator pointIt = pointListIt->begin();
                  pointIt != pointListIt->end(); ++pointIt )
             {
                 VECTOR2D pointPos( pointIt->x * glyphSize.x + xOffset, pointIt->y * glyphSize.y );
@@ -328,14 +425,10 @@ void STROKE_FONT::drawSingleLineText( const UTF8& aText )
 
                 pointListScaled.push_back( pointPos );
             }
-
-            m_gal->DrawPolyline( pointListScaled );
         }
 
         xOffset += glyphSize.x * bbox.GetEnd().x;
     }
-
-    m_gal->Restore();
 }
 
 
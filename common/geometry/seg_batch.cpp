@@ -0,0 +1,172 @@
+/*
+ * This program source code file is part of KiCad, a free EDA CAD application.
+ *
+ * Copyright (C) 2014 KiCad Developers, see change_log.txt for contributors.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, you may find one here:
+ * http://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+ * or you may search the http://www.gnu.org website for the version 2 license,
+ * or you may write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+#include <algorithm>
+
+#include <geometry/seg_batch.h>
+#include <geometry/shape_line_chain.h>
+
+
+SEG_BATCH::SEG_BATCH( const SHAPE_LINE_CHAIN& aChain )
+{
+    Add( aChain );
+}
+
+
+void SEG_BATCH::Clear()
+{
+    m_ax.clear();
+    m_ay.clear();
+    m_bx.clear();
+    m_by.clear();
+    m_left.clear();
+    m_top.clear();
+    m_right.clear();
+    m_bottom.clear();
+}
+
+
+void SEG_BATCH::Reserve( int aCount )
+{
+    m_ax.reserve( aCount );
+    m_ay.reserve( aCount );
+    m_bx.reserve( aCount );
+    m_by.reserve( aCount );
+    m_left.reserve( aCount );
+    m_top.reserve( aCount );
+    m_right.reserve( aCount );
+    m_bottom.reserve( aCount );
+}
+
+
+void SEG_BATCH::Add( const SEG& aSeg )
+{
+    // same box as SHAPE_LINE_CHAIN::Collide() builds for each of its segments
+    const BOX2I box( aSeg.A, aSeg.B - aSeg.A );
+
+    m_ax.push_back( aSeg.A.x );
+    m_ay.push_back( aSeg.A.y );
+    m_bx.push_back( aSeg.B.x );
+    m_by.push_back( aSeg.B.y );
+    m_left.push_back( box.GetX() );
+    m_top.push_back( box.GetY() );
+    m_right.push_back( box.GetRight() );
+    m_bottom.push_back( box.GetBottom() );
+}
+
+
+void SEG_BATCH::Add( const SHAPE_LINE_CHAIN& aChain )
+{
+    Reserve( Size() + aChain.SegmentCount() );
+
+    for( int i = 0; i < aChain.SegmentCount(); i++ )
+        Add( aChain.CSegment( i ) );
+}
+
+
+int SEG_BATCH::filterBox( int aStart, int aCount, const BOX2I& aBox, ecoord aDistSq,
+                          unsigned char* aMask ) const
+{
+    const int* left   = &m_left[aStart];
+    const int* top    = &m_top[aStart];
+    const int* right  = &m_right[aStart];
+    const int* bottom = &m_bottom[aStart];
+    const ecoord boxLeft   = aBox.GetX();
+    const ecoord boxTop    = aBox.GetY();
+    const ecoord boxRight  = aBox.GetRight();
+    const ecoord boxBottom = aBox.GetBottom();
+    int count = 0;
+
+    // Same distance as aBox.SquaredDistance( segment box ), written branch-free on
+    // purpose: this loop is what gets vectorized.
+    for( int i = 0; i < aCount; i++ )
+    {
+        ecoord dx1 = boxLeft - right[i];
+        ecoord dx2 = left[i] - boxRight;
+        ecoord dy1 = boxTop - bottom[i];
+        ecoord dy2 = top[i] - boxBottom;
+        ecoord dx = dx1 > 0 ? dx1 : ( dx2 > 0 ? dx2 : 0 );
+        ecoord dy = dy1 > 0 ? dy1 : ( dy2 > 0 ? dy2 : 0 );
+        ecoord d = dx * dx + dy * dy;
+
+        aMask[i] = ( d < aDistSq );
+        count += aMask[i];
+    }
+
+    return count;
+}
+
+
+int SEG_BATCH::Collide( const SEG& aSeg, int aClearance ) const
+{
+    unsigned char mask[BlockSize];
+    const BOX2I box( aSeg.A, aSeg.B - aSeg.A );
+    ecoord dist_sq = (ecoord) aClearance * aClearance;
+    int n = Size();
+
+    for( int start = 0; start < n; start += BlockSize )
+    {
+        int count = std::min( (int) BlockSize, n - start );
+
+        if( !filterBox( start, count, box, dist_sq, mask ) )
+            continue;
+
+        for( int i = 0; i < count; i++ )
+        {
+            if( mask[i] && Segment( start + i ).Collide( aSeg, aClearance ) )
+                return start + i;
+        }
+    }
+
+    return -1;
+}
+
+
+int SEG_BATCH::CollideCircle( const VECTOR2I& aCenter, int aRadius ) const
+{
+    unsigned char mask[BlockSize];
+    const BOX2I box( aCenter, VECTOR2I( 0, 0 ) );
+    int n = Size();
+
+    // SEG::Distance() truncates the square root: it is <= aRadius as long as the squared
+    // distance is below ( aRadius + 1 )^2. The nearest point of a segment lies within its
+    // bounding box, so the box distance never exceeds the segment distance.
+    ecoord limit = (ecoord) aRadius + 1;
+    ecoord dist_sq = limit * limit;
+
+    for( int start = 0; start < n; start += BlockSize )
+    {
+        int count = std::min( (int) BlockSize, n - start );
+
+        if( !filterBox( start, count, box, dist_sq, mask ) )
+            continue;
+
+        for( int i = 0; i < count; i++ )
+        {
+            if( mask[i] && Segment( start + i ).Distance( aCenter ) <= aRadius )
+                return start + i;
+        }
+    }
+
+    return -1;
+}
@@ -0,0 +1,290 @@
+/*
+ * This program source code file is part of KiCad, a free EDA CAD application.
+ *
+ * Copyright (C) 2014 KiCad Developers, see change_log.txt for contributors.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, you may find one here:
+ * http://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+ * or you may search the http://www.gnu.org website for the version 2 license,
+ * or you may write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+/**
+ * @file profile_trace.cpp
+ * @brief Timers and counters for measuring performance.
+ */
+
+#include <profile_trace.h>
+
+#include <boost/thread/tss.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/atomic.hpp>
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+
+namespace
+{
+
+/// A single recorded event
+struct TRACE_EVENT
+{
+    const char* name;
+    uint64_t    start;          ///< Event start [us]
+    int64_t     value;          ///< Duration [us] or counter value
+    bool        counter;
+};
+
+
+/// Events recorded by a single thread
+struct THREAD_BUFFER
+{
+    ///> Number of events kept for every thread
+    static const unsigned int SIZE = 16384;
+
+    THREAD_BUFFER( unsigned int aThreadId ) :
+        threadId( aThreadId ), count( 0 )
+    {
+    }
+
+    /**
+     * Function Add
+     * stores an event, overwriting the oldest one if the buffer is full.
+     * Only the thread owning the buffer writes to it.
+     */
+    inline void Add( const TRACE_EVENT& aEvent )
+    {
+        unsigned int n = count.load( boost::memory_order_relaxed );
+        events[n % SIZE] = aEvent;
+        count.store( n + 1, boost::memory_order_release );
+    }
+
+    /**
+     * Function Get
+     * copies the stored events, starting with the oldest one. Events written while they are
+     * copied may be skipped or partially overwritten.
+     */
+    void Get( std::vector<TRACE_EVENT>& aEvents ) const
+    {
+        unsigned int n = count.load( boost::memory_order_acquire );
+        unsigned int first = n > SIZE ? n - SIZE : 0;
+
+        for( unsigned int i = first; i < n; ++i )
+            aEvents.push_back( events[i % SIZE] );
+    }
+
+    unsigned int                threadId;
+    boost::atomic<unsigned int> count;      ///< Number of events written so far
+    TRACE_EVENT                 events[SIZE];
+};
+
+
+/// Buffers are owned by the registry below, so they are not freed when a thread exits
+void keepBuffer( THREAD_BUFFER* )
+{
+}
+
+
+boost::thread_specific_ptr<THREAD_BUFFER> threadBuffer( keepBuffer );
+
+/// All the buffers that have been created
+std::vector<THREAD_BUFFER*> buffers;
+boost::mutex                buffersLock;
+
+
+THREAD_BUFFER* getThreadBuffer()
+{
+    THREAD_BUFFER* buffer = threadBuffer.get();
+
+    if( !buffer )
+    {
+        // Happens once per thread, so locking is not an issue
+        boost::mutex::scoped_lock lock( buffersLock );
+
+        buffer = new THREAD_BUFFER( buffers.size() + 1 );
+        buffers.push_back( buffer );
+        threadBuffer.reset( buffer );
+    }
+
+    return buffer;
+}
+
+} // namespace
+
+
+PROF_TRACE& PROF_TRACE::Instance()
+{
+    static PROF_TRACE instance;
+
+    return instance;
+}
+
+
+PROF_TRACE::PROF_TRACE() :
+    m_enabled( false ), m_overlay( false )
+{
+    const char* traceFile = getenv( "KICAD_PROFILE_TRACE" );
+    const char* overlay = getenv( "KICAD_PROFILE_OVERLAY" );
+
+    if( traceFile && *traceFile )
+    {
+        m_traceFile = traceFile;
+        m_enabled = true;
+    }
+
+    if( overlay && *overlay && strcmp( overlay, "0" ) != 0 )
+    {
+        m_overlay = true;
+        m_enabled = true;
+    }
+}
+
+
+PROF_TRACE::~PROF_TRACE()
+{
+    if( !m_traceFile.empty() )
+        ExportChromeTrace( m_traceFile );
+
+    // Other threads are gone at this point
+    for( unsigned int i = 0; i < buffers.size(); ++i )
+        delete buffers[i];
+
+    buffers.clear();
+}
+
+
+void PROF_TRACE::AddEvent( const char* aName, uint64_t aStart, uint64_t aEnd )
+{
+    TRACE_EVENT event = { aName, aStart, (int64_t) ( aEnd - aStart ), false };
+
+    getThreadBuffer()->Add( event );
+}
+
+
+void PROF_TRACE::AddCounter( const char* aName, int64_t aValue )
+{
+    TRACE_EVENT event = { aName, get_tics(), aValue, true };
+
+    getThreadBuffer()->Add( event );
+}
+
+
+void PROF_TRACE::GetSummary( std::vector<PROF_TRACE_SUMMARY>& aSummary ) const
+{
+    // The same name used in different files may be stored under different pointers
+    std::map<std::string, PROF_TRACE_SUMMARY> summary;
+    std::vector<TRACE_EVENT> events;
+
+    {
+        boost::mutex::scoped_lock lock( buffersLock );
+
+        for( unsigned int i = 0; i < buffers.size(); ++i )
+            buffers[i]->Get( events );
+    }
+
+    for( unsigned int i = 0; i < events.size(); ++i )
+    {
+        const TRACE_EVENT& event = events[i];
+        std::map<std::string, PROF_TRACE_SUMMARY>::iterator it = summary.find( event.name );
+
+        if( it == summary.end() )
+        {
+            PROF_TRACE_SUMMARY entry;
+            entry.name    = event.name;
+            entry.counter = event.counter;
+            entry.count   = 0;
+            entry.last    = 0;
+            entry.max     = event.value;
+            entry.total   = 0;
+
+            it = summary.insert( std::make_pair( entry.name, entry ) ).first;
+        }
+
+        PROF_TRACE_SUMMARY& entry = it->second;
+        entry.count++;
+        entry.last = event.value;
+        entry.total += event.value;
+
+        if( event.value > entry.max )
+            entry.max = event.value;
+    }
+
+    aSummary.clear();
+
+    for( std::map<std::string, PROF_TRACE_SUMMARY>::const_iterator it = summary.begin();
+         it != summary.end(); ++it )
+    {
+        aSummary.push_back( it->second );
+    }
+}
+
+
+bool PROF_TRACE::ExportChromeTrace( const std::string& aFileName ) const
+{
+    FILE* file = fopen( aFileName.c_str(), "wt" );
+
+    if( !file )
+        return false;
+
+    boost::mutex::scoped_lock lock( buffersLock );
+
+    fprintf( file, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[" );
+
+    const char* separator = "\n";
+    std::vector<TRACE_EVENT> events;
+
+    for( unsigned int i = 0; i < buffers.size(); ++i )
+    {
+        events.clear();
+        buffers[i]->Get( events );
+
+        for( unsigned int j = 0; j < events.size(); ++j )
+        {
+            const TRACE_EVENT& event = events[j];
+
+            if( event.counter )
+            {
+                fprintf( file, "%s{\"name\":\"%s\",\"ph\":\"C\",\"ts\":%llu,\"pid\":1,"
+                         "\"tid\":%u,\"args\":{\"value\":%lld}}",
+                         separator, event.name, (unsigned long long) event.start,
+                         buffers[i]->threadId, (long long) event.value );
+            }
+            else
+            {
+                fprintf( file, "%s{\"name\":\"%s\",\"ph\":\"X\",\"ts\":%llu,\"dur\":%lld,"
+                         "\"pid\":1,\"tid\":%u}",
+                         separator, event.name, (unsigned long long) event.start,
+                         (long long) event.value, buffers[i]->threadId );
+            }
+
+            separator = ",\n";
+        }
+    }
+
+    fprintf( file, "\n]}\n" );
+
+    return fclose( file ) == 0;
+}
+
+
+void PROF_TRACE::Clear()
+{
+    boost::mutex::scoped_lock lock( buffersLock );
+
+    for( unsigned int i = 0; i < buffers.size(); ++i )
+        buffers[i]->count.store( 0 );
+}
@@ -197,7 +197,9 @@ char* GetLine( FILE* File, char* Line, int* LineNum, int SizeLine )
 
     } while( Line[0] == '#' || Line[0] == '\n' ||  Line[0] == '\r' || Line[0] == 0 );
 
-    strtok( Line, "\n\r" );
+    // Strip the end of line by hand: strtok() is not reentrant, and the libraries are
+    // loaded on several threads.
+    Line[ strcspn( Line, "\n\r" ) ] = 0;
     return Line;
 }
 
@@ -23,6 +23,12 @@
  */
 
 #include <boost/foreach.hpp>
+#include <boost/thread.hpp>
+#include <boost/lockfree/queue.hpp>
+#include <algorithm>
+#include <cmath>
+
+#include <wx/stopwatch.h>
 
 #include <base_struct.h>
 #include <layers_id_colors_and_visibility.h>
@@ -37,15 +43,125 @@
 #ifdef PROFILE
 #include <profile.h>
 #endif /* PROFILE  */
+#include <profile_trace.h>
 
 using namespace KIGFX;
 
+const double VIEW::INSTANCE_LOD_SIZE = 1.5;
+const int VIEW::RECACHE_TIME_LIMIT = 20;
+
+
+/**
+ * Struct VIEW::JOB_QUEUE
+ * runs VIEW_ITEM_JOBs on a worker thread. Submitted jobs wait under a mutex, the finished ones
+ * are handed back to the UI thread through a lock-free queue, that is polled every frame.
+ */
+struct VIEW::JOB_QUEUE
+{
+    JOB_QUEUE() :
+        m_finished( 256 ),
+        m_stop( false ),
+        m_thread( &JOB_QUEUE::run, this )
+    {
+    }
+
+    ~JOB_QUEUE()
+    {
+        {
+            boost::mutex::scoped_lock lock( m_mutex );
+            m_stop = true;
+        }
+
+        m_wakeUp.notify_one();
+        m_thread.join();
+
+        BOOST_FOREACH( VIEW_ITEM_JOB* job, m_waiting )
+            discard( job );
+
+        VIEW_ITEM_JOB* job;
+
+        while( m_finished.pop( job ) )
+            discard( job );
+    }
+
+    void Add( VIEW_ITEM_JOB* aJob )
+    {
+        {
+            boost::mutex::scoped_lock lock( m_mutex );
+            m_waiting.push_back( aJob );
+        }
+
+        m_wakeUp.notify_one();
+    }
+
+    bool PopFinished( VIEW_ITEM_JOB*& aJob )
+    {
+        return m_finished.pop( aJob );
+    }
+
+private:
+    static void discard( VIEW_ITEM_JOB* aJob )
+    {
+        // The item must not keep a pointer to the deleted job
+        if( aJob->m_item )
+            aJob->m_item->m_job = NULL;
+
+        delete aJob;
+    }
+
+    void run()
+    {
+        std::vector<VIEW_ITEM_JOB*> jobs;
+
+        for( ;; )
+        {
+            {
+                boost::mutex::scoped_lock lock( m_mutex );
+
+                while( m_waiting.empty() && !m_stop )
+                    m_wakeUp.wait( lock );
+
+                if( m_stop )
+                    return;
+
+                jobs.swap( m_waiting );
+            }
+
+            int count = jobs.size();
+            int i;
+
+#ifdef USE_OPENMP
+            #pragma omp parallel for schedule( dynamic, 1 ) private( i )
+#endif /* USE_OPENMP */
+            for( i = 0; i < count; ++i )
+            {
+                jobs[i]->Run();
+
+                // The queue allocates more nodes if it is full, so a job is never lost
+                m_finished.push( jobs[i] );
+            }
+
+            jobs.clear();
+        }
+    }
+
+    std::vector<VIEW_ITEM_JOB*>             m_waiting;
+    boost::lockfree::queue<VIEW_ITEM_JOB*>  m_finished;
+    boost::mutex                            m_mutex;
+    boost::condition_variable               m_wakeUp;
+    bool                                    m_stop;
+    boost::thread                           m_thread;
+};
+
+
 VIEW::VIEW( bool aIsDynamic ) :
     m_enableOrderModifier( true ),
     m_scale( 1.0 ),
     m_painter( NULL ),
     m_gal( NULL ),
-    m_dynamic( aIsDynamic )
+    m_dynamic( aIsDynamic ),
+    m_jobQueue( NULL ),
+    m_runningJobs( 0 )
 {
     m_needsUpdate.reserve( 32768 );
 
@@ -63,6 +179,8 @@ VIEW::VIEW( bool aIsDynamic ) :
 
 VIEW::~VIEW()
 {
+    delete m_jobQueue;
+
     BOOST_FOREACH( LAYER_MAP::value_type& l, m_layers )
         delete l.second.items;
 }
@@ -91,12 +209,13 @@ void VIEW::Add( VIEW_ITEM* aItem )
 
     aItem->ViewGetLayers( layers, layers_count );
     aItem->saveLayers( layers, layers_count );
+    aItem->m_viewBBox = aItem->ViewBBox();
 
     for( int i = 0; i < layers_count; ++i )
     {
         VIEW_LAYER& l = m_layers[layers[i]];
         l.items->Insert( aItem );
-        MarkTargetDirty( l.target );
+        markTargetDirty( l.target, aItem->m_viewBBox );
     }
 
     if( m_dynamic )
@@ -107,6 +226,45 @@ void VIEW::Add( VIEW_ITEM* aItem )
 }
 
 
+void VIEW::AddItems( const std::vector<VIEW_ITEM*>& aItems )
+{
+    boost::unordered_map<int, std::vector<VIEW_ITEM*> > layerItems;
+    int layers[VIEW_MAX_LAYERS], layers_count;
+
+    for( unsigned i = 0; i < aItems.size(); ++i )
+    {
+        VIEW_ITEM* item = aItems[i];
+
+        item->ViewGetLayers( layers, layers_count );
+        item->saveLayers( layers, layers_count );
+        item->m_viewBBox = item->ViewBBox();
+
+        for( int j = 0; j < layers_count; ++j )
+            layerItems[layers[j]].push_back( item );
+    }
+
+    boost::unordered_map<int, std::vector<VIEW_ITEM*> >::const_iterator it;
+
+    for( it = layerItems.begin(); it != layerItems.end(); ++it )
+    {
+        VIEW_LAYER& l = m_layers[it->first];
+        l.items->Insert( it->second );
+        MarkTargetDirty( l.target );
+    }
+
+    for( unsigned i = 0; i < aItems.size(); ++i )
+    {
+        VIEW_ITEM* item = aItems[i];
+
+        if( m_dynamic )
+            item->viewAssign( this );
+
+        if( item->viewRequiredUpdate() != VIEW_ITEM::NONE )
+            MarkForUpdate( item );
+    }
+}
+
+
 void VIEW::Remove( VIEW_ITEM* aItem )
 {
     if( m_dynamic )
@@ -121,6 +279,19 @@ void VIEW::Remove( VIEW_ITEM* aItem )
             m_needsUpdate.erase( item );
     }
 
+    cancelJob( aItem );
+
+    // The last queued item takes the place of the removed one
+    if( aItem->m_recacheIndex >= 0 )
+    {
+        VIEW_ITEM* last = m_recacheQueue.back();
+
+        m_recacheQueue[aItem->m_recacheIndex] = last;
+        last->m_recacheIndex = aItem->m_recacheIndex;
+        m_recacheQueue.pop_back();
+        aItem->m_recacheIndex = -1;
+    }
+
     int layers[VIEW::VIEW_MAX_LAYERS], layers_count;
     aItem->getLayers( layers, layers_count );
 
@@ -128,13 +299,10 @@ void VIEW::Remove( VIEW_ITEM* aItem )
     {
         VIEW_LAYER& l = m_layers[layers[i]];
         l.items->Remove( aItem );
-        MarkTargetDirty( l.target );
+        markTargetDirty( l.target, aItem->m_viewBBox );
 
         // Clear the GAL cache
-        int prevGroup = aItem->getGroup( layers[i] );
-
-        if( prevGroup >= 0 )
-            m_gal->DeleteGroup( prevGroup );
+        releaseGroup( aItem, layers[i] );
     }
 
     aItem->deleteGroups();
@@ -159,14 +327,14 @@ struct queryVisitor
 {
     typedef typename Container::value_type item_type;
 
-    queryVisitor( Container& aCont, int aLayer ) :
-        m_cont( aCont ), m_layer( aLayer )
+    queryVisitor( Container& aCont, int aLayer, bool aVisibleOnly ) :
+        m_cont( aCont ), m_layer( aLayer ), m_visibleOnly( aVisibleOnly )
     {
     }
 
     bool operator()( VIEW_ITEM* aItem )
     {
-        if( aItem->ViewIsVisible() )
+        if( !m_visibleOnly || aItem->ViewIsVisible() )
             m_cont.push_back( VIEW::LAYER_ITEM_PAIR( aItem, m_layer ) );
 
         return true;
@@ -174,10 +342,12 @@ struct queryVisitor
 
     Container&  m_cont;
     int         m_layer;
+    bool        m_visibleOnly;
 };
 
 
-int VIEW::Query( const BOX2I& aRect, std::vector<LAYER_ITEM_PAIR>& aResult ) const
+int VIEW::Query( const BOX2I& aRect, std::vector<LAYER_ITEM_PAIR>& aResult,
+                 bool aVisibleOnly ) const
 {
     if( m_orderedLayers.empty() )
         return 0;
@@ -192,7 +362,7 @@ int VIEW::Query( const BOX2I& aRect, std::vector<LAYER_ITEM_PAIR>& aResult ) con
         if( ( *i )->displayOnly )
             continue;
 
-        queryVisitor<std::vector<LAYER_ITEM_PAIR> > visitor( aResult, ( *i )->id );
+        queryVisitor<std::vector<LAYER_ITEM_PAIR> > visitor( aResult, ( *i )->id, aVisibleOnly );
         ( *i )->items->Query( aRect, visitor );
     }
 
@@ -250,6 +420,7 @@ void VIEW::SetGAL( GAL* aGal )
 
     // clear group numbers, so everything is going to be recached
     clearGroupCache();
+    clearInstanceCache();
 
     // every target has to be refreshed
     MarkDirty();
@@ -366,8 +537,8 @@ void VIEW::SortLayers( int aLayers[], int& aCount ) const
 
 struct VIEW::updateItemsColor
 {
-    updateItemsColor( int aLayer, PAINTER* aPainter, GAL* aGal ) :
-        layer( aLayer ), painter( aPainter ), gal( aGal )
+    updateItemsColor( VIEW* aView, int aLayer, PAINTER* aPainter, GAL* aGal ) :
+        view( aView ), layer( aLayer ), painter( aPainter ), gal( aGal )
     {
     }
 
@@ -379,10 +550,13 @@ struct VIEW::updateItemsColor
 
         if( group >= 0 )
             gal->ChangeGroupColor( group, color );
+        else if( group < -1 )
+            view->releaseGroup( aItem, layer );   // shared shapes are stored with their color
 
         return true;
     }
 
+    VIEW* view;
     int layer;
     PAINTER* painter;
     GAL* gal;
@@ -399,9 +573,11 @@ void VIEW::UpdateLayerColor( int aLayer )
 
     r.SetMaximum();
 
-    updateItemsColor visitor( aLayer, m_painter, m_gal );
+    updateItemsColor visitor( this, aLayer, m_painter, m_gal );
     m_layers[aLayer].items->Query( r, visitor );
     MarkTargetDirty( m_layers[aLayer].target );
+
+    clearDotCache();
 }
 
 
@@ -419,10 +595,11 @@ void VIEW::UpdateAllLayersColor()
         if( !IsCached( l->id ) )
             continue;
 
-        updateItemsColor visitor( l->id, m_painter, m_gal );
+        updateItemsColor visitor( this, l->id, m_painter, m_gal );
         l->items->Query( r, visitor );
     }
 
+    clearDotCache();
     MarkDirty();
 }
 
@@ -461,6 +638,21 @@ void VIEW::ChangeLayerDepth( int aLayer, int aDepth )
 
     changeItemsDepth visitor( aLayer, aDepth, m_gal );
     m_layers[aLayer].items->Query( r, visitor );
+
+    // Shapes shared by instanced items are stored once per layer
+    for( unsigned int i = 0; i < m_instances.size(); ++i )
+    {
+        if( m_instances[i].users > 0 && m_instances[i].key.layer == aLayer )
+            m_gal->ChangeGroupDepth( m_instances[i].group, aDepth );
+    }
+
+    for( std::map<INSTANCE_KEY, int>::const_iterator it = m_dotGroups.begin();
+         it != m_dotGroups.end(); ++it )
+    {
+        if( it->first.layer == aLayer )
+            m_gal->ChangeGroupDepth( it->second, aDepth );
+    }
+
     MarkTargetDirty( m_layers[aLayer].target );
 }
 
@@ -599,6 +791,18 @@ void VIEW::draw( VIEW_ITEM* aItem, int aLayer, bool aImmediate )
 {
     if( IsCached( aLayer ) && !aImmediate )
     {
+        VIEW_INSTANCE instance;
+        bool hasInstance = aItem->ViewGetInstance( aLayer, instance );
+
+        // Level of details: there is no point in drawing shapes of items that are about a pixel big
+        if( hasInstance && std::fabs( ToScreen( instance.size, false ) ) < INSTANCE_LOD_SIZE )
+        {
+            drawDot( aItem, aLayer, instance );
+            return;
+        }
+
+        hasInstance = hasInstance && m_gal->IsInstancingSupported();
+
         // Draw using cached information or create one
         int group = aItem->getGroup( aLayer );
 
@@ -606,8 +810,14 @@ void VIEW::draw( VIEW_ITEM* aItem, int aLayer, bool aImmediate )
         {
             m_gal->DrawGroup( group );
         }
+        else if( hasInstance )
+        {
+            drawInstance( aItem, aLayer, instance );
+        }
         else
         {
+            releaseGroup( aItem, aLayer );      // drop a shared shape the item does not use anymore
+
             group = m_gal->BeginGroup();
             aItem->setGroup( aLayer, group );
 
@@ -657,6 +867,13 @@ struct VIEW::unlinkItem
     bool operator()( VIEW_ITEM* aItem )
     {
         aItem->m_view = NULL;
+        aItem->deleteGroups();    // groups are not valid anymore after clearing the cache
+
+        if( aItem->m_job )
+        {
+            aItem->m_job->m_item = NULL;
+            aItem->m_job = NULL;
+        }
 
         return true;
     }
@@ -673,14 +890,15 @@ struct VIEW::recacheItem
     bool operator()( VIEW_ITEM* aItem )
     {
         // Remove previously cached group
-        int group = aItem->getGroup( layer );
+        view->releaseGroup( aItem, layer );
 
-        if( group >= 0 )
-            gal->DeleteGroup( group );
+        // Shared shapes are drawn instead of a group owned by the item
+        if( view->isInstanced( aItem, layer ) )
+            return true;
 
         if( immediately )
         {
-            group = gal->BeginGroup();
+            int group = gal->BeginGroup();
             aItem->setGroup( layer, group );
 
             if( !view->m_painter->Draw( aItem, layer ) )
@@ -704,6 +922,29 @@ struct VIEW::recacheItem
 };
 
 
+struct VIEW::queueRecache
+{
+    queueRecache( VIEW* aView ) :
+        view( aView )
+    {
+    }
+
+    bool operator()( VIEW_ITEM* aItem )
+    {
+        // Items are visited once for every layer they occupy, but they are queued only once
+        if( aItem->m_recacheIndex < 0 )
+        {
+            aItem->m_recacheIndex = view->m_recacheQueue.size();
+            view->m_recacheQueue.push_back( aItem );
+        }
+
+        return true;
+    }
+
+    VIEW* view;
+};
+
+
 void VIEW::Clear()
 {
     BOX2I r;
@@ -722,12 +963,20 @@ void VIEW::Clear()
     }
 
     m_gal->ClearCache();
+    clearInstanceCache();
     m_needsUpdate.clear();
+    clearRecacheQueue();
 }
 
 
 void VIEW::ClearTargets()
 {
+    bool partial = isPartialRedraw();
+
+    // Only the area covering changed items is cleared and redrawn in the current frame
+    if( partial )
+        m_gal->SetClipArea( BOX2D( m_dirtyArea.GetOrigin(), m_dirtyArea.GetSize() ) );
+
     if( IsTargetDirty( TARGET_CACHED ) || IsTargetDirty( TARGET_NONCACHED ) )
     {
         // TARGET_CACHED and TARGET_NONCACHED have to be redrawn together, as they contain
@@ -735,7 +984,15 @@ void VIEW::ClearTargets()
         m_gal->ClearTarget( TARGET_NONCACHED );
         m_gal->ClearTarget( TARGET_CACHED );
 
-        MarkDirty();
+        if( partial )
+        {
+            m_dirtyTargets[TARGET_CACHED] = true;
+            m_dirtyTargets[TARGET_NONCACHED] = true;
+        }
+        else
+        {
+            MarkDirty();
+        }
     }
 
     if( IsTargetDirty( TARGET_OVERLAY ) )
@@ -747,6 +1004,8 @@ void VIEW::ClearTargets()
 
 void VIEW::Redraw()
 {
+    PROF_SCOPE( "VIEW::Redraw" );
+
 #ifdef PROFILE
     prof_counter totalRealTime;
     prof_start( &totalRealTime );
@@ -757,7 +1016,21 @@ void VIEW::Redraw()
                    ToWorld( screenSize ) - ToWorld( VECTOR2D( 0, 0 ) ) );
     rect.Normalize();
 
-    redrawRect( rect );
+    if( isPartialRedraw() )
+    {
+        // Limit the redrawn area to the part of the screen that has changed
+        VECTOR2I start( std::max( rect.GetLeft(), m_dirtyArea.GetLeft() ),
+                        std::max( rect.GetTop(), m_dirtyArea.GetTop() ) );
+        VECTOR2I end( std::min( rect.GetRight(), m_dirtyArea.GetRight() ),
+                      std::min( rect.GetBottom(), m_dirtyArea.GetBottom() ) );
+
+        if( start.x <= end.x && start.y <= end.y )
+            redrawRect( BOX2I( start, end - start ) );
+    }
+    else
+    {
+        redrawRect( rect );
+    }
 
     // All targets were redrawn, so nothing is dirty
     markTargetClean( TARGET_CACHED );
@@ -813,12 +1086,25 @@ void VIEW::clearGroupCache()
 
 void VIEW::invalidateItem( VIEW_ITEM* aItem, int aUpdateFlags )
 {
+    // The item might have been moved, so both its previous and its current position are redrawn
+    BOX2I area = aItem->m_viewBBox;
+
     // updateLayers updates geometry too, so we do not have to update both of them at the same time
     if( aUpdateFlags & VIEW_ITEM::LAYERS )
         updateLayers( aItem );
     else if( aUpdateFlags & VIEW_ITEM::GEOMETRY )
         updateBbox( aItem );
 
+    area.Merge( aItem->ViewBBox() );
+
+    // A changed shape on the same layers may be prepared on a worker thread, the current
+    // display lists are shown until then
+    bool deferred = ( aUpdateFlags & VIEW_ITEM::GEOMETRY ) &&
+                    !( aUpdateFlags & VIEW_ITEM::LAYERS ) && submitJob( aItem );
+
+    if( !deferred && ( aUpdateFlags & ( VIEW_ITEM::GEOMETRY | VIEW_ITEM::LAYERS ) ) )
+        cancelJob( aItem );
+
     int layers[VIEW_MAX_LAYERS], layers_count;
     aItem->ViewGetLayers( layers, layers_count );
 
@@ -830,13 +1116,16 @@ void VIEW::invalidateItem( VIEW_ITEM* aItem, int aUpdateFlags )
         if( IsCached( layerId ) )
         {
             if( aUpdateFlags & ( VIEW_ITEM::GEOMETRY | VIEW_ITEM::LAYERS ) )
-                updateItemGeometry( aItem, layerId );
+            {
+                if( !deferred )
+                    updateItemGeometry( aItem, layerId );
+            }
             else if( aUpdateFlags & VIEW_ITEM::COLOR )
                 updateItemColor( aItem, layerId );
         }
 
         // Mark those layers as dirty, so the VIEW will be refreshed
-        MarkTargetDirty( m_layers[layerId].target );
+        markTargetDirty( m_layers[layerId].target, area );
     }
 
     aItem->clearUpdateFlags();
@@ -870,6 +1159,8 @@ void VIEW::updateItemColor( VIEW_ITEM* aItem, int aLayer )
     // Change the color, only if it has group assigned
     if( group >= 0 )
         m_gal->ChangeGroupColor( group, color );
+    else if( group < -1 )
+        releaseGroup( aItem, aLayer );    // a shape with the new color is found when drawing
 }
 
 
@@ -884,12 +1175,13 @@ void VIEW::updateItemGeometry( VIEW_ITEM* aItem, int aLayer )
     m_gal->SetLayerDepth( l.renderingOrder );
 
     // Redraw the item from scratch
-    int group = aItem->getGroup( aLayer );
+    releaseGroup( aItem, aLayer );
 
-    if( group >= 0 )
-        m_gal->DeleteGroup( group );
+    // Instanced items use shared shapes, they do not need their own groups
+    if( isInstanced( aItem, aLayer ) )
+        return;
 
-    group = m_gal->BeginGroup();
+    int group = m_gal->BeginGroup();
     aItem->setGroup( aLayer, group );
 
     if( !m_painter->Draw( static_cast<EDA_ITEM*>( aItem ), aLayer ) )
@@ -899,18 +1191,219 @@ void VIEW::updateItemGeometry( VIEW_ITEM* aItem, int aLayer )
 }
 
 
+bool VIEW::isInstanced( const VIEW_ITEM* aItem, int aLayer ) const
+{
+    VIEW_INSTANCE instance;
+
+    return m_gal->IsInstancingSupported() && aItem->ViewGetInstance( aLayer, instance );
+}
+
+
+void VIEW::drawInstance( VIEW_ITEM* aItem, int aLayer, const VIEW_INSTANCE& aInstance )
+{
+    int group = aItem->getGroup( aLayer );
+    int index;
+
+    if( group < -1 )
+    {
+        index = -2 - group;
+    }
+    else
+    {
+        INSTANCE_KEY key;
+        key.layer = aLayer;
+        key.color = m_painter->GetSettings()->GetColor( aItem, aLayer );
+        std::copy( aInstance.shape, aInstance.shape + VIEW_INSTANCE::SHAPE_PARAMS, key.shape );
+
+        std::map<INSTANCE_KEY, int>::iterator it = m_instanceIndex.find( key );
+
+        if( it != m_instanceIndex.end() )
+        {
+            index = it->second;
+        }
+        else
+        {
+            if( m_freeInstances.empty() )
+            {
+                index = m_instances.size();
+                m_instances.push_back( INSTANCE_GROUP() );
+            }
+            else
+            {
+                index = m_freeInstances.back();
+                m_freeInstances.pop_back();
+            }
+
+            // The shared shape is stored relative to the placement of the first instance
+            VECTOR2D origin( 0.0, 0.0 );
+
+            INSTANCE_GROUP& shape = m_instances[index];
+            shape.key = key;
+            shape.users = 0;
+            shape.group = m_gal->BeginGroup();
+            m_gal->Save();
+            m_gal->Rotate( -aInstance.angle );
+            m_gal->Translate( origin - aInstance.offset );
+
+            if( !m_painter->Draw( aItem, aLayer ) )
+                aItem->ViewDraw( aLayer, m_gal ); // Alternative drawing method
+
+            m_gal->Restore();
+            m_gal->EndGroup();
+
+            m_instanceIndex[key] = index;
+        }
+
+        ++m_instances[index].users;
+        aItem->setGroup( aLayer, -2 - index );
+    }
+
+    m_gal->Save();
+    m_gal->Translate( aInstance.offset );
+    m_gal->Rotate( aInstance.angle );
+    m_gal->DrawGroup( m_instances[index].group );
+    m_gal->Restore();
+}
+
+
+void VIEW::drawDot( VIEW_ITEM* aItem, int aLayer, const VIEW_INSTANCE& aInstance )
+{
+    INSTANCE_KEY key;
+    key.layer = aLayer;
+    key.color = m_painter->GetSettings()->GetColor( aItem, aLayer );
+    std::fill( key.shape, key.shape + VIEW_INSTANCE::SHAPE_PARAMS, 0 );
+
+    double size = ToWorld( INSTANCE_LOD_SIZE );
+
+    m_gal->SetIsStroke( false );
+    m_gal->SetIsFill( true );
+    m_gal->SetFillColor( key.color );
+
+    if( !m_gal->IsInstancingSupported() )
+    {
+        // A cached layer may be drawn only using groups, the dot goes to the noncached target
+        VECTOR2D corner( size / 2.0, size / 2.0 );
+
+        m_gal->SetTarget( TARGET_NONCACHED );
+        m_gal->DrawRectangle( aInstance.offset - corner, aInstance.offset + corner );
+        m_gal->SetTarget( m_layers[aLayer].target );
+
+        return;
+    }
+
+    std::map<INSTANCE_KEY, int>::iterator it = m_dotGroups.find( key );
+    int group;
+
+    if( it != m_dotGroups.end() )
+    {
+        group = it->second;
+    }
+    else
+    {
+        // A unit square, scaled to the dot size when it is drawn
+        group = m_gal->BeginGroup();
+        m_gal->DrawRectangle( VECTOR2D( -0.5, -0.5 ), VECTOR2D( 0.5, 0.5 ) );
+        m_gal->EndGroup();
+
+        m_dotGroups[key] = group;
+    }
+
+    m_gal->Save();
+    m_gal->Translate( aInstance.offset );
+    m_gal->Scale( VECTOR2D( size, size ) );
+    m_gal->DrawGroup( group );
+    m_gal->Restore();
+}
+
+
+void VIEW::releaseGroup( VIEW_ITEM* aItem, int aLayer )
+{
+    int group = aItem->getGroup( aLayer );
+
+    if( group >= 0 )
+    {
+        m_gal->DeleteGroup( group );
+    }
+    else if( group < -1 )
+    {
+        INSTANCE_GROUP& shape = m_instances[-2 - group];
+
+        // Shapes that are not used anymore are removed, so they do not pile up as items change
+        if( --shape.users == 0 )
+        {
+            m_gal->DeleteGroup( shape.group );
+            m_instanceIndex.erase( shape.key );
+            m_freeInstances.push_back( -2 - group );
+        }
+    }
+    else
+    {
+        return;
+    }
+
+    aItem->setGroup( aLayer, -1 );
+}
+
+
+void VIEW::clearInstanceCache()
+{
+    m_instances.clear();
+    m_freeInstances.clear();
+    m_instanceIndex.clear();
+    m_dotGroups.clear();
+}
+
+
+void VIEW::clearDotCache()
+{
+    for( std::map<INSTANCE_KEY, int>::const_iterator it = m_dotGroups.begin();
+         it != m_dotGroups.end(); ++it )
+        m_gal->DeleteGroup( it->second );
+
+    m_dotGroups.clear();
+}
+
+
+bool VIEW::INSTANCE_KEY::operator<( const INSTANCE_KEY& aOther ) const
+{
+    if( layer != aOther.layer )
+        return layer < aOther.layer;
+
+    for( int i = 0; i < VIEW_INSTANCE::SHAPE_PARAMS; ++i )
+    {
+        if( shape[i] != aOther.shape[i] )
+            return shape[i] < aOther.shape[i];
+    }
+
+    if( color.r != aOther.color.r )
+        return color.r < aOther.color.r;
+
+    if( color.g != aOther.color.g )
+        return color.g < aOther.color.g;
+
+    if( color.b != aOther.color.b )
+        return color.b < aOther.color.b;
+
+    return color.a < aOther.color.a;
+}
+
+
 void VIEW::updateBbox( VIEW_ITEM* aItem )
 {
     int layers[VIEW_MAX_LAYERS], layers_count;
 
     aItem->ViewGetLayers( layers, layers_count );
 
+    BOX2I area = aItem->m_viewBBox;
+    aItem->m_viewBBox = aItem->ViewBBox();
+    area.Merge( aItem->m_viewBBox );
+
     for( int i = 0; i < layers_count; ++i )
     {
         VIEW_LAYER& l = m_layers[layers[i]];
         l.items->Remove( aItem );
         l.items->Insert( aItem );
-        MarkTargetDirty( l.target );
+        markTargetDirty( l.target, area );
     }
 }
 
@@ -926,31 +1419,50 @@ void VIEW::updateLayers( VIEW_ITEM* aItem )
     {
         VIEW_LAYER& l = m_layers[layers[i]];
         l.items->Remove( aItem );
-        MarkTargetDirty( l.target );
+        markTargetDirty( l.target, aItem->m_viewBBox );
 
+        // Redraw the item from scratch
         if( IsCached( l.id ) )
-        {
-            // Redraw the item from scratch
-            int prevGroup = aItem->getGroup( layers[i] );
-
-            if( prevGroup >= 0 )
-            {
-                m_gal->DeleteGroup( prevGroup );
-                aItem->setGroup( l.id, -1 );
-            }
-        }
+            releaseGroup( aItem, l.id );
     }
 
     // Add the item to new layer set
     aItem->ViewGetLayers( layers, layers_count );
     aItem->saveLayers( layers, layers_count );
+    aItem->m_viewBBox = aItem->ViewBBox();
 
     for( int i = 0; i < layers_count; i++ )
     {
         VIEW_LAYER& l = m_layers[layers[i]];
         l.items->Insert( aItem );
-        MarkTargetDirty( l.target );
+        markTargetDirty( l.target, aItem->m_viewBBox );
+    }
+}
+
+
+void VIEW::markTargetDirty( int aTarget, const BOX2I& aArea )
+{
+    wxASSERT( aTarget < TARGETS_NUMBER );
+
+    if( !IsDirty() )
+    {
+        // Nothing was changed since the last redraw, so the dirty area starts from scratch
+        m_dirtyArea = aArea;
+        m_dirtyArea.Normalize();
+        m_redrawAll = false;
+    }
+    else if( !m_redrawAll )
+    {
+        m_dirtyArea.Merge( aArea );
     }
+
+    m_dirtyTargets[aTarget] = true;
+}
+
+
+bool VIEW::isPartialRedraw() const
+{
+    return !m_redrawAll && m_gal && m_gal->IsClippingSupported();
 }
 
 
@@ -983,16 +1495,27 @@ void VIEW::RecacheAllItems( bool aImmediately )
     prof_start( &totalRealTime );
 #endif /* PROFILE */
 
+    clearDotCache();
+
     for( LAYER_MAP_ITER i = m_layers.begin(); i != m_layers.end(); ++i )
     {
         VIEW_LAYER* l = &( ( *i ).second );
 
         if( IsCached( l->id ) )
         {
-            m_gal->SetTarget( l->target );
-            m_gal->SetLayerDepth( l->renderingOrder );
-            recacheItem visitor( this, m_gal, l->id, aImmediately );
-            l->items->Query( r, visitor );
+            if( aImmediately )
+            {
+                m_gal->SetTarget( l->target );
+                m_gal->SetLayerDepth( l->renderingOrder );
+                recacheItem visitor( this, m_gal, l->id, aImmediately );
+                l->items->Query( r, visitor );
+            }
+            else
+            {
+                queueRecache visitor( this );
+                l->items->Query( r, visitor );
+            }
+
             MarkTargetDirty( l->target );
         }
     }
@@ -1008,6 +1531,9 @@ void VIEW::RecacheAllItems( bool aImmediately )
 
 void VIEW::UpdateItems()
 {
+    PROF_SCOPE( "VIEW::UpdateItems" );
+    PROF_COUNTER( "VIEW::updatedItems", (int64_t) m_needsUpdate.size() );
+
     // Update items that need this
     BOOST_FOREACH( VIEW_ITEM* item, m_needsUpdate )
     {
@@ -1017,6 +1543,145 @@ void VIEW::UpdateItems()
     }
 
     m_needsUpdate.clear();
+
+    if( m_runningJobs > 0 )
+        processFinishedJobs();
+
+    if( !m_recacheQueue.empty() )
+        processRecacheQueue();
+}
+
+
+void VIEW::processRecacheQueue()
+{
+#ifdef PROFILE
+    prof_counter totalRealTime;
+    prof_start( &totalRealTime );
+#endif /* PROFILE */
+
+    // Number of items recached between checks of the elapsed time
+    const int BATCH_SIZE = 64;
+
+    wxLongLong start = wxGetLocalTimeMillis();
+    int recached = 0;
+
+    while( !m_recacheQueue.empty() )
+    {
+        if( recached % BATCH_SIZE == 0 && recached > 0 &&
+            wxGetLocalTimeMillis() - start >= RECACHE_TIME_LIMIT )
+            break;
+
+        VIEW_ITEM* item = m_recacheQueue.back();
+        m_recacheQueue.pop_back();
+        item->m_recacheIndex = -1;
+
+        // Items prepared by a job are recached when it is finished
+        if( item->m_job || submitJob( item ) )
+            continue;
+
+        int layers[VIEW_MAX_LAYERS], layers_count;
+        item->getLayers( layers, layers_count );
+
+        // The current display list is replaced only when the new one is ready
+        for( int i = 0; i < layers_count; ++i )
+        {
+            if( IsCached( layers[i] ) )
+            {
+                updateItemGeometry( item, layers[i] );
+                markTargetDirty( m_layers[layers[i]].target, item->m_viewBBox );
+            }
+        }
+
+        ++recached;
+    }
+
+#ifdef PROFILE
+    prof_end( &totalRealTime );
+
+    wxLogDebug( wxT( "processRecacheQueue: %d items %.1f ms, %d left" ), recached,
+                totalRealTime.msecs(), (int) m_recacheQueue.size() );
+#endif /* PROFILE */
+}
+
+
+void VIEW::clearRecacheQueue()
+{
+    BOOST_FOREACH( VIEW_ITEM* item, m_recacheQueue )
+        item->m_recacheIndex = -1;
+
+    m_recacheQueue.clear();
+}
+
+
+bool VIEW::submitJob( VIEW_ITEM* aItem )
+{
+    // Items of static views are not linked to them, so they cannot wait for the results
+    if( !m_dynamic || !m_painter )
+        return false;
+
+    VIEW_ITEM_JOB* job = m_painter->CreateJob( aItem );
+
+    if( !job )
+        return false;
+
+    // Results of a previous job are outdated
+    cancelJob( aItem );
+
+    job->m_item = aItem;
+    aItem->m_job = job;
+
+    if( !m_jobQueue )
+        m_jobQueue = new JOB_QUEUE;
+
+    m_jobQueue->Add( job );
+    ++m_runningJobs;
+
+    return true;
+}
+
+
+void VIEW::processFinishedJobs()
+{
+    VIEW_ITEM_JOB* job;
+
+    while( m_jobQueue->PopFinished( job ) )
+    {
+        --m_runningJobs;
+
+        VIEW_ITEM* item = job->m_item;
+
+        if( item )
+        {
+            item->m_job = NULL;
+            job->Finish( item );
+
+            int layers[VIEW_MAX_LAYERS], layers_count;
+            item->getLayers( layers, layers_count );
+
+            // The new display lists replace the ones shown while the job was running
+            for( int i = 0; i < layers_count; ++i )
+            {
+                if( IsCached( layers[i] ) )
+                {
+                    updateItemGeometry( item, layers[i] );
+                    markTargetDirty( m_layers[layers[i]].target, item->m_viewBBox );
+                }
+            }
+        }
+
+        delete job;
+    }
+}
+
+
+void VIEW::cancelJob( VIEW_ITEM* aItem )
+{
+    // The job is deleted when it is finished, as the worker thread may be running it now
+    if( aItem->m_job )
+    {
+        aItem->m_job->m_item = NULL;
+        aItem->m_job = NULL;
+    }
 }
 
 
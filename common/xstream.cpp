@@ -0,0 +1,238 @@
+/*
+ * This program source code file is part of KiCad, a free EDA CAD application.
+ *
+ * Copyright (C) 2014 KiCad Developers, see change_log.txt for contributors.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, you may find one here:
+ * http://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+ * or you may search the http://www.gnu.org website for the version 2 license,
+ * or you may write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+
+#include <xstream.h>
+#include <macros.h>
+
+
+//-----<XSTREAM_SEXPR>---------------------------------------------------------
+
+void XSTREAM_SEXPR::StartElement( const wxString& aName ) throw( IO_ERROR )
+{
+    OPEN_ELEMENT* parent = current();
+
+    if( parent )
+    {
+        // XNODE::FormatContents() starts the first child element on a new line,
+        // and XNODE::Format() ends an element followed by a sibling with a new line.
+        if( !parent->m_HasChildren || parent->m_LastChildIsElement )
+            m_out->Print( 0, "\n" );
+
+        parent->m_HasChildren = true;
+        parent->m_LastChildIsElement = true;
+    }
+
+    m_out->Print( (int) m_stack.size(), "(%s", m_out->Quotew( aName ).c_str() );
+
+    pushElement( aName );
+}
+
+
+void XSTREAM_SEXPR::AddAttribute( const wxString& aName, const wxString& aValue )
+    throw( IO_ERROR )
+{
+    wxASSERT( current() && !current()->m_HasChildren );
+
+    m_out->Print( 0, " (%s %s)",
+                  // attr names should never need quoting, no spaces, we designed the file.
+                  m_out->Quotew( aName ).c_str(),
+                  m_out->Quotew( aValue ).c_str() );
+}
+
+
+void XSTREAM_SEXPR::AddText( const wxString& aContent ) throw( IO_ERROR )
+{
+    if( aContent.IsEmpty() )
+        return;
+
+    OPEN_ELEMENT* parent = current();
+
+    wxASSERT( parent );
+
+    if( parent->m_LastChildIsElement )
+        m_out->Print( 0, "\n" );
+
+    parent->m_HasChildren = true;
+    parent->m_LastChildIsElement = false;
+
+    m_out->Print( 0, " %s", m_out->Quotew( aContent ).c_str() );
+}
+
+
+void XSTREAM_SEXPR::EndElement() throw( IO_ERROR )
+{
+    wxASSERT( current() );
+
+    m_out->Print( 0, ")" );
+
+    m_stack.pop_back();
+}
+
+
+//-----<XSTREAM_XML>-----------------------------------------------------------
+
+void XSTREAM_XML::closeStartTag() throw( IO_ERROR )
+{
+    if( m_tagOpen )
+    {
+        m_out->Print( 0, ">" );
+        m_tagOpen = false;
+    }
+}
+
+
+void XSTREAM_XML::indent( int aIndent ) throw( IO_ERROR )
+{
+    m_out->Print( 0, "\n%*s", aIndent, "" );
+}
+
+
+void XSTREAM_XML::writeEscaped( const wxString& aText, bool aIsAttribute ) throw( IO_ERROR )
+{
+    // Same entities as wxXmlDocument::Save()
+    m_escaped.clear();
+
+    for( wxString::const_iterator it = aText.begin(); it != aText.end(); ++it )
+    {
+        const wxChar c = *it;
+
+        switch( c )
+        {
+        case wxT( '<' ):  m_escaped += wxT( "&lt;" );   break;
+        case wxT( '>' ):  m_escaped += wxT( "&gt;" );   break;
+        case wxT( '&' ):  m_escaped += wxT( "&amp;" );  break;
+        case wxT( '\r' ): m_escaped += wxT( "&#xD;" );  break;
+
+        case wxT( '"' ):
+            if( aIsAttribute )
+                m_escaped += wxT( "&quot;" );
+            else
+                m_escaped += c;
+            break;
+
+        case wxT( '\t' ):
+            if( aIsAttribute )
+                m_escaped += wxT( "&#x9;" );
+            else
+                m_escaped += c;
+            break;
+
+        case wxT( '\n' ):
+            if( aIsAttribute )
+                m_escaped += wxT( "&#xA;" );
+            else
+                m_escaped += c;
+            break;
+
+        default:
+            m_escaped += c;
+        }
+    }
+
+    m_out->Print( 0, "%s", TO_UTF8( m_escaped ) );
+}
+
+
+void XSTREAM_XML::StartElement( const wxString& aName ) throw( IO_ERROR )
+{
+    OPEN_ELEMENT* parent = current();
+
+    if( parent )
+    {
+        closeStartTag();
+
+        if( m_indentStep >= 0 )
+            indent( (int) m_stack.size() * m_indentStep );
+
+        parent->m_HasChildren = true;
+        parent->m_LastChildIsElement = true;
+    }
+    else
+    {
+        m_out->Print( 0, "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n" );
+    }
+
+    m_out->Print( 0, "<%s", TO_UTF8( aName ) );
+    m_tagOpen = true;
+
+    pushElement( aName );
+}
+
+
+void XSTREAM_XML::AddAttribute( const wxString& aName, const wxString& aValue )
+    throw( IO_ERROR )
+{
+    wxASSERT( m_tagOpen );
+
+    m_out->Print( 0, " %s=\"", TO_UTF8( aName ) );
+    writeEscaped( aValue, true );
+    m_out->Print( 0, "\"" );
+}
+
+
+void XSTREAM_XML::AddText( const wxString& aContent ) throw( IO_ERROR )
+{
+    if( aContent.IsEmpty() )
+        return;
+
+    OPEN_ELEMENT* parent = current();
+
+    wxASSERT( parent );
+
+    closeStartTag();
+
+    parent->m_HasChildren = true;
+    parent->m_LastChildIsElement = false;
+
+    writeEscaped( aContent, false );
+}
+
+
+void XSTREAM_XML::EndElement() throw( IO_ERROR )
+{
+    OPEN_ELEMENT* element = current();
+
+    wxASSERT( element );
+
+    if( !element->m_HasChildren )
+    {
+        m_out->Print( 0, "/>" );
+        m_tagOpen = false;
+    }
+    else
+    {
+        if( m_indentStep >= 0 && element->m_LastChildIsElement )
+            indent( ( (int) m_stack.size() - 1 ) * m_indentStep );
+
+        m_out->Print( 0, "</%s>", TO_UTF8( element->m_Name ) );
+    }
+
+    m_stack.pop_back();
+
+    // wxXmlDocument::Save() ends the document with a new line
+    if( m_stack.empty() )
+        m_out->Print( 0, "\n" );
+}
+
+// EOF
@@ -46,11 +46,13 @@ void SCH_EDIT_FRAME::DeleteAnnotation( bool aCurrentSheetOnly )
         SCH_SCREEN* screen = GetScreen();
         wxCHECK_RET( screen != NULL, wxT( "Attempt to clear annotation of a NULL screen." ) );
         screen->ClearAnnotation( m_CurrentSheet );
+        screen->SetConnectivityModified();
     }
     else
     {
         SCH_SCREENS ScreenList;
         ScreenList.ClearAnnotation();
+        ScreenList.SetConnectivityModified();
     }
 
     // Update the references for the sheet that is currently being displayed.
@@ -162,6 +164,9 @@ void SCH_EDIT_FRAME::AnnotateComponents( bool              aAnnotateSchematic,
 
     OnModify();
 
+    // Units of components may have changed in any sheet
+    screens.SetConnectivityModified();
+
     // Update on screen references, that can be modified by previous calculations:
     m_CurrentSheet->UpdateAllScreenReferences();
     SetSheetNumberAndCount();
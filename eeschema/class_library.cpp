@@ -246,6 +246,7 @@ bool PART_LIB::AddAlias( LIB_ALIAS* aAlias )
     m_amap[ name ] = aAlias;
     isModified = true;
     ++m_mod_hash;
+    ++PART_LIBS::s_modify_generation;
 
     return true;
 }
@@ -280,6 +281,7 @@ bool PART_LIB::AddPart( LIB_PART* aPart )
 
     isModified = true;
     ++m_mod_hash;
+    ++PART_LIBS::s_modify_generation;
 
     return true;
 }
@@ -324,6 +326,7 @@ LIB_ALIAS* PART_LIB::RemoveEntry( LIB_ALIAS* aEntry )
     m_amap.erase( it );
     isModified = true;
     ++m_mod_hash;
+    ++PART_LIBS::s_modify_generation;
     return alias;
 }
 
@@ -358,6 +361,7 @@ LIB_PART* PART_LIB::ReplacePart( LIB_PART* aOldPart, LIB_PART* aNewPart )
 
     isModified = true;
     ++m_mod_hash;
+    ++PART_LIBS::s_modify_generation;
     return my_part;
 }
 
@@ -561,13 +565,14 @@ void PART_LIB::LoadAliases( LIB_PART* aPart )
 bool PART_LIB::LoadHeader( LINE_READER& aLineReader )
 {
     char* line, * text, * data;
+    char* saveptr;
 
     while( aLineReader.ReadLine() )
     {
         line = (char*) aLineReader;
 
-        text = strtok( line, " \t\r\n" );
-        data = strtok( NULL, " \t\r\n" );
+        text = strtok_r( line, " \t\r\n", &saveptr );
+        data = strtok_r( NULL, " \t\r\n", &saveptr );
 
         if( stricmp( text, "TimeStamp" ) == 0 )
             timeStamp = atol( data );
@@ -588,6 +593,7 @@ bool PART_LIB::LoadDocs( wxString& aErrorMsg )
     FILE*      file;
     wxString   msg;
     wxFileName fn = fileName;
+    char*      saveptr;
 
     fn.SetExt( DOC_EXT );
 
@@ -626,7 +632,7 @@ bool PART_LIB::LoadDocs( wxString& aErrorMsg )
         }
 
         // Read one $CMP/$ENDCMP part entry from library:
-        name = strtok( line + 5, "\n\r" );
+        name = strtok_r( line + 5, "\n\r", &saveptr );
 
         wxString cmpname = FROM_UTF8( name );
 
@@ -637,7 +643,7 @@ bool PART_LIB::LoadDocs( wxString& aErrorMsg )
             if( strncmp( line, "$ENDCMP", 7 ) == 0 )
                 break;
 
-            text = strtok( line + 2, "\n\r" );
+            text = strtok_r( line + 2, "\n\r", &saveptr );
 
             if( entry )
             {
@@ -742,10 +748,16 @@ bool PART_LIB::SaveHeader( OUTPUTFORMATTER& aFormatter )
 
 PART_LIB* PART_LIB::LoadLibrary( const wxString& aFileName ) throw( IO_ERROR )
 {
-    std::auto_ptr<PART_LIB> lib( new PART_LIB( LIBRARY_TYPE_EESCHEMA, aFileName ) );
-
     wxBusyCursor ShowWait;
 
+    return loadLibrary( aFileName );
+}
+
+
+PART_LIB* PART_LIB::loadLibrary( const wxString& aFileName ) throw( IO_ERROR )
+{
+    std::auto_ptr<PART_LIB> lib( new PART_LIB( LIBRARY_TYPE_EESCHEMA, aFileName ) );
+
     wxString errorMsg;
 
     if( !lib->Load( errorMsg ) )
@@ -783,6 +795,7 @@ PART_LIB* PART_LIBS::AddLibrary( const wxString& aFileName ) throw( IO_ERROR )
     lib = PART_LIB::LoadLibrary( aFileName );
 
     push_back( lib );
+    ++s_modify_generation;
 
     return lib;
 }
@@ -806,6 +819,8 @@ PART_LIB* PART_LIBS::AddLibrary( const wxString& aFileName, PART_LIBS::iterator&
     else
         push_back( lib );
 
+    ++s_modify_generation;
+
     return lib;
 }
 
@@ -820,6 +835,7 @@ void PART_LIBS::RemoveLibrary( const wxString& aName )
         if( it->GetName().CmpNoCase( aName ) == 0 )
         {
             erase( it );
+            ++s_modify_generation;
             return;
         }
     }
@@ -862,13 +878,56 @@ wxArrayString PART_LIBS::GetLibraryNames( bool aSorted )
 }
 
 
+/// Key of PART_LIBS::m_aliasIndex, compares like AliasMapSort
+static inline wxString aliasIndexKey( const wxString& aName )
+{
+#ifdef KICAD_KEEPCASE
+    return aName;
+#else
+    return aName.Lower();
+#endif
+}
+
+
+LIB_ALIAS* PART_LIBS::findIndexedEntry( const wxString& aName )
+{
+    if( m_indexGeneration != s_modify_generation || m_indexLibCount != size() )
+    {
+        m_aliasIndex.clear();
+
+        BOOST_FOREACH( PART_LIB& lib, *this )
+        {
+            for( LIB_ALIAS_MAP::iterator it = lib.m_amap.begin();  it != lib.m_amap.end();  ++it )
+            {
+                // insert() keeps the alias of the first library having this name
+                m_aliasIndex.insert( std::make_pair( aliasIndexKey( it->first ), it->second ) );
+            }
+        }
+
+        m_indexGeneration = s_modify_generation;
+        m_indexLibCount = size();
+    }
+
+    ALIAS_INDEX::const_iterator it = m_aliasIndex.find( aliasIndexKey( aName ) );
+
+    return it != m_aliasIndex.end() ? it->second : NULL;
+}
+
+
 LIB_PART* PART_LIBS::FindLibPart( const wxString& aName, const wxString& aLibraryName )
 {
     LIB_PART* part = NULL;
 
+    if( aLibraryName.IsEmpty() )
+    {
+        LIB_ALIAS* alias = findIndexedEntry( aName );
+
+        return alias ? alias->GetPart() : NULL;
+    }
+
     BOOST_FOREACH( PART_LIB& lib, *this )
     {
-        if( !aLibraryName.IsEmpty() && lib.GetName() != aLibraryName )
+        if( lib.GetName() != aLibraryName )
             continue;
 
         part = lib.FindPart( aName );
@@ -885,9 +944,12 @@ LIB_ALIAS* PART_LIBS::FindLibraryEntry( const wxString& aName, const wxString& a
 {
     LIB_ALIAS* entry = NULL;
 
+    if( !aLibraryName )
+        return findIndexedEntry( aName );
+
     BOOST_FOREACH( PART_LIB& lib, *this )
     {
-        if( !!aLibraryName && lib.GetName() != aLibraryName )
+        if( lib.GetName() != aLibraryName )
             continue;
 
         entry = lib.FindEntry( aName );
@@ -1054,6 +1116,9 @@ void PART_LIBS::LoadAllLibraries( PROJECT* aProject ) throw( IO_ERROR )
 
     wxASSERT( !size() );    // expect to load into "this" empty container.
 
+    wxArrayString   filenames;
+    wxArrayString   loadedNames;
+
     for( unsigned i = 0; i < lib_names.GetCount();  ++i )
     {
         fn.Clear();
@@ -1080,42 +1145,92 @@ void PART_LIBS::LoadAllLibraries( PROJECT* aProject ) throw( IO_ERROR )
             filename = fn.GetFullPath();
         }
 
-        try
-        {
-            AddLibrary( filename );
-        }
-        catch( const IO_ERROR& ioe )
-        {
-            wxString msg = wxString::Format( _(
-                    "Part library '%s' failed to load. Error:\n"
-                    "%s" ),
-                    GetChars( filename ),
-                    GetChars( ioe.errorText )
-                    );
+        // Don't load the library twice, as AddLibrary() does.
+        fn = filename;
 
-            THROW_IO_ERROR( msg );
-        }
+        if( FindLibrary( fn.GetName() ) || loadedNames.Index( fn.GetName() ) != wxNOT_FOUND )
+            continue;
+
+        loadedNames.Add( fn.GetName() );
+        filenames.Add( filename );
     }
 
     // add the special cache library.
     wxString cache_name = CacheName( aProject->GetProjectFullName() );
+    bool     add_cache = false;
+
     if( !!cache_name )
     {
-        try
+        fn = cache_name;
+        add_cache = !FindLibrary( fn.GetName() )
+                    && loadedNames.Index( fn.GetName() ) == wxNOT_FOUND;
+
+        if( add_cache )
+            filenames.Add( cache_name );
+    }
+
+    // Libraries are independent, so they are parsed concurrently.  The results are
+    // appended afterwards in the configured order, which is the search order.
+    int                     count = filenames.GetCount();
+    std::vector<PART_LIB*>  libs( count, (PART_LIB*) NULL );
+    std::vector<wxString>   errors( count );
+    int                     ii;
+
+    {
+        wxBusyCursor ShowWait;
+
+#ifdef USE_OPENMP
+        #pragma omp parallel for schedule(dynamic, 1) private(ii)
+#endif /* USE_OPENMP */
+        for( ii = 0; ii < count; ii++ )
         {
-            if( PART_LIB* lib = AddLibrary( cache_name ) )
-                lib->SetCache();
+            try
+            {
+                libs[ii] = PART_LIB::loadLibrary( filenames[ii] );
+            }
+            catch( const IO_ERROR& ioe )
+            {
+                errors[ii] = ioe.errorText;
+            }
         }
-        catch( const IO_ERROR& ioe )
+    }
+
+    for( ii = 0; ii < count; ii++ )
+    {
+        if( !libs[ii] )
         {
-            wxString msg = wxString::Format( _(
-                    "Part library '%s' failed to load.\nError: %s" ),
-                    GetChars( cache_name ),
-                    GetChars( ioe.errorText )
-                    );
+            // Stop at the first library which failed, like a serial load would do.
+            for( int jj = ii + 1; jj < count; jj++ )
+                delete libs[jj];
+
+            bool is_cache = add_cache && ii == count - 1;
+
+            wxString msg = is_cache ?
+                    wxString::Format( _(
+                        "Part library '%s' failed to load.\nError: %s" ),
+                        GetChars( filenames[ii] ),
+                        GetChars( errors[ii] )
+                        ) :
+                    wxString::Format( _(
+                        "Part library '%s' failed to load. Error:\n"
+                        "%s" ),
+                        GetChars( filenames[ii] ),
+                        GetChars( errors[ii] )
+                        );
 
             THROW_IO_ERROR( msg );
         }
+
+        push_back( libs[ii] );
+        ++s_modify_generation;
+    }
+
+    if( !!cache_name )
+    {
+        fn = cache_name;
+
+        if( PART_LIB* lib = FindLibrary( fn.GetName() ) )
+            lib->SetCache();
     }
 
     // Print the libraries not found
@@ -36,6 +36,7 @@
 #include <class_libentry.h>
 
 #include <project.h>
+#include <hashtables.h>
 
 class LINE_READER;
 class OUTPUTFORMATTER;
@@ -105,9 +106,11 @@ class PART_LIBS : public PART_LIBS_BASE, public PROJECT::_ELEM
 {
 public:
 
-    static int s_modify_generation;     ///< helper for GetModifyHash()
+    static int s_modify_generation;     ///< helper for GetModifyHash(), bumped on any change
 
-    PART_LIBS()
+    PART_LIBS() :
+        m_indexGeneration( 0 ),
+        m_indexLibCount( 0 )
     {
         ++s_modify_generation;
     }
@@ -145,7 +148,11 @@ public:
      */
     void RemoveLibrary( const wxString& aName );
 
-    void RemoveAllLibraries()       { clear(); }
+    void RemoveAllLibraries()
+    {
+        clear();
+        ++s_modify_generation;
+    }
 
     /**
      * Function LoadAllLibraries
@@ -239,6 +246,24 @@ public:
 
     int GetLibraryCount() { return size(); }
 
+private:
+    /// Maps an alias name to the alias found first in the library search order
+    typedef boost::unordered_map< wxString, LIB_ALIAS*, WXSTRING_HASH >  ALIAS_INDEX;
+
+    /**
+     * Function findIndexedEntry
+     * searches all libraries for an entry using m_aliasIndex, which is rebuilt first
+     * if any library was added, removed or modified since it was built.  Names missing
+     * from every library cost a single hash lookup as well.
+     *
+     * @param aEntryName - Name of entry to search for.
+     * @return The entry object if found, otherwise NULL.
+     */
+    LIB_ALIAS* findIndexedEntry( const wxString& aEntryName );
+
+    ALIAS_INDEX     m_aliasIndex;       ///< all the aliases, respecting library precedence
+    int             m_indexGeneration;  ///< s_modify_generation when m_aliasIndex was built
+    size_t          m_indexLibCount;    ///< size() when m_aliasIndex was built
 };
 
 
@@ -546,6 +571,14 @@ public:
      * @throw IO_ERROR if there's any problem loading the library.
      */
     static PART_LIB* LoadLibrary( const wxString& aFileName ) throw( IO_ERROR );
+
+private:
+    /**
+     * Function loadLibrary
+     * is LoadLibrary() without any user interface call, so several libraries can be
+     * loaded concurrently on worker threads.
+     */
+    static PART_LIB* loadLibrary( const wxString& aFileName ) throw( IO_ERROR );
 };
 
 
@@ -36,6 +36,7 @@
 #include <class_netlist_object.h>
 
 #include <wx/regex.h>
+#include <wx/thread.h>
 
 
 /**
@@ -45,12 +46,20 @@
  */
 static wxRegEx busLabelRe( wxT( "^([^[:space:]]+)(\\[[\\d]+\\.+[\\d]+\\])$" ), wxRE_ADVANCED );
 
+/**
+ * wxRegEx keeps the result of the last match, so the regular expression is locked when
+ * netlist items are created from several threads.
+ */
+static wxMutex busLabelLock;
+
 
 bool IsBusLabel( const wxString& aLabel )
 {
     wxCHECK_MSG( busLabelRe.IsValid(), false,
                  wxT( "Invalid regular expression in IsBusLabel()." ) );
 
+    wxMutexLocker lock( busLabelLock );
+
     return busLabelRe.Matches( aLabel );
 }
 
@@ -252,8 +261,14 @@ void NETLIST_OBJECT::ConvertBusToNetListItems( NETLIST_OBJECT_LIST& aNetListItem
     wxString tmp, busName, busNumber;
     long begin, end, member;
 
-    busName = busLabelRe.GetMatch( m_Label, 1 );
-    busNumber = busLabelRe.GetMatch( m_Label, 2 );
+    {
+        wxMutexLocker lock( busLabelLock );
+
+        // Another thread may have used the regular expression after the check above
+        busLabelRe.Matches( m_Label );
+        busName = busLabelRe.GetMatch( m_Label, 1 );
+        busNumber = busLabelRe.GetMatch( m_Label, 2 );
+    }
 
     /* Search for  '[' because a bus label is like "busname[nn..mm]" */
     i = busNumber.Find( '[' );
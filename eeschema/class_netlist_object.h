@@ -35,7 +35,10 @@
 #include <sch_sheet_path.h>
 #include <lib_pin.h>      // LIB_PIN::PinStringNum( m_PinNum )
 
+#include <map>
+
 class NETLIST_OBJECT_LIST;
+class NETLIST_CONNECTION_INDEX;
 class SCH_COMPONENT;
 
 
@@ -267,6 +270,16 @@ class NETLIST_OBJECT_LIST : public std::vector <NETLIST_OBJECT*>
     int m_lastBusNetCode;   // Used in intermediate calculation:
                             // last net code created for bus members
 
+    // Used in intermediate calculation: when 2 nets are merged, the old net code is
+    // linked to the new one (union-find), instead of updating all items of the old net.
+    // m_netParent[code] is the code the net was merged to, or code itself.
+    // Net codes of items are updated by resolveNetCodes()
+    std::vector<int> m_netParent;
+    std::vector<int> m_busNetParent;
+
+    // Label type items, indexed by their lower case name
+    typedef std::map< wxString, std::vector<NETLIST_OBJECT*> > LABEL_INDEX;
+
 public:
     /**
      * Constructor.
@@ -286,6 +299,8 @@ public:
      * the master function of tgis class.
      * Build the list of connected objects (pins, labels ...) and
      * all info to generate netlists or run ERC diags
+     * Items of a sheet and their connections inside the sheet are cached, and built
+     * again only when the sheet screen is modified (see SCH_SCREEN::GetConnectivityStamp())
      * @param aSheets = the flattened sheet list
      * @return true if OK, false is not item found
      */
@@ -378,19 +393,68 @@ public:
     #endif
 
 private:
+    /*
+     * Fill the list with the connected items of aSheet, and build their connections
+     * (see connectSheetItems())
+     */
+    void buildSheetItems( SCH_SHEET_PATH* aSheet );
+
+    /*
+     * Append copies of the items of aSource, connected by buildSheetItems()
+     */
+    void copyItems( const NETLIST_OBJECT_LIST& aSource );
+
+    /*
+     * Build the connections between items of a single sheet.
+     * The list is expected to contain only items of this sheet.
+     * Net codes and bus net codes are numbered from 1, m_lastNetCode and m_lastBusNetCode
+     * are the first unused codes.
+     */
+    void connectSheetItems();
+
     /*
      * Propagate aNewNetCode to items having an internal netcode aOldNetCode
      * used to interconnect group of items already physically connected,
      * when a new connection is found between aOldNetCode and aNewNetCode
+     * Both codes must be current codes, i.e. returned by getNetCode()
      */
     void propageNetCode( int aOldNetCode, int aNewNetCode, bool aIsBus );
 
+    /*
+     * @return the net code (or the bus net code) aNetCode was merged to
+     */
+    int findNetCode( int aNetCode, bool aIsBus );
+
+    /*
+     * @return the current net code (or bus net code) of aItem, while connections are searched
+     */
+    int getNetCode( NETLIST_OBJECT* aItem, bool aIsBus )
+    {
+        return findNetCode( aIsBus ? aItem->m_BusNetCode : aItem->GetNet(), aIsBus );
+    }
+
+    /*
+     * Set the net code (or the bus net code) of a single item
+     */
+    void setNetCode( NETLIST_OBJECT* aItem, int aNetCode, bool aIsBus );
+
+    /*
+     * Store the current net codes in items, once connections are found
+     */
+    void resolveNetCodes();
+
+    /*
+     * Fill aIndex with the label type items of the list
+     */
+    void buildLabelIndex( LABEL_INDEX& aIndex ) const;
+
     /*
      * This function merges the net codes of groups of objects already connected
      * to labels (wires, bus, pins ... ) when 2 labels are equivalents
      * (i.e. group objects connected by labels)
+     * aLabels is the index of labels built by buildLabelIndex()
      */
-    void labelConnect( NETLIST_OBJECT* aLabelRef );
+    void labelConnect( NETLIST_OBJECT* aLabelRef, const LABEL_INDEX& aLabels );
 
     /* Comparison function to sort by increasing Netcode the list of connected items
      */
@@ -409,19 +473,26 @@ private:
     /*
      * Propagate net codes from a parent sheet to an include sheet,
      * from a pin sheet connection
+     * aLabels is the index of labels built by buildLabelIndex()
      */
-    void sheetLabelConnect( NETLIST_OBJECT* aSheetLabel );
+    void sheetLabelConnect( NETLIST_OBJECT* aSheetLabel, const LABEL_INDEX& aLabels );
 
-    void pointToPointConnect( NETLIST_OBJECT* aRef, bool aIsBus, int start );
+    /*
+     * Search items of the sheet of aRef having an end point common with aRef
+     * Propagate the aRef net code to these items.
+     * aSheetItems is the index of items of the aRef sheet
+     */
+    void pointToPointConnect( NETLIST_OBJECT* aRef, bool aIsBus,
+                              const NETLIST_CONNECTION_INDEX& aSheetItems );
 
     /*
      * Search connections betweena junction and segments
      * Propagate the junction net code to objects connected by this junction.
      * The junction must have a valid net code
-     * The list of objects is expected sorted by sheets.
-     * Search is done from index aIdxStart to the last element of list
+     * aSheetItems is the index of items of the junction sheet
      */
-    void segmentToPointConnect( NETLIST_OBJECT* aJonction, bool aIsBus, int aIdxStart );
+    void segmentToPointConnect( NETLIST_OBJECT* aJonction, bool aIsBus,
+                                const NETLIST_CONNECTION_INDEX& aSheetItems );
 
     void connectBusLabels();
 
@@ -24,6 +24,7 @@
 #include <component_tree_search_container.h>
 
 #include <algorithm>
+#include <iterator>
 #include <boost/foreach.hpp>
 #include <set>
 
@@ -98,6 +99,38 @@ bool COMPONENT_TREE_SEARCH_CONTAINER::scoreComparator( const TREE_NODE* a1, cons
 }
 
 
+bool COMPONENT_TREE_SEARCH_CONTAINER::hasMatchScore( const TREE_NODE* aNode )
+{
+    return aNode->MatchScore > 0;
+}
+
+
+// Appends all the trigrams of aText to aTrigrams, each one packed in a single integer.
+// Code points fit in 21 bits, so three of them fit in 63 bits.
+static void getTrigrams( const wxString& aText, std::vector<wxUint64>& aTrigrams )
+{
+    const wxUint64 mask = ( (wxUint64) 1 << 63 ) - 1;
+    wxUint64 trigram = 0;
+    int length = 0;
+
+    for( wxString::const_iterator it = aText.begin(); it != aText.end(); ++it )
+    {
+        const wxChar c = *it;
+
+        trigram = ( ( trigram << 21 ) | ( (wxUint32) c & 0x1FFFFF ) ) & mask;
+
+        if( ++length >= 3 )
+            aTrigrams.push_back( trigram );
+    }
+}
+
+
+static bool shorterList( const std::vector<int>* aFirst, const std::vector<int>* aSecond )
+{
+    return aFirst->size() < aSecond->size();
+}
+
+
 COMPONENT_TREE_SEARCH_CONTAINER::COMPONENT_TREE_SEARCH_CONTAINER( PART_LIBS* aLibs ) :
     tree( NULL ),
     libraries_added( 0 ),
@@ -147,6 +180,13 @@ void COMPONENT_TREE_SEARCH_CONTAINER::AddAliasList( const wxString& aNodeName,
     TREE_NODE* const lib_node = new TREE_NODE( TREE_NODE::TYPE_LIB,  NULL, NULL,
                                                aNodeName, wxEmptyString, wxEmptyString );
     nodes.push_back( lib_node );
+    m_libNodes.push_back( lib_node );
+    m_libFirstAlias.push_back( m_aliasNodes.size() );
+
+    // Results of the previous search do not cover the new aliases.
+    m_lastSearch.Clear();
+
+    std::vector<wxUint64> trigrams;
 
     BOOST_FOREACH( const wxString& aName, aAliasNameList )
     {
@@ -189,6 +229,23 @@ void COMPONENT_TREE_SEARCH_CONTAINER::AddAliasList( const wxString& aNodeName,
                                                a, a->GetName(), display_info, search_text );
         nodes.push_back( alias_node );
 
+        // Index the text searched by UpdateSearchTerm(). The name and the search text are
+        // separate strings, so trigrams spanning both of them are not indexed.
+        const int alias_pos = m_aliasNodes.size();
+        m_aliasNodes.push_back( alias_node );
+
+        trigrams.clear();
+        getTrigrams( alias_node->MatchName, trigrams );
+        getTrigrams( alias_node->SearchText, trigrams );
+
+        BOOST_FOREACH( wxUint64 trigram, trigrams )
+        {
+            std::vector<int>& aliases = m_trigrams[trigram];
+
+            if( aliases.empty() || aliases.back() != alias_pos )
+                aliases.push_back( alias_pos );
+        }
+
         if( a->GetPart()->IsMulti() )    // Add all units as sub-nodes.
         {
             for( int u = 1; u <= a->GetPart()->GetUnitCount(); ++u )
@@ -240,22 +297,131 @@ static int matchPosScore(int aPosition, int aMaximum)
 }
 
 
+bool COMPONENT_TREE_SEARCH_CONTAINER::findCandidates( const wxString& aTerm,
+                                                      std::vector<int>& aCandidates ) const
+{
+    std::vector<wxUint64> trigrams;
+    getTrigrams( aTerm, trigrams );
+
+    if( trigrams.empty() )
+        return false;
+
+    aCandidates.clear();
+
+    // Aliases having all the trigrams of the term in their own text.
+    std::vector<const std::vector<int>*> lists;
+
+    BOOST_FOREACH( wxUint64 trigram, trigrams )
+    {
+        TRIGRAM_INDEX::const_iterator it = m_trigrams.find( trigram );
+
+        if( it == m_trigrams.end() )
+        {
+            lists.clear();      // No alias has this trigram.
+            break;
+        }
+
+        lists.push_back( &it->second );
+    }
+
+    if( !lists.empty() )
+    {
+        // Intersecting the shortest lists first keeps the intermediate results small.
+        std::sort( lists.begin(), lists.end(), shorterList );
+        aCandidates = *lists[0];
+
+        std::vector<int> narrowed;
+
+        for( unsigned i = 1; i < lists.size() && !aCandidates.empty(); ++i )
+        {
+            narrowed.clear();
+            std::set_intersection( aCandidates.begin(), aCandidates.end(),
+                                   lists[i]->begin(), lists[i]->end(),
+                                   std::back_inserter( narrowed ) );
+            aCandidates.swap( narrowed );
+        }
+    }
+
+    // A term matching the library name matches all the aliases of the library.
+    bool added = false;
+
+    for( unsigned i = 0; i < m_libNodes.size(); ++i )
+    {
+        if( m_libNodes[i]->MatchName.Find( aTerm ) == wxNOT_FOUND )
+            continue;
+
+        const int end = ( i + 1 < m_libNodes.size() ) ? m_libFirstAlias[i + 1]
+                                                      : (int) m_aliasNodes.size();
+
+        for( int pos = m_libFirstAlias[i]; pos < end; ++pos )
+            aCandidates.push_back( pos );
+
+        added = true;
+    }
+
+    if( added )
+    {
+        std::sort( aCandidates.begin(), aCandidates.end() );
+        aCandidates.erase( std::unique( aCandidates.begin(), aCandidates.end() ),
+                           aCandidates.end() );
+    }
+
+    return true;
+}
+
+
 void COMPONENT_TREE_SEARCH_CONTAINER::UpdateSearchTerm( const wxString& aSearch )
 {
     if( tree == NULL )
         return;
 
-    // We score the list by going through it several time, essentially with a complexity
-    // of O(n). For the default library of 2000+ items, this typically takes less than 5ms
-    // on an i5. Good enough, no index needed.
+    // Only the aliases which may match all the terms are scored. Candidates come from the
+    // trigram index built in AddAliasList(), terms shorter than a trigram do not restrict them.
+    // When the search string extends the previous one (the usual case while typing), the
+    // aliases matching it also matched the previous string, so only these are looked at.
+    std::vector<int> candidates;
+
+    if( !m_lastSearch.IsEmpty() && aSearch.StartsWith( m_lastSearch ) )
+    {
+        candidates = m_lastMatches;
+    }
+    else
+    {
+        candidates.resize( m_aliasNodes.size() );
+
+        for( unsigned i = 0; i < candidates.size(); ++i )
+            candidates[i] = i;
+    }
+
+    std::vector<wxString> terms;
+    std::vector<int> term_candidates;
+    std::vector<int> narrowed;
+    wxStringTokenizer tokenizer( aSearch );
+
+    while ( tokenizer.HasMoreTokens() )
+    {
+        terms.push_back( tokenizer.GetNextToken().Lower() );
+
+        if( !findCandidates( terms.back(), term_candidates ) )
+            continue;
+
+        narrowed.clear();
+        std::set_intersection( candidates.begin(), candidates.end(),
+                               term_candidates.begin(), term_candidates.end(),
+                               std::back_inserter( narrowed ) );
+        candidates.swap( narrowed );
+    }
 
-    // Initial AND condition: Leaf nodes are considered to match initially.
+    // Initial AND condition: Candidate leaf nodes are considered to match initially.
     BOOST_FOREACH( TREE_NODE* node, nodes )
     {
         node->PreviousScore = node->MatchScore;
-        node->MatchScore = ( node->Type == TREE_NODE::TYPE_LIB ) ? 0 : kLowestDefaultScore;
+        node->MatchScore = 0;
     }
 
+    BOOST_FOREACH( int pos, candidates )
+        m_aliasNodes[pos]->MatchScore = kLowestDefaultScore;
+
     // Create match scores for each node for all the terms, that come space-separated.
     // Scoring adds up values for each term according to importance of the match. If a term does
     // not match at all, the result is thrown out of the results (AND semantics).
@@ -267,16 +433,11 @@ void COMPONENT_TREE_SEARCH_CONTAINER::UpdateSearchTerm( const wxString& aSearch
     //     first so contribute more to the score.
     //
     // This is of course subject to tweaking.
-    wxStringTokenizer tokenizer( aSearch );
-
-    while ( tokenizer.HasMoreTokens() )
+    BOOST_FOREACH( const wxString& term, terms )
     {
-        const wxString term = tokenizer.GetNextToken().Lower();
-
-        BOOST_FOREACH( TREE_NODE* node, nodes )
+        BOOST_FOREACH( int pos, candidates )
         {
-            if( node->Type != TREE_NODE::TYPE_ALIAS )
-                continue;      // Only aliases are actually scored here.
+            TREE_NODE* node = m_aliasNodes[pos];
 
             if( node->MatchScore == 0)
                 continue;   // Leaf node without score are out of the game.
@@ -311,39 +472,43 @@ void COMPONENT_TREE_SEARCH_CONTAINER::UpdateSearchTerm( const wxString& aSearch
         }
     }
 
+    m_lastSearch = aSearch;
+    m_lastMatches.clear();
+
+    BOOST_FOREACH( int pos, candidates )
+    {
+        if( m_aliasNodes[pos]->MatchScore > 0 )
+            m_lastMatches.push_back( pos );
+    }
+
     // Library nodes have the maximum score seen in any of their children.
-    // Alias nodes have the score of their parents.
+    // Unit nodes have the score of their parents.
     unsigned highest_score_seen = 0;
     bool any_change = false;
 
-    BOOST_FOREACH( TREE_NODE* node, nodes )
+    BOOST_FOREACH( TREE_NODE* node, m_aliasNodes )
     {
-        switch( node->Type )
-        {
-        case TREE_NODE::TYPE_ALIAS:
-            {
-                any_change |= (node->PreviousScore != node->MatchScore);
-                // Update library score.
-                node->Parent->MatchScore = std::max( node->Parent->MatchScore, node->MatchScore );
-                highest_score_seen = std::max( highest_score_seen, node->MatchScore );
-            }
-            break;
+        any_change |= (node->PreviousScore != node->MatchScore);
+        // Update library score.
+        node->Parent->MatchScore = std::max( node->Parent->MatchScore, node->MatchScore );
+        highest_score_seen = std::max( highest_score_seen, node->MatchScore );
+    }
 
-        case TREE_NODE::TYPE_UNIT:
+    BOOST_FOREACH( TREE_NODE* node, nodes )
+    {
+        if( node->Type == TREE_NODE::TYPE_UNIT )
             node->MatchScore = node->Parent->MatchScore;
-            break;
-
-        default:
-            break;
-        }
     }
 
     // The tree update might be slow, so we want to bail out if there is no change.
     if( !any_change )
         return;
 
-    // Now: sort all items according to match score, libraries first.
-    std::sort( nodes.begin(), nodes.end(), scoreComparator );
+    // Now: sort the items having a match according to match score, libraries first. Only
+    // these are displayed, so the (usually many more) others are just moved out of the way.
+    const std::vector<TREE_NODE*>::iterator matches_end =
+        std::partition( nodes.begin(), nodes.end(), hasMatchScore );
+    std::sort( nodes.begin(), matches_end, scoreComparator );
 
     // Fill the tree with all items that have a match. Re-arranging, adding and removing changed
     // items is pretty complex, so we just re-build the whole tree.
@@ -353,10 +518,9 @@ void COMPONENT_TREE_SEARCH_CONTAINER::UpdateSearchTerm( const wxString& aSearch
     const TREE_NODE* first_match = NULL;
     const TREE_NODE* preselected_node = NULL;
 
-    BOOST_FOREACH( TREE_NODE* node, nodes )
+    for( std::vector<TREE_NODE*>::iterator it = nodes.begin(); it != matches_end; ++it )
     {
-        if( node->MatchScore == 0 )
-            continue;
+        TREE_NODE* node = *it;
 
         // If we have nodes that go beyond the default score, suppress nodes that
         // have the default score. That can happen if they have an honary += 0 score due to
@@ -26,6 +26,7 @@
 
 #include <vector>
 #include <wx/string.h>
+#include <boost/unordered_map.hpp>
 
 class LIB_ALIAS;
 class PART_LIB;
@@ -105,6 +106,18 @@ public:
 private:
     struct TREE_NODE;
     static bool scoreComparator( const TREE_NODE* a1, const TREE_NODE* a2 );
+    static bool hasMatchScore( const TREE_NODE* aNode );
+
+    /** Function findCandidates
+     * Find the aliases which may match a search term, using the trigram index: an alias
+     * matches only if its name, keywords and description contain all the trigrams of the
+     * term, or if the name of its library contains the term.
+     *
+     * @param aTerm is the lower case search term.
+     * @param aCandidates receives the sorted positions in m_aliasNodes of the candidates.
+     * @return false if aTerm is too short to be looked up in the index.
+     */
+    bool findCandidates( const wxString& aTerm, std::vector<int>& aCandidates ) const;
 
     std::vector<TREE_NODE*> nodes;
     wxTreeCtrl* tree;
@@ -114,6 +127,21 @@ private:
     int preselect_unit_number;
 
     PART_LIBS*      m_libs;         // no ownership
+
+    // Search index, built while adding libraries.
+    std::vector<TREE_NODE*> m_aliasNodes;   ///< Alias nodes, in the order they were added.
+    std::vector<TREE_NODE*> m_libNodes;     ///< Library nodes, in the order they were added.
+    std::vector<int> m_libFirstAlias;       ///< Position of the first alias of each library
+                                            ///< in m_aliasNodes (aliases of a library are
+                                            ///< contiguous).
+
+    /// Trigram of lower case text -> sorted positions in m_aliasNodes of the aliases
+    /// having this trigram in their name, keywords or description.
+    typedef boost::unordered_map< wxUint64, std::vector<int> > TRIGRAM_INDEX;
+    TRIGRAM_INDEX m_trigrams;
+
+    wxString m_lastSearch;                  ///< Search string of the previous update.
+    std::vector<int> m_lastMatches;         ///< Aliases matching m_lastSearch.
 };
 
 #endif /* COMPONENT_TREE_SEARCH_CONTAINER_H */
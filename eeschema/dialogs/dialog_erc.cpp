@@ -474,16 +474,18 @@ void DIALOG_ERC::TestErc( wxArrayString* aMessagesList )
     unsigned nextNet = lastNet = 0;
     int NetNbItems = 0;
     int MinConn    = NOC;
+    ERC_NET_PINS netPins;
 
     for( unsigned net = 0; net < objectsConnectedList->size(); net++ )
     {
-        if( objectsConnectedList->GetItemNet( lastNet ) !=
+        if( net == 0 || objectsConnectedList->GetItemNet( lastNet ) !=
             objectsConnectedList->GetItemNet( net ) )
         {
             // New net found:
             MinConn    = NOC;
             NetNbItems = 0;
             nextNet   = net;
+            netPins.Init( objectsConnectedList, net );
         }
 
         switch( objectsConnectedList->GetItemType( net ) )
@@ -524,7 +526,7 @@ void DIALOG_ERC::TestErc( wxArrayString* aMessagesList )
         case NET_PIN:
 
             // Look for ERC problems between pins:
-            TestOthersItems( objectsConnectedList, net, nextNet, &NetNbItems, &MinConn );
+            TestOthersItems( objectsConnectedList, net, netPins, &NetNbItems, &MinConn );
             break;
         }
 
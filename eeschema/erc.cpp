@@ -346,14 +346,41 @@ void Diagnose( NETLIST_OBJECT* aNetItemRef, NETLIST_OBJECT* aNetItemTst,
 }
 
 
-void TestOthersItems( NETLIST_OBJECT_LIST* aList,
-                      unsigned aNetItemRef, unsigned aNetStart,
-                      int* aNetNbItems, int* aMinConnexion )
+void ERC_NET_PINS::Init( NETLIST_OBJECT_LIST* aList, unsigned aNetStart )
 {
-    unsigned netItemTst = aNetStart;
-    int jj;
-    int erc = OK;
+    m_hasNoConnect = false;
 
+    for( int ii = 0; ii < PIN_NMAX; ii++ )
+    {
+        m_pins[ii].clear();
+        m_next[ii] = 0;
+    }
+
+    for( m_netEnd = aNetStart; m_netEnd < aList->size(); m_netEnd++ )
+    {
+        if( aList->GetItemNet( m_netEnd ) != aList->GetItemNet( aNetStart ) )
+            break;
+
+        switch( aList->GetItemType( m_netEnd ) )
+        {
+        case NET_NOCONNECT:
+            m_hasNoConnect = true;
+            break;
+
+        case NET_PIN:
+            m_pins[aList->GetItem( m_netEnd )->m_ElectricalType].push_back( m_netEnd );
+            break;
+
+        default:
+            break;
+        }
+    }
+}
+
+
+void TestOthersItems( NETLIST_OBJECT_LIST* aList, unsigned aNetItemRef,
+                      ERC_NET_PINS& aNetPins, int* aNetNbItems, int* aMinConnexion )
+{
     /* Analysis of the table of connections. */
     int ref_elect_type = aList->GetItem( aNetItemRef )->m_ElectricalType;
     int local_minconn = NOC;
@@ -361,124 +388,98 @@ void TestOthersItems( NETLIST_OBJECT_LIST* aList,
     if( ref_elect_type == PIN_NC )
         local_minconn = NPI;
 
-    /* Test pins connected to NetItemRef */
-    for( ; ; netItemTst++ )
-    {
-        if( aNetItemRef == netItemTst )
-            continue;
+    // Pins after NetItemRef, by electrical type
+    wxASSERT( aNetPins.m_pins[ref_elect_type][aNetPins.m_next[ref_elect_type]] == aNetItemRef );
+    aNetPins.m_next[ref_elect_type]++;
 
-        // We examine only a given net. We stop the search if the net changes
-        if( ( netItemTst >= aList->size() ) // End of list
-            || ( aList->GetItemNet( aNetItemRef ) !=
-                 aList->GetItemNet( netItemTst ) ) ) // End of net
-        {
-            /* End net code found: minimum connection test. */
-            if( ( *aMinConnexion < NET_NC ) && ( local_minconn < NET_NC ) )
-            {
-                /* Not connected or not driven pin. */
-                bool seterr = true;
+    /* Test pins connected to NetItemRef, using the pins of each type */
+    if( aNetPins.m_hasNoConnect )
+        local_minconn = std::max( NET_NC, local_minconn );
 
-                if( local_minconn == NOC &&
-                    aList->GetItemType( aNetItemRef ) == NET_PIN )
-                {
-                    /* This pin is not connected: for multiple part per
-                     * package, and duplicated pin,
-                     * search for an other instance of this pin
-                     * this will be flagged only if all instances of this pin
-                     * are not connected
-                     * TODO test also if instances connected are connected to
-                     * the same net
-                     */
-                    for( unsigned duplicate = 0; duplicate < aList->size(); duplicate++ )
-                    {
-                        if( aList->GetItemType( duplicate ) != NET_PIN )
-                            continue;
-
-                        if( duplicate == aNetItemRef )
-                            continue;
-
-                        if( aList->GetItem( aNetItemRef )->m_PinNum !=
-                            aList->GetItem( duplicate )->m_PinNum )
-                            continue;
-
-                        if( ( (SCH_COMPONENT*) aList->GetItem( aNetItemRef )->
-                             m_Link )->GetRef( &aList->GetItem( aNetItemRef )-> m_SheetPath ) !=
-                            ( (SCH_COMPONENT*) aList->GetItem( duplicate )->m_Link )
-                           ->GetRef( &aList->GetItem( duplicate )->m_SheetPath ) )
-                            continue;
-
-                        // Same component and same pin. Do dot create error for this pin
-                        // if the other pin is connected (i.e. if duplicate net has an other
-                        // item)
-                        if( (duplicate > 0)
-                          && ( aList->GetItemNet( duplicate ) ==
-                               aList->GetItemNet( duplicate - 1 ) ) )
-                            seterr = false;
-
-                        if( (duplicate < aList->size() - 1)
-                          && ( aList->GetItemNet( duplicate ) ==
-                               aList->GetItemNet( duplicate + 1 ) ) )
-                            seterr = false;
-                    }
-                }
+    // Only the first pin after NetItemRef having a conflict with it is diagnosed.
+    // It is the first of the next pins of the conflicting types.
+    unsigned netItemTst = aNetPins.m_netEnd;
 
-                if( seterr )
-                    Diagnose( aList->GetItem( aNetItemRef ), NULL, local_minconn, WAR );
+    for( int jj = 0; jj < PIN_NMAX; jj++ )
+    {
+        const std::vector<unsigned>& pins = aNetPins.m_pins[jj];
 
-                *aMinConnexion = DRV;   // inhibiting other messages of this
-                                       // type for the net.
-            }
-            return;
-        }
+        // Other pins of this type on the net
+        int count = pins.size() - ( jj == ref_elect_type ? 1 : 0 );
 
-        switch( aList->GetItemType( netItemTst ) )
-        {
-        case NET_ITEM_UNSPECIFIED:
-        case NET_SEGMENT:
-        case NET_BUS:
-        case NET_JUNCTION:
-        case NET_LABEL:
-        case NET_HIERLABEL:
-        case NET_BUSLABELMEMBER:
-        case NET_HIERBUSLABELMEMBER:
-        case NET_SHEETBUSLABELMEMBER:
-        case NET_SHEETLABEL:
-        case NET_GLOBLABEL:
-        case NET_GLOBBUSLABELMEMBER:
-        case NET_PINLABEL:
-            break;
+        if( count > 0 )
+            local_minconn = std::max( MinimalReq[ref_elect_type][jj], local_minconn );
 
-        case NET_NOCONNECT:
-            local_minconn = std::max( NET_NC, local_minconn );
-            break;
+        *aNetNbItems += pins.size() - aNetPins.m_next[jj];
 
-        case NET_PIN:
-            jj = aList->GetItem( netItemTst )->m_ElectricalType;
-            local_minconn = std::max( MinimalReq[ref_elect_type][jj], local_minconn );
+        if( aNetPins.m_next[jj] < pins.size() && DiagErc[ref_elect_type][jj] != OK )
+            netItemTst = std::min( netItemTst, pins[aNetPins.m_next[jj]] );
+    }
 
-            if( netItemTst <= aNetItemRef )
-                break;
+    if( netItemTst < aNetPins.m_netEnd
+      && aList->GetConnectionType( netItemTst ) == UNCONNECTED )
+    {
+        int erc = DiagErc[ref_elect_type][aList->GetItem( netItemTst )->m_ElectricalType];
 
-            *aNetNbItems += 1;
+        Diagnose( aList->GetItem( aNetItemRef ), aList->GetItem( netItemTst ), 0, erc );
+        aList->SetConnectionType( netItemTst, NOCONNECT_SYMBOL_PRESENT );
+    }
 
-            if( erc == OK )
+    /* Minimum connection test. */
+    if( ( *aMinConnexion < NET_NC ) && ( local_minconn < NET_NC ) )
+    {
+        /* Not connected or not driven pin. */
+        bool seterr = true;
+
+        if( local_minconn == NOC &&
+            aList->GetItemType( aNetItemRef ) == NET_PIN )
+        {
+            /* This pin is not connected: for multiple part per
+             * package, and duplicated pin,
+             * search for an other instance of this pin
+             * this will be flagged only if all instances of this pin
+             * are not connected
+             * TODO test also if instances connected are connected to
+             * the same net
+             */
+            for( unsigned duplicate = 0; duplicate < aList->size(); duplicate++ )
             {
-                erc = DiagErc[ref_elect_type][jj];
+                if( aList->GetItemType( duplicate ) != NET_PIN )
+                    continue;
 
-                if( erc != OK )
-                {
-                    if( aList->GetConnectionType( netItemTst ) == UNCONNECTED )
-                    {
-                        Diagnose( aList->GetItem( aNetItemRef ),
-                                  aList->GetItem( netItemTst ),
-                                  0, erc );
-                        aList->SetConnectionType( netItemTst, NOCONNECT_SYMBOL_PRESENT );
-                    }
-                }
-            }
+                if( duplicate == aNetItemRef )
+                    continue;
 
-            break;
+                if( aList->GetItem( aNetItemRef )->m_PinNum !=
+                    aList->GetItem( duplicate )->m_PinNum )
+                    continue;
+
+                if( ( (SCH_COMPONENT*) aList->GetItem( aNetItemRef )->
+                     m_Link )->GetRef( &aList->GetItem( aNetItemRef )-> m_SheetPath ) !=
+                    ( (SCH_COMPONENT*) aList->GetItem( duplicate )->m_Link )
+                   ->GetRef( &aList->GetItem( duplicate )->m_SheetPath ) )
+                    continue;
+
+                // Same component and same pin. Do dot create error for this pin
+                // if the other pin is connected (i.e. if duplicate net has an other
+                // item)
+                if( (duplicate > 0)
+                  && ( aList->GetItemNet( duplicate ) ==
+                       aList->GetItemNet( duplicate - 1 ) ) )
+                    seterr = false;
+
+                if( (duplicate < aList->size() - 1)
+                  && ( aList->GetItemNet( duplicate ) ==
+                       aList->GetItemNet( duplicate + 1 ) ) )
+                    seterr = false;
+            }
         }
+
+        if( seterr )
+            Diagnose( aList->GetItem( aNetItemRef ), NULL, local_minconn, WAR );
+
+        *aMinConnexion = DRV;   // inhibiting other messages of this
+                               // type for the net.
     }
 }
 
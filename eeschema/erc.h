@@ -30,6 +30,8 @@
 #ifndef _ERC_H
 #define _ERC_H
 
+#include <vector>
+
 
 class EDA_DRAW_PANEL;
 class NETLIST_OBJECT;
@@ -82,13 +84,33 @@ extern bool WriteDiagnosticERC( const wxString& aFullFileName );
 extern void Diagnose( NETLIST_OBJECT* NetItemRef, NETLIST_OBJECT* NetItemTst,
                       int MinConnexion, int Diag );
 
+/**
+ * Structure ERC_NET_PINS
+ * lists the pins of each electrical type on a net, so the pins of a net are tested
+ * against each other in linear time.
+ */
+struct ERC_NET_PINS
+{
+    unsigned              m_netEnd;         ///< Index of the first item of the next net
+    bool                  m_hasNoConnect;   ///< True if a no connect symbol is on the net
+    std::vector<unsigned> m_pins[PIN_NMAX]; ///< Item indexes of the pins of each type
+    unsigned              m_next[PIN_NMAX]; ///< Position in m_pins of the first pin
+                                            ///< after the last tested pin
+
+    /**
+     * Function Init
+     * lists the pins of the net starting at \a aNetStart in \a aList.
+     */
+    void Init( NETLIST_OBJECT_LIST* aList, unsigned aNetStart );
+};
+
 /**
  * Perform ERC testing for electrical conflicts between \a NetItemRef and other items
  * on the same net.
+ * Pins of a net must be tested in list order, with \a aNetPins initialized for this net.
  */
-extern void TestOthersItems( NETLIST_OBJECT_LIST* aList,
-                             unsigned aNetItemRef, unsigned aNetStart,
-                             int* aNetNbItems, int* aMinConnexion );
+extern void TestOthersItems( NETLIST_OBJECT_LIST* aList, unsigned aNetItemRef,
+                             ERC_NET_PINS& aNetPins, int* aNetNbItems, int* aMinConnexion );
 
 /**
  * Function TestLabel
@@ -26,6 +26,7 @@
  */
 
 #include <fctsys.h>
+#include <kicad_string.h>
 #include <gr_basic.h>
 #include <macros.h>
 #include <class_drawpanel.h>
@@ -72,6 +73,7 @@ bool LIB_BEZIER::Save( OUTPUTFORMATTER& aFormatter )
 bool LIB_BEZIER::Load( LINE_READER& aLineReader, wxString& aErrorMsg )
 {
     char*   p;
+    char*   saveptr;
     int     i, ccount = 0;
     wxPoint pt;
     char*   line = (char*) aLineReader;
@@ -90,15 +92,15 @@ bool LIB_BEZIER::Load( LINE_READER& aLineReader, wxString& aErrorMsg )
         return false;
     }
 
-    p = strtok( line + 2, " \t\n" );
-    p = strtok( NULL, " \t\n" );
-    p = strtok( NULL, " \t\n" );
-    p = strtok( NULL, " \t\n" );
+    p = strtok_r( line + 2, " \t\n", &saveptr );
+    p = strtok_r( NULL, " \t\n", &saveptr );
+    p = strtok_r( NULL, " \t\n", &saveptr );
+    p = strtok_r( NULL, " \t\n", &saveptr );
 
     for( i = 0; i < ccount; i++ )
     {
         wxPoint point;
-        p = strtok( NULL, " \t\n" );
+        p = strtok_r( NULL, " \t\n", &saveptr );
 
         if( sscanf( p, "%d", &pt.x ) != 1 )
         {
@@ -106,7 +108,7 @@ bool LIB_BEZIER::Load( LINE_READER& aLineReader, wxString& aErrorMsg )
             return false;
         }
 
-        p = strtok( NULL, " \t\n" );
+        p = strtok_r( NULL, " \t\n", &saveptr );
 
         if( sscanf( p, "%d", &pt.y ) != 1 )
         {
@@ -119,7 +121,7 @@ bool LIB_BEZIER::Load( LINE_READER& aLineReader, wxString& aErrorMsg )
 
     m_Fill = NO_FILL;
 
-    if( ( p = strtok( NULL, " \t\n" ) ) != NULL )
+    if( ( p = strtok_r( NULL, " \t\n", &saveptr ) ) != NULL )
     {
         if( p[0] == 'F' )
             m_Fill = FILLED_SHAPE;
@@ -27,6 +27,7 @@
  */
 
 #include <fctsys.h>
+#include <kicad_string.h>
 #include <gr_basic.h>
 #include <macros.h>
 #include <class_drawpanel.h>
@@ -74,6 +75,7 @@ bool LIB_POLYLINE::Save( OUTPUTFORMATTER& aFormatter )
 bool LIB_POLYLINE::Load( LINE_READER& aLineReader, wxString& aErrorMsg )
 {
     char*   p;
+    char*   saveptr;
     int     i, ccount = 0;
     wxPoint pt;
     char*   line = (char*) aLineReader;
@@ -94,15 +96,15 @@ bool LIB_POLYLINE::Load( LINE_READER& aLineReader, wxString& aErrorMsg )
         return false;
     }
 
-    p = strtok( line + 2, " \t\n" );
-    p = strtok( NULL, " \t\n" );
-    p = strtok( NULL, " \t\n" );
-    p = strtok( NULL, " \t\n" );
+    p = strtok_r( line + 2, " \t\n", &saveptr );
+    p = strtok_r( NULL, " \t\n", &saveptr );
+    p = strtok_r( NULL, " \t\n", &saveptr );
+    p = strtok_r( NULL, " \t\n", &saveptr );
 
     for( i = 0; i < ccount; i++ )
     {
         wxPoint point;
-        p = strtok( NULL, " \t\n" );
+        p = strtok_r( NULL, " \t\n", &saveptr );
 
         if( p == NULL || sscanf( p, "%d", &pt.x ) != 1 )
         {
@@ -110,7 +112,7 @@ bool LIB_POLYLINE::Load( LINE_READER& aLineReader, wxString& aErrorMsg )
             return false;
         }
 
-        p = strtok( NULL, " \t\n" );
+        p = strtok_r( NULL, " \t\n", &saveptr );
 
         if( p == NULL || sscanf( p, "%d", &pt.y ) != 1 )
         {
@@ -121,7 +123,7 @@ bool LIB_POLYLINE::Load( LINE_READER& aLineReader, wxString& aErrorMsg )
         AddPoint( pt );
     }
 
-    if( ( p = strtok( NULL, " \t\n" ) ) != NULL )
+    if( ( p = strtok_r( NULL, " \t\n", &saveptr ) ) != NULL )
     {
         if( p[0] == 'F' )
             m_Fill = FILLED_SHAPE;
@@ -44,9 +44,10 @@
 #include <sch_sheet.h>
 
 #include <wx/tokenzr.h>
-#include <xnode.h>      // also nests: <wx/xml/xml.h>
+#include <xstream.h>
 #include <build_version.h>
 #include <set>
+#include <map>
 
 #define INTERMEDIATE_NETLIST_EXT wxT("xml")
 
@@ -110,6 +111,24 @@ class NETLIST_EXPORT_TOOL
 
     std::set<void*>     m_Libraries;    ///< unique libraries used
 
+    /// A schematic component placed in a given sheet path, i.e. one unit of a package
+    struct COMPONENT_INSTANCE
+    {
+        SCH_COMPONENT*  m_Component;
+        SCH_SHEET_PATH  m_SheetPath;
+    };
+
+    typedef std::vector<COMPONENT_INSTANCE> COMPONENT_INSTANCES;
+
+    /// All the instances of the schematic components, keyed by upper case reference,
+    /// in the order of the sheet list and of the draw lists.
+    std::map<wxString, COMPONENT_INSTANCES>         m_componentInstances;
+
+    /// Pins of m_masterList, grouped by their parent item, in the m_masterList order.
+    std::map<SCH_ITEM*, std::vector<NETLIST_OBJECT*> > m_componentPins;
+
+    bool                m_indexBuilt;   ///< true once the two maps above are filled
+
 
     /**
      * Function sprintPinNetName
@@ -172,6 +191,15 @@ class NETLIST_EXPORT_TOOL
                                       LIB_PART*       aEntry,
                                       SCH_SHEET_PATH* aSheetPath );
 
+    /**
+     * Function buildComponentIndex
+     * fills m_componentInstances and m_componentPins in a single pass over the hierarchy
+     * and over m_masterList, if not already done. The index is shared by all the netlist
+     * writers, so looking for the units of a package or the pins of a component does not
+     * scan the whole design each time.
+     */
+    void buildComponentIndex();
+
     /**
      * Function writeGENERICListOfNets
      * writes out nets (ranked by Netcode), and elements that are
@@ -192,50 +220,50 @@ class NETLIST_EXPORT_TOOL
     bool writeListOfNetsCADSTAR( FILE* f );
 
     /**
-     * Function makeGenericRoot
-     * builds the entire document tree for the generic export.  This is factored
-     * out here so we can write the tree in either S-expression file format
-     * or in XML if we put the tree built here into a wxXmlDocument.
+     * Function writeGenericRoot
+     * writes the entire document for the generic export.  This is factored
+     * out here so we can write the document in either S-expression file format
+     * or in XML, depending on the kind of \a aOut.
      */
-    XNODE* makeGenericRoot();
+    void writeGenericRoot( XSTREAM& aOut ) throw( IO_ERROR );
 
     /**
-     * Function makeGenericComponents
-     * returns a sub-tree holding all the schematic components.
+     * Function writeGenericComponents
+     * writes the element holding all the schematic components.
      */
-    XNODE* makeGenericComponents();
+    void writeGenericComponents( XSTREAM& aOut ) throw( IO_ERROR );
 
     /**
-     * Function makeGenericDesignHeader
-     * fills out a project "design" header into an XML node.
-     * @return XNODE* - the design header
+     * Function writeGenericDesignHeader
+     * writes a project "design" header element.
      */
-    XNODE* makeGenericDesignHeader();
+    void writeGenericDesignHeader( XSTREAM& aOut ) throw( IO_ERROR );
 
     /**
-     * Function makeGenericLibParts
-     * fills out an XML node with the unique library parts and returns it.
+     * Function writeGenericLibParts
+     * writes an element holding the unique library parts.
      */
-    XNODE* makeGenericLibParts();
+    void writeGenericLibParts( XSTREAM& aOut ) throw( IO_ERROR );
 
     /**
-     * Function makeGenericListOfNets
-     * fills out an XML node with a list of nets and returns it.
+     * Function writeGenericListOfNets
+     * writes an element holding the list of nets.
      */
-    XNODE* makeGenericListOfNets();
+    void writeGenericListOfNets( XSTREAM& aOut ) throw( IO_ERROR );
 
     /**
-     * Function makeGenericLibraries
-     * fills out an XML node with a list of used libraries and returns it.
-     * Must have called makeGenericLibParts() before this function.
+     * Function writeGenericLibraries
+     * writes an element holding the list of used libraries.
+     * Must have called writeGenericLibParts() before this function.
      */
-    XNODE* makeGenericLibraries();
+    void writeGenericLibraries( XSTREAM& aOut ) throw( IO_ERROR );
 
 public:
     NETLIST_EXPORT_TOOL( NETLIST_OBJECT_LIST* aMasterList, PART_LIBS* aLibs )
     {
         m_masterList = aMasterList;
         m_libs = aLibs;
+        m_indexBuilt = false;
     }
 
     /**
@@ -630,37 +658,17 @@ SCH_COMPONENT* NETLIST_EXPORT_TOOL::findNextComponentAndCreatePinList( EDA_ITEM*
 }
 
 
-/**
- * Function node
- * is a convenience function that creates a new XNODE with an optional textual child.
- * It also provides some insulation from a possible change in XML library.
- *
- * @param aName is the name to associate with a new node of type wxXML_ELEMENT_NODE.
- * @param aTextualContent is optional, and if given is the text to include in a child
- *   of the returned node, and has type wxXML_TEXT_NODE.
- */
-static XNODE* node( const wxString& aName, const wxString& aTextualContent = wxEmptyString )
+void NETLIST_EXPORT_TOOL::writeGenericDesignHeader( XSTREAM& aOut ) throw( IO_ERROR )
 {
-    XNODE* n = new XNODE( wxXML_ELEMENT_NODE, aName );
-
-    if( aTextualContent.Len() > 0 )     // excludes wxEmptyString, the parameter's default value
-        n->AddChild( new XNODE( wxXML_TEXT_NODE, wxEmptyString, aTextualContent ) );
-
-    return n;
-}
-
-
-XNODE* NETLIST_EXPORT_TOOL::makeGenericDesignHeader()
-{
-    XNODE*  xdesign = node( wxT("design") );
+    aOut.StartElement( wxT( "design" ) );
 
     // the root sheet is a special sheet, call it source
-    xdesign->AddChild( node( wxT( "source" ), g_RootSheet->GetScreen()->GetFileName() ) );
+    aOut.AddElement( wxT( "source" ), g_RootSheet->GetScreen()->GetFileName() );
 
-    xdesign->AddChild( node( wxT( "date" ), DateAndTime() ) );
+    aOut.AddElement( wxT( "date" ), DateAndTime() );
 
     // which Eeschema tool
-    xdesign->AddChild( node( wxT( "tool" ), wxT( "Eeschema " ) + GetBuildVersion() ) );
+    aOut.AddElement( wxT( "tool" ), wxT( "Eeschema " ) + GetBuildVersion() );
 
     /*  @todo might do a list of schematic pages
 
@@ -684,33 +692,32 @@ XNODE* NETLIST_EXPORT_TOOL::makeGenericDesignHeader()
         </sheets>
     */
 
-    return xdesign;
+    aOut.EndElement();
 }
 
 
-XNODE* NETLIST_EXPORT_TOOL::makeGenericLibraries()
+void NETLIST_EXPORT_TOOL::writeGenericLibraries( XSTREAM& aOut ) throw( IO_ERROR )
 {
-    XNODE*  xlibs = node( wxT( "libraries" ) );     // auto_ptr
+    aOut.StartElement( wxT( "libraries" ) );
 
     for( std::set<void*>::iterator it = m_Libraries.begin(); it!=m_Libraries.end();  ++it )
     {
         PART_LIB*    lib = (PART_LIB*) *it;
-        XNODE*      xlibrary;
 
-        xlibs->AddChild( xlibrary = node( wxT( "library" ) ) );
-        xlibrary->AddAttribute( wxT( "logical" ), lib->GetLogicalName() );
-        xlibrary->AddChild( node( wxT( "uri" ),  lib->GetFullFileName() ) );
+        aOut.StartElement( wxT( "library" ) );
+        aOut.AddAttribute( wxT( "logical" ), lib->GetLogicalName() );
+        aOut.AddElement( wxT( "uri" ),  lib->GetFullFileName() );
 
         // @todo: add more fun stuff here
+        aOut.EndElement();
     }
 
-    return xlibs;
+    aOut.EndElement();
 }
 
 
-XNODE* NETLIST_EXPORT_TOOL::makeGenericLibParts()
+void NETLIST_EXPORT_TOOL::writeGenericLibParts( XSTREAM& aOut ) throw( IO_ERROR )
 {
-    XNODE*      xlibparts = node( wxT( "libparts" ) );   // auto_ptr
     wxString    sLibpart  = wxT( "libpart" );
     wxString    sLib      = wxT( "lib" );
     wxString    sPart     = wxT( "part" );
@@ -734,6 +741,8 @@ XNODE* NETLIST_EXPORT_TOOL::makeGenericLibParts()
 
     m_Libraries.clear();
 
+    aOut.StartElement( wxT( "libparts" ) );
+
     for( std::set<void*>::iterator it = m_LibParts.begin(); it!=m_LibParts.end();  ++it )
     {
         LIB_PART*       lcomp = (LIB_PART*     ) *it;
@@ -741,61 +750,63 @@ XNODE* NETLIST_EXPORT_TOOL::makeGenericLibParts()
 
         m_Libraries.insert( library );  // inserts component's library if unique
 
-        XNODE*      xlibpart;
-        xlibparts->AddChild( xlibpart = node( sLibpart ) );
-        xlibpart->AddAttribute( sLib, library->GetLogicalName() );
-        xlibpart->AddAttribute( sPart, lcomp->GetName()  );
+        aOut.StartElement( sLibpart );
+        aOut.AddAttribute( sLib, library->GetLogicalName() );
+        aOut.AddAttribute( sPart, lcomp->GetName()  );
 
         if( lcomp->GetAliasCount() )
         {
             wxArrayString aliases = lcomp->GetAliasNames( false );
             if( aliases.GetCount() )
             {
-                XNODE*  xaliases = node( sAliases );
-                xlibpart->AddChild( xaliases );
+                aOut.StartElement( sAliases );
                 for( unsigned i=0;  i<aliases.GetCount();  ++i )
                 {
-                    xaliases->AddChild( node( sAlias, aliases[i] ) );
+                    aOut.AddElement( sAlias, aliases[i] );
                 }
+                aOut.EndElement();
             }
         }
 
         //----- show the important properties -------------------------
         if( !lcomp->GetAlias( 0 )->GetDescription().IsEmpty() )
-            xlibpart->AddChild( node( sDescr, lcomp->GetAlias( 0 )->GetDescription() ) );
+            aOut.AddElement( sDescr, lcomp->GetAlias( 0 )->GetDescription() );
 
         if( !lcomp->GetAlias( 0 )->GetDocFileName().IsEmpty() )
-            xlibpart->AddChild( node( sDocs,  lcomp->GetAlias( 0 )->GetDocFileName() ) );
+            aOut.AddElement( sDocs,  lcomp->GetAlias( 0 )->GetDocFileName() );
 
         // Write the footprint list
         if( lcomp->GetFootPrints().GetCount() )
         {
-            XNODE*  xfootprints;
-            xlibpart->AddChild( xfootprints = node( sFprints ) );
+            aOut.StartElement( sFprints );
 
             for( unsigned i=0; i<lcomp->GetFootPrints().GetCount(); ++i )
             {
-                xfootprints->AddChild( node( sFp, lcomp->GetFootPrints()[i] ) );
+                aOut.AddElement( sFp, lcomp->GetFootPrints()[i] );
             }
+
+            aOut.EndElement();
         }
 
         //----- show the fields here ----------------------------------
         fieldList.clear();
         lcomp->GetFields( fieldList );
 
-        XNODE*     xfields;
-        xlibpart->AddChild( xfields = node( sFields ) );
+        aOut.StartElement( sFields );
 
         for( unsigned i=0;  i<fieldList.size();  ++i )
         {
             if( !fieldList[i].GetText().IsEmpty() )
             {
-                XNODE*     xfield;
-                xfields->AddChild( xfield = node( sField, fieldList[i].GetText() ) );
-                xfield->AddAttribute( sName, fieldList[i].GetName(false) );
+                aOut.StartElement( sField );
+                aOut.AddAttribute( sName, fieldList[i].GetName(false) );
+                aOut.AddText( fieldList[i].GetText() );
+                aOut.EndElement();
             }
         }
 
+        aOut.EndElement();
+
         //----- show the pins here ------------------------------------
         pinList.clear();
         lcomp->GetPins( pinList, 0, 0 );
@@ -820,30 +831,31 @@ XNODE* NETLIST_EXPORT_TOOL::makeGenericLibParts()
 
         if( pinList.size() )
         {
-            XNODE*     pins;
+            aOut.StartElement( sPins );
 
-            xlibpart->AddChild( pins = node( sPins ) );
             for( unsigned i=0; i<pinList.size();  ++i )
             {
-                XNODE*     pin;
-
-                pins->AddChild( pin = node( sPin ) );
-                pin->AddAttribute( sPinNum, pinList[i]->GetNumberString() );
-                pin->AddAttribute( sPinName, pinList[i]->GetName() );
-                pin->AddAttribute( sPinType, pinList[i]->GetTypeString() );
+                aOut.StartElement( sPin );
+                aOut.AddAttribute( sPinNum, pinList[i]->GetNumberString() );
+                aOut.AddAttribute( sPinName, pinList[i]->GetName() );
+                aOut.AddAttribute( sPinType, pinList[i]->GetTypeString() );
 
                 // caution: construction work site here, drive slowly
+                aOut.EndElement();
             }
+
+            aOut.EndElement();
         }
+
+        aOut.EndElement();
     }
 
-    return xlibparts;
+    aOut.EndElement();
 }
 
 
-XNODE* NETLIST_EXPORT_TOOL::makeGenericListOfNets()
+void NETLIST_EXPORT_TOOL::writeGenericListOfNets( XSTREAM& aOut ) throw( IO_ERROR )
 {
-    XNODE*      xnets = node( wxT( "nets" ) );      // auto_ptr if exceptions ever get used.
     wxString    netCodeTxt;
     wxString    netName;
     wxString    ref;
@@ -856,7 +868,7 @@ XNODE* NETLIST_EXPORT_TOOL::makeGenericListOfNets()
     wxString    sNode = wxT( "node" );
     wxString    sFmtd = wxT( "%d" );
 
-    XNODE*      xnet = 0;
+    bool        netOpen = false;
     int         netCode;
     int         lastNetCode = -1;
     int         sameNetcodeCount = 0;
@@ -871,6 +883,8 @@ XNODE* NETLIST_EXPORT_TOOL::makeGenericListOfNets()
 
     m_LibParts.clear();     // must call this function before using m_LibParts.
 
+    aOut.StartElement( wxT( "nets" ) );
+
     for( unsigned ii = 0; ii < m_masterList->size(); ii++ )
     {
         NETLIST_OBJECT* nitem = m_masterList->GetItem( ii );
@@ -899,48 +913,53 @@ XNODE* NETLIST_EXPORT_TOOL::makeGenericListOfNets()
 
         if( ++sameNetcodeCount == 1 )
         {
-            xnets->AddChild( xnet = node( sNet ) );
+            if( netOpen )
+                aOut.EndElement();
+
+            aOut.StartElement( sNet );
+            netOpen = true;
             netCodeTxt.Printf( sFmtd, netCode );
-            xnet->AddAttribute( sCode, netCodeTxt );
-            xnet->AddAttribute( sName, netName );
+            aOut.AddAttribute( sCode, netCodeTxt );
+            aOut.AddAttribute( sName, netName );
         }
 
-        XNODE*      xnode;
-        xnet->AddChild( xnode = node( sNode ) );
-        xnode->AddAttribute( sRef, ref );
-        xnode->AddAttribute( sPin,  nitem->GetPinNumText() );
+        aOut.StartElement( sNode );
+        aOut.AddAttribute( sRef, ref );
+        aOut.AddAttribute( sPin,  nitem->GetPinNumText() );
+        aOut.EndElement();
     }
 
-    return xnets;
+    if( netOpen )
+        aOut.EndElement();
+
+    aOut.EndElement();
 }
 
 
-XNODE* NETLIST_EXPORT_TOOL::makeGenericRoot()
+void NETLIST_EXPORT_TOOL::writeGenericRoot( XSTREAM& aOut ) throw( IO_ERROR )
 {
-    XNODE*      xroot = node( wxT( "export" ) );
+    aOut.StartElement( wxT( "export" ) );
 
-    xroot->AddAttribute( wxT( "version" ), wxT( "D" ) );
+    aOut.AddAttribute( wxT( "version" ), wxT( "D" ) );
 
     // add the "design" header
-    xroot->AddChild( makeGenericDesignHeader() );
+    writeGenericDesignHeader( aOut );
 
-    xroot->AddChild( makeGenericComponents() );
+    writeGenericComponents( aOut );
 
-    xroot->AddChild( makeGenericLibParts() );
+    writeGenericLibParts( aOut );
 
-    // must follow makeGenericLibParts()
-    xroot->AddChild( makeGenericLibraries() );
+    // must follow writeGenericLibParts()
+    writeGenericLibraries( aOut );
 
-    xroot->AddChild( makeGenericListOfNets() );
+    writeGenericListOfNets( aOut );
 
-    return xroot;
+    aOut.EndElement();
 }
 
 
-XNODE* NETLIST_EXPORT_TOOL::makeGenericComponents()
+void NETLIST_EXPORT_TOOL::writeGenericComponents( XSTREAM& aOut ) throw( IO_ERROR )
 {
-    XNODE*      xcomps = node( wxT( "components" ) );
-
     wxString    timeStamp;
 
     // some strings we need many times, but don't want to construct more
@@ -973,6 +992,8 @@ XNODE* NETLIST_EXPORT_TOOL::makeGenericComponents()
 
     SCH_SHEET_LIST sheetList;
 
+    aOut.StartElement( wxT( "components" ) );
+
     // Output is xml, so there is no reason to remove spaces from the field values.
     // And XML element names need not be translated to various languages.
 
@@ -986,31 +1007,28 @@ XNODE* NETLIST_EXPORT_TOOL::makeGenericComponents()
 
             schItem = comp;
 
-            XNODE* xcomp;  // current component being constructed
-
             // Output the component's elements in order of expected access frequency.
             // This may not always look best, but it will allow faster execution
             // under XSL processing systems which do sequential searching within
             // an element.
 
-            xcomps->AddChild( xcomp = node( sComponent ) );
-            xcomp->AddAttribute( sRef, comp->GetRef( path ) );
+            aOut.StartElement( sComponent );
+            aOut.AddAttribute( sRef, comp->GetRef( path ) );
 
-            xcomp->AddChild( node( sValue, comp->GetField( VALUE )->GetText() ) );
+            aOut.AddElement( sValue, comp->GetField( VALUE )->GetText() );
 
             if( !comp->GetField( FOOTPRINT )->IsVoid() )
-                xcomp->AddChild( node( sFootprint, comp->GetField( FOOTPRINT )->GetText() ) );
+                aOut.AddElement( sFootprint, comp->GetField( FOOTPRINT )->GetText() );
 
             if( !comp->GetField( DATASHEET )->IsVoid() )
-                xcomp->AddChild( node( sDatasheet, comp->GetField( DATASHEET )->GetText() ) );
+                aOut.AddElement( sDatasheet, comp->GetField( DATASHEET )->GetText() );
 
             // Export all user defined fields within the component,
             // which start at field index MANDATORY_FIELDS.  Only output the <fields>
             // container element if there are any <field>s.
             if( comp->GetFieldCount() > MANDATORY_FIELDS )
             {
-                XNODE* xfields;
-                xcomp->AddChild( xfields = node( sFields ) );
+                aOut.StartElement( sFields );
 
                 for( int fldNdx = MANDATORY_FIELDS; fldNdx < comp->GetFieldCount(); ++fldNdx )
                 {
@@ -1019,37 +1037,41 @@ XNODE* NETLIST_EXPORT_TOOL::makeGenericComponents()
                     // only output a field if non empty and not just "~"
                     if( !f->IsVoid() )
                     {
-                        XNODE*  xfield;
-                        xfields->AddChild( xfield = node( sField, f->GetText() ) );
-                        xfield->AddAttribute( sName, f->GetName() );
+                        aOut.StartElement( sField );
+                        aOut.AddAttribute( sName, f->GetName() );
+                        aOut.AddText( f->GetText() );
+                        aOut.EndElement();
                     }
                 }
+
+                aOut.EndElement();
             }
 
-            XNODE*  xlibsource;
-            xcomp->AddChild( xlibsource = node( sLibSource ) );
+            aOut.StartElement( sLibSource );
 
             // "logical" library name, which is in anticipation of a better search
             // algorithm for parts based on "logical_lib.part" and where logical_lib
             // is merely the library name minus path and extension.
             LIB_PART* part = m_libs->FindLibPart( comp->GetPartName() );
             if( part )
-                xlibsource->AddAttribute( sLib, part->GetLib()->GetLogicalName() );
-
-            xlibsource->AddAttribute( sPart, comp->GetPartName() );
+                aOut.AddAttribute( sLib, part->GetLib()->GetLogicalName() );
 
-            XNODE* xsheetpath;
+            aOut.AddAttribute( sPart, comp->GetPartName() );
+            aOut.EndElement();
 
-            xcomp->AddChild( xsheetpath = node( sSheetPath ) );
-            xsheetpath->AddAttribute( sNames, path->PathHumanReadable() );
-            xsheetpath->AddAttribute( sTStamps, path->Path() );
+            aOut.StartElement( sSheetPath );
+            aOut.AddAttribute( sNames, path->PathHumanReadable() );
+            aOut.AddAttribute( sTStamps, path->Path() );
+            aOut.EndElement();
 
             timeStamp.Printf( sTSFmt, comp->GetTimeStamp() );
-            xcomp->AddChild( node( sTStamp, timeStamp ) );
+            aOut.AddElement( sTStamp, timeStamp );
+
+            aOut.EndElement();
         }
     }
 
-    return xcomps;
+    aOut.EndElement();
 }
 
 
@@ -1059,13 +1081,12 @@ bool NETLIST_EXPORT_TOOL::WriteKiCadNetList( const wxString& aOutFileName )
     for( unsigned ii = 0; ii < m_masterList->size(); ii++ )
         m_masterList->GetItem( ii )->m_Flag = 0;
 
-    std::auto_ptr<XNODE>    xroot( makeGenericRoot() );
-
     try
     {
         FILE_OUTPUTFORMATTER    formatter( aOutFileName );
+        XSTREAM_SEXPR           out( &formatter );
 
-        xroot->Format( &formatter, 0 );
+        writeGenericRoot( out );
     }
     catch( const IO_ERROR& ioe )
     {
@@ -1083,11 +1104,21 @@ bool NETLIST_EXPORT_TOOL::WriteGENERICNetList( const wxString& aOutFileName )
         m_masterList->GetItem( ii )->m_Flag = 0;
 
     // output the XML format netlist.
-    wxXmlDocument   xdoc;
+    try
+    {
+        // binary mode: wxXmlDocument::Save() did not translate new lines either
+        FILE_OUTPUTFORMATTER    formatter( aOutFileName, wxT( "wb" ) );
+        XSTREAM_XML             out( &formatter, 2 );
 
-    xdoc.SetRoot( makeGenericRoot() );
+        writeGenericRoot( out );
+    }
+    catch( const IO_ERROR& ioe )
+    {
+        DisplayError( NULL, ioe.errorText );
+        return false;
+    }
 
-    return xdoc.Save( aOutFileName, 2 /* indent bug, today was ignored by wxXml lib */ );
+    return true;
 }
 
 
@@ -1526,16 +1557,20 @@ bool NETLIST_EXPORT_TOOL::WriteNetListPCBNEW( FILE* f, bool with_pcbnew )
 bool NETLIST_EXPORT_TOOL::addPinToComponentPinList( SCH_COMPONENT* aComponent,
                                       SCH_SHEET_PATH* aSheetPath, LIB_PIN* aPin )
 {
-    // Search the PIN description for Pin in g_NetObjectslist
-    for( unsigned ii = 0; ii < m_masterList->size(); ii++ )
-    {
-        NETLIST_OBJECT* pin = m_masterList->GetItem( ii );
+    buildComponentIndex();
 
-        if( pin->m_Type != NET_PIN )
-            continue;
+    std::map<SCH_ITEM*, std::vector<NETLIST_OBJECT*> >::const_iterator it =
+        m_componentPins.find( aComponent );
 
-        if( pin->m_Link != aComponent )
-            continue;
+    if( it == m_componentPins.end() )
+        return false;
+
+    // Search the PIN description for Pin in g_NetObjectslist
+    const std::vector<NETLIST_OBJECT*>& pins = it->second;
+
+    for( unsigned ii = 0; ii < pins.size(); ii++ )
+    {
+        NETLIST_OBJECT* pin = pins[ii];
 
         if( pin->m_PinNum != aPin->GetNumber() )
             continue;
@@ -1617,12 +1652,10 @@ void NETLIST_EXPORT_TOOL::eraseDuplicatePins( )
 }
 
 
-void NETLIST_EXPORT_TOOL::findAllInstancesOfComponent( SCH_COMPONENT*  aComponent,
-                                         LIB_PART*       aEntry,
-                                         SCH_SHEET_PATH* aSheetPath )
+void NETLIST_EXPORT_TOOL::buildComponentIndex()
 {
-    wxString    ref = aComponent->GetRef( aSheetPath );
-    wxString    ref2;
+    if( m_indexBuilt )
+        return;
 
     SCH_SHEET_LIST sheetList;
 
@@ -1633,27 +1666,63 @@ void NETLIST_EXPORT_TOOL::findAllInstancesOfComponent( SCH_COMPONENT*  aComponen
             if( item->Type() != SCH_COMPONENT_T )
                 continue;
 
-            SCH_COMPONENT*  comp2 = (SCH_COMPONENT*) item;
+            COMPONENT_INSTANCE instance;
+            instance.m_Component = (SCH_COMPONENT*) item;
+            instance.m_SheetPath = *sheet;
 
-            ref2 = comp2->GetRef( sheet );
-            if( ref2.CmpNoCase( ref ) != 0 )
-                continue;
+            wxString ref = instance.m_Component->GetRef( sheet ).Upper();
+            m_componentInstances[ref].push_back( instance );
+        }
+    }
 
-            int unit2 = comp2->GetUnitSelection( sheet );  // slow
+    for( unsigned ii = 0; ii < m_masterList->size(); ii++ )
+    {
+        NETLIST_OBJECT* pin = m_masterList->GetItem( ii );
 
-            for( LIB_PIN* pin = aEntry->GetNextPin();  pin;  pin = aEntry->GetNextPin( pin ) )
-            {
-                wxASSERT( pin->Type() == LIB_PIN_T );
+        if( pin->m_Type != NET_PIN )
+            continue;
 
-                if( pin->GetUnit() && pin->GetUnit() != unit2 )
-                    continue;
+        m_componentPins[pin->m_Link].push_back( pin );
+    }
 
-                if( pin->GetConvert() && pin->GetConvert() != comp2->GetConvert() )
-                    continue;
+    m_indexBuilt = true;
+}
 
-                // A suitable pin is found: add it to the current list
-                addPinToComponentPinList( comp2, sheet, pin );
-            }
+
+void NETLIST_EXPORT_TOOL::findAllInstancesOfComponent( SCH_COMPONENT*  aComponent,
+                                         LIB_PART*       aEntry,
+                                         SCH_SHEET_PATH* aSheetPath )
+{
+    buildComponentIndex();
+
+    wxString ref = aComponent->GetRef( aSheetPath ).Upper();
+
+    std::map<wxString, COMPONENT_INSTANCES>::iterator it = m_componentInstances.find( ref );
+
+    if( it == m_componentInstances.end() )
+        return;
+
+    COMPONENT_INSTANCES& instances = it->second;
+
+    for( unsigned ii = 0; ii < instances.size(); ii++ )
+    {
+        SCH_COMPONENT*  comp2 = instances[ii].m_Component;
+        SCH_SHEET_PATH* sheet = &instances[ii].m_SheetPath;
+
+        int unit2 = comp2->GetUnitSelection( sheet );  // slow
+
+        for( LIB_PIN* pin = aEntry->GetNextPin();  pin;  pin = aEntry->GetNextPin( pin ) )
+        {
+            wxASSERT( pin->Type() == LIB_PIN_T );
+
+            if( pin->GetUnit() && pin->GetUnit() != unit2 )
+                continue;
+
+            if( pin->GetConvert() && pin->GetConvert() != comp2->GetConvert() )
+                continue;
+
+            // A suitable pin is found: add it to the current list
+            addPinToComponentPinList( comp2, sheet, pin );
         }
     }
 }
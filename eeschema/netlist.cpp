@@ -41,9 +41,11 @@
 #include <sch_no_connect.h>
 #include <sch_text.h>
 #include <sch_sheet.h>
+#include <class_sch_screen.h>
 #include <algorithm>
 
 #include <boost/foreach.hpp>
+#include <boost/unordered_map.hpp>
 
 #define IS_WIRE false
 #define IS_BUS true
@@ -97,6 +99,39 @@ bool SCH_EDIT_FRAME::CreateNetlist( int aFormat, const wxString& aFullFileName,
 // Buffer to build the list of items used in netlist and erc calculations
 NETLIST_OBJECT_LIST s_NetObjectslist( true );
 
+
+/**
+ * Structure SHEET_NETLIST_CACHE
+ * keeps the items of a sheet, connected inside this sheet, so they are built again
+ * only when the sheet screen or the libraries are modified.
+ */
+struct SHEET_NETLIST_CACHE
+{
+    SHEET_NETLIST_CACHE() :
+        m_items( true ), m_screen( NULL ), m_stamp( 0 ), m_libHash( 0 ), m_lastUse( 0 )
+    {
+    }
+
+    bool IsValid( const SCH_SHEET_PATH& aSheet, int aLibHash ) const
+    {
+        // m_screen is compared before using it, as it could have been deleted
+        return m_screen != NULL && m_screen == aSheet.LastScreen()
+               && m_stamp == m_screen->GetConnectivityStamp()
+               && m_libHash == aLibHash && m_sheetPath == aSheet;
+    }
+
+    NETLIST_OBJECT_LIST m_items;        ///< Items of the sheet, owned by the cache
+    SCH_SHEET_PATH      m_sheetPath;
+    SCH_SCREEN*         m_screen;       ///< Sheet screen when items were built
+    int                 m_stamp;        ///< Connectivity stamp of m_screen at this time
+    int                 m_libHash;      ///< Libraries modify hash at this time
+    unsigned            m_lastUse;      ///< Last netlist build using the cache
+};
+
+// Cached items of sheets, indexed by sheet path
+static std::map<wxString, SHEET_NETLIST_CACHE> s_sheetNetlistCache;
+static unsigned s_sheetNetlistBuildCount = 0;
+
 //#define NETLIST_DEBUG
 
 NETLIST_OBJECT_LIST::~NETLIST_OBJECT_LIST()
@@ -161,137 +196,401 @@ NETLIST_OBJECT_LIST * SCH_EDIT_FRAME::BuildNetListBase()
 }
 
 
-bool NETLIST_OBJECT_LIST::BuildNetListInfo( SCH_SHEET_LIST& aSheets )
+/**
+ * Class NETLIST_CONNECTION_INDEX
+ * indexes the items of a single sheet by their positions, to find items that can be
+ * physically connected without testing every item of the sheet:
+ * - end points (m_Start and m_End) are stored in a hash map,
+ * - wires and buses are stored in a uniform grid, in every cell touched by their bounding box.
+ */
+class NETLIST_CONNECTION_INDEX
 {
-    s_NetObjectslist.SetOwner( true );
-    s_NetObjectslist.FreeList();
-
-    SCH_SHEET_PATH* sheet;
-
-    // Fill list with connected items from the flattened sheet list
-    for( sheet = aSheets.GetFirst(); sheet != NULL;
-         sheet = aSheets.GetNext() )
+public:
+    typedef std::vector<NETLIST_OBJECT*> ITEMS;
+
+    /**
+     * Function Build
+     * indexes items of aList from aStart to aEnd (excluded).
+     */
+    void Build( const NETLIST_OBJECT_LIST& aList, unsigned aStart, unsigned aEnd )
     {
-        for( SCH_ITEM* item = sheet->LastScreen()->GetDrawItems(); item; item = item->Next() )
+        m_points.clear();
+        m_wires.Clear();
+        m_buses.Clear();
+
+        for( unsigned ii = aStart; ii < aEnd; ii++ )
         {
-            item->GetNetListItem( *this, sheet );
+            NETLIST_OBJECT* item = aList.GetItem( ii );
+
+            m_points[item->m_Start].push_back( item );
+
+            if( item->m_End != item->m_Start )
+                m_points[item->m_End].push_back( item );
+
+            if( item->m_Type == NET_SEGMENT )
+                m_wires.Add( item );
+            else if( item->m_Type == NET_BUS )
+                m_buses.Add( item );
         }
     }
 
-    if( size() == 0 )
-        return false;
+    /**
+     * Function ItemsAt
+     * @return items having m_Start or m_End at aPoint, or NULL if there is none.
+     */
+    const ITEMS* ItemsAt( const wxPoint& aPoint ) const
+    {
+        POINT_MAP::const_iterator it = m_points.find( aPoint );
 
-    // Sort objects by Sheet
-    SortListbySheet();
+        return it == m_points.end() ? NULL : &it->second;
+    }
 
-    sheet = &(GetItem( 0 )->m_SheetPath);
-    m_lastNetCode = m_lastBusNetCode = 1;
+    /**
+     * Function SegmentsNear
+     * appends to aSegments the wires (or the buses) that may contain aPoint.
+     */
+    void SegmentsNear( const wxPoint& aPoint, bool aIsBus, ITEMS& aSegments ) const
+    {
+        ( aIsBus ? m_buses : m_wires ).Query( aPoint, aSegments );
+    }
 
-    for( unsigned ii = 0, istart = 0; ii < size(); ii++ )
+private:
+    struct POINT_HASH
     {
-        NETLIST_OBJECT* net_item = GetItem( ii );
+        size_t operator()( const wxPoint& aPoint ) const
+        {
+            return ( (size_t) aPoint.x * 73856093 ) ^ ( (size_t) aPoint.y * 19349663 );
+        }
+    };
+
+    typedef boost::unordered_map<wxPoint, ITEMS, POINT_HASH> POINT_MAP;
 
-        if( net_item->m_SheetPath != *sheet )   // Sheet change
+    class SEGMENT_GRID
+    {
+    public:
+        void Clear()
         {
-            sheet  = &(net_item->m_SheetPath);
-            istart = ii;
+            m_cells.clear();
+            m_large.clear();
         }
 
+        void Add( NETLIST_OBJECT* aSegment )
+        {
+            int x0 = cell( std::min( aSegment->m_Start.x, aSegment->m_End.x ) );
+            int x1 = cell( std::max( aSegment->m_Start.x, aSegment->m_End.x ) );
+            int y0 = cell( std::min( aSegment->m_Start.y, aSegment->m_End.y ) );
+            int y1 = cell( std::max( aSegment->m_Start.y, aSegment->m_End.y ) );
+
+            // Long diagonal segments would fill too many cells
+            if( (int64_t) ( x1 - x0 + 1 ) * ( y1 - y0 + 1 ) > MAX_CELLS )
+            {
+                m_large.push_back( aSegment );
+                return;
+            }
+
+            for( int x = x0; x <= x1; x++ )
+            {
+                for( int y = y0; y <= y1; y++ )
+                    m_cells[key( x, y )].push_back( aSegment );
+            }
+        }
+
+        void Query( const wxPoint& aPoint, ITEMS& aSegments ) const
+        {
+            CELL_MAP::const_iterator it = m_cells.find( key( cell( aPoint.x ), cell( aPoint.y ) ) );
+
+            if( it != m_cells.end() )
+                aSegments.insert( aSegments.end(), it->second.begin(), it->second.end() );
+
+            aSegments.insert( aSegments.end(), m_large.begin(), m_large.end() );
+        }
+
+    private:
+        ///> Size of a grid cell, in internal units (mils)
+        static const int CELL_SIZE = 500;
+
+        ///> Segments covering more cells are stored in m_large
+        static const int MAX_CELLS = 256;
+
+        typedef boost::unordered_map<uint64_t, ITEMS> CELL_MAP;
+
+        static int cell( int aCoord )
+        {
+            // Round towards minus infinity
+            return aCoord >= 0 ? aCoord / CELL_SIZE : -( ( -aCoord - 1 ) / CELL_SIZE ) - 1;
+        }
+
+        static uint64_t key( int aX, int aY )
+        {
+            return ( (uint64_t) (uint32_t) aX << 32 ) | (uint32_t) aY;
+        }
+
+        CELL_MAP    m_cells;
+        ITEMS       m_large;
+    };
+
+    POINT_MAP       m_points;
+    SEGMENT_GRID    m_wires;
+    SEGMENT_GRID    m_buses;
+};
+
+
+void NETLIST_OBJECT_LIST::buildSheetItems( SCH_SHEET_PATH* aSheet )
+{
+    for( SCH_ITEM* item = aSheet->LastScreen()->GetDrawItems(); item; item = item->Next() )
+        item->GetNetListItem( *this, aSheet );
+
+    connectSheetItems();
+}
+
+
+void NETLIST_OBJECT_LIST::copyItems( const NETLIST_OBJECT_LIST& aSource )
+{
+    reserve( size() + aSource.size() );
+
+    for( unsigned ii = 0; ii < aSource.size(); ii++ )
+        push_back( new NETLIST_OBJECT( *aSource.GetItem( ii ) ) );
+
+    m_lastNetCode = aSource.m_lastNetCode;
+    m_lastBusNetCode = aSource.m_lastBusNetCode;
+}
+
+
+void NETLIST_OBJECT_LIST::connectSheetItems()
+{
+    m_lastNetCode = m_lastBusNetCode = 1;
+
+    // Items indexed by position
+    NETLIST_CONNECTION_INDEX sheetItems;
+    sheetItems.Build( *this, 0, size() );
+
+    for( unsigned ii = 0; ii < size(); ii++ )
+    {
+        NETLIST_OBJECT* net_item = GetItem( ii );
+
         switch( net_item->m_Type )
         {
         case NET_ITEM_UNSPECIFIED:
-            wxMessageBox( wxT( "BuildNetListBase() error" ) );
+            // Reported by BuildNetListInfo()
             break;
 
         case NET_PIN:
         case NET_PINLABEL:
         case NET_SHEETLABEL:
         case NET_NOCONNECT:
-            if( net_item->GetNet() != 0 )
+            if( getNetCode( net_item, IS_WIRE ) != 0 )
                 break;
 
         case NET_SEGMENT:
             // Test connections point to point type without bus.
-            if( net_item->GetNet() == 0 )
+            if( getNetCode( net_item, IS_WIRE ) == 0 )
             {
-                net_item->SetNet( m_lastNetCode );
+                setNetCode( net_item, m_lastNetCode, IS_WIRE );
                 m_lastNetCode++;
             }
 
-            pointToPointConnect( net_item, IS_WIRE, istart );
+            pointToPointConnect( net_item, IS_WIRE, sheetItems );
             break;
 
         case NET_JUNCTION:
             // Control of the junction outside BUS.
-            if( net_item->GetNet() == 0 )
+            if( getNetCode( net_item, IS_WIRE ) == 0 )
             {
-                net_item->SetNet( m_lastNetCode );
+                setNetCode( net_item, m_lastNetCode, IS_WIRE );
                 m_lastNetCode++;
             }
 
-            segmentToPointConnect( net_item, IS_WIRE, istart );
+            segmentToPointConnect( net_item, IS_WIRE, sheetItems );
 
             // Control of the junction, on BUS.
-            if( net_item->m_BusNetCode == 0 )
+            if( getNetCode( net_item, IS_BUS ) == 0 )
             {
-                net_item->m_BusNetCode = m_lastBusNetCode;
+                setNetCode( net_item, m_lastBusNetCode, IS_BUS );
                 m_lastBusNetCode++;
             }
 
-            segmentToPointConnect( net_item, IS_BUS, istart );
+            segmentToPointConnect( net_item, IS_BUS, sheetItems );
             break;
 
         case NET_LABEL:
         case NET_HIERLABEL:
         case NET_GLOBLABEL:
             // Test connections type junction without bus.
-            if( net_item->GetNet() == 0 )
+            if( getNetCode( net_item, IS_WIRE ) == 0 )
             {
-                net_item->SetNet( m_lastNetCode );
+                setNetCode( net_item, m_lastNetCode, IS_WIRE );
                 m_lastNetCode++;
             }
 
-            segmentToPointConnect( net_item, IS_WIRE, istart );
+            segmentToPointConnect( net_item, IS_WIRE, sheetItems );
             break;
 
         case NET_SHEETBUSLABELMEMBER:
-            if( net_item->m_BusNetCode != 0 )
+            if( getNetCode( net_item, IS_BUS ) != 0 )
                 break;
 
         case NET_BUS:
             // Control type connections point to point mode bus
-            if( net_item->m_BusNetCode == 0 )
+            if( getNetCode( net_item, IS_BUS ) == 0 )
             {
-                net_item->m_BusNetCode = m_lastBusNetCode;
+                setNetCode( net_item, m_lastBusNetCode, IS_BUS );
                 m_lastBusNetCode++;
             }
 
-            pointToPointConnect( net_item, IS_BUS, istart );
+            pointToPointConnect( net_item, IS_BUS, sheetItems );
             break;
 
         case NET_BUSLABELMEMBER:
         case NET_HIERBUSLABELMEMBER:
         case NET_GLOBBUSLABELMEMBER:
             // Control connections similar has on BUS
-            if( net_item->GetNet() == 0 )
+            if( getNetCode( net_item, IS_WIRE ) == 0 )
             {
-                net_item->m_BusNetCode = m_lastBusNetCode;
+                setNetCode( net_item, m_lastBusNetCode, IS_BUS );
                 m_lastBusNetCode++;
             }
 
-            segmentToPointConnect( net_item, IS_BUS, istart );
+            segmentToPointConnect( net_item, IS_BUS, sheetItems );
             break;
         }
     }
 
+    resolveNetCodes();
+}
+
+
+// Comparison routine to sort sheet paths like SortListbySheet() sorts items
+static bool sortSheetPaths( const SCH_SHEET_PATH* aSheet1, const SCH_SHEET_PATH* aSheet2 )
+{
+    return aSheet1->Cmp( *aSheet2 ) < 0;
+}
+
+
+bool NETLIST_OBJECT_LIST::BuildNetListInfo( SCH_SHEET_LIST& aSheets )
+{
+    s_NetObjectslist.SetOwner( true );
+    s_NetObjectslist.FreeList();
+
+    // Sheets are gathered in a fixed order, so net codes do not depend on threads
+    std::vector<SCH_SHEET_PATH*> sheets;
+
+    for( SCH_SHEET_PATH* sheet = aSheets.GetFirst(); sheet != NULL; sheet = aSheets.GetNext() )
+        sheets.push_back( sheet );
+
+    std::sort( sheets.begin(), sheets.end(), sortSheetPaths );
+
+    int sheetCount = sheets.size();
+    int ii;
+
+    // Find the cached items of every sheet, and the sheets to build again
+    std::vector<SHEET_NETLIST_CACHE*> caches( sheetCount, (SHEET_NETLIST_CACHE*) NULL );
+    std::vector<char> rebuild( sheetCount, 1 );
+    int libHash = 0;
+
+    if( sheetCount )
+        libHash = sheets[0]->LastScreen()->Prj().SchLibs()->GetModifyHash();
+
+    s_sheetNetlistBuildCount++;
+
+    for( ii = 0; ii < sheetCount; ii++ )
+    {
+        SHEET_NETLIST_CACHE& cache = s_sheetNetlistCache[sheets[ii]->Path()];
+
+        // Sheets having the same path name (duplicate time stamps) are not cached
+        if( cache.m_lastUse == s_sheetNetlistBuildCount )
+            continue;
+
+        cache.m_lastUse = s_sheetNetlistBuildCount;
+        caches[ii] = &cache;
+        rebuild[ii] = !cache.IsValid( *sheets[ii], libHash );
+
+        if( rebuild[ii] )
+        {
+            cache.m_items.FreeList();
+            cache.m_sheetPath = *sheets[ii];
+            cache.m_screen = sheets[ii]->LastScreen();
+            cache.m_stamp = cache.m_screen->GetConnectivityStamp();
+            cache.m_libHash = libHash;
+        }
+    }
+
+    // Forget sheets which do not exist any more
+    std::map<wxString, SHEET_NETLIST_CACHE>::iterator it = s_sheetNetlistCache.begin();
+
+    while( it != s_sheetNetlistCache.end() )
+    {
+        if( it->second.m_lastUse != s_sheetNetlistBuildCount )
+            s_sheetNetlistCache.erase( it++ );
+        else
+            ++it;
+    }
+
+    // Items can be connected only to items of the same sheet, or through labels.
+    // So connected items are extracted and connected inside every modified sheet
+    // independently, then sheets are connected together.
+    std::vector<NETLIST_OBJECT_LIST> sheetItems( sheets.size() );
+
+#ifdef USE_OPENMP
+    #pragma omp parallel for schedule(dynamic, 1) private(ii)
+#endif /* USE_OPENMP */
+    for( ii = 0; ii < sheetCount; ii++ )
+    {
+        if( caches[ii] == NULL )
+        {
+            sheetItems[ii].buildSheetItems( sheets[ii] );
+            continue;
+        }
+
+        if( rebuild[ii] )
+            caches[ii]->m_items.buildSheetItems( sheets[ii] );
+
+        // Items are modified when sheets are connected together, so they are copied
+        sheetItems[ii].copyItems( caches[ii]->m_items );
+    }
+
+    // Fill list with connected items, net codes of every sheet are shifted after
+    // the codes used by previous sheets
+    m_lastNetCode = m_lastBusNetCode = 1;
+
+    for( unsigned jj = 0; jj < sheetItems.size(); jj++ )
+    {
+        const NETLIST_OBJECT_LIST& items = sheetItems[jj];
+
+        for( unsigned kk = 0; kk < items.size(); kk++ )
+        {
+            NETLIST_OBJECT* net_item = items.GetItem( kk );
+
+            if( net_item->m_Type == NET_ITEM_UNSPECIFIED )
+                wxMessageBox( wxT( "BuildNetListBase() error" ) );
+
+            if( net_item->GetNet() != 0 )
+                net_item->SetNet( net_item->GetNet() + m_lastNetCode - 1 );
+
+            if( net_item->m_BusNetCode != 0 )
+                net_item->m_BusNetCode += m_lastBusNetCode - 1;
+
+            push_back( net_item );
+        }
+
+        m_lastNetCode += items.m_lastNetCode - 1;
+        m_lastBusNetCode += items.m_lastBusNetCode - 1;
+    }
+
+    if( size() == 0 )
+        return false;
+
 #if defined(NETLIST_DEBUG) && defined(DEBUG)
     std::cout << "\n\nafter sheet local\n\n";
     DumpNetTable();
 #endif
 
+    // Sheets are connected together: net codes of different sheets are merged.
     // Updating the Bus Labels Netcode connected by Bus
     connectBusLabels();
 
+    LABEL_INDEX labels;
+    buildLabelIndex( labels );
+
     // Group objects by label.
     for( unsigned ii = 0; ii < size(); ii++ )
     {
@@ -310,7 +609,7 @@ bool NETLIST_OBJECT_LIST::BuildNetListInfo( SCH_SHEET_LIST& aSheets )
         case NET_PINLABEL:
         case NET_BUSLABELMEMBER:
         case NET_GLOBBUSLABELMEMBER:
-            labelConnect( GetItem( ii ) );
+            labelConnect( GetItem( ii ), labels );
             break;
 
         case NET_SHEETBUSLABELMEMBER:
@@ -333,9 +632,11 @@ bool NETLIST_OBJECT_LIST::BuildNetListInfo( SCH_SHEET_LIST& aSheets )
     {
         if( GetItem( ii )->m_Type == NET_SHEETLABEL
             || GetItem( ii )->m_Type == NET_SHEETBUSLABELMEMBER )
-            sheetLabelConnect( GetItem( ii ) );
+            sheetLabelConnect( GetItem( ii ), labels );
     }
 
+    resolveNetCodes();
+
     // Sort objects by NetCode
     SortListbyNetcode();
 
@@ -566,14 +867,24 @@ void NETLIST_OBJECT_LIST::findBestNetNameForEachNet()
 }
 
 
-void NETLIST_OBJECT_LIST::sheetLabelConnect( NETLIST_OBJECT* SheetLabel )
+void NETLIST_OBJECT_LIST::sheetLabelConnect( NETLIST_OBJECT* SheetLabel,
+                                             const LABEL_INDEX& aLabels )
 {
-    if( SheetLabel->GetNet() == 0 )
+    int netCode = getNetCode( SheetLabel, IS_WIRE );
+
+    if( netCode == 0 )
         return;
 
-    for( unsigned ii = 0; ii < size(); ii++ )
+    LABEL_INDEX::const_iterator sameName = aLabels.find( SheetLabel->m_Label.Lower() );
+
+    if( sameName == aLabels.end() )
+        return;
+
+    const std::vector<NETLIST_OBJECT*>& candidates = sameName->second;
+
+    for( unsigned ii = 0; ii < candidates.size(); ii++ )
     {
-        NETLIST_OBJECT* ObjetNet = GetItem( ii );
+        NETLIST_OBJECT* ObjetNet = candidates[ii];
 
         if( ObjetNet->m_SheetPath != SheetLabel->m_SheetPathInclude )
             continue;  //use SheetInclude, not the sheet!!
@@ -581,17 +892,19 @@ void NETLIST_OBJECT_LIST::sheetLabelConnect( NETLIST_OBJECT* SheetLabel )
         if( (ObjetNet->m_Type != NET_HIERLABEL ) && (ObjetNet->m_Type != NET_HIERBUSLABELMEMBER ) )
             continue;
 
-        if( ObjetNet->GetNet() == SheetLabel->GetNet() )
+        int objetNetCode = getNetCode( ObjetNet, IS_WIRE );
+
+        if( objetNetCode == netCode )
             continue;  //already connected.
 
         if( ObjetNet->m_Label.CmpNoCase( SheetLabel->m_Label ) != 0 )
             continue;  //different names.
 
         // Propagate Netcode having all the objects of the same Netcode.
-        if( ObjetNet->GetNet() )
-            propageNetCode( ObjetNet->GetNet(), SheetLabel->GetNet(), IS_WIRE );
+        if( objetNetCode )
+            propageNetCode( objetNetCode, netCode, IS_WIRE );
         else
-            ObjetNet->SetNet( SheetLabel->GetNet() );
+            setNetCode( ObjetNet, netCode, IS_WIRE );
     }
 }
 
@@ -606,12 +919,14 @@ void NETLIST_OBJECT_LIST::connectBusLabels()
           || (Label->m_Type == NET_BUSLABELMEMBER)
           || (Label->m_Type == NET_HIERBUSLABELMEMBER) )
         {
-            if( Label->GetNet() == 0 )
+            if( getNetCode( Label, IS_WIRE ) == 0 )
             {
-                Label->SetNet( m_lastNetCode );
+                setNetCode( Label, m_lastNetCode, IS_WIRE );
                 m_lastNetCode++;
             }
 
+            int netCode = getNetCode( Label, IS_WIRE );
+
             for( unsigned jj = ii + 1; jj < size(); jj++ )
             {
                 NETLIST_OBJECT* LabelInTst =  GetItem( jj );
@@ -619,16 +934,19 @@ void NETLIST_OBJECT_LIST::connectBusLabels()
                    || (LabelInTst->m_Type == NET_BUSLABELMEMBER)
                    || (LabelInTst->m_Type == NET_HIERBUSLABELMEMBER) )
                 {
+                    // Bus net codes do not change any more
                     if( LabelInTst->m_BusNetCode != Label->m_BusNetCode )
                         continue;
 
                     if( LabelInTst->m_Member != Label->m_Member )
                         continue;
 
-                    if( LabelInTst->GetNet() == 0 )
-                        LabelInTst->SetNet( Label->GetNet() );
+                    int labelNetCode = getNetCode( LabelInTst, IS_WIRE );
+
+                    if( labelNetCode == 0 )
+                        setNetCode( LabelInTst, netCode, IS_WIRE );
                     else
-                        propageNetCode( LabelInTst->GetNet(), Label->GetNet(), IS_WIRE );
+                        propageNetCode( labelNetCode, netCode, IS_WIRE );
                 }
             }
         }
@@ -636,184 +954,209 @@ void NETLIST_OBJECT_LIST::connectBusLabels()
 }
 
 
+int NETLIST_OBJECT_LIST::findNetCode( int aNetCode, bool aIsBus )
+{
+    std::vector<int>& parents = aIsBus ? m_busNetParent : m_netParent;
+
+    if( aNetCode <= 0 || aNetCode >= (int) parents.size() )
+        return aNetCode;
+
+    // Path halving keeps the trees flat
+    while( parents[aNetCode] != aNetCode )
+    {
+        parents[aNetCode] = parents[parents[aNetCode]];
+        aNetCode = parents[aNetCode];
+    }
+
+    return aNetCode;
+}
+
+
 void NETLIST_OBJECT_LIST::propageNetCode( int aOldNetCode, int aNewNetCode, bool aIsBus )
 {
-    if( aOldNetCode == aNewNetCode )
+    if( aOldNetCode == aNewNetCode || aOldNetCode == 0 )
         return;
 
-    if( aIsBus == false )    // Propagate NetCode
+    std::vector<int>& parents = aIsBus ? m_busNetParent : m_netParent;
+    int maxNetCode = std::max( aOldNetCode, aNewNetCode );
+
+    while( (int) parents.size() <= maxNetCode )
+        parents.push_back( parents.size() );
+
+    // Items having aOldNetCode now have aNewNetCode
+    parents[aOldNetCode] = aNewNetCode;
+}
+
+
+void NETLIST_OBJECT_LIST::setNetCode( NETLIST_OBJECT* aItem, int aNetCode, bool aIsBus )
+{
+    if( aIsBus )
+        aItem->m_BusNetCode = aNetCode;
+    else
+        aItem->SetNet( aNetCode );
+}
+
+
+void NETLIST_OBJECT_LIST::resolveNetCodes()
+{
+    for( unsigned ii = 0; ii < size(); ii++ )
     {
-        for( unsigned jj = 0; jj < size(); jj++ )
-        {
-            NETLIST_OBJECT* object = GetItem( jj );
+        NETLIST_OBJECT* item = GetItem( ii );
 
-            if( object->GetNet() == aOldNetCode )
-                object->SetNet( aNewNetCode );
-        }
+        item->SetNet( getNetCode( item, IS_WIRE ) );
+        item->m_BusNetCode = getNetCode( item, IS_BUS );
     }
-    else               // Propagate BusNetCode
+
+    m_netParent.clear();
+    m_busNetParent.clear();
+}
+
+
+void NETLIST_OBJECT_LIST::buildLabelIndex( LABEL_INDEX& aIndex ) const
+{
+    aIndex.clear();
+
+    // Labels are compared without case sensitivity
+    for( unsigned ii = 0; ii < size(); ii++ )
     {
-        for( unsigned jj = 0; jj < size(); jj++ )
-        {
-            NETLIST_OBJECT* object = GetItem( jj );
+        NETLIST_OBJECT* item = GetItem( ii );
 
-            if( object->m_BusNetCode == aOldNetCode )
-                object->m_BusNetCode = aNewNetCode;
-        }
+        if( item->IsLabelType() )
+            aIndex[item->m_Label.Lower()].push_back( item );
     }
 }
 
 
 void NETLIST_OBJECT_LIST::pointToPointConnect( NETLIST_OBJECT* aRef, bool aIsBus,
-                                               int start )
+                                               const NETLIST_CONNECTION_INDEX& aSheetItems )
 {
-    int netCode;
+    int netCode = getNetCode( aRef, aIsBus );
 
-    if( aIsBus == false )    // Objects other than BUS and BUSLABELS
+    // Only items having an end point common with aRef can be connected to it.
+    // Items having both ends common with aRef are found twice, what is harmless.
+    const NETLIST_CONNECTION_INDEX::ITEMS* candidates[2];
+
+    candidates[0] = aSheetItems.ItemsAt( aRef->m_Start );
+    candidates[1] = aRef->m_End != aRef->m_Start ? aSheetItems.ItemsAt( aRef->m_End ) : NULL;
+
+    for( int ii = 0; ii < 2; ii++ )
     {
-        netCode = aRef->GetNet();
+        if( candidates[ii] == NULL )
+            continue;
 
-        for( unsigned i = start; i < size(); i++ )
+        for( unsigned i = 0; i < candidates[ii]->size(); i++ )
         {
-            NETLIST_OBJECT* item = GetItem( i );
-
-            if( item->m_SheetPath != aRef->m_SheetPath )  //used to be > (why?)
-                continue;
+            NETLIST_OBJECT* item = (*candidates[ii])[i];
+            int itemNetCode = getNetCode( item, aIsBus );
 
-            switch( item->m_Type )
+            if( aIsBus == false )    // Objects other than BUS and BUSLABELS
             {
-            case NET_SEGMENT:
-            case NET_PIN:
-            case NET_LABEL:
-            case NET_HIERLABEL:
-            case NET_GLOBLABEL:
-            case NET_SHEETLABEL:
-            case NET_PINLABEL:
-            case NET_JUNCTION:
-            case NET_NOCONNECT:
-                if( aRef->m_Start == item->m_Start
-                    || aRef->m_Start == item->m_End
-                    || aRef->m_End   == item->m_Start
-                    || aRef->m_End   == item->m_End )
+                switch( item->m_Type )
                 {
-                    if( item->GetNet() == 0 )
-                        item->SetNet( netCode );
+                case NET_SEGMENT:
+                case NET_PIN:
+                case NET_LABEL:
+                case NET_HIERLABEL:
+                case NET_GLOBLABEL:
+                case NET_SHEETLABEL:
+                case NET_PINLABEL:
+                case NET_JUNCTION:
+                case NET_NOCONNECT:
+                    if( itemNetCode == 0 )
+                        setNetCode( item, netCode, IS_WIRE );
                     else
-                        propageNetCode( item->GetNet(), netCode, IS_WIRE );
+                        propageNetCode( itemNetCode, netCode, IS_WIRE );
+                    break;
+
+                case NET_BUS:
+                case NET_BUSLABELMEMBER:
+                case NET_SHEETBUSLABELMEMBER:
+                case NET_HIERBUSLABELMEMBER:
+                case NET_GLOBBUSLABELMEMBER:
+                case NET_ITEM_UNSPECIFIED:
+                    break;
                 }
-                break;
-
-            case NET_BUS:
-            case NET_BUSLABELMEMBER:
-            case NET_SHEETBUSLABELMEMBER:
-            case NET_HIERBUSLABELMEMBER:
-            case NET_GLOBBUSLABELMEMBER:
-            case NET_ITEM_UNSPECIFIED:
-                break;
             }
-        }
-    }
-    else    // Object type BUS, BUSLABELS, and junctions.
-    {
-        netCode = aRef->m_BusNetCode;
-
-        for( unsigned i = start; i < size(); i++ )
-        {
-            NETLIST_OBJECT* item = GetItem( i );
-
-            if( item->m_SheetPath != aRef->m_SheetPath )
-                continue;
-
-            switch( item->m_Type )
+            else    // Object type BUS, BUSLABELS, and junctions.
             {
-            case NET_ITEM_UNSPECIFIED:
-            case NET_SEGMENT:
-            case NET_PIN:
-            case NET_LABEL:
-            case NET_HIERLABEL:
-            case NET_GLOBLABEL:
-            case NET_SHEETLABEL:
-            case NET_PINLABEL:
-            case NET_NOCONNECT:
-                break;
-
-            case NET_BUS:
-            case NET_BUSLABELMEMBER:
-            case NET_SHEETBUSLABELMEMBER:
-            case NET_HIERBUSLABELMEMBER:
-            case NET_GLOBBUSLABELMEMBER:
-            case NET_JUNCTION:
-                if(  aRef->m_Start == item->m_Start
-                  || aRef->m_Start == item->m_End
-                  || aRef->m_End   == item->m_Start
-                  || aRef->m_End   == item->m_End )
+                switch( item->m_Type )
                 {
-                    if( item->m_BusNetCode == 0 )
-                        item->m_BusNetCode = netCode;
+                case NET_ITEM_UNSPECIFIED:
+                case NET_SEGMENT:
+                case NET_PIN:
+                case NET_LABEL:
+                case NET_HIERLABEL:
+                case NET_GLOBLABEL:
+                case NET_SHEETLABEL:
+                case NET_PINLABEL:
+                case NET_NOCONNECT:
+                    break;
+
+                case NET_BUS:
+                case NET_BUSLABELMEMBER:
+                case NET_SHEETBUSLABELMEMBER:
+                case NET_HIERBUSLABELMEMBER:
+                case NET_GLOBBUSLABELMEMBER:
+                case NET_JUNCTION:
+                    if( itemNetCode == 0 )
+                        setNetCode( item, netCode, IS_BUS );
                     else
-                        propageNetCode( item->m_BusNetCode, netCode, IS_BUS );
+                        propageNetCode( itemNetCode, netCode, IS_BUS );
+                    break;
                 }
-                break;
             }
         }
     }
 }
 
 
-void NETLIST_OBJECT_LIST::segmentToPointConnect( NETLIST_OBJECT* aJonction,
-                                                bool aIsBus, int aIdxStart )
+void NETLIST_OBJECT_LIST::segmentToPointConnect( NETLIST_OBJECT* aJonction, bool aIsBus,
+                                                 const NETLIST_CONNECTION_INDEX& aSheetItems )
 {
-    for( unsigned i = aIdxStart; i < size(); i++ )
-    {
-        NETLIST_OBJECT* segment = GetItem( i );
+    int netCode = getNetCode( aJonction, aIsBus );
+    NETLIST_CONNECTION_INDEX::ITEMS segments;
 
-        // if different sheets, obviously no physical connection between elements.
-        if( segment->m_SheetPath != aJonction->m_SheetPath )
-            continue;
+    aSheetItems.SegmentsNear( aJonction->m_Start, aIsBus, segments );
 
-        if( aIsBus == IS_WIRE )
-        {
-            if( segment->m_Type != NET_SEGMENT )
-                continue;
-        }
-        else
-        {
-            if( segment->m_Type != NET_BUS )
-                continue;
-        }
+    for( unsigned i = 0; i < segments.size(); i++ )
+    {
+        NETLIST_OBJECT* segment = segments[i];
 
         if( IsPointOnSegment( segment->m_Start, segment->m_End, aJonction->m_Start ) )
         {
-            // Propagation Netcode has all the objects of the same Netcode.
-            if( aIsBus == IS_WIRE )
-            {
-                if( segment->GetNet() )
-                    propageNetCode( segment->GetNet(), aJonction->GetNet(), aIsBus );
-                else
-                    segment->SetNet( aJonction->GetNet() );
-            }
+            // Propagation Netcode (or BusNetCode) has all the objects of the same Netcode.
+            int segmentNetCode = getNetCode( segment, aIsBus );
+
+            if( segmentNetCode )
+                propageNetCode( segmentNetCode, netCode, aIsBus );
             else
-            {
-                if( segment->m_BusNetCode )
-                    propageNetCode( segment->m_BusNetCode, aJonction->m_BusNetCode, aIsBus );
-                else
-                    segment->m_BusNetCode = aJonction->m_BusNetCode;
-            }
+                setNetCode( segment, netCode, aIsBus );
         }
     }
 }
 
 
-void NETLIST_OBJECT_LIST::labelConnect( NETLIST_OBJECT* aLabelRef )
+void NETLIST_OBJECT_LIST::labelConnect( NETLIST_OBJECT* aLabelRef, const LABEL_INDEX& aLabels )
 {
-    if( aLabelRef->GetNet() == 0 )
+    int netCode = getNetCode( aLabelRef, IS_WIRE );
+
+    if( netCode == 0 )
+        return;
+
+    // Only labels having the same name can be connected
+    LABEL_INDEX::const_iterator sameName = aLabels.find( aLabelRef->m_Label.Lower() );
+
+    if( sameName == aLabels.end() )
         return;
 
-    for( unsigned i = 0; i < size(); i++ )
+    const std::vector<NETLIST_OBJECT*>& candidates = sameName->second;
+
+    for( unsigned i = 0; i < candidates.size(); i++ )
     {
-        NETLIST_OBJECT* item = GetItem( i );
+        NETLIST_OBJECT* item = candidates[i];
+        int itemNetCode = getNetCode( item, IS_WIRE );
 
-        if( item->GetNet() == aLabelRef->GetNet() )
+        if( itemNetCode == netCode )
             continue;
 
         if( item->m_SheetPath != aLabelRef->m_SheetPath )
@@ -833,16 +1176,11 @@ void NETLIST_OBJECT_LIST::labelConnect( NETLIST_OBJECT* aLabelRef )
         // NET_LABEL are local to a sheet
         // NET_GLOBLABEL are global.
         // NET_PINLABEL is a kind of global label (generated by a power pin invisible)
-        if( item->IsLabelType() )
-        {
-            if( item->m_Label.CmpNoCase( aLabelRef->m_Label ) != 0 )
-                continue;
-
-            if( item->GetNet() )
-                propageNetCode( item->GetNet(), aLabelRef->GetNet(), IS_WIRE );
-            else
-                item->SetNet( aLabelRef->GetNet() );
-        }
+        // The index contains only label type items.
+        if( itemNetCode )
+            propageNetCode( itemNetCode, netCode, IS_WIRE );
+        else
+            setNetCode( item, netCode, IS_WIRE );
     }
 }
 
@@ -0,0 +1,173 @@
+/*
+ * This program source code file is part of KiCad, a free EDA CAD application.
+ *
+ * Copyright (C) 2014 KiCad Developers, see change_log.txt for contributors.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, you may find one here:
+ * http://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+ * or you may search the http://www.gnu.org website for the version 2 license,
+ * or you may write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+/**
+ * @file sch_item_index.cpp
+ */
+
+#include <fctsys.h>
+#include <algorithm>
+
+#include <sch_item_index.h>
+#include <sch_item_struct.h>
+#include <sch_sheet.h>
+
+
+/// Collects the items found by an R-tree search
+struct SCH_ITEM_COLLECTOR
+{
+    SCH_ITEM_COLLECTOR( std::vector<SCH_ITEM*>& aItems ) :
+        m_items( aItems )
+    {
+    }
+
+    bool operator()( SCH_ITEM* aItem )
+    {
+        m_items.push_back( aItem );
+        return true;
+    }
+
+    std::vector<SCH_ITEM*>& m_items;
+};
+
+
+SCH_ITEM_INDEX::SCH_ITEM_INDEX() :
+    m_nextOrder( 0 )
+{
+}
+
+
+SCH_ITEM_INDEX::ENTRY SCH_ITEM_INDEX::makeEntry( SCH_ITEM* aItem )
+{
+    EDA_RECT box = aItem->GetBoundingBox();
+    std::vector<wxPoint> points;
+
+    aItem->GetConnectionPoints( points );
+
+    for( unsigned i = 0; i < points.size(); i++ )
+        box.Merge( points[i] );
+
+    // Sheet pins are hit tested through their sheet, their texts can be outside of it.
+    if( aItem->Type() == SCH_SHEET_T )
+    {
+        SCH_SHEET* sheet = (SCH_SHEET*) aItem;
+
+        for( unsigned i = 0; i < sheet->GetPins().size(); i++ )
+            box.Merge( sheet->GetPins()[i].GetBoundingBox() );
+    }
+
+    box.Normalize();
+
+    ENTRY entry;
+
+    entry.m_Min[0] = box.GetX();
+    entry.m_Min[1] = box.GetY();
+    entry.m_Max[0] = box.GetRight();
+    entry.m_Max[1] = box.GetBottom();
+    entry.m_Order  = m_nextOrder++;
+
+    return entry;
+}
+
+
+void SCH_ITEM_INDEX::Build( SCH_ITEM* aFirstItem )
+{
+    Clear();
+
+    std::vector<SCH_ITEM*> items;
+    std::vector<int> mmin, mmax;
+
+    for( SCH_ITEM* item = aFirstItem; item; item = item->Next() )
+    {
+        const ENTRY& entry = m_entries[item] = makeEntry( item );
+
+        items.push_back( item );
+        mmin.push_back( entry.m_Min[0] );
+        mmin.push_back( entry.m_Min[1] );
+        mmax.push_back( entry.m_Max[0] );
+        mmax.push_back( entry.m_Max[1] );
+    }
+
+    if( !items.empty() )
+        m_tree.BulkInsert( &mmin[0], &mmax[0], &items[0], items.size() );
+}
+
+
+void SCH_ITEM_INDEX::Clear()
+{
+    m_tree.RemoveAll();
+    m_entries.clear();
+    m_nextOrder = 0;
+}
+
+
+void SCH_ITEM_INDEX::Insert( SCH_ITEM* aItem )
+{
+    wxCHECK_RET( m_entries.find( aItem ) == m_entries.end(),
+                 wxT( "Item already in the schematic index." ) );
+
+    const ENTRY& entry = m_entries[aItem] = makeEntry( aItem );
+
+    m_tree.Insert( entry.m_Min, entry.m_Max, aItem );
+}
+
+
+void SCH_ITEM_INDEX::Remove( SCH_ITEM* aItem )
+{
+    ENTRIES::iterator it = m_entries.find( aItem );
+
+    if( it == m_entries.end() )
+        return;
+
+    m_tree.Remove( it->second.m_Min, it->second.m_Max, aItem );
+    m_entries.erase( it );
+}
+
+
+void SCH_ITEM_INDEX::Query( const EDA_RECT& aArea, std::vector<SCH_ITEM*>& aItems )
+{
+    aItems.clear();
+
+    EDA_RECT area = aArea;
+    area.Normalize();
+
+    const int mmin[2] = { area.GetX(), area.GetY() };
+    const int mmax[2] = { area.GetRight(), area.GetBottom() };
+
+    SCH_ITEM_COLLECTOR collector( aItems );
+    m_tree.Search( mmin, mmax, collector );
+
+    if( aItems.size() > 1 )
+    {
+        // Restore the draw list order
+        std::vector< std::pair<unsigned, SCH_ITEM*> > sorted;
+
+        for( unsigned i = 0; i < aItems.size(); i++ )
+            sorted.push_back( std::make_pair( m_entries[aItems[i]].m_Order, aItems[i] ) );
+
+        std::sort( sorted.begin(), sorted.end() );
+
+        for( unsigned i = 0; i < sorted.size(); i++ )
+            aItems[i] = sorted[i].second;
+    }
+}
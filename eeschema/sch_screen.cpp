@@ -53,6 +53,8 @@
 #include <sch_text.h>
 #include <lib_pin.h>
 
+#include <algorithm>
+#include <geometry/rtree.h>
 #include <boost/foreach.hpp>
 
 #define EESCHEMA_FILE_STAMP   "EESchema"
@@ -76,6 +78,9 @@ static double SchematicZoomList[] =
 
 #define MM_TO_SCH_UNITS 1000.0 / 25.4       //schematic internal unites are mils
 
+/// Last stamp given by SCH_SCREEN::SetConnectivityModified(), to all screens
+static int s_lastConnectivityStamp = 0;
+
 
 /* Default grid sizes for the schematic editor.
  * Do NOT add others values (mainly grid values in mm),
@@ -112,6 +117,8 @@ SCH_SCREEN::SCH_SCREEN( KIWAY* aKiway ) :
 
     SetGrid( wxRealPoint( 50, 50 ) );   // Default grid size.
     m_refCount = 0;
+    m_itemIndexStamp = 0;
+    SetConnectivityModified();
 
     // Suitable for schematic only. For libedit and viewlib, must be set to true
     m_Center = false;
@@ -152,15 +159,68 @@ void SCH_SCREEN::Clear()
 }
 
 
+void SCH_SCREEN::SetConnectivityModified()
+{
+    m_connectivityStamp = ++s_lastConnectivityStamp;
+}
+
+
+void SCH_SCREEN::Append( SCH_ITEM* aItem )
+{
+    bool indexed = itemIndexIsValid();
+
+    m_drawList.Append( aItem );
+    --m_modification_sync;
+    SetConnectivityModified();
+
+    // Keep the spatial index in sync instead of rebuilding it on next use.
+    if( indexed )
+    {
+        m_itemIndex.Insert( aItem );
+        m_itemIndexStamp = m_connectivityStamp;
+    }
+}
+
+
+void SCH_SCREEN::Append( DLIST< SCH_ITEM >& aList )
+{
+    bool      indexed = itemIndexIsValid();
+    SCH_ITEM* first = aList.begin();
+
+    m_drawList.Append( aList );
+    --m_modification_sync;
+    SetConnectivityModified();
+
+    if( indexed )
+    {
+        for( SCH_ITEM* item = first; item; item = item->Next() )
+            m_itemIndex.Insert( item );
+
+        m_itemIndexStamp = m_connectivityStamp;
+    }
+}
+
+
 void SCH_SCREEN::FreeDrawList()
 {
     m_drawList.DeleteAll();
+    m_itemIndex.Clear();
+    SetConnectivityModified();
 }
 
 
 void SCH_SCREEN::Remove( SCH_ITEM* aItem )
 {
+    bool indexed = itemIndexIsValid();
+
     m_drawList.Remove( aItem );
+    SetConnectivityModified();
+
+    if( indexed )
+    {
+        m_itemIndex.Remove( aItem );
+        m_itemIndexStamp = m_connectivityStamp;
+    }
 }
 
 
@@ -172,6 +232,8 @@ void SCH_SCREEN::DeleteItem( SCH_ITEM* aItem )
 
     if( aItem->Type() == SCH_SHEET_PIN_T )
     {
+        SetConnectivityModified();
+
         // This structure is attached to a sheet, get the parent sheet object.
         SCH_SHEET_PIN* sheetPin = (SCH_SHEET_PIN*) aItem;
         SCH_SHEET* sheet = sheetPin->GetParent();
@@ -182,11 +244,24 @@ void SCH_SCREEN::DeleteItem( SCH_ITEM* aItem )
     }
     else
     {
-        delete m_drawList.Remove( aItem );
+        Remove( aItem );
+        delete aItem;
     }
 }
 
 
+void SCH_SCREEN::queryItems( const EDA_RECT& aArea, std::vector<SCH_ITEM*>& aItems ) const
+{
+    if( !itemIndexIsValid() )
+    {
+        m_itemIndex.Build( m_drawList.begin() );
+        m_itemIndexStamp = m_connectivityStamp;
+    }
+
+    m_itemIndex.Query( aArea, aItems );
+}
+
+
 bool SCH_SCREEN::CheckIfOnDrawList( SCH_ITEM* aItem )
 {
     SCH_ITEM* itemList = m_drawList.begin();
@@ -205,8 +280,14 @@ bool SCH_SCREEN::CheckIfOnDrawList( SCH_ITEM* aItem )
 
 SCH_ITEM* SCH_SCREEN::GetItem( const wxPoint& aPosition, int aAccuracy, KICAD_T aType ) const
 {
-    for( SCH_ITEM* item = m_drawList.begin(); item; item = item->Next() )
+    std::vector<SCH_ITEM*> items;
+
+    queryItems( aPosition, aAccuracy, items );
+
+    for( unsigned ii = 0; ii < items.size(); ii++ )
     {
+        SCH_ITEM* item = items[ii];
+
         if( item->HitTest( aPosition, aAccuracy ) && (aType == NOT_USED) )
             return item;
 
@@ -266,6 +347,8 @@ void SCH_SCREEN::ExtractWires( DLIST< SCH_ITEM >& aList, bool aCreateCopy )
             break;
         }
     }
+
+    SetConnectivityModified();
 }
 
 
@@ -292,6 +375,7 @@ void SCH_SCREEN::ReplaceWires( DLIST< SCH_ITEM >& aWireList )
     }
 
     m_drawList.Append( aWireList );
+    SetConnectivityModified();
 }
 
 
@@ -481,6 +565,10 @@ bool SCH_SCREEN::SchematicCleanUp( EDA_DRAW_PANEL* aCanvas, wxDC* aDC )
         }
     }
 
+    // Merged lines were modified in place.
+    if( modified )
+        SetConnectivityModified();
+
     TestDanglingEnds( aCanvas, aDC );
 
     if( aCanvas && modified )
@@ -567,6 +655,9 @@ void SCH_SCREEN::BuildSchCmpLinksToLibCmp()
             SCH_COMPONENT::ResolveAll( c, libs );
 
             m_modification_sync = mod_hash;     // note the last mod_hash
+
+            // Pins of components may have changed
+            SetConnectivityModified();
         }
     }
 }
@@ -646,16 +737,18 @@ void SCH_SCREEN::ClearDrawingState()
 LIB_PIN* SCH_SCREEN::GetPin( const wxPoint& aPosition, SCH_COMPONENT** aComponent,
                              bool aEndPointOnly ) const
 {
-    SCH_ITEM*       item;
     SCH_COMPONENT*  component = NULL;
     LIB_PIN*        pin = NULL;
+    std::vector<SCH_ITEM*> items;
 
-    for( item = m_drawList.begin(); item; item = item->Next() )
+    queryItems( aPosition, 0, items );
+
+    for( unsigned ii = 0; ii < items.size(); ii++ )
     {
-        if( item->Type() != SCH_COMPONENT_T )
+        if( items[ii]->Type() != SCH_COMPONENT_T )
             continue;
 
-        component = (SCH_COMPONENT*) item;
+        component = (SCH_COMPONENT*) items[ii];
 
         if( aEndPointOnly )
         {
@@ -719,13 +812,16 @@ SCH_SHEET* SCH_SCREEN::GetSheet( const wxString& aName )
 SCH_SHEET_PIN* SCH_SCREEN::GetSheetLabel( const wxPoint& aPosition )
 {
     SCH_SHEET_PIN* sheetPin = NULL;
+    std::vector<SCH_ITEM*> items;
 
-    for( SCH_ITEM* item = m_drawList.begin(); item; item = item->Next() )
+    queryItems( aPosition, 0, items );
+
+    for( unsigned ii = 0; ii < items.size(); ii++ )
     {
-        if( item->Type() != SCH_SHEET_T )
+        if( items[ii]->Type() != SCH_SHEET_T )
             continue;
 
-        SCH_SHEET* sheet = (SCH_SHEET*) item;
+        SCH_SHEET* sheet = (SCH_SHEET*) items[ii];
         sheetPin = sheet->GetPin( aPosition );
 
         if( sheetPin )
@@ -738,11 +834,15 @@ SCH_SHEET_PIN* SCH_SCREEN::GetSheetLabel( const wxPoint& aPosition )
 
 int SCH_SCREEN::CountConnectedItems( const wxPoint& aPos, bool aTestJunctions ) const
 {
-    SCH_ITEM* item;
     int       count = 0;
+    std::vector<SCH_ITEM*> items;
 
-    for( item = m_drawList.begin(); item; item = item->Next() )
+    queryItems( aPos, 0, items );
+
+    for( unsigned ii = 0; ii < items.size(); ii++ )
     {
+        SCH_ITEM* item = items[ii];
+
         if( item->Type() == SCH_JUNCTION_T  && !aTestJunctions )
             continue;
 
@@ -852,12 +952,16 @@ void SCH_SCREEN::SelectBlockItems()
 
 void SCH_SCREEN::addConnectedItemsToBlock( const wxPoint& position )
 {
-    SCH_ITEM* item;
     ITEM_PICKER picker;
     bool addinlist = true;
+    std::vector<SCH_ITEM*> items;
 
-    for( item = m_drawList.begin(); item; item = item->Next() )
+    queryItems( position, 0, items );
+
+    for( unsigned ii = 0; ii < items.size(); ii++ )
     {
+        SCH_ITEM* item = items[ii];
+
         picker.SetItem( item );
 
         if( !item->IsConnectable() || !item->IsConnected( position )
@@ -904,8 +1008,14 @@ int SCH_SCREEN::UpdatePickList()
     area.SetSize( m_BlockLocate.GetSize() );
     area.Normalize();
 
-    for( SCH_ITEM* item = m_drawList.begin(); item; item = item->Next() )
+    std::vector<SCH_ITEM*> items;
+
+    queryItems( area, items );
+
+    for( unsigned ii = 0; ii < items.size(); ii++ )
     {
+        SCH_ITEM* item = items[ii];
+
         // An item is picked if its bounding box intersects the reference area.
         if( item->HitTest( area ) )
         {
@@ -930,6 +1040,100 @@ int SCH_SCREEN::UpdatePickList()
 }
 
 
+/**
+ * Class DANGLING_END_INDEX
+ * is an R-tree of the end items of a screen.  It gives each item only the end items which
+ * can change its dangling state: the ones located at its own end points, and the wires and
+ * buses passing over them.
+ */
+class DANGLING_END_INDEX
+{
+public:
+    DANGLING_END_INDEX( const std::vector< DANGLING_END_ITEM >& aEndPoints ) :
+        m_endPoints( aEndPoints )
+    {
+        std::vector< int > ids, mmin, mmax;
+
+        for( unsigned ii = 0; ii < aEndPoints.size(); ii++ )
+        {
+            wxPoint start = aEndPoints[ii].GetPosition();
+            wxPoint end = start;
+
+            // A wire or a bus is indexed as a whole, see Query().
+            if( isSegmentStart( ii ) )
+                end = aEndPoints[ii + 1].GetPosition();
+
+            ids.push_back( ii );
+            mmin.push_back( std::min( start.x, end.x ) );
+            mmin.push_back( std::min( start.y, end.y ) );
+            mmax.push_back( std::max( start.x, end.x ) );
+            mmax.push_back( std::max( start.y, end.y ) );
+
+            if( isSegmentStart( ii ) )
+                ii++;
+        }
+
+        if( !ids.empty() )
+            m_tree.BulkInsert( &mmin[0], &mmax[0], &ids[0], ids.size() );
+    }
+
+    /**
+     * Function Query
+     * finds the end items located at or passing over \a aEnds.
+     * @param aEnds are the end points of the tested item.
+     * @param aNearEnds is filled with the end items found, in the order of the indexed list.
+     *                  A wire or a bus is given by its two consecutive end items, which
+     *                  SCH_TEXT::IsDanglingStateChanged() expects.
+     */
+    void Query( const std::vector< DANGLING_END_ITEM >& aEnds,
+                std::vector< DANGLING_END_ITEM >& aNearEnds )
+    {
+        m_found.clear();
+
+        for( unsigned ii = 0; ii < aEnds.size(); ii++ )
+        {
+            const int point[2] = { aEnds[ii].GetPosition().x, aEnds[ii].GetPosition().y };
+
+            m_tree.Search( point, point, *this );
+        }
+
+        std::sort( m_found.begin(), m_found.end() );
+        m_found.erase( std::unique( m_found.begin(), m_found.end() ), m_found.end() );
+
+        aNearEnds.clear();
+
+        for( unsigned ii = 0; ii < m_found.size(); ii++ )
+        {
+            aNearEnds.push_back( m_endPoints[m_found[ii]] );
+
+            if( isSegmentStart( m_found[ii] ) )
+                aNearEnds.push_back( m_endPoints[m_found[ii] + 1] );
+        }
+    }
+
+    /// R-tree search callback
+    bool operator()( int aId )
+    {
+        m_found.push_back( aId );
+        return true;
+    }
+
+private:
+    /// @return true if the end item \a aIndex and the next one are the ends of a segment.
+    bool isSegmentStart( unsigned aIndex ) const
+    {
+        DANGLING_END_T type = m_endPoints[aIndex].GetType();
+
+        return ( type == WIRE_START_END || type == BUS_START_END )
+               && aIndex + 1 < m_endPoints.size();
+    }
+
+    const std::vector< DANGLING_END_ITEM >& m_endPoints;
+    RTree< int, int, 2, float >             m_tree;
+    std::vector< int >                      m_found;
+};
+
+
 bool SCH_SCREEN::TestDanglingEnds( EDA_DRAW_PANEL* aCanvas, wxDC* aDC )
 {
     SCH_ITEM* item;
@@ -939,9 +1143,19 @@ bool SCH_SCREEN::TestDanglingEnds( EDA_DRAW_PANEL* aCanvas, wxDC* aDC )
     for( item = m_drawList.begin(); item; item = item->Next() )
         item->GetEndPoints( endPoints );
 
+    // Testing every item against all the end points is quadratic, so every item is
+    // only given the end points near its own ones.
+    DANGLING_END_INDEX endPointIndex( endPoints );
+    std::vector< DANGLING_END_ITEM > itemEnds;
+    std::vector< DANGLING_END_ITEM > nearEnds;
+
     for( item = m_drawList.begin(); item; item = item->Next() )
     {
-        if( item->IsDanglingStateChanged( endPoints ) && ( aCanvas ) && ( aDC ) )
+        itemEnds.clear();
+        item->GetEndPoints( itemEnds );
+        endPointIndex.Query( itemEnds, nearEnds );
+
+        if( item->IsDanglingStateChanged( nearEnds ) && ( aCanvas ) && ( aDC ) )
         {
             item->Draw( aCanvas, aDC, wxPoint( 0, 0 ), g_XorMode );
             item->Draw( aCanvas, aDC, wxPoint( 0, 0 ), GR_DEFAULT_DRAWMODE );
@@ -980,6 +1194,9 @@ bool SCH_SCREEN::BreakSegment( const wxPoint& aPoint )
         brokenSegments = true;
     }
 
+    if( brokenSegments )
+        SetConnectivityModified();
+
     return brokenSegments;
 }
 
@@ -1015,8 +1232,14 @@ bool SCH_SCREEN::BreakSegmentsOnJunctions()
 
 int SCH_SCREEN::GetNode( const wxPoint& aPosition, EDA_ITEMS& aList )
 {
-    for( SCH_ITEM* item = m_drawList.begin(); item; item = item->Next() )
+    std::vector<SCH_ITEM*> items;
+
+    queryItems( aPosition, 0, items );
+
+    for( unsigned ii = 0; ii < items.size(); ii++ )
     {
+        SCH_ITEM* item = items[ii];
+
         if( item->Type() == SCH_LINE_T && item->HitTest( aPosition )
             && (item->GetLayer() == LAYER_BUS || item->GetLayer() == LAYER_WIRE) )
         {
@@ -1034,8 +1257,14 @@ int SCH_SCREEN::GetNode( const wxPoint& aPosition, EDA_ITEMS& aList )
 
 SCH_LINE* SCH_SCREEN::GetWireOrBus( const wxPoint& aPosition )
 {
-    for( SCH_ITEM* item = m_drawList.begin(); item; item = item->Next() )
+    std::vector<SCH_ITEM*> items;
+
+    queryItems( aPosition, 0, items );
+
+    for( unsigned ii = 0; ii < items.size(); ii++ )
     {
+        SCH_ITEM* item = items[ii];
+
         if( (item->Type() == SCH_LINE_T) && item->HitTest( aPosition )
             && (item->GetLayer() == LAYER_BUS || item->GetLayer() == LAYER_WIRE) )
         {
@@ -1050,8 +1279,14 @@ SCH_LINE* SCH_SCREEN::GetWireOrBus( const wxPoint& aPosition )
 SCH_LINE* SCH_SCREEN::GetLine( const wxPoint& aPosition, int aAccuracy, int aLayer,
                                SCH_LINE_TEST_T aSearchType )
 {
-    for( SCH_ITEM* item = m_drawList.begin(); item; item = item->Next() )
+    std::vector<SCH_ITEM*> items;
+
+    queryItems( aPosition, aAccuracy, items );
+
+    for( unsigned ii = 0; ii < items.size(); ii++ )
     {
+        SCH_ITEM* item = items[ii];
+
         if( item->Type() != SCH_LINE_T )
             continue;
 
@@ -1083,8 +1318,14 @@ SCH_LINE* SCH_SCREEN::GetLine( const wxPoint& aPosition, int aAccuracy, int aLay
 
 SCH_TEXT* SCH_SCREEN::GetLabel( const wxPoint& aPosition, int aAccuracy )
 {
-    for( SCH_ITEM* item = m_drawList.begin(); item; item = item->Next() )
+    std::vector<SCH_ITEM*> items;
+
+    queryItems( aPosition, aAccuracy, items );
+
+    for( unsigned ii = 0; ii < items.size(); ii++ )
     {
+        SCH_ITEM* item = items[ii];
+
         switch( item->Type() )
         {
         case SCH_LABEL_T:
@@ -1437,6 +1678,13 @@ void SCH_SCREENS::ClearAnnotation()
 }
 
 
+void SCH_SCREENS::SetConnectivityModified()
+{
+    for( size_t i = 0;  i < m_screens.size();  i++ )
+        m_screens[i]->SetConnectivityModified();
+}
+
+
 void SCH_SCREENS::SchematicCleanUp()
 {
     for( size_t i = 0;  i < m_screens.size();  i++ )
@@ -719,6 +719,7 @@ void SCH_EDIT_FRAME::OnModify()
 {
     GetScreen()->SetModify();
     GetScreen()->SetSave();
+    GetScreen()->SetConnectivityModified();
 
     if( m_dlgFindReplace == NULL )
         m_foundItems.SetForceSearch();
@@ -1186,6 +1187,7 @@ void SCH_EDIT_FRAME::addCurrentItemToList( wxDC* aDC )
 
     item->ClearFlags();
     screen->SetModify();
+    screen->SetConnectivityModified();
     screen->SetCurItem( NULL );
     m_canvas->SetMouseCapture( NULL, NULL );
     m_canvas->EndMouseCapture();
@@ -157,6 +157,9 @@ protected:
     void onEnter( wxEvent& aEvent );
     void onRefreshTimer( wxTimerEvent& aEvent );
 
+    /// Draws a summary of events recorded by PROF_TRACE on the overlay target
+    void drawProfilingOverlay();
+
     static const int MinRefreshPeriod = 17;             ///< 60 FPS.
 
     /// Pointer to the parent window
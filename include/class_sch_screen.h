@@ -36,6 +36,7 @@
 #include <class_base_screen.h>
 #include <class_title_block.h>
 #include <kiway_player.h>
+#include <sch_item_index.h>
 
 #include <../eeschema/general.h>
 
@@ -83,6 +84,40 @@ private:
     int     m_modification_sync;        ///< inequality with PART_LIBS::GetModificationHash()
                                         ///< will trigger ResolveAll().
 
+    int     m_connectivityStamp;        ///< changed when connectible items are modified,
+                                        ///< see GetConnectivityStamp()
+
+    mutable SCH_ITEM_INDEX m_itemIndex; ///< Spatial index of m_drawList, for hit testing.
+    mutable int     m_itemIndexStamp;   ///< m_connectivityStamp when m_itemIndex was last
+                                        ///< updated.  The index is rebuilt before being
+                                        ///< used if the stamp has changed since then.
+
+    /**
+     * Function itemIndexIsValid
+     * @return true if m_itemIndex matches the items of the screen.
+     */
+    bool itemIndexIsValid() const { return m_itemIndexStamp == m_connectivityStamp; }
+
+    /**
+     * Function queryItems
+     * finds the items which can be hit in \a aArea, using the spatial index which is
+     * rebuilt first if the screen was modified.
+     * @param aItems is filled with the items found, in draw list order.
+     */
+    void queryItems( const EDA_RECT& aArea, std::vector<SCH_ITEM*>& aItems ) const;
+
+    /**
+     * Function queryItems
+     * finds the items which can be hit within \a aAccuracy of \a aPosition.
+     */
+    void queryItems( const wxPoint& aPosition, int aAccuracy,
+                     std::vector<SCH_ITEM*>& aItems ) const
+    {
+        EDA_RECT area( aPosition, wxSize( 0, 0 ) );
+
+        queryItems( area.Inflate( aAccuracy ), aItems );
+    }
+
     /**
      * Function addConnectedItemsToBlock
      * add items connected at \a aPosition to the block pick list.
@@ -135,11 +170,11 @@ public:
      */
     SCH_ITEM* GetDrawItems() const                          { return m_drawList.begin(); }
 
-    void Append( SCH_ITEM* aItem )
-    {
-        m_drawList.Append( aItem );
-        --m_modification_sync;
-    }
+    /**
+     * Function Append
+     * adds \a aItem to the end of the list of draw items for the sheet.
+     */
+    void Append( SCH_ITEM* aItem );
 
     /**
      * Function Append
@@ -147,11 +182,22 @@ public:
      *
      * @param aList A reference to a #DLIST containing the #SCH_ITEM to add to the sheet.
      */
-    void Append( DLIST< SCH_ITEM >& aList )
-    {
-        m_drawList.Append( aList );
-        --m_modification_sync;
-    }
+    void Append( DLIST< SCH_ITEM >& aList );
+
+    /**
+     * Function GetConnectivityStamp
+     * returns a value which is changed each time items of the screen are added, removed
+     * or modified.  Connections found in the screen items (see NETLIST_OBJECT_LIST) are
+     * kept while it does not change.  Stamps are unique among all screens.
+     */
+    int GetConnectivityStamp() const { return m_connectivityStamp; }
+
+    /**
+     * Function SetConnectivityModified
+     * must be called after items of the screen are modified, to invalidate the
+     * connections found in the screen and the spatial index used for hit testing.
+     */
+    void SetConnectivityModified();
 
     /**
      * Function GetCurItem
@@ -552,6 +598,13 @@ public:
      */
     void ClearAnnotation();
 
+    /**
+     * Function SetConnectivityModified
+     * invalidates the connections found in all the screens, after a change affecting the
+     * entire hierarchy (i.e. annotation, which can change the units of components).
+     */
+    void SetConnectivityModified();
+
     /**
      * Function SchematicCleanUp
      * merges and breaks wire segments in the entire schematic hierarchy.
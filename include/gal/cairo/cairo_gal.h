@@ -28,7 +28,9 @@
 #define CAIROGAL_H_
 
 #include <map>
+#include <vector>
 #include <iterator>
+#include <string>
 
 #include <cairo.h>
 
@@ -46,44 +48,27 @@
 #endif
 #endif
 
-/**
- * @brief Class CAIRO_GAL is the cairo implementation of the graphics abstraction layer.
- *
- * Quote from Wikipedia:
- * " Cairo is a software library used to provide a vector graphics-based, device-independent
- *   API for software developers. It is designed to provide primitives for 2-dimensional
- *   drawing across a number of different backends. "
- * <br>
- * Cairo offers also backends for Postscript and PDF surfaces. So it can be used for printing
- * of KiCad graphics surfaces as well.
- *
- */
 namespace KIGFX
 {
 class CAIRO_COMPOSITOR;
 
-class CAIRO_GAL : public GAL, public wxWindow
+/**
+ * Class CAIRO_GAL_BASE
+ * holds the part of the Cairo GAL that does not depend on a window: it renders
+ * into an in-memory Cairo image surface. Derived classes decide what happens
+ * with the image once a frame is finished.
+ */
+class CAIRO_GAL_BASE : public GAL
 {
 public:
     /**
-     * Constructor CAIRO_GAL
-     *
-     * @param aParent is the wxWidgets immediate wxWindow parent of this object.
-     *
-     * @param aMouseListener is the wxEvtHandler that should receive the mouse events,
-     *  this can be can be any wxWindow, but is often a wxFrame container.
-     *
-     * @param aPaintListener is the wxEvtHandler that should receive the paint
-     *  event.  This can be any wxWindow, but is often a derived instance
-     *  of this class or a containing wxFrame.  The "paint event" here is
-     *  a wxCommandEvent holding EVT_GAL_REDRAW, as sent by PostPaint().
+     * Constructor CAIRO_GAL_BASE
      *
-     * @param aName is the name of this window for use by wxWindow::FindWindowByName()
+     * @param aScreenSize is the initial size of the image, in pixels.
      */
-    CAIRO_GAL( wxWindow* aParent, wxEvtHandler* aMouseListener = NULL,
-               wxEvtHandler* aPaintListener = NULL, const wxString& aName = wxT( "CairoCanvas" ) );
+    CAIRO_GAL_BASE( const VECTOR2I& aScreenSize );
 
-    virtual ~CAIRO_GAL();
+    virtual ~CAIRO_GAL_BASE();
 
     // ---------------
     // Drawing methods
@@ -128,9 +113,6 @@ public:
     /// @brief Resizes the canvas.
     virtual void ResizeScreen( int aWidth, int aHeight );
 
-    /// @brief Shows/hides the GAL canvas
-    virtual bool Show( bool aShow );
-
     /// @copydoc GAL::Flush()
     virtual void Flush();
 
@@ -206,6 +188,18 @@ public:
     /// @copydoc GAL::ClearCache()
     virtual void ClearCache();
 
+    /// @copydoc GAL::IsGrouping()
+    virtual bool IsGrouping() const
+    {
+        return isGrouping;
+    }
+
+    /// @copydoc GAL::IsInstancingSupported()
+    virtual bool IsInstancingSupported() const
+    {
+        return true;
+    }
+
     // --------------------------------------------------------
     // Handling the world <-> screen transformation
     // --------------------------------------------------------
@@ -225,44 +219,28 @@ public:
     /// @copydoc GAL::ClearTarget()
     virtual void ClearTarget( RENDER_TARGET aTarget );
 
+    /// @copydoc GAL::IsClippingSupported()
+    virtual bool IsClippingSupported() const
+    {
+        return true;
+    }
+
+    /// @copydoc GAL::SetClipArea()
+    virtual void SetClipArea( const BOX2D& aArea );
+
+    /// @copydoc GAL::ResetClipArea()
+    virtual void ResetClipArea();
+
     // -------
     // Cursor
     // -------
 
-    /// @copydoc GAL::SetCursorSize()
-    virtual void SetCursorSize( unsigned int aCursorSize );
-
     /// @copydoc GAL::DrawCursor()
     virtual void DrawCursor( const VECTOR2D& aCursorPosition );
 
-    /**
-     * Function PostPaint
-     * posts an event to m_paint_listener.  A post is used so that the actual drawing
-     * function can use a device context type that is not specific to the wxEVT_PAINT event.
-     */
-    void PostPaint()
-    {
-        if( paintListener )
-        {
-            wxPaintEvent redrawEvent;
-            wxPostEvent( paintListener, redrawEvent );
-        }
-    }
-
-    void SetMouseListener( wxEvtHandler* aMouseListener )
-    {
-        mouseListener = aMouseListener;
-    }
-
-    void SetPaintListener( wxEvtHandler* aPaintListener )
-    {
-        paintListener = aPaintListener;
-    }
-
 protected:
     virtual void drawGridLine( const VECTOR2D& aStartPoint, const VECTOR2D& aEndPoint );
 
-private:
     /// Super class definition
     typedef GAL super;
 
@@ -273,19 +251,7 @@ private:
     RENDER_TARGET           currentTarget;          ///< Current rendering target
     bool                    validCompositor;        ///< Compositor initialization flag
 
-    // Variables related to wxWidgets
-    wxWindow*               parentWindow;           ///< Parent window
-    wxEvtHandler*           mouseListener;          ///< Mouse listener
-    wxEvtHandler*           paintListener;          ///< Paint listener
     unsigned int            bufferSize;             ///< Size of buffers cairoOutput, bitmapBuffers
-    unsigned char*          wxOutput;               ///< wxImage comaptible buffer
-
-    // Cursor variables
-    std::deque<wxColour>    savedCursorPixels;      ///< Saved pixels of the cursor
-    bool                    isDeleteSavedPixels;    ///< True, if the saved pixels can be discarded
-    wxPoint                 savedCursorPosition;    ///< The last cursor position
-    wxBitmap*               cursorPixels;           ///< Cursor pixels
-    wxBitmap*               cursorPixelsSaved;      ///< Saved cursor pixels
 
     /// Maximum number of arguments for one command
     static const int MAX_CAIRO_ARGUMENTS = 6;
@@ -327,7 +293,31 @@ private:
     unsigned int                groupCounter;       ///< Counter used for generating keys for groups
     GROUP*                      currentGroup;       ///< Currently used group
 
-    // Variables related to Cairo <-> wxWidgets
+    /// Drawing attributes that are changed by the commands stored in groups
+    struct REPLAY_STATE
+    {
+        bool    isFillEnabled;
+        bool    isStrokeEnabled;
+        COLOR4D fillColor;
+        COLOR4D strokeColor;
+    };
+
+    /// Group drawn with DrawGroup(), waiting to be rasterized by flushGroups()
+    struct DEFERRED_GROUP
+    {
+        const GROUP*    group;                      ///< Commands to be executed
+        cairo_matrix_t  matrix;                     ///< Transformation at the moment of the call
+        double          lineWidth;                  ///< Line width at the moment of the call
+        REPLAY_STATE    state;                      ///< Attributes at the moment of the call
+        double          top;                        ///< Upper bound of drawn pixels (device y)
+        double          bottom;                     ///< Lower bound of drawn pixels (device y)
+    };
+
+    // Variables for the tiled rasterization of groups
+    std::vector<DEFERRED_GROUP> deferredGroups;     ///< Groups waiting to be rasterized
+    int                         tileCount;          ///< Number of tiles rasterized in parallel
+
+    // Cairo image and surface
     cairo_matrix_t      cairoWorldScreenMatrix; ///< Cairo world to screen transformation matrix
     cairo_t*            currentContext;         ///< Currently used Cairo context for drawing
     cairo_t*            context;                ///< Cairo image
@@ -338,33 +328,39 @@ private:
     bool                isInitialized;          ///< Are Cairo image & surface ready to use
     COLOR4D             backgroundColor;        ///< Background color
 
+    // Clipping
+    bool                isClipping;             ///< Is drawing limited to clipArea?
+    BOX2I               clipArea;               ///< Area of the screen that may be changed
+
     // Methods
     void storePath();                           ///< Store the actual path
 
-    // Event handlers
-    /**
-     * @brief Paint event handler.
-     *
-     * @param aEvent is the paint event.
-     */
-    void onPaint( wxPaintEvent& aEvent );
+    /// Finishes drawing of a layer by painting its group onto the current buffer
+    void paintLayer();
 
     /**
-     * @brief Mouse event handler, forwards the event to the child.
+     * @brief Executes commands stored in a group.
      *
-     * @param aEvent is the mouse event to be forwarded.
+     * @param aContext is the context used for drawing.
+     * @param aGroup is the group to be executed.
+     * @param aState holds the drawing attributes, they are updated by the group commands.
+     * @param aDraw tells if paths should be drawn. If false, only the context state and
+     *  the drawing attributes are updated.
+     * @param aDeferred (optional) has its vertical extents enlarged to cover paths of the group,
+     *  if they are not drawn.
      */
-    void skipMouseEvent( wxMouseEvent& aEvent );
+    void replayGroup( cairo_t* aContext, const GROUP& aGroup, REPLAY_STATE& aState, bool aDraw,
+                      DEFERRED_GROUP* aDeferred = NULL );
 
-    /**
-     * @brief Prepares cursor bitmap.
-     */
-    virtual void initCursor();
+    /// Enlarges vertical extents of a deferred group to cover a path (in the current context)
+    void updateExtents( cairo_t* aContext, cairo_path_t* aPath, bool aStroke,
+                        DEFERRED_GROUP& aDeferred );
 
     /**
-     * @brief Blits cursor into the current screen.
+     * @brief Rasterizes deferred groups. The current target is split into horizontal tiles
+     * that are drawn in parallel, each one using its own Cairo surface and context.
      */
-    virtual void blitCursor( wxBufferedDC& clientDC );
+    void flushGroups();
 
     /// Prepare Cairo surfaces for drawing
     void initSurface();
@@ -391,9 +387,180 @@ private:
     /// Format used to store pixels
     static const cairo_format_t GAL_FORMAT = CAIRO_FORMAT_RGB24;
 
+    ///> Minimal number of deferred groups that is worth splitting into tiles
+    static const unsigned int MIN_TILED_GROUPS = 64;
+
     ///> Opacity of a single layer
     static const float LAYER_ALPHA;
 };
+
+
+/**
+ * @brief Class CAIRO_GAL is the cairo implementation of the graphics abstraction layer.
+ *
+ * Quote from Wikipedia:
+ * " Cairo is a software library used to provide a vector graphics-based, device-independent
+ *   API for software developers. It is designed to provide primitives for 2-dimensional
+ *   drawing across a number of different backends. "
+ * <br>
+ * Cairo offers also backends for Postscript and PDF surfaces. So it can be used for printing
+ * of KiCad graphics surfaces as well.
+ *
+ */
+class CAIRO_GAL : public CAIRO_GAL_BASE, public wxWindow
+{
+public:
+    /**
+     * Constructor CAIRO_GAL
+     *
+     * @param aParent is the wxWidgets immediate wxWindow parent of this object.
+     *
+     * @param aMouseListener is the wxEvtHandler that should receive the mouse events,
+     *  this can be can be any wxWindow, but is often a wxFrame container.
+     *
+     * @param aPaintListener is the wxEvtHandler that should receive the paint
+     *  event.  This can be any wxWindow, but is often a derived instance
+     *  of this class or a containing wxFrame.  The "paint event" here is
+     *  a wxCommandEvent holding EVT_GAL_REDRAW, as sent by PostPaint().
+     *
+     * @param aName is the name of this window for use by wxWindow::FindWindowByName()
+     */
+    CAIRO_GAL( wxWindow* aParent, wxEvtHandler* aMouseListener = NULL,
+               wxEvtHandler* aPaintListener = NULL, const wxString& aName = wxT( "CairoCanvas" ) );
+
+    virtual ~CAIRO_GAL();
+
+    /// @copydoc GAL::BeginDrawing()
+    virtual void BeginDrawing();
+
+    /// @copydoc GAL::EndDrawing()
+    virtual void EndDrawing();
+
+    /// @brief Resizes the canvas.
+    virtual void ResizeScreen( int aWidth, int aHeight );
+
+    /// @brief Shows/hides the GAL canvas
+    virtual bool Show( bool aShow );
+
+    /// @copydoc GAL::SetCursorSize()
+    virtual void SetCursorSize( unsigned int aCursorSize );
+
+    /**
+     * Function PostPaint
+     * posts an event to m_paint_listener.  A post is used so that the actual drawing
+     * function can use a device context type that is not specific to the wxEVT_PAINT event.
+     */
+    void PostPaint()
+    {
+        if( paintListener )
+        {
+            wxPaintEvent redrawEvent;
+            wxPostEvent( paintListener, redrawEvent );
+        }
+    }
+
+    void SetMouseListener( wxEvtHandler* aMouseListener )
+    {
+        mouseListener = aMouseListener;
+    }
+
+    void SetPaintListener( wxEvtHandler* aPaintListener )
+    {
+        paintListener = aPaintListener;
+    }
+
+private:
+    // Variables related to wxWidgets
+    wxWindow*               parentWindow;           ///< Parent window
+    wxEvtHandler*           mouseListener;          ///< Mouse listener
+    wxEvtHandler*           paintListener;          ///< Paint listener
+    unsigned char*          wxOutput;               ///< wxImage comaptible buffer
+
+    // Cursor variables
+    std::deque<wxColour>    savedCursorPixels;      ///< Saved pixels of the cursor
+    bool                    isDeleteSavedPixels;    ///< True, if the saved pixels can be discarded
+    wxPoint                 savedCursorPosition;    ///< The last cursor position
+    wxBitmap*               cursorPixels;           ///< Cursor pixels
+    wxBitmap*               cursorPixelsSaved;      ///< Saved cursor pixels
+
+    // Event handlers
+    /**
+     * @brief Paint event handler.
+     *
+     * @param aEvent is the paint event.
+     */
+    void onPaint( wxPaintEvent& aEvent );
+
+    /**
+     * @brief Mouse event handler, forwards the event to the child.
+     *
+     * @param aEvent is the mouse event to be forwarded.
+     */
+    void skipMouseEvent( wxMouseEvent& aEvent );
+
+    /**
+     * @brief Prepares cursor bitmap.
+     */
+    virtual void initCursor();
+
+    /**
+     * @brief Blits cursor into the current screen.
+     */
+    virtual void blitCursor( wxBufferedDC& clientDC );
+};
+
+
+/**
+ * Class CAIRO_OFFSCREEN_GAL
+ * is a Cairo GAL that is not attached to any window. Every frame is rendered into
+ * an in-memory image, so it works without a display (e.g. for benchmarks or for
+ * comparing rendering results in regression tests).
+ */
+class CAIRO_OFFSCREEN_GAL : public CAIRO_GAL_BASE
+{
+public:
+    /**
+     * Constructor CAIRO_OFFSCREEN_GAL
+     *
+     * @param aWidth is the width of the image, in pixels.
+     * @param aHeight is the height of the image, in pixels.
+     */
+    CAIRO_OFFSCREEN_GAL( int aWidth, int aHeight );
+
+    /// @brief There is nothing to be shown, the request is ignored.
+    virtual bool Show( bool aShow )
+    {
+        return false;
+    }
+
+    /**
+     * Function GetPixels
+     * returns the last rendered frame. Pixels are stored as CAIRO_FORMAT_RGB24, rows are
+     * GetStride() bytes long.
+     */
+    const unsigned int* GetPixels() const
+    {
+        return bitmapBuffer;
+    }
+
+    /**
+     * Function GetStride
+     * returns the length of a single row of pixels returned by GetPixels(), in bytes.
+     */
+    int GetStride() const
+    {
+        return stride;
+    }
+
+    /**
+     * Function SaveImage
+     * writes the last rendered frame to a PNG file.
+     *
+     * @param aFileName is the name of the output file.
+     * @return True if the file was written successfully.
+     */
+    bool SaveImage( const std::string& aFileName ) const;
+};
 } // namespace KIGFX
 
 #endif  // CAIROGAL_H_
@@ -28,10 +28,12 @@
 #define GRAPHICSABSTRACTIONLAYER_H_
 
 #include <deque>
+#include <vector>
 #include <stack>
 #include <limits>
 
 #include <math/matrix3x3.h>
+#include <math/box2.h>
 
 #include <gal/color4d.h>
 #include <gal/definitions.h>
@@ -138,6 +140,23 @@ public:
      */
     virtual void DrawPolygon( const std::deque<VECTOR2D>& aPointList ) = 0;
 
+    /**
+     * @brief Draw a set of filled triangles. The default implementation draws each triangle
+     * as a polygon.
+     *
+     * @param aTriangles is the list of triangle corners, 3 consecutive points per triangle.
+     */
+    virtual void DrawTriangles( const std::vector<VECTOR2D>& aTriangles );
+
+    /**
+     * @brief Tells if drawing already triangulated shapes with DrawTriangles() is faster than
+     * drawing their outlines with DrawPolygon().
+     */
+    virtual bool IsTriangulationPreferred() const
+    {
+        return false;
+    }
+
     /**
      * @brief Draw a cubic bezier spline.
      *
@@ -410,6 +429,21 @@ public:
      */
     virtual void ClearCache() = 0;
 
+    /**
+     * @brief Tells if a group is being created. Items drawn to a group may be displayed
+     * at any zoom level, so they should not depend on the current one.
+     */
+    virtual bool IsGrouping() const = 0;
+
+    /**
+     * @brief Tells if groups are drawn using the current transformation, so a single group
+     * can be drawn in many places.
+     */
+    virtual bool IsInstancingSupported() const
+    {
+        return false;
+    }
+
     // --------------------------------------------------------
     // Handling the world <-> screen transformation
     // --------------------------------------------------------
@@ -609,6 +643,27 @@ public:
      */
     virtual void ClearTarget( RENDER_TARGET aTarget ) = 0;
 
+    /**
+     * @brief Tells if clearing targets and drawing may be limited to a part of the screen.
+     */
+    virtual bool IsClippingSupported() const
+    {
+        return false;
+    }
+
+    /**
+     * @brief Limits clearing of targets and drawing to an area of the screen. The area stays
+     * in effect until ResetClipArea() is called or the drawing is finished with EndDrawing().
+     *
+     * @param aArea is the area in world coordinates.
+     */
+    virtual void SetClipArea( const BOX2D& aArea ) {}
+
+    /**
+     * @brief Removes the limit set with SetClipArea().
+     */
+    virtual void ResetClipArea() {}
+
     // -------------
     // Grid methods
     // -------------
@@ -903,6 +958,16 @@ protected:
      */
     virtual void drawGridLine( const VECTOR2D& aStartPoint, const VECTOR2D& aEndPoint ) = 0;
 
+    /**
+     * @brief Computes the part of the screen (in pixels) covered by an area given in world
+     * coordinates. The result is enlarged by a pixel margin, so antialiased edges of items
+     * are covered as well, and limited to the screen size.
+     *
+     * @param aArea is the area in world coordinates.
+     * @return The area in screen coordinates.
+     */
+    BOX2I computeScreenArea( const BOX2D& aArea ) const;
+
     static const int MIN_DEPTH = -2048;
     static const int MAX_DEPTH = 2047;
 };
@@ -72,20 +72,62 @@ public:
      */
     virtual VERTEX* GetVertices( const VERTEX_ITEM* aItem ) const;
 
+    ///> Counters describing the work done by the memory manager
+    struct ALLOCATOR_STATS
+    {
+        unsigned int reallocations;     ///< Items moved to a bigger chunk
+        unsigned int resizes;           ///< Changes of the container size
+        unsigned int defragmentations;  ///< Full defragmentations
+        unsigned int compactedItems;    ///< Items moved by the incremental compaction
+        unsigned int compactedVertices; ///< Vertices moved by the incremental compaction
+    };
+
+    /**
+     * Function GetStats()
+     * returns counters describing the work done by the memory manager since the container was
+     * created or cleared.
+     */
+    inline const ALLOCATOR_STATS& GetStats() const
+    {
+        return m_stats;
+    }
+
+    /**
+     * Function GetFragmentation()
+     * returns the part of the free space that is not available as a single chunk: 0.0 means
+     * that all the free space is continuous, values close to 1.0 mean that it is scattered.
+     */
+    double GetFragmentation() const;
+
 protected:
-    ///> Maps size of free memory chunks to their offsets
+    ///> Free memory chunk, described by its size and offset (in this order, so chunks are
+    ///> sorted by size and then by offset)
     typedef std::pair<unsigned int, unsigned int> CHUNK;
-    typedef std::multimap<unsigned int, unsigned int> FREE_CHUNK_MAP;
+
+    ///> Free chunks sorted by size, used to find the best fitting chunk
+    typedef std::set<CHUNK> FREE_CHUNK_SET;
+
+    ///> Maps offsets of free chunks to their sizes, used to merge neighbouring chunks
+    typedef std::map<unsigned int, unsigned int> FREE_CHUNK_MAP;
 
     /// List of all the stored items
     typedef std::set<VERTEX_ITEM*> ITEMS;
 
+    ///> Maps offsets of items that have vertices stored to the items
+    typedef std::map<unsigned int, VERTEX_ITEM*> ITEM_OFFSET_MAP;
+
     ///> Stores size & offset of free chunks.
-    FREE_CHUNK_MAP      m_freeChunks;
+    FREE_CHUNK_SET      m_freeChunks;
+
+    ///> Stores offset & size of free chunks.
+    FREE_CHUNK_MAP      m_freeChunkOffsets;
 
     ///> Stored VERTEX_ITEMs
     ITEMS               m_items;
 
+    ///> Stored VERTEX_ITEMs, sorted by their offsets
+    ITEM_OFFSET_MAP     m_itemOffsets;
+
     ///> Currently modified item
     VERTEX_ITEM*        m_item;
 
@@ -94,6 +136,15 @@ protected:
     unsigned int        m_chunkOffset;
     unsigned int        m_itemSize;
 
+    ///> Memory manager statistics
+    ALLOCATOR_STATS     m_stats;
+
+    ///> Fragmentation level that starts the incremental compaction
+    static const double COMPACTION_THRESHOLD;
+
+    ///> Number of vertices that may be moved by a single compaction step
+    static const unsigned int COMPACTION_STEP;
+
     /**
      * Function reallocate()
      * resizes the chunk that stores the current item to the given size.
@@ -109,18 +160,21 @@ protected:
      * for storing vertices at the and of the container.
      *
      * @param aTarget is the already allocated destination for defragmented data. It has to be
-     * at least of the same size as the current container. If left NULL, it will be allocated
-     * inside the defragment() function.
+     * at least of the same size as the current container. If left NULL, the data is moved
+     * inside the current container.
      * @return false in case of failure (eg. memory shortage)
      */
     virtual bool defragment( VERTEX* aTarget = NULL );
 
     /**
-     * Function mergeFreeChunks()
-     * looks for consecutive free memory chunks and merges them, decreasing fragmentation of
-     * memory.
+     * Function compact()
+     * moves items placed at the end of the container to free chunks closer to its beginning,
+     * so the free space is merged into a continuous area. It is an incremental alternative
+     * to defragment(), as the amount of moved data is limited.
+     *
+     * @param aMaxVertices is the maximal number of vertices to be moved.
      */
-    virtual void mergeFreeChunks();
+    void compact( unsigned int aMaxVertices );
 
     /**
      * Function resizeContainer()
@@ -131,6 +185,27 @@ protected:
      */
     virtual bool resizeContainer( unsigned int aNewSize );
 
+    /**
+     * Function addFreeChunk()
+     * returns a memory chunk to the pool of free space. The chunk is merged with neighbouring
+     * free chunks.
+     *
+     * @param aOffset is the offset of the chunk.
+     * @param aSize is the size of the chunk.
+     */
+    void addFreeChunk( unsigned int aOffset, unsigned int aSize );
+
+    /**
+     * Function takeFreeChunk()
+     * removes a chunk from the pool of free space and returns the part that is not needed
+     * back to the pool.
+     *
+     * @param aChunk is the chunk to be used.
+     * @param aSize is the number of vertices that are going to be stored in the chunk.
+     * @return offset of the chunk.
+     */
+    unsigned int takeFreeChunk( FREE_CHUNK_SET::iterator aChunk, unsigned int aSize );
+
     /**
      * Function getPowerOf2()
      * returns the nearest power of 2, bigger than aNumber.
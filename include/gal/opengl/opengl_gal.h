@@ -115,6 +115,15 @@ public:
     /// @copydoc GAL::DrawPolygon()
     virtual void DrawPolygon( const std::deque<VECTOR2D>& aPointList );
 
+    /// @copydoc GAL::DrawTriangles()
+    virtual void DrawTriangles( const std::vector<VECTOR2D>& aTriangles );
+
+    /// @copydoc GAL::IsTriangulationPreferred()
+    virtual bool IsTriangulationPreferred() const
+    {
+        return true;
+    }
+
     /// @copydoc GAL::DrawCurve()
     virtual void DrawCurve( const VECTOR2D& startPoint, const VECTOR2D& controlPointA,
                             const VECTOR2D& controlPointB, const VECTOR2D& endPoint );
@@ -182,6 +191,18 @@ public:
     /// @copydoc GAL::ClearCache()
     virtual void ClearCache();
 
+    /// @copydoc GAL::IsGrouping()
+    virtual bool IsGrouping() const
+    {
+        return isGrouping;
+    }
+
+    /// @copydoc GAL::IsInstancingSupported()
+    virtual bool IsInstancingSupported() const
+    {
+        return true;
+    }
+
     // --------------------------------------------------------
     // Handling the world <-> screen transformation
     // --------------------------------------------------------
@@ -201,6 +222,18 @@ public:
     /// @copydoc GAL::ClearTarget()
     virtual void ClearTarget( RENDER_TARGET aTarget );
 
+    /// @copydoc GAL::IsClippingSupported()
+    virtual bool IsClippingSupported() const
+    {
+        return true;
+    }
+
+    /// @copydoc GAL::SetClipArea()
+    virtual void SetClipArea( const BOX2D& aArea );
+
+    /// @copydoc GAL::ResetClipArea()
+    virtual void ResetClipArea();
+
     // -------
     // Cursor
     // -------
@@ -281,6 +314,8 @@ private:
     bool                    isFramebufferInitialized;   ///< Are the framebuffers initialized?
     bool                    isShaderInitialized;        ///< Was the shader initialized?
     bool                    isGrouping;                 ///< Was a group started?
+    bool                    isClipping;                 ///< Is drawing limited to clipArea?
+    BOX2I                   clipArea;                   ///< Area of the screen that may be changed
 
     // Polygon tesselation
     /// The tessellator
@@ -350,6 +385,13 @@ private:
      */
     void blitCursor();
 
+    /**
+     * @brief Enables or disables limiting of rendering to the clip area.
+     *
+     * @param aEnable tells if the scissor test should be enabled.
+     */
+    void setScissor( bool aEnable );
+
     /**
      * @brief Returns a valid key that can be used as a new group number.
      *
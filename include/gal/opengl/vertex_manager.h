@@ -278,6 +278,29 @@ public:
         return m_transform;
     }
 
+    /**
+     * Function IsTransformed()
+     * tells if new vertices are going to be transformed, ie. if the current transformation
+     * matrix was set up with PushMatrix().
+     */
+    bool IsTransformed() const
+    {
+        return !m_noTransform;
+    }
+
+    /**
+     * Function PutItem()
+     * adds copies of vertices owned by an item of another manager to the currently set item,
+     * so a shape cached once may be drawn in many places. Coordinates are transformed by
+     * aTransform, colors and shader parameters are kept.
+     *
+     * @param aSource is the manager storing the item.
+     * @param aItem is the item to be copied.
+     * @param aTransform is the transformation applied to the copies.
+     */
+    void PutItem( const VERTEX_MANAGER& aSource, const VERTEX_ITEM& aItem,
+                  const glm::mat4& aTransform ) const;
+
     /**
      * Function SetShader()
      * sets a shader program that is going to be used during rendering.
@@ -30,6 +30,7 @@
 #define STROKE_FONT_H_
 
 #include <deque>
+#include <map>
 #include <utf8.h>
 
 #include <eda_text.h>
@@ -151,6 +152,45 @@ private:
     EDA_TEXT_VJUSTIFY_T m_verticalJustify;                        ///< Vertical justification
     bool                m_bold, m_italic, m_mirrored, m_overbar;  ///< Properties of text
 
+    /// Identifies a line of text laid out with given settings
+    struct LINE_KEY
+    {
+        std::string text;
+        VECTOR2D    glyphSize;
+        int         interline;
+        bool        italic;
+        bool        mirrored;
+
+        bool operator<( const LINE_KEY& aOther ) const;
+    };
+
+    /// Line of text converted to polylines, ready to be drawn
+    struct LINE_STROKES
+    {
+        GLYPH       strokes;        ///< Polylines of all glyphs and overbars
+        double      width;          ///< Width of the line of text
+    };
+
+    typedef std::map<LINE_KEY, LINE_STROKES> LINE_CACHE;
+
+    LINE_CACHE          m_lineCache;                              ///< Recently drawn lines of text
+
+    /**
+     * @brief Returns polylines for a single line of text using current settings. Results are
+     * cached, so texts that are redrawn every frame are converted only once.
+     *
+     * @param aText is the text to be converted.
+     */
+    LINE_STROKES& getLineStrokes( const UTF8& aText );
+
+    /**
+     * @brief Converts a single line of text to polylines using current settings.
+     *
+     * @param aText is the text to be converted.
+     * @param aLine is the result.
+     */
+    void layoutLine( const UTF8& aText, LINE_STROKES& aLine );
+
     /**
      * @brief Returns a single line height using current settings.
      *
@@ -172,8 +212,10 @@ private:
      * function.
      *
      * @param aText is the text to be drawn.
+     * @param aAsBox tells if the text is too small to be readable, so only its bounding box
+     *  should be drawn.
      */
-    void drawSingleLineText( const UTF8& aText );
+    void drawSingleLineText( const UTF8& aText, bool aAsBox );
 
     /**
      * @brief Compute the size of a given text.
@@ -206,6 +248,15 @@ private:
 
     ///> Scale factor for a glyph
     static const double HERSHEY_SCALE;
+
+    ///> Texts smaller than that (in pixels) are not drawn
+    static const double LOD_HIDE_SIZE;
+
+    ///> Texts smaller than that (in pixels) are drawn as boxes
+    static const double LOD_BOX_SIZE;
+
+    ///> Maximum number of lines stored in the cache
+    static const unsigned int LINE_CACHE_SIZE;
 };
 } // namespace KIGFX
 
@@ -30,6 +30,9 @@
 #include <assert.h>
 #include <stdlib.h>
 
+#include <algorithm>
+#include <vector>
+
 #define ASSERT assert    // RTree uses ASSERT( condition )
 #ifndef rMin
   #define rMin std::min
@@ -112,6 +115,19 @@ public:
                  const ELEMTYPE     a_max[NUMDIMS],
                  const DATATYPE&    a_dataId );
 
+    /// Insert many entries at once
+    /// The tree is rebuilt from scratch (including the entries already present) using the
+    /// Sort-Tile-Recursive packing algorithm. This is much faster than inserting the entries
+    /// one by one and produces fully packed nodes with little overlap.
+    /// \param a_min Min of bounding rects, NUMDIMS values per entry
+    /// \param a_max Max of bounding rects, NUMDIMS values per entry
+    /// \param a_dataIds Data of each entry
+    /// \param a_count Number of entries
+    void BulkInsert( const ELEMTYPE*    a_min,
+                     const ELEMTYPE*    a_max,
+                     const DATATYPE*    a_dataIds,
+                     int                a_count );
+
     /// Remove entry
     /// \param a_min Min of bounding rect
     /// \param a_max Max of bounding rect
@@ -512,6 +528,24 @@ protected:
         return true; // Continue searching
     }
 
+    /// Orders branches along one axis, by the center of their rectangle (for BulkInsert)
+    struct BranchCenterLess
+    {
+        BranchCenterLess( int a_axis ) : m_axis( a_axis ) {}
+
+        bool operator()( const Branch& a_a, const Branch& a_b ) const
+        {
+            return (ELEMTYPEREAL) a_a.m_rect.m_min[m_axis] + (ELEMTYPEREAL) a_a.m_rect.m_max[m_axis]
+                   < (ELEMTYPEREAL) a_b.m_rect.m_min[m_axis] + (ELEMTYPEREAL) a_b.m_rect.m_max[m_axis];
+        }
+
+        int m_axis;
+    };
+
+    void    CollectLeavesRec( Node* a_node, std::vector<Branch>& a_branches );
+    void    SortTileRec( std::vector<Branch>& a_branches, int a_begin, int a_end, int a_axis,
+                         std::vector<int>& a_groupEnds );
+
     void    RemoveAllRec( Node* a_node );
     void    Reset();
     void    CountRec( Node* a_node, int& a_count );
@@ -665,6 +699,123 @@ void RTREE_QUAL::Insert( const ELEMTYPE     a_min[NUMDIMS],
 }
 
 
+RTREE_TEMPLATE
+void RTREE_QUAL::BulkInsert( const ELEMTYPE*    a_min,
+                             const ELEMTYPE*    a_max,
+                             const DATATYPE*    a_dataIds,
+                             int                a_count )
+{
+    std::vector<Branch> branches;
+
+    CollectLeavesRec( m_root, branches );
+    branches.reserve( branches.size() + a_count );
+
+    for( int i = 0; i < a_count; ++i )
+    {
+        Branch branch;
+
+        for( int axis = 0; axis < NUMDIMS; ++axis )
+        {
+            ASSERT( a_min[i * NUMDIMS + axis] <= a_max[i * NUMDIMS + axis] );
+
+            branch.m_rect.m_min[axis] = a_min[i * NUMDIMS + axis];
+            branch.m_rect.m_max[axis] = a_max[i * NUMDIMS + axis];
+        }
+
+        branch.m_data = a_dataIds[i];
+        branches.push_back( branch );
+    }
+
+    Reset();
+
+    // Pack the branches level by level, from the leaves up, until they fit in the root
+    int level = 0;
+
+    while( (int) branches.size() > MAXNODES )
+    {
+        std::vector<int> groupEnds;
+        std::vector<Branch> parents;
+
+        SortTileRec( branches, 0, branches.size(), 0, groupEnds );
+        parents.reserve( groupEnds.size() );
+
+        int begin = 0;
+
+        for( unsigned i = 0; i < groupEnds.size(); ++i )
+        {
+            Node* node = AllocNode();
+            node->m_level = level;
+
+            for( int j = begin; j < groupEnds[i]; ++j )
+                node->m_branch[node->m_count++] = branches[j];
+
+            begin = groupEnds[i];
+
+            Branch parent;
+            parent.m_rect = NodeCover( node );
+            parent.m_child = node;
+            parents.push_back( parent );
+        }
+
+        branches.swap( parents );
+        level++;
+    }
+
+    m_root = AllocNode();
+    m_root->m_level = level;
+
+    for( unsigned i = 0; i < branches.size(); ++i )
+        m_root->m_branch[m_root->m_count++] = branches[i];
+}
+
+
+// Orders the branches of range [a_begin, a_end) so that consecutive runs form the nodes of
+// the next level (Sort-Tile-Recursive): sort along a_axis, cut in slabs holding a whole
+// number of nodes, then recurse in each slab on the next axis. The ends of the runs are
+// appended to a_groupEnds.
+RTREE_TEMPLATE
+void RTREE_QUAL::SortTileRec( std::vector<Branch>& a_branches, int a_begin, int a_end,
+                              int a_axis, std::vector<int>& a_groupEnds )
+{
+    int count = a_end - a_begin;
+    int nodeCount = ( count + MAXNODES - 1 ) / MAXNODES;
+
+    std::sort( a_branches.begin() + a_begin, a_branches.begin() + a_end,
+               BranchCenterLess( a_axis ) );
+
+    if( a_axis == NUMDIMS - 1 )
+    {
+        // Spread the branches evenly, so that no node falls below MINNODES
+        for( int i = 1; i <= nodeCount; ++i )
+            a_groupEnds.push_back( a_begin + (int) ( (long long) count * i / nodeCount ) );
+
+        return;
+    }
+
+    int slabCount = (int) ceil( pow( (double) nodeCount, 1.0 / ( NUMDIMS - a_axis ) ) );
+    int slabSize = ( ( nodeCount + slabCount - 1 ) / slabCount ) * MAXNODES;
+
+    for( int begin = a_begin; begin < a_end; begin += slabSize )
+        SortTileRec( a_branches, begin, rMin( begin + slabSize, a_end ), a_axis + 1, a_groupEnds );
+}
+
+
+RTREE_TEMPLATE
+void RTREE_QUAL::CollectLeavesRec( Node* a_node, std::vector<Branch>& a_branches )
+{
+    ASSERT( a_node );
+    ASSERT( a_node->m_level >= 0 );
+
+    for( int index = 0; index < a_node->m_count; ++index )
+    {
+        if( a_node->IsInternalNode() )
+            CollectLeavesRec( a_node->m_branch[index].m_child, a_branches );
+        else
+            a_branches.push_back( a_node->m_branch[index] );
+    }
+}
+
+
 RTREE_TEMPLATE
 void RTREE_QUAL::Remove( const ELEMTYPE     a_min[NUMDIMS],
                          const ELEMTYPE     a_max[NUMDIMS],
@@ -0,0 +1,131 @@
+/*
+ * This program source code file is part of KiCad, a free EDA CAD application.
+ *
+ * Copyright (C) 2014 KiCad Developers, see change_log.txt for contributors.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, you may find one here:
+ * http://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+ * or you may search the http://www.gnu.org website for the version 2 license,
+ * or you may write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+#ifndef __SEG_BATCH_H
+#define __SEG_BATCH_H
+
+#include <vector>
+
+#include <math/vector2d.h>
+#include <math/box2.h>
+#include <geometry/seg.h>
+
+class SHAPE_LINE_CHAIN;
+
+/**
+ * Class SEG_BATCH
+ *
+ * Stores a set of segments in structure-of-arrays form (separate coordinate and bounding
+ * box arrays) to test a single segment or circle against all of them in one call.
+ * The bounding box rejection runs over contiguous integer arrays in blocks, which the
+ * compiler turns into vector code; the surviving candidates go through the exact integer
+ * tests of SEG, so the results are identical to testing the segments one by one.
+ */
+class SEG_BATCH
+{
+public:
+    SEG_BATCH() {}
+
+    /**
+     * Constructor
+     * Creates a batch holding all the segments of a line chain, in order.
+     */
+    SEG_BATCH( const SHAPE_LINE_CHAIN& aChain );
+
+    void Clear();
+
+    void Reserve( int aCount );
+
+    /**
+     * Function Add()
+     *
+     * Appends a segment to the batch.
+     * @param aSeg the segment
+     */
+    void Add( const SEG& aSeg );
+
+    /**
+     * Function Add()
+     *
+     * Appends all the segments of a line chain, in order.
+     * @param aChain the line chain
+     */
+    void Add( const SHAPE_LINE_CHAIN& aChain );
+
+    int Size() const
+    {
+        return m_ax.size();
+    }
+
+    /**
+     * Function Segment()
+     *
+     * Returns a (locally referenced) copy of segment aIndex.
+     */
+    const SEG Segment( int aIndex ) const
+    {
+        return SEG( m_ax[aIndex], m_ay[aIndex], m_bx[aIndex], m_by[aIndex] );
+    }
+
+    /**
+     * Function Collide()
+     *
+     * Finds the first segment of the batch colliding with aSeg. The result is the same as
+     * SHAPE_LINE_CHAIN::Collide( aSeg, aClearance ): a bounding box test followed by
+     * SEG::Collide() for each segment.
+     * @param aSeg the segment to test
+     * @param aClearance minimum clearance
+     * @return index of the first colliding segment, or -1 if none collides.
+     */
+    int Collide( const SEG& aSeg, int aClearance ) const;
+
+    /**
+     * Function CollideCircle()
+     *
+     * Finds the first segment of the batch closer to aCenter than aRadius, with the same
+     * result as SHAPE_CIRCLE::Collide( SEG, aClearance ) (aRadius being the circle radius
+     * plus the clearance), i.e. SEG::Distance( aCenter ) <= aRadius.
+     * @return index of the first colliding segment, or -1 if none collides.
+     */
+    int CollideCircle( const VECTOR2I& aCenter, int aRadius ) const;
+
+private:
+    typedef VECTOR2I::extended_type ecoord;
+
+    ///> Number of segments examined at once by the bounding box rejection
+    static const int BlockSize = 64;
+
+    /**
+     * Function filterBox()
+     * Marks in aMask the segments of range [aStart, aStart + aCount) whose bounding box
+     * is closer to aBox than aDistSq (squared distance), as BOX2I::SquaredDistance() does.
+     * @return number of marked segments
+     */
+    int filterBox( int aStart, int aCount, const BOX2I& aBox, ecoord aDistSq,
+                   unsigned char* aMask ) const;
+
+    std::vector<int> m_ax, m_ay, m_bx, m_by;            ///> segment ends
+    std::vector<int> m_left, m_top, m_right, m_bottom;  ///> segment BOX2I( A, B - A )
+};
+
+#endif // __SEG_BATCH_H
@@ -344,8 +344,8 @@ void SHAPE_INDEX<T>::RemoveAll()
 template <class T>
 void SHAPE_INDEX<T>::Reindex()
 {
-    RTree<T, int, 2, float>* newTree;
-    newTree = new RTree<T, int, 2, float>();
+    std::vector<T> shapes;
+    std::vector<int> min, max;
 
     Iterator iter = this->Begin();
 
@@ -353,12 +353,22 @@ void SHAPE_INDEX<T>::Reindex()
     {
         T shape = *iter;
         BOX2I box = boundingBox( shape );
-        int min[2] = { box.GetX(), box.GetY() };
-        int max[2] = { box.GetRight(), box.GetBottom() };
-        newTree->Insert( min, max, shape );
+
+        shapes.push_back( shape );
+        min.push_back( box.GetX() );
+        min.push_back( box.GetY() );
+        max.push_back( box.GetRight() );
+        max.push_back( box.GetBottom() );
         iter++;
     }
 
+    // the whole contents is known at once: bulk load the new tree
+    RTree<T, int, 2, float>* newTree;
+    newTree = new RTree<T, int, 2, float>();
+
+    if( !shapes.empty() )
+        newTree->BulkInsert( &min[0], &max[0], &shapes[0], shapes.size() );
+
     delete this->m_tree;
     this->m_tree = newTree;
 }
@@ -42,6 +42,7 @@ namespace KIGFX
 {
 class GAL;
 class VIEW_ITEM;
+class VIEW_ITEM_JOB;
 
 /**
  * Class RENDER_SETTINGS
@@ -301,6 +302,19 @@ public:
      */
     virtual bool Draw( const VIEW_ITEM* aItem, int aLayer ) = 0;
 
+    /**
+     * Function CreateJob
+     * Returns a job that prepares data needed to draw an item (eg. a triangulation of filled
+     * areas) on a worker thread, so the item is not blocking the UI when it is recached.
+     * @param aItem is the item that is going to be recached.
+     * @return The job (the caller takes its ownership), or NULL if the item is drawn without
+     * any expensive preparation.
+     */
+    virtual VIEW_ITEM_JOB* CreateJob( const VIEW_ITEM* aItem )
+    {
+        return NULL;
+    }
+
 protected:
     /// Instance of graphic abstraction layer that gives an interface to call
     /// commands used to draw (eg. DrawLine, DrawCircle, etc.)
@@ -0,0 +1,195 @@
+/*
+ * This program source code file is part of KiCad, a free EDA CAD application.
+ *
+ * Copyright (C) 2014 KiCad Developers, see change_log.txt for contributors.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, you may find one here:
+ * http://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+ * or you may search the http://www.gnu.org website for the version 2 license,
+ * or you may write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+/**
+ * @file profile_trace.h
+ * @brief Always available, low overhead timers and counters for measuring performance.
+ *
+ * Tracing is disabled by default, then a scoped timer costs a single flag check.
+ * It is enabled by environment variables:
+ *  - KICAD_PROFILE_TRACE=<file> records events and saves them to a file in the Chrome trace
+ *    format (chrome://tracing) when the application exits,
+ *  - KICAD_PROFILE_OVERLAY=1 records events and shows their summary in GAL canvases.
+ */
+
+#ifndef __PROFILE_TRACE_H
+#define __PROFILE_TRACE_H
+
+#include <profile.h>
+#include <string>
+#include <vector>
+
+/**
+ * Structure PROF_TRACE_SUMMARY
+ * contains statistics of recorded events sharing the same name.
+ */
+struct PROF_TRACE_SUMMARY
+{
+    std::string name;
+    bool        counter;        ///< True for counters, false for timers
+    unsigned    count;          ///< Number of recorded events
+    int64_t     last;           ///< Last duration [us] or counter value
+    int64_t     max;            ///< Maximal duration [us] or counter value
+    int64_t     total;          ///< Sum of durations [us] or counter values
+};
+
+
+/**
+ * Class PROF_TRACE
+ * collects timing events and counter samples. Every thread records events into its own
+ * buffer, so there is no locking on the hot path. The buffers are fixed size rings, so only
+ * the most recent events are kept.
+ */
+class PROF_TRACE
+{
+public:
+    /**
+     * Function Instance
+     * returns the global trace collector.
+     */
+    static PROF_TRACE& Instance();
+
+    ~PROF_TRACE();
+
+    /**
+     * Function IsEnabled
+     * @return true if events are recorded.
+     */
+    inline bool IsEnabled() const
+    {
+        return m_enabled;
+    }
+
+    /**
+     * Function SetEnabled
+     * starts or stops recording events.
+     */
+    void SetEnabled( bool aEnabled )
+    {
+        m_enabled = aEnabled;
+    }
+
+    /**
+     * Function IsOverlayEnabled
+     * @return true if a summary of recorded events should be displayed in GAL canvases.
+     */
+    inline bool IsOverlayEnabled() const
+    {
+        return m_enabled && m_overlay;
+    }
+
+    /**
+     * Function AddEvent
+     * records a timed event.
+     *
+     * @param aName is the event name. It has to be a string literal, as only the pointer
+     * is stored.
+     * @param aStart is the event start time, as returned by get_tics().
+     * @param aEnd is the event end time, as returned by get_tics().
+     */
+    void AddEvent( const char* aName, uint64_t aStart, uint64_t aEnd );
+
+    /**
+     * Function AddCounter
+     * records a counter sample.
+     *
+     * @param aName is the counter name. It has to be a string literal, as only the pointer
+     * is stored.
+     * @param aValue is the current value of the counter.
+     */
+    void AddCounter( const char* aName, int64_t aValue );
+
+    /**
+     * Function GetSummary
+     * computes statistics of the recorded events, grouped by their names.
+     */
+    void GetSummary( std::vector<PROF_TRACE_SUMMARY>& aSummary ) const;
+
+    /**
+     * Function ExportChromeTrace
+     * saves the recorded events in the Chrome trace event format.
+     *
+     * @param aFileName is the output file name.
+     * @return true on success.
+     */
+    bool ExportChromeTrace( const std::string& aFileName ) const;
+
+    /**
+     * Function Clear
+     * removes all the recorded events. It should not be called while other threads record
+     * events.
+     */
+    void Clear();
+
+private:
+    PROF_TRACE();
+
+    ///> Tells if the events are recorded
+    volatile bool m_enabled;
+
+    ///> Tells if the summary is displayed in GAL canvases
+    bool m_overlay;
+
+    ///> File where the trace is saved at exit, empty if it is not saved
+    std::string m_traceFile;
+};
+
+
+/**
+ * Class PROF_SCOPED_TIMER
+ * records a timed event covering the lifetime of the object.
+ */
+class PROF_SCOPED_TIMER
+{
+public:
+    PROF_SCOPED_TIMER( const char* aName ) :
+        m_name( aName ), m_start( PROF_TRACE::Instance().IsEnabled() ? get_tics() : 0 )
+    {
+    }
+
+    ~PROF_SCOPED_TIMER()
+    {
+        if( m_start )
+            PROF_TRACE::Instance().AddEvent( m_name, m_start, get_tics() );
+    }
+
+private:
+    const char* m_name;
+    uint64_t    m_start;
+};
+
+
+#define PROF_CONCAT_( a, b )  a##b
+#define PROF_CONCAT( a, b )   PROF_CONCAT_( a, b )
+
+/// Measures time spent in the current scope
+#define PROF_SCOPE( aName ) PROF_SCOPED_TIMER PROF_CONCAT( profScope, __LINE__ )( aName )
+
+/// Records a counter sample
+#define PROF_COUNTER( aName, aValue ) \
+    do { \
+        if( PROF_TRACE::Instance().IsEnabled() ) \
+            PROF_TRACE::Instance().AddCounter( aName, aValue ); \
+    } while( 0 )
+
+#endif /* __PROFILE_TRACE_H */
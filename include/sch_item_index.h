@@ -0,0 +1,108 @@
+/*
+ * This program source code file is part of KiCad, a free EDA CAD application.
+ *
+ * Copyright (C) 2014 KiCad Developers, see change_log.txt for contributors.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, you may find one here:
+ * http://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+ * or you may search the http://www.gnu.org website for the version 2 license,
+ * or you may write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+/**
+ * @file sch_item_index.h
+ * @brief Spatial index of the draw items of a schematic screen.
+ */
+
+#ifndef SCH_ITEM_INDEX_H
+#define SCH_ITEM_INDEX_H
+
+#include <vector>
+#include <boost/unordered_map.hpp>
+
+#include <class_eda_rect.h>
+#include <geometry/rtree.h>
+
+class SCH_ITEM;
+
+
+/**
+ * Class SCH_ITEM_INDEX
+ * is an R-tree of the draw items of a SCH_SCREEN.  Every item is stored with a box covering
+ * its bounding box, its connection points and, for sheets, their pins, so a query returns
+ * every item which can be hit or connected in the queried area.  Items are returned in the
+ * order of the draw list, so the first item found by a query is the first one a walk of the
+ * list would find.
+ * Non-owning.
+ */
+class SCH_ITEM_INDEX
+{
+public:
+    SCH_ITEM_INDEX();
+
+    /**
+     * Function Build
+     * replaces the content of the index by the draw list starting at \a aFirstItem.
+     */
+    void Build( SCH_ITEM* aFirstItem );
+
+    /**
+     * Function Clear
+     * removes all the items from the index.
+     */
+    void Clear();
+
+    /**
+     * Function Insert
+     * adds \a aItem after all the indexed items, like DLIST::Append() does in the draw list.
+     */
+    void Insert( SCH_ITEM* aItem );
+
+    /**
+     * Function Remove
+     * removes \a aItem from the index, using the box it was inserted with.
+     */
+    void Remove( SCH_ITEM* aItem );
+
+    /**
+     * Function Query
+     * finds the items whose box intersects \a aArea.
+     * @param aArea is the area to search.
+     * @param aItems is filled with the items found, in draw list order.
+     */
+    void Query( const EDA_RECT& aArea, std::vector<SCH_ITEM*>& aItems );
+
+private:
+    typedef RTree<SCH_ITEM*, int, 2, float> SCH_ITEM_RTREE;
+
+    /// What is needed to find and sort an indexed item
+    struct ENTRY
+    {
+        int         m_Min[2];
+        int         m_Max[2];
+        unsigned    m_Order;        ///< Position of the item in the draw list
+    };
+
+    typedef boost::unordered_map<SCH_ITEM*, ENTRY> ENTRIES;
+
+    /// Computes the indexed box of \a aItem and its next order number
+    ENTRY makeEntry( SCH_ITEM* aItem );
+
+    SCH_ITEM_RTREE  m_tree;
+    ENTRIES         m_entries;
+    unsigned        m_nextOrder;
+};
+
+#endif  // SCH_ITEM_INDEX_H
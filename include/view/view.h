@@ -27,19 +27,39 @@
 
 #include <vector>
 #include <set>
+#include <map>
 #include <boost/unordered/unordered_map.hpp>
 
 #include <math/box2.h>
 #include <gal/definitions.h>
+#include <gal/color4d.h>
 
 namespace KIGFX
 {
 class PAINTER;
 class GAL;
 class VIEW_ITEM;
+class VIEW_ITEM_JOB;
 class VIEW_GROUP;
 class VIEW_RTREE;
 
+/**
+ * Structure VIEW_INSTANCE
+ * describes an item that is drawn as a translated and rotated copy of a shape shared with
+ * other items (e.g. vias of the same size or pads with the same pad stack).
+ */
+struct VIEW_INSTANCE
+{
+    ///> Number of values that describe a shape
+    static const int SHAPE_PARAMS = 12;
+
+    int         shape[SHAPE_PARAMS];    ///< Values describing the shape, unused ones set to 0
+    VECTOR2D    offset;                 ///< Position of the item
+    double      angle;                  ///< Rotation of the item (in radians)
+    double      size;                   ///< Approximate size of the item (for level of detail)
+};
+
+
 /**
  * Class VIEW.
  * Holds a (potentially large) number of VIEW_ITEMs and renders them on a graphics device
@@ -91,9 +111,12 @@ public:
      * @param aResult result of the search, containing VIEW_ITEMs associated with their layers.
      *  Sorted according to the rendering order (items that are on top of the rendering stack as
      *  first).
+     * @param aVisibleOnly tells if hidden items (e.g. selected items, which are drawn by the
+     *  selection group instead) are skipped.
      * @return Number of found items.
      */
-    int Query( const BOX2I& aRect, std::vector<LAYER_ITEM_PAIR>& aResult ) const;
+    int Query( const BOX2I& aRect, std::vector<LAYER_ITEM_PAIR>& aResult,
+               bool aVisibleOnly = true ) const;
 
     /**
      * Function SetRequired()
@@ -112,11 +135,13 @@ public:
      */
     void CopySettings( const VIEW* aOtherView );
 
-    /*
-     *  Convenience wrappers for adding multiple items
-     *  template <class T> void AddItems( const T& aItems );
-     *  template <class T> void RemoveItems( const T& aItems );
+    /**
+     * Function AddItems()
+     * Adds many VIEW_ITEMs to the view at once. The spatial index of each layer is bulk
+     * loaded, which is much faster than calling Add() for each item.
+     * @param aItems: items to be added. No ownership is given
      */
+    void AddItems( const std::vector<VIEW_ITEM*>& aItems );
 
     /**
      * Function SetGAL()
@@ -419,7 +444,8 @@ public:
      * Function RecacheAllItems()
      * Rebuilds GAL display lists.
      * @param aForceNow decides if every item should be instantly recached. Otherwise items are
-     * going to be recached when they become visible.
+     * recached in batches by UpdateItems() during the following frames, and their current
+     * display lists are used until then.
      */
     void RecacheAllItems( bool aForceNow = false );
 
@@ -472,6 +498,7 @@ public:
         wxASSERT( aTarget < TARGETS_NUMBER );
 
         m_dirtyTargets[aTarget] = true;
+        m_redrawAll = true;
     }
 
     /// Returns true if the layer is cached
@@ -488,6 +515,8 @@ public:
     {
         for( int i = 0; i < TARGETS_NUMBER; ++i )
             m_dirtyTargets[i] = true;
+
+        m_redrawAll = true;
     }
 
     /**
@@ -502,10 +531,22 @@ public:
 
     /**
      * Function UpdateItems()
-     * Iterates through the list of items that asked for updating and updates them.
+     * Iterates through the list of items that asked for updating and updates them. Then
+     * recaches the items prepared by worker threads and a part of items queued by
+     * RecacheAllItems().
      */
     void UpdateItems();
 
+    /**
+     * Function HasPendingUpdates()
+     * Returns true if there are items waiting to be recached, so another frame should be
+     * rendered to show them up to date.
+     */
+    bool HasPendingUpdates() const
+    {
+        return !m_recacheQueue.empty() || m_runningJobs > 0;
+    }
+
     const BOX2I CalculateExtents() ;
 
     static const int VIEW_MAX_LAYERS = 256;      ///< maximum number of layers that may be shown
@@ -531,6 +572,7 @@ private:
     // Function objects that need to access VIEW/VIEW_ITEM private/protected members
     struct clearLayerCache;
     struct recacheItem;
+    struct queueRecache;
     struct drawItem;
     struct unlinkItem;
     struct updateItemsColor;
@@ -548,6 +590,18 @@ private:
         m_dirtyTargets[aTarget] = false;
     }
 
+    /**
+     * Function markTargetDirty()
+     * Sets target 'dirty' flag, but only a part of the target has to be redrawn (unless the
+     * whole target was marked dirty before).
+     * @param aTarget is the target to set.
+     * @param aArea is the area that has changed (in world coordinates).
+     */
+    void markTargetDirty( int aTarget, const BOX2I& aArea );
+
+    /// Returns true if only the dirty area has to be redrawn in the next frame
+    bool isPartialRedraw() const;
+
     /**
      * Function draw()
      * Draws an item, but on a specified layers. It has to be marked that some of drawing settings
@@ -607,6 +661,63 @@ private:
     /// Updates set of layers that an item occupies
     void updateLayers( VIEW_ITEM* aItem );
 
+    /// Checks if an item is drawn as an instance of a shared shape on a given layer
+    bool isInstanced( const VIEW_ITEM* aItem, int aLayer ) const;
+
+    /**
+     * Function drawInstance()
+     * Draws an item using the cached shape shared with other instances. The shape is cached
+     * when it is used for the first time and the item holds a reference to it until its
+     * cached geometry is invalidated.
+     * @param aItem is the item to be drawn.
+     * @param aLayer is the layer which should be drawn.
+     * @param aInstance describes the shape and placement of the item.
+     */
+    void drawInstance( VIEW_ITEM* aItem, int aLayer, const VIEW_INSTANCE& aInstance );
+
+    /**
+     * Function drawDot()
+     * Draws an item that is too small to be distinguished as a dot in the item color
+     * (level of details).
+     * @param aItem is the item to be drawn.
+     * @param aLayer is the layer which should be drawn.
+     * @param aInstance describes the placement of the item.
+     */
+    void drawDot( VIEW_ITEM* aItem, int aLayer, const VIEW_INSTANCE& aInstance );
+
+    /**
+     * Function releaseGroup()
+     * Frees the cached geometry of an item on a given layer: either the group owned by the item
+     * or its reference to a shape shared with other instances.
+     */
+    void releaseGroup( VIEW_ITEM* aItem, int aLayer );
+
+    /// Forgets shapes cached for instanced items, used when the GAL cache is gone
+    void clearInstanceCache();
+
+    /// Removes dots drawn for small items, so they are recreated with the current colors
+    void clearDotCache();
+
+    /// Recaches queued items, until the time limit is reached
+    void processRecacheQueue();
+
+    /// Removes all items from the recaching queue
+    void clearRecacheQueue();
+
+    /**
+     * Function submitJob()
+     * Starts preparing an item on a worker thread, if its PAINTER has a job for it. The item
+     * keeps its current display lists until the job is finished.
+     * @return true if the item is recached later, false if it has to be recached now.
+     */
+    bool submitJob( VIEW_ITEM* aItem );
+
+    /// Recaches items whose jobs are finished
+    void processFinishedJobs();
+
+    /// Discards the result of the job preparing an item, if there is one
+    void cancelJob( VIEW_ITEM* aItem );
+
     /// Determines rendering order of layers. Used in display order sorting function.
     static bool compareRenderingOrder( VIEW_LAYER* aI, VIEW_LAYER* aJ )
     {
@@ -647,11 +758,64 @@ private:
     /// Flags to mark targets as dirty, so they have to be redrawn on the next refresh event
     bool m_dirtyTargets[TARGETS_NUMBER];
 
+    /// Flag telling that the whole screen has to be redrawn, not only m_dirtyArea
+    bool m_redrawAll;
+
+    /// Area covering items that have changed since the last redraw (in world coordinates)
+    BOX2I m_dirtyArea;
+
     /// Rendering order modifier for layers that are marked as top layers
     static const int TOP_LAYER_MODIFIER = -VIEW_MAX_LAYERS;
 
     /// Items to be updated
     std::vector<VIEW_ITEM*> m_needsUpdate;
+
+    /// Items waiting to be recached, their current display lists are shown until then.
+    /// Each item stores its position (VIEW_ITEM::m_recacheIndex), so it is removed in O(1).
+    std::vector<VIEW_ITEM*> m_recacheQueue;
+
+    /// Time (in milliseconds) that UpdateItems() may spend on recaching queued items
+    static const int RECACHE_TIME_LIMIT;
+
+    /// Worker thread running VIEW_ITEM_JOBs, started when the first job is submitted
+    struct JOB_QUEUE;
+    JOB_QUEUE* m_jobQueue;
+
+    /// Number of submitted jobs that have not been processed by processFinishedJobs() yet
+    int m_runningJobs;
+
+    /// Identifies a shape shared by instanced items
+    struct INSTANCE_KEY
+    {
+        int     layer;
+        COLOR4D color;
+        int     shape[VIEW_INSTANCE::SHAPE_PARAMS];
+
+        bool operator<( const INSTANCE_KEY& aOther ) const;
+    };
+
+    /// Shape shared by instanced items
+    struct INSTANCE_GROUP
+    {
+        INSTANCE_KEY key;
+        int group;          ///< GAL group storing the shape
+        int users;          ///< Number of items referencing the shape
+    };
+
+    /// Shared shapes, items reference them by storing ( -2 - index ) as their group number
+    std::vector<INSTANCE_GROUP> m_instances;
+
+    /// Indices of unused entries in m_instances
+    std::vector<int> m_freeInstances;
+
+    /// Maps shapes to their indices in m_instances
+    std::map<INSTANCE_KEY, int> m_instanceIndex;
+
+    /// GAL groups storing dots drawn for small items (the shape of a key is not used)
+    std::map<INSTANCE_KEY, int> m_dotGroups;
+
+    /// Items describing their instance and smaller than that (in pixels) are drawn as dots
+    static const double INSTANCE_LOD_SIZE;
 };
 } // namespace KIGFX
 
@@ -42,6 +42,42 @@ namespace KIGFX
 // Forward declarations
 class GAL;
 class PAINTER;
+class VIEW_ITEM;
+
+/**
+ * Class VIEW_ITEM_JOB
+ * computes data needed to draw an item (e.g. a triangulation) on a worker thread of the VIEW,
+ * while the item is still displayed with its current display lists. A job works on its own
+ * copy of the item data, it never accesses the item until it is finished.
+ * Jobs are created by PAINTER::CreateJob().
+ */
+class VIEW_ITEM_JOB
+{
+public:
+    VIEW_ITEM_JOB() : m_item( NULL ) {}
+
+    virtual ~VIEW_ITEM_JOB() {}
+
+    /**
+     * Function Run()
+     * Does the computations. Called on a worker thread.
+     */
+    virtual void Run() = 0;
+
+    /**
+     * Function Finish()
+     * Stores the results in the item, before it is recached. Called on the UI thread, only if
+     * the item still belongs to the VIEW and has not been changed since the job was created.
+     * @param aItem is the item the job was created for.
+     */
+    virtual void Finish( VIEW_ITEM* aItem ) = 0;
+
+private:
+    friend class VIEW;
+
+    ///> Item waiting for the results, NULL if they are not needed anymore (UI thread only)
+    VIEW_ITEM* m_item;
+};
 
 /**
  * Class VIEW_ITEM -
@@ -77,7 +113,7 @@ public:
     };
 
     VIEW_ITEM() : m_view( NULL ), m_visible( true ), m_requiredUpdate( ALL ),
-                  m_groups( NULL ), m_groupsSize( 0 ) {}
+                  m_recacheIndex( -1 ), m_job( NULL ), m_groups( NULL ), m_groupsSize( 0 ) {}
 
     /**
      * Destructor. For dynamic views, removes the item from the view.
@@ -153,6 +189,21 @@ public:
         return 0;
     }
 
+    /**
+     * Function ViewGetInstance()
+     * Items that look exactly the same on a given layer, except for their position and
+     * rotation, may share cached geometry. Such items fill aInstance with values describing
+     * their shape (equal values mean equal shapes) and their placement.
+     * @param aLayer: current drawing layer
+     * @param aInstance: shape and placement of the item
+     * @return true if the item may be drawn as an instance of a shared shape.
+     */
+    virtual bool ViewGetInstance( int aLayer, VIEW_INSTANCE& aInstance ) const
+    {
+        // By default items have their own geometry
+        return false;
+    }
+
     /**
      * Function ViewUpdate()
      * For dynamic VIEWs, informs the associated VIEW that the graphical representation of
@@ -203,6 +254,9 @@ protected:
     VIEW*   m_view;             ///< Current dynamic view the item is assigned to.
     bool    m_visible;          ///< Are we visible in the current dynamic VIEW.
     int     m_requiredUpdate;   ///< Flag required for updating
+    int     m_recacheIndex;     ///< Position in the VIEW recaching queue, -1 if not queued
+    VIEW_ITEM_JOB* m_job;       ///< Job preparing the item to be recached, NULL if none
+    BOX2I   m_viewBBox;         ///< Bounding box of the item, as indexed by the dynamic VIEW
 
     ///* Helper for storing cached items group ids
     typedef std::pair<int, int> GroupPair;
@@ -25,6 +25,8 @@
 #ifndef __VIEW_RTREE_H
 #define __VIEW_RTREE_H
 
+#include <vector>
+
 #include <math/box2.h>
 
 #include <geometry/rtree.h>
@@ -55,6 +57,29 @@ public:
         VIEW_RTREE_BASE::Insert( mmin, mmax, aItem );
     }
 
+    /**
+     * Function Insert()
+     * Inserts many items at once. The tree is rebuilt by bulk loading, which is faster than
+     * inserting items one by one and gives a better balanced tree.
+     */
+    void Insert( const std::vector<VIEW_ITEM*>& aItems )
+    {
+        std::vector<int> mmin( 2 * aItems.size() ), mmax( 2 * aItems.size() );
+
+        for( unsigned i = 0; i < aItems.size(); ++i )
+        {
+            const BOX2I& bbox = aItems[i]->ViewBBox();
+
+            mmin[2 * i]     = bbox.GetX();
+            mmin[2 * i + 1] = bbox.GetY();
+            mmax[2 * i]     = bbox.GetRight();
+            mmax[2 * i + 1] = bbox.GetBottom();
+        }
+
+        if( !aItems.empty() )
+            VIEW_RTREE_BASE::BulkInsert( &mmin[0], &mmax[0], &aItems[0], aItems.size() );
+    }
+
     /**
      * Function Remove()
      * Removes an item from the tree. Removal is done by comparing pointers, attepmting to remove a copy
@@ -1557,7 +1557,17 @@ public:
     void AutoPlaceModule( MODULE* Module, int place_mode, wxDC* DC );
 
     // Autorouting:
-    int Solve( wxDC* DC, int two_sides );
+
+    /**
+     * Function Solve
+     * routes the work list on the routing matrix with an AR_SOLVER (see autorout.h),
+     * showing the progress on the canvas and in the message panel.
+     * @param DC = the device context used to show the routing progress
+     * @param aLayersCount = the number of routing layers (1 or 2)
+     * @return SUCCESS (1) when done, STOP_FROM_ESC (-1) if aborted by the user or
+     *  ERR_MEMORY (-2) if the search memory could not be allocated
+     */
+    int Solve( wxDC* DC, int aLayersCount );
     void Reset_Noroutable( wxDC* DC );
     void Autoroute( wxDC* DC, int mode );
     void ReadAutoroutedTracks( wxDC* DC );
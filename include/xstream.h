@@ -0,0 +1,185 @@
+#ifndef XSTREAM_H_
+#define XSTREAM_H_
+
+/*
+ * This program source code file is part of KiCad, a free EDA CAD application.
+ *
+ * Copyright (C) 2014 KiCad Developers, see change_log.txt for contributors.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, you may find one here:
+ * http://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+ * or you may search the http://www.gnu.org website for the version 2 license,
+ * or you may write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+#include <richio.h>
+#include <vector>
+
+
+/**
+ * Class XSTREAM
+ * writes a document tree in EITHER XML or S-expression, one element at a time,
+ * straight to an OUTPUTFORMATTER.  It is the streaming counterpart of XNODE:
+ * nothing is kept in memory except the chain of currently open elements, and the
+ * output is byte for byte what XNODE::Format() or wxXmlDocument::Save() would
+ * produce for the equivalent tree.
+ * <p>
+ * Within an element, all the attributes have to be added before any child
+ * element or text.
+ */
+class XSTREAM
+{
+public:
+    XSTREAM( OUTPUTFORMATTER* aOutput ) :
+        m_out( aOutput )
+    {
+    }
+
+    virtual ~XSTREAM() {}
+
+    /**
+     * Function StartElement
+     * opens a new element, as a child of the currently open one (if any).
+     */
+    virtual void StartElement( const wxString& aName ) throw( IO_ERROR ) = 0;
+
+    /**
+     * Function AddAttribute
+     * adds an attribute to the element just opened.
+     */
+    virtual void AddAttribute( const wxString& aName, const wxString& aValue )
+        throw( IO_ERROR ) = 0;
+
+    /**
+     * Function AddText
+     * adds a textual child to the currently open element.  An empty \a aContent is
+     * ignored, just like the node() helpers building XNODE trees do.
+     */
+    virtual void AddText( const wxString& aContent ) throw( IO_ERROR ) = 0;
+
+    /**
+     * Function EndElement
+     * closes the currently open element.
+     */
+    virtual void EndElement() throw( IO_ERROR ) = 0;
+
+    /**
+     * Function AddElement
+     * is a convenience function writing a complete element holding an optional text.
+     */
+    void AddElement( const wxString& aName, const wxString& aTextualContent = wxEmptyString )
+        throw( IO_ERROR )
+    {
+        StartElement( aName );
+        AddText( aTextualContent );
+        EndElement();
+    }
+
+protected:
+    /// State of an element which is not closed yet
+    struct OPEN_ELEMENT
+    {
+        wxString    m_Name;
+        bool        m_HasChildren;          ///< true if a child element or text was written
+        bool        m_LastChildIsElement;   ///< true if the last child is not a text
+    };
+
+    /**
+     * Function pushElement
+     * records a new open element named \a aName.
+     */
+    void pushElement( const wxString& aName )
+    {
+        OPEN_ELEMENT element;
+
+        element.m_Name = aName;
+        element.m_HasChildren = false;
+        element.m_LastChildIsElement = false;
+
+        m_stack.push_back( element );
+    }
+
+    /// @return the innermost open element or NULL if there is none.
+    OPEN_ELEMENT* current()
+    {
+        return m_stack.empty() ? NULL : &m_stack.back();
+    }
+
+    OUTPUTFORMATTER*            m_out;
+    std::vector<OPEN_ELEMENT>   m_stack;    ///< open elements, the root one first
+};
+
+
+/**
+ * Class XSTREAM_SEXPR
+ * writes the S-expression form, with the layout of XNODE::Format().
+ */
+class XSTREAM_SEXPR : public XSTREAM
+{
+public:
+    XSTREAM_SEXPR( OUTPUTFORMATTER* aOutput ) :
+        XSTREAM( aOutput )
+    {
+    }
+
+    void StartElement( const wxString& aName ) throw( IO_ERROR );
+    void AddAttribute( const wxString& aName, const wxString& aValue ) throw( IO_ERROR );
+    void AddText( const wxString& aContent ) throw( IO_ERROR );
+    void EndElement() throw( IO_ERROR );
+};
+
+
+/**
+ * Class XSTREAM_XML
+ * writes the XML form, with the UTF-8 declaration, escaping and indentation of
+ * wxXmlDocument::Save().
+ */
+class XSTREAM_XML : public XSTREAM
+{
+public:
+    /**
+     * Constructor
+     * @param aOutput is the formatter to write to.
+     * @param aIndentStep is the number of spaces per nesting level, as in
+     *  wxXmlDocument::Save().
+     */
+    XSTREAM_XML( OUTPUTFORMATTER* aOutput, int aIndentStep = 2 ) :
+        XSTREAM( aOutput ),
+        m_indentStep( aIndentStep ),
+        m_tagOpen( false )
+    {
+    }
+
+    void StartElement( const wxString& aName ) throw( IO_ERROR );
+    void AddAttribute( const wxString& aName, const wxString& aValue ) throw( IO_ERROR );
+    void AddText( const wxString& aContent ) throw( IO_ERROR );
+    void EndElement() throw( IO_ERROR );
+
+private:
+    /// Terminates the start tag of the current element, if still open
+    void closeStartTag() throw( IO_ERROR );
+
+    /// Writes a new line indented by aIndent spaces
+    void indent( int aIndent ) throw( IO_ERROR );
+
+    /// Writes aText with the XML special characters replaced by entities
+    void writeEscaped( const wxString& aText, bool aIsAttribute ) throw( IO_ERROR );
+
+    int         m_indentStep;
+    bool        m_tagOpen;      ///< true if '>' is still to be written for the current element
+    wxString    m_escaped;      ///< reused for escaping
+};
+
+#endif  // XSTREAM_H_
@@ -483,10 +483,6 @@ int genPlacementRoutingMatrix( BOARD* aBrd, EDA_MSG_PANEL* messagePanel )
 
     RoutingMatrix.InitRoutingMatrix();
 
-    // Display memory usage.
-    msg.Printf( wxT( "%d" ), RoutingMatrix.m_MemSize / 1024 );
-    messagePanel->SetMessage( 24, wxT( "Mem(Kb)" ), msg, CYAN );
-
     g_Route_Layer_BOTTOM = F_Cu;
 
     if( RoutingMatrix.m_RoutingLayersCount > 1 )
@@ -536,9 +532,12 @@ int genPlacementRoutingMatrix( BOARD* aBrd, EDA_MSG_PANEL* messagePanel )
         ii = propagate();
 
     // Initialize top layer. to the same value as the bottom layer
-    if( RoutingMatrix.m_BoardSide[TOP] )
-        memcpy( RoutingMatrix.m_BoardSide[TOP], RoutingMatrix.m_BoardSide[BOTTOM],
-                nbCells * sizeof(MATRIX_CELL) );
+    if( RoutingMatrix.m_RoutingLayersCount > 1 )
+        RoutingMatrix.CopyCells( BOTTOM, TOP );
+
+    // Display memory usage (tiles are allocated when cells are written).
+    msg.Printf( wxT( "%d" ), RoutingMatrix.m_MemSize / 1024 );
+    messagePanel->SetMessage( 24, wxT( "Mem(Kb)" ), msg, CYAN );
 
     return 1;
 }
@@ -32,6 +32,7 @@
 
 #include <fctsys.h>
 #include <class_drawpanel.h>
+#include <confirm.h>
 #include <wxPcbStruct.h>
 #include <gr_basic.h>
 #include <msgpanel.h>
@@ -45,6 +46,7 @@
 #include <class_track.h>
 #include <convert_to_biu.h>
 
+#include <protos.h>
 #include <autorout.h>
 
 
@@ -193,7 +195,6 @@ void PCB_EDIT_FRAME::Autoroute( wxDC* DC, int mode )
     Solve( DC, RoutingMatrix.m_RoutingLayersCount );
 
     /* Free memory. */
-    FreeQueue();
     InitWork();             /* Free memory for the list of router connections. */
     RoutingMatrix.UnInitRoutingMatrix();
     stop = time( NULL ) - start;
@@ -202,6 +203,145 @@ void PCB_EDIT_FRAME::Autoroute( wxDC* DC, int mode )
 }
 
 
+/**
+ * Class FRAME_SOLVER
+ * routes the work list from the board editor: it shows the progress in the message panel
+ * and on the canvas, asks to abort when the user requested it and keeps the new tracks
+ * for the undo command.
+ */
+class FRAME_SOLVER : public AR_SOLVER
+{
+public:
+    FRAME_SOLVER( PCB_EDIT_FRAME* aFrame, wxDC* aDC ) :
+        AR_SOLVER( aFrame->GetBoard() ),
+        m_frame( aFrame ),
+        m_dc( aDC ),
+        m_itemCount( 0 )
+    {
+    }
+
+    PICKED_ITEMS_LIST   m_ItemsListPicker;      // the new tracks
+
+protected:
+    bool onStartItem( RATSNEST_ITEM* aItem, const wxPoint& aStart, const wxPoint& aEnd )
+    {
+        EDA_DRAW_PANEL* canvas = m_frame->GetCanvas();
+        wxString        msg;
+
+        // Test to stop routing ( escape key pressed )
+        wxYield();
+
+        if( canvas->GetAbortRequest() )
+        {
+            if( IsOK( m_frame, _( "Abort routing?" ) ) )
+                return false;
+
+            canvas->SetAbortRequest( false );
+        }
+
+        m_frame->EraseMsgBox();
+
+        m_itemCount++;
+        NETINFO_ITEM* net = m_board->FindNet( aItem->GetNet() );
+
+        if( net )
+        {
+            msg.Printf( wxT( "[%8.8s]" ), GetChars( net->GetNetname() ) );
+            m_frame->AppendMsgPanel( wxT( "Net route" ), msg, BROWN );
+            msg.Printf( wxT( "%d / %d" ), m_itemCount, RoutingMatrix.m_RouteCount );
+            m_frame->AppendMsgPanel( wxT( "Activity" ), msg, BROWN );
+        }
+
+        // Draw segment.
+        m_start = aStart;
+        m_end   = aEnd;
+        GRLine( canvas->GetClipBox(), m_dc, m_start.x, m_start.y, m_end.x, m_end.y, 0, WHITE );
+        aItem->m_PadStart->Draw( canvas, m_dc, GR_OR | GR_HIGHLIGHT );
+        aItem->m_PadEnd->Draw( canvas, m_dc, GR_OR | GR_HIGHLIGHT );
+
+        return true;
+    }
+
+    void onItemDone( RATSNEST_ITEM* aItem, int aResult, TRACK* aFirstTrack, int aTrackCount )
+    {
+        EDA_DRAW_PANEL* canvas = m_frame->GetCanvas();
+        wxString        msg;
+
+        if( aResult == SUCCESS )
+        {
+            // Remove link.
+            GRSetDrawMode( m_dc, GR_XOR );
+            GRLine( canvas->GetClipBox(), m_dc, m_start.x, m_start.y, m_end.x, m_end.y,
+                    0, WHITE );
+        }
+
+        if( aFirstTrack )
+        {
+            TRACK* track = aFirstTrack;
+
+            for( int ii = 0; ii < aTrackCount; ii++, track = track->Next() )
+            {
+                ITEM_PICKER picker( track, UR_NEW );
+                m_ItemsListPicker.PushItem( picker );
+            }
+
+            DrawTraces( canvas, m_dc, aFirstTrack, aTrackCount, GR_OR );
+            m_frame->TestNetConnection( m_dc, aItem->GetNet() );
+            m_frame->GetScreen()->SetModify();
+        }
+
+        msg.Printf( wxT( "%d" ), m_RoutedCount );
+        m_frame->AppendMsgPanel( wxT( "OK" ), msg, GREEN );
+        msg.Printf( wxT( "%d" ), m_FailedCount );
+        m_frame->AppendMsgPanel( wxT( "Fail" ), msg, RED );
+        msg.Printf( wxT( "  %d" ), m_board->GetUnconnectedNetCount() );
+        m_frame->AppendMsgPanel( wxT( "Not Connected" ), msg, CYAN );
+
+        // Delete routing from display.
+        aItem->m_PadStart->Draw( canvas, m_dc, GR_AND );
+        aItem->m_PadEnd->Draw( canvas, m_dc, GR_AND );
+
+        msg.Printf( wxT( "Activity: Open %d   Closed %d   Moved %d"),
+                    m_OpenNodes, m_ClosNodes, m_MoveNodes );
+        m_frame->SetStatusText( msg );
+    }
+
+    void onError( const wxString& aMessage )
+    {
+        wxMessageBox( aMessage );
+    }
+
+private:
+    PCB_EDIT_FRAME* m_frame;
+    wxDC*           m_dc;
+    int             m_itemCount;        // items started
+    wxPoint         m_start, m_end;     // ratsnest line of the current item
+};
+
+
+/* Route all traces
+ * :
+ *  SUCCESS if OK
+ *  STOP_FROM_ESC if escape (stop being routed) request
+ *  ERR_MEMORY if default memory allocation
+ */
+int PCB_EDIT_FRAME::Solve( wxDC* DC, int aLayersCount )
+{
+    FRAME_SOLVER solver( this, DC );
+    wxBusyCursor dummy_cursor;      // Set an hourglass cursor while routing
+
+    m_canvas->SetAbortRequest( false );
+
+    int result = solver.Solve( aLayersCount );
+
+    SaveCopyInUndoList( solver.m_ItemsListPicker, UR_UNSPECIFIED );
+    solver.m_ItemsListPicker.ClearItemsList();  // the picker list is no more owner of
+                                                // picked items
+
+    return result;
+}
+
+
 /* Clear the flag CH_NOROUTABLE which is set to 1 by Solve(),
  * when a track was not routed.
  * (If this flag is 1 the corresponding track it is not rerouted)
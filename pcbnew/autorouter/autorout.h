@@ -33,7 +33,11 @@
 #define AUTOROUT_H
 
 
+#include <vector>
+#include <stdint.h>
+
 #include <base_struct.h>
+#include <dlist.h>
 #include <layers_id_colors_and_visibility.h>
 
 
@@ -65,12 +69,12 @@ enum AUTOPLACEROUTE_OPTIONS
 
 #define FORCE_PADS 1  /* Force placement of pads for any Netcode */
 
-/* search statistics */
-extern int OpenNodes;   /* total number of nodes opened */
-extern int ClosNodes;   /* total number of nodes closed */
-extern int MoveNodes;   /* total number of nodes moved */
-extern int MaxNodes;    /* maximum number of nodes opened at one time */
-
+/* Results of the routing of a track */
+#define NOSUCCESS       0
+#define STOP_FROM_ESC   -1
+#define ERR_MEMORY      -2
+#define SUCCESS         1
+#define TRIVIAL_SUCCESS 2
 
 /* Structures useful to the generation of board as bitmap. */
 typedef char MATRIX_CELL;
@@ -81,35 +85,102 @@ typedef char DIR_CELL;
 /**
  * class MATRIX_ROUTING_HEAD
  * handle the matrix routing that describes the actual board
+ *
+ * The matrix is split in square tiles of ROUTING_TILE_SIZE x ROUTING_TILE_SIZE cells, which
+ * are only allocated when one of their cells is written: a tile never written reads as
+ * empty cells, with no direction and a distance of 0.
+ * Inside a tile, each bit of the cells is stored in its own bit plane, allocated when one
+ * of the cells sets this bit, and the search data (directions and distances) is only
+ * allocated for the tiles reached by the search of the track being routed.
+ *
+ * A matrix can also be an overlay of another one (see InitOverlay()): it reads the cells of
+ * its base, copies a tile of the base when writing to it and has its own search data.
  */
 class MATRIX_ROUTING_HEAD
 {
 public:
-    MATRIX_CELL* m_BoardSide[MAX_ROUTING_LAYERS_COUNT]; // the image map of 2 board sides
-    DIST_CELL*   m_DistSide[MAX_ROUTING_LAYERS_COUNT];  // the image map of 2 board sides:
-                                                        // distance to cells
-    DIR_CELL*    m_DirSide[MAX_ROUTING_LAYERS_COUNT];   // the image map of 2 board sides:
-                                                        // pointers back to source
     bool         m_InitMatrixDone;
     int          m_RoutingLayersCount;          // Number of layers for autorouting (0 or 1)
     int          m_GridRouting;                 // Size of grid for autoplace/autoroute
     EDA_RECT     m_BrdBox;                      // Actual board bounding box
     int          m_Nrows, m_Ncols;              // Matrix size
-    int          m_MemSize;                     // Memory requirement, just for statistics
+    int          m_MemSize;                     // Memory currently used by the tiles
+    int          m_MemPeak;                     // Largest value of m_MemSize since the init
     int          m_RouteCount;                  // Number of routes
 
 private:
+    static const int TILE_SHIFT = 5;
+    static const int TILE_SIZE  = 1 << TILE_SHIFT;
+    static const int TILE_MASK  = TILE_SIZE - 1;
+    static const int TILE_CELLS = TILE_SIZE * TILE_SIZE;
+    static const int TILE_WORDS = TILE_CELLS / 64;      // uint64_t words in a bit plane
+
+    /// Distance offset of a cell whose distance was never set, it reads as 0
+    static const uint16_t DIST_UNSET = 0xFFFF;
+
+    /// Cells of one tile, one bit plane per bit of MATRIX_CELL
+    struct CELL_TILE
+    {
+        uint64_t*   m_Planes[8];    // NULL if no cell of the tile has this bit set
+    };
+
+    /// Search data of one tile
+    struct SEARCH_TILE
+    {
+        unsigned char   m_Dir[TILE_CELLS / 2];  // DIR_CELL values, 4 bits per cell
+        uint16_t        m_Dist[TILE_CELLS];     // distance - m_DistBase, or DIST_UNSET
+        int             m_DistBase;
+        int*            m_WideDist;             // replaces m_Dist when the distances of the
+                                                // tile do not fit in 16 bits, else NULL
+        uint64_t        m_Queued[TILE_WORDS];   // cells currently in the search queue
+    };
+
+    std::vector<CELL_TILE*>     m_CellTiles[MAX_ROUTING_LAYERS_COUNT];
+    std::vector<SEARCH_TILE*>   m_SearchTiles[MAX_ROUTING_LAYERS_COUNT];
+    std::vector<int>            m_SearchTilesUsed[MAX_ROUTING_LAYERS_COUNT];
+    std::vector<SEARCH_TILE*>   m_FreeSearchTiles;  // cleared tiles kept for reuse
+    std::vector<unsigned>       m_TileStamps[MAX_ROUTING_LAYERS_COUNT]; // m_WriteCount at
+                                                                        // the last tile write
+    unsigned                    m_WriteCount;
+    int                         m_TileRows, m_TileCols;
+
+    MATRIX_ROUTING_HEAD*        m_Base;             // matrix overlaid, or NULL
+    MATRIX_ROUTING_HEAD*        m_WriteTarget;      // matrix written by WriteCell()
+
     // a pointer to the current selected cell operation
     void        (MATRIX_ROUTING_HEAD::* m_opWriteCell)( int aRow, int aCol,
                                                         int aSide, MATRIX_CELL aCell);
 
+    static int tileCell( int aRow, int aCol )
+    {
+        return ( ( aRow & TILE_MASK ) << TILE_SHIFT ) | ( aCol & TILE_MASK );
+    }
+
+    int tileIndex( int aRow, int aCol ) const
+    {
+        return ( aRow >> TILE_SHIFT ) * m_TileCols + ( aCol >> TILE_SHIFT );
+    }
+
+    void addMemory( int aBytes );
+
+    /// Stores aCell in the bit planes of the cell at aRow, aCol
+    void storeCell( int aRow, int aCol, int aSide, MATRIX_CELL aCell );
+
+    /// @return the search tile of a cell, allocated if needed
+    SEARCH_TILE* searchTile( int aRow, int aCol, int aSide );
+
+    /// Re-encodes the distances of aTile so that aDist fits, or switches it to m_WideDist
+    void fitDist( SEARCH_TILE* aTile, int aDist );
+
+    void freeTiles();
+
 public:
     MATRIX_ROUTING_HEAD();
     ~MATRIX_ROUTING_HEAD();
 
     void WriteCell( int aRow, int aCol, int aSide, MATRIX_CELL aCell)
     {
-        (*this.*m_opWriteCell)( aRow, aCol, aSide, aCell );
+        (*m_WriteTarget.*m_opWriteCell)( aRow, aCol, aSide, aCell );
     }
 
     /**
@@ -142,6 +213,40 @@ public:
 
     void UnInitRoutingMatrix();
 
+    /**
+     * Function InitOverlay
+     * makes this matrix an overlay of \a aBase, which must be initialized: it has the same
+     * size, reads the cells of \a aBase until it writes them and has its own search data.
+     * Writing to the overlay never changes \a aBase, and several overlays of the same base
+     * can be searched concurrently as long as the base is not modified.
+     */
+    void InitOverlay( MATRIX_ROUTING_HEAD& aBase );
+
+    /**
+     * Function SetWriteTarget
+     * redirects WriteCell() (and therefore the functions drawing on the routing matrix,
+     * like PlacePad() or TraceSegmentPcb()) to \a aTarget, typically an overlay of this
+     * matrix. NULL restores the default target, this matrix.
+     */
+    void SetWriteTarget( MATRIX_ROUTING_HEAD* aTarget )
+    {
+        m_WriteTarget = aTarget ? aTarget : this;
+    }
+
+    /**
+     * Function GetWriteCount
+     * @return a counter incremented each time a cell of this matrix is changed.
+     */
+    unsigned GetWriteCount() const { return m_WriteCount; }
+
+    /**
+     * Function IsModifiedSince
+     * @return true if a cell of the tiles overlapping the given rows and columns was
+     * changed after GetWriteCount() returned \a aWriteCount.
+     */
+    bool IsModifiedSince( int aRowMin, int aColMin, int aRowMax, int aColMax,
+                          unsigned aWriteCount ) const;
+
     // Initialize WriteCell to make the aLogicOp
     void SetCellOperation( int aLogicOp );
 
@@ -157,6 +262,32 @@ public:
     int GetDir( int aRow, int aCol, int aSide );
     void SetDir( int aRow, int aCol, int aSide, int aDir);
 
+    /**
+     * Function CopyCells
+     * replaces all the cells of side \a aDestSide by the cells of side \a aSrcSide.
+     */
+    void CopyCells( int aSrcSide, int aDestSide );
+
+    /**
+     * Function IsQueued
+     * @return true if the cell is in the search queue, see SetQueued().
+     */
+    bool IsQueued( int aRow, int aCol, int aSide );
+
+    /**
+     * Function SetQueued
+     * marks the cell as being in the search queue or not.
+     */
+    void SetQueued( int aRow, int aCol, int aSide, bool aQueued );
+
+    /**
+     * Function ClearSearch
+     * resets the search data of all the cells: no direction, no distance and not queued.
+     * Only the tiles reached since the previous call are actually cleared.
+     * @param aTwoSides = true to clear both sides, false to clear the BOTTOM side only
+     */
+    void ClearSearch( bool aTwoSides );
+
     // calculate distance (with penalty) of a trace through a cell
     int CalcDist(int x,int y,int z ,int side );
 
@@ -215,11 +346,62 @@ void TraceFilledRectangle( int ux0, int uy0, int ux1, int uy1,
                            int color, int op_logic );
 
 /* QUEUE.CPP */
-void FreeQueue();
-void InitQueue();
-void GetQueue( int *, int *, int *, int *, int * );
-int  SetQueue( int, int, int, int, int, int, int );
-void ReSetQueue( int, int, int, int, int, int, int );
+
+/**
+ * Class ROUTING_QUEUE
+ * is the search queue of one track search: the cells to explore, ordered by the estimated
+ * length of the path through them. Each search has its own queue, so several tracks can
+ * be searched at the same time on different overlays of the routing matrix.
+ */
+class ROUTING_QUEUE
+{
+public:
+    ROUTING_QUEUE( MATRIX_ROUTING_HEAD& aMatrix );
+
+    /// initialize the search queue and the statistics
+    void InitQueue();
+
+    /// get search queue item from list, *r is ILLEGAL if the queue is empty
+    void GetQueue( int* r, int* c, int* s, int* d, int* a );
+
+    /**
+     * Function SetQueue
+     * adds a search node to the list.
+     * @return 1 if OK, 0 if failed to allocate memory
+     */
+    int SetQueue( int r, int c, int side, int d, int a, int r2, int c2 );
+
+    /// reposition node in list, after a shorter path to it was found
+    void ReSetQueue( int r, int c, int s, int d, int a, int r2, int c2 );
+
+    // search statistics
+    int m_OpenNodes;    // total number of nodes opened
+    int m_ClosNodes;    // total number of nodes closed
+    int m_MoveNodes;    // total number of nodes moved
+    int m_MaxNodes;     // maximum number of nodes opened at one time
+
+private:
+    struct PcbQueue             // search queue structure
+    {
+        int         Row;        // current row
+        int         Col;        // current column
+        int         Side;       // 0=top, 1=bottom
+        int         Dist;       // path distance to this cell so far
+        int         ApxDist;    // approximate distance to target from here
+        bool        IsGoal;     // this is the target cell
+        unsigned    Order;      // insertion order, to break ties
+    };
+
+    struct PcbQueueCompare
+    {
+        bool operator()( const PcbQueue& a, const PcbQueue& b ) const;
+    };
+
+    MATRIX_ROUTING_HEAD&    m_matrix;   // matrix flagging the queued cells
+    std::vector<PcbQueue>   m_heap;
+    long                    m_qlen;     // current queue length (queued cells)
+    unsigned                m_qorder;   // insertion counter
+};
 
 /* WORK.CPP */
 void InitWork();
@@ -232,5 +414,105 @@ void SortWork(); /* order the work items; shortest first */
 int Build_Work( BOARD * Pcb );
 void PlaceCells( BOARD * Pcb, int net_code, int flag = 0 );
 
+/* SOLVE.CPP */
+
+struct AR_ROUTE;
+
+/**
+ * Class AR_SOLVER
+ * routes the items of the work list (see Build_Work()) on RoutingMatrix and inserts the
+ * new tracks in the board. It does not use any UI: a derived class shows the progress and
+ * can stop the routing through the virtual functions called for each item.
+ *
+ * Consecutive items of the work list whose areas do not overlap are routed as a batch:
+ * each one is searched inside its area, on its own overlay of RoutingMatrix, concurrently
+ * when OpenMP is available. The results are then committed in the work list order. An item
+ * which cannot be routed inside its area, or whose area was changed by the tracks committed
+ * before it, is searched again on the whole matrix, so the batches only change the tracks
+ * found when the area was too small for the best path.
+ */
+class AR_SOLVER
+{
+public:
+    AR_SOLVER( BOARD* aBoard );
+    virtual ~AR_SOLVER();
+
+    /**
+     * Function Solve
+     * routes all the items of the work list.
+     * @param aLayersCount = the number of routing layers (1 or 2)
+     * @param aConcurrent = true to route the items by batches, false to route them one at
+     *                      a time
+     * @return SUCCESS when the work list is done, STOP_FROM_ESC if onStartItem() stopped
+     *  the routing or ERR_MEMORY if a search queue could not be allocated
+     */
+    int Solve( int aLayersCount, bool aConcurrent = true );
+
+    int     m_RoutedCount;      // items routed, or found already connected
+    int     m_FailedCount;      // items not routed, flagged CH_UNROUTABLE
+    int     m_RetryCount;       // items of a batch searched again on the whole matrix
+    int     m_MemPeak;          // largest memory used by RoutingMatrix and its overlays
+
+    // search statistics of the last item
+    int     m_OpenNodes;
+    int     m_ClosNodes;
+    int     m_MoveNodes;
+
+protected:
+    /**
+     * Function onStartItem
+     * is called before committing an item.
+     * @param aItem = the ratsnest item
+     * @param aStart, aEnd = the grid points connected, in board coordinates
+     * @return false to stop the routing
+     */
+    virtual bool onStartItem( RATSNEST_ITEM* aItem, const wxPoint& aStart, const wxPoint& aEnd )
+    {
+        return true;
+    }
+
+    /**
+     * Function onItemDone
+     * is called after an item is committed.
+     * @param aItem = the ratsnest item
+     * @param aResult = SUCCESS, TRIVIAL_SUCCESS, NOSUCCESS or ERR_MEMORY
+     * @param aFirstTrack = the first of the \a aTrackCount new tracks, inserted one after
+     *                      the other in the board, or NULL if no track was added
+     */
+    virtual void onItemDone( RATSNEST_ITEM* aItem, int aResult,
+                             TRACK* aFirstTrack, int aTrackCount ) {}
+
+    /// is called when the tracks of a routed item cannot be built
+    virtual void onError( const wxString& aMessage ) {}
+
+    BOARD*      m_board;
+
+private:
+    bool        m_twoSides;
+    wxPoint     m_origin;       // board coordinates of the routing matrix origin
+    int         m_clearance;
+    int         m_marge;        // clearance + half track width
+    int         m_viaMarge;     // clearance + half via size
+    DLIST<TRACK> m_newTracks;   // tracks of the item being committed
+
+    /// @return the next item of the work list, or NULL when the list is done
+    AR_ROUTE* nextRoute();
+
+    /**
+     * Function prepare
+     * checks that the item can be routed and draws its pads on the overlay of the item.
+     * @return true if the item has to be searched, false if its result is already known
+     */
+    bool prepare( AR_ROUTE& aRoute, bool aConfined );
+
+    /// builds the tracks of a searched item and inserts them in the board
+    bool commit( AR_ROUTE& aRoute );
+
+    int retrace( AR_ROUTE& aRoute );
+    void orCellTrace( AR_ROUTE& aRoute, int col, int row, int side, int orient );
+    void addNewTrace( AR_ROUTE& aRoute );
+    void updateMemPeak( const std::vector<AR_ROUTE*>& aBatch );
+};
+
 
 #endif  // AUTOROUT_H
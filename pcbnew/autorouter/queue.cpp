@@ -35,86 +35,94 @@
 #include <fctsys.h>
 #include <common.h>
 
+#include <algorithm>
+#include <vector>
+
 #include <pcbnew.h>
 #include <autorout.h>
 #include <cell.h>
 
 
-struct PcbQueue /* search queue structure */
+/* The search queue is a binary heap ordered by the estimated total path length
+ * ( distance so far + approximate distance to target ).
+ * Repositioning a node (ReSetQueue) does not search the heap: the node is pushed again
+ * with its new, shorter, distance and the outdated entry is dropped when it reaches the
+ * top of the heap (its distance no longer matches the one stored in the routing matrix).
+ * The routing matrix also flags the cells which are in the queue, so the statistics count
+ * nodes and not heap entries.
+ */
+
+
+/* Ordering of the heap: smallest estimated length first.
+ * On equal length, the goal node comes first, then the most recently queued node
+ * (this is the order the former sorted list used).
+ */
+bool ROUTING_QUEUE::PcbQueueCompare::operator()( const PcbQueue& a, const PcbQueue& b ) const
 {
-    struct PcbQueue* Next;
-    int              Row;       /* current row                  */
-    int              Col;       /* current column               */
-    int              Side;      /* 0=top, 1=bottom              */
-    int              Dist;      /* path distance to this cell so far        */
-    int              ApxDist;   /* approximate distance to target from here */
-};
+    int la = a.Dist + a.ApxDist;
+    int lb = b.Dist + b.ApxDist;
 
-static long             qlen = 0;   /* current queue length */
-static struct PcbQueue* Head = NULL;
-static struct PcbQueue* Tail = NULL;
-static struct PcbQueue* Save = NULL;    /* hold empty queue structs */
+    if( la != lb )
+        return la > lb;
 
+    if( a.IsGoal != b.IsGoal )
+        return b.IsGoal;
 
-void InitQueue();
-void GetQueue( int*, int*, int*, int*, int* );
-int  SetQueue( int, int, int, int, int, int, int );
-void ReSetQueue( int, int, int, int, int, int, int );
+    return a.Order < b.Order;
+}
 
 
-/* Free the memory used for storing all the queue */
-void FreeQueue()
+ROUTING_QUEUE::ROUTING_QUEUE( MATRIX_ROUTING_HEAD& aMatrix ) :
+    m_matrix( aMatrix )
 {
-    struct PcbQueue* p;
-
     InitQueue();
-
-    while( (p = Save) != NULL )
-    {
-        Save = p->Next;
-        delete p;
-    }
 }
 
 
 /* initialize the search queue */
-void InitQueue()
+void ROUTING_QUEUE::InitQueue()
 {
-    struct PcbQueue* p;
-
-    while( (p = Head) != NULL )
-    {
-        Head    = p->Next;
-        p->Next = Save; Save = p;
-    }
+    m_heap.clear();
 
-    Tail = NULL;
-    OpenNodes = ClosNodes = MoveNodes = MaxNodes = qlen = 0;
+    m_qorder = 0;
+    m_qlen = 0;
+    m_OpenNodes = m_ClosNodes = m_MoveNodes = m_MaxNodes = 0;
 }
 
 
 /* get search queue item from list */
-void GetQueue( int* r, int* c, int* s, int* d, int* a )
+void ROUTING_QUEUE::GetQueue( int* r, int* c, int* s, int* d, int* a )
 {
-    struct PcbQueue* p;
-
-    if( (p = Head) != NULL )  /* return first item in list */
+    while( !m_heap.empty() )
     {
-        *r = p->Row; *c = p->Col;
-        *s = p->Side;
-        *d = p->Dist; *a = p->ApxDist;
+        PcbQueue p = m_heap.front();
 
-        if( (Head = p->Next) == NULL )
-            Tail = NULL;
+        std::pop_heap( m_heap.begin(), m_heap.end(), PcbQueueCompare() );
+        m_heap.pop_back();
 
-        /* put node on free list */
-        p->Next = Save; Save = p;
-        ClosNodes++; qlen--;
-    }
-    else /* empty list */
-    {
-        *r = *c = *s = *d = *a = ILLEGAL;
+        /* skip entries superseded by ReSetQueue (a shorter path was found since).
+         * Source cells are never reached from another cell, so they have no direction
+         * and their distance in the matrix is meaningless.
+         */
+        if( !m_matrix.IsQueued( p.Row, p.Col, p.Side ) )
+            continue;
+
+        if( m_matrix.GetDir( p.Row, p.Col, p.Side ) != FROM_NOWHERE
+            && p.Dist > m_matrix.GetDist( p.Row, p.Col, p.Side ) )
+            continue;
+
+        m_matrix.SetQueued( p.Row, p.Col, p.Side, false );
+
+        *r = p.Row; *c = p.Col;
+        *s = p.Side;
+        *d = p.Dist; *a = p.ApxDist;
+
+        m_ClosNodes++; m_qlen--;
+        return;
     }
+
+    /* empty list */
+    *r = *c = *s = *d = *a = ILLEGAL;
 }
 
 
@@ -123,103 +131,52 @@ void GetQueue( int* r, int* c, int* s, int* d, int* a )
  *      1 - OK
  *      0 - Failed to allocate memory.
  */
-int SetQueue( int r, int c, int side, int d, int a, int r2, int c2 )
+int ROUTING_QUEUE::SetQueue( int r, int c, int side, int d, int a, int r2, int c2 )
 {
-    struct PcbQueue* p, * q, * t;
-    int i, j;
+    PcbQueue p;
 
-    j = 0;                      // gcc warning fix
+    p.Row     = r;
+    p.Col     = c;
+    p.Side    = side;
+    p.Dist    = d;
+    p.ApxDist = a;
+    p.IsGoal  = ( r == r2 && c == c2 );
+    p.Order   = m_qorder++;
 
-    if( (p = Save) != NULL )    /* try free list first */
+    try
     {
-        Save = p->Next;
+        m_heap.push_back( p );
     }
-    else if( ( p = (PcbQueue*) operator new( sizeof( PcbQueue ), std::nothrow ) ) == NULL )
+    catch( const std::bad_alloc& )
     {
         return 0;
     }
 
-    p->Row  = r;
-    p->Col  = c;
-    p->Side = side;
-    i = (p->Dist = d) + (p->ApxDist = a);
-    p->Next = NULL;
+    std::push_heap( m_heap.begin(), m_heap.end(), PcbQueueCompare() );
 
-    if( (q = Head) != NULL ) /* insert in proper position in list */
-    {
-        if( q->Dist + q->ApxDist > i ) /* insert at head */
-        {
-            p->Next = q; Head = p;
-        }
-        else   /* search for proper position */
-        {
-            for( t = q, q = q->Next; q && i > ( j = q->Dist + q->ApxDist ); t = q, q = q->Next )
-                ;
-
-            if( q && i == j && q->Row == r2 && q->Col == c2 )
-            {
-                /* insert after q, which is a goal node */
-                if( ( p->Next = q->Next ) == NULL )
-                    Tail = p;
-
-                q->Next = p;
-            }
-            else  /* insert in front of q */
-            {
-                if( ( p->Next = q ) == NULL )
-                    Tail = p;
-
-                t->Next = p;
-            }
-        }
-    }
-    else /* empty search list */
+    if( !m_matrix.IsQueued( r, c, side ) )
     {
-        Head = Tail = p;
-    }
+        m_matrix.SetQueued( r, c, side, true );
+        m_OpenNodes++;
 
-    OpenNodes++;
-
-    if( ++qlen > MaxNodes )
-        MaxNodes = qlen;
+        if( ++m_qlen > m_MaxNodes )
+            m_MaxNodes = m_qlen;
+    }
 
     return 1;
 }
 
 
-/* reposition node in list */
-void ReSetQueue( int r, int c, int s, int d, int a, int r2, int c2 )
+/* reposition node in list
+ * The caller has already stored the new (shorter) distance in the routing matrix,
+ * so the previous entry of this node, if any, will be skipped by GetQueue.
+ */
+void ROUTING_QUEUE::ReSetQueue( int r, int c, int s, int d, int a, int r2, int c2 )
 {
-    struct PcbQueue* p, * q;
-
-    /* first, see if it is already in the list */
-    for( q = NULL, p = Head; p; q = p, p = p->Next )
-    {
-        if( p->Row == r && p->Col == c && p->Side == s )
-        {
-            /* old one to remove */
-            if( q )
-            {
-                if( ( q->Next = p->Next ) == NULL )
-                    Tail = q;
-            }
-            else if( ( Head = p->Next ) == NULL )
-            {
-                Tail = NULL;
-            }
-
-            p->Next = Save;
-            Save = p;
-            OpenNodes--;
-            MoveNodes++;
-            qlen--;
-            break;
-        }
-    }
-
-    if( !p )            /* not found, it has already been closed once */
-        ClosNodes--;    /* we will close it again, but just count once */
+    if( m_matrix.IsQueued( r, c, s ) )
+        m_MoveNodes++;
+    else                    /* it has already been closed once */
+        m_ClosNodes--;      /* we will close it again, but just count once */
 
-    /* if it was there, it's gone now; insert it at the proper position */
     SetQueue( r, c, s, d, a, r2, c2 );
 }
@@ -32,6 +32,7 @@
 
 #include <fctsys.h>
 #include <common.h>
+#include <algorithm>
 
 #include <pcbnew.h>
 #include <cell.h>
@@ -47,18 +48,21 @@
 
 MATRIX_ROUTING_HEAD::MATRIX_ROUTING_HEAD()
 {
-    m_BoardSide[0]   = m_BoardSide[1] = NULL;
-    m_DistSide[0]    = m_DistSide[1] = NULL;
-    m_DirSide[0]     = m_DirSide[1] = NULL;
     m_InitMatrixDone = false;
     m_Nrows   = m_Ncols = 0;
-    m_MemSize = 0;
+    m_MemSize = m_MemPeak = 0;
     m_RoutingLayersCount = 1;
+    m_TileRows = m_TileCols = 0;
+    m_WriteCount = 0;
+    m_Base = NULL;
+    m_WriteTarget = this;
+    m_opWriteCell = &MATRIX_ROUTING_HEAD::SetCell;
 }
 
 
 MATRIX_ROUTING_HEAD::~MATRIX_ROUTING_HEAD()
 {
+    freeTiles();
 }
 
 
@@ -104,78 +108,133 @@ int MATRIX_ROUTING_HEAD::InitRoutingMatrix()
 
     m_InitMatrixDone = true;     // we have been called
 
-    // give a small margin for memory allocation:
-    int ii = (RoutingMatrix.m_Nrows + 1) * (RoutingMatrix.m_Ncols + 1);
+    freeTiles();
+    m_Base = NULL;
+    m_WriteTarget = this;
+
+    // Tiles are allocated when written, only the tile maps are needed for now
+    m_TileRows = ( m_Nrows + TILE_SIZE - 1 ) >> TILE_SHIFT;
+    m_TileCols = ( m_Ncols + TILE_SIZE - 1 ) >> TILE_SHIFT;
+
+    int tileCount = m_TileRows * m_TileCols;
 
-    int side = BOTTOM;
-    for( int jj = 0; jj < m_RoutingLayersCount; jj++ )  // m_RoutingLayersCount = 1 or 2
+    for( int side = 0; side < MAX_ROUTING_LAYERS_COUNT; side++ )
     {
-        m_BoardSide[side] = NULL;
-        m_DistSide[side]  = NULL;
-        m_DirSide[side]   = NULL;
+        m_CellTiles[side].assign( tileCount, (CELL_TILE*) NULL );
+        m_SearchTiles[side].assign( tileCount, (SEARCH_TILE*) NULL );
+        m_TileStamps[side].assign( tileCount, 0 );
+    }
 
-        // allocate matrix & initialize everything to empty
-        m_BoardSide[side] = (MATRIX_CELL*) operator new( ii * sizeof(MATRIX_CELL) );
-        memset( m_BoardSide[side], 0, ii * sizeof(MATRIX_CELL) );
+    m_WriteCount = 0;
+    m_MemSize = m_MemPeak = 0;
+    addMemory( MAX_ROUTING_LAYERS_COUNT * tileCount
+               * ( sizeof(CELL_TILE*) + sizeof(SEARCH_TILE*) + sizeof(unsigned) ) );
 
-        if( m_BoardSide[side] == NULL )
-            return -1;
+    return m_MemSize;
+}
 
-        // allocate Distances
-        m_DistSide[side] = (DIST_CELL*) operator new( ii * sizeof(DIST_CELL) );
-        memset( m_DistSide[side], 0, ii * sizeof(DIST_CELL) );
 
-        if( m_DistSide[side] == NULL )
-            return -1;
+void MATRIX_ROUTING_HEAD::InitOverlay( MATRIX_ROUTING_HEAD& aBase )
+{
+    wxASSERT( aBase.m_InitMatrixDone && !aBase.m_Base );
 
-        // allocate Dir (chars)
-        m_DirSide[side] = (char*) operator new( ii );
-        memset( m_DirSide[side], 0, ii );
+    m_RoutingLayersCount = aBase.m_RoutingLayersCount;
+    m_GridRouting = aBase.m_GridRouting;
+    m_BrdBox      = aBase.m_BrdBox;
+    m_Nrows       = aBase.m_Nrows;
+    m_Ncols       = aBase.m_Ncols;
+    m_RouteCount  = aBase.m_RouteCount;
 
-        if( m_DirSide[side] == NULL )
-            return -1;
+    InitRoutingMatrix();
 
-        side = TOP;
-    }
+    m_Base = &aBase;
+}
 
-    m_MemSize = m_RouteCount * ii * ( sizeof(MATRIX_CELL)
-                + sizeof(DIST_CELL) + sizeof(char) );
 
-    return m_MemSize;
+bool MATRIX_ROUTING_HEAD::IsModifiedSince( int aRowMin, int aColMin, int aRowMax, int aColMax,
+                                           unsigned aWriteCount ) const
+{
+    int trowMin = std::max( aRowMin, 0 ) >> TILE_SHIFT;
+    int tcolMin = std::max( aColMin, 0 ) >> TILE_SHIFT;
+    int trowMax = std::min( aRowMax, m_Nrows - 1 ) >> TILE_SHIFT;
+    int tcolMax = std::min( aColMax, m_Ncols - 1 ) >> TILE_SHIFT;
+
+    for( int side = 0; side < MAX_ROUTING_LAYERS_COUNT; side++ )
+    {
+        for( int trow = trowMin; trow <= trowMax; trow++ )
+        {
+            for( int tcol = tcolMin; tcol <= tcolMax; tcol++ )
+            {
+                if( m_TileStamps[side][trow * m_TileCols + tcol] > aWriteCount )
+                    return true;
+            }
+        }
+    }
+
+    return false;
 }
 
 
 void MATRIX_ROUTING_HEAD::UnInitRoutingMatrix()
 {
-    int ii;
-
     m_InitMatrixDone = false;
 
-    for( ii = 0; ii < MAX_ROUTING_LAYERS_COUNT; ii++ )
+    freeTiles();
+
+    m_Nrows = m_Ncols = 0;
+    m_MemSize = 0;
+    m_Base = NULL;
+    m_WriteTarget = this;
+}
+
+
+void MATRIX_ROUTING_HEAD::freeTiles()
+{
+    for( int side = 0; side < MAX_ROUTING_LAYERS_COUNT; side++ )
     {
-        // de-allocate Dir matrix
-        if( m_DirSide[ii] )
+        for( unsigned ii = 0; ii < m_CellTiles[side].size(); ii++ )
         {
-            delete m_DirSide[ii];
-            m_DirSide[ii] = NULL;
-        }
+            CELL_TILE* tile = m_CellTiles[side][ii];
 
-        // de-allocate Distances matrix
-        if( m_DistSide[ii] )
-        {
-            delete m_DistSide[ii];
-            m_DistSide[ii] = NULL;
+            if( !tile )
+                continue;
+
+            for( int bit = 0; bit < 8; bit++ )
+                delete[] tile->m_Planes[bit];
+
+            delete tile;
         }
 
-        // de-allocate cells matrix
-        if( m_BoardSide[ii] )
+        for( unsigned ii = 0; ii < m_SearchTiles[side].size(); ii++ )
         {
-            delete m_BoardSide[ii];
-            m_BoardSide[ii] = NULL;
+            if( m_SearchTiles[side][ii] )
+            {
+                delete[] m_SearchTiles[side][ii]->m_WideDist;
+                delete m_SearchTiles[side][ii];
+            }
         }
+
+        m_CellTiles[side].clear();
+        m_SearchTiles[side].clear();
+        m_SearchTilesUsed[side].clear();
+        m_TileStamps[side].clear();
     }
 
-    m_Nrows = m_Ncols = 0;
+    for( unsigned ii = 0; ii < m_FreeSearchTiles.size(); ii++ )
+        delete m_FreeSearchTiles[ii];
+
+    m_FreeSearchTiles.clear();
+
+    m_TileRows = m_TileCols = 0;
+}
+
+
+void MATRIX_ROUTING_HEAD::addMemory( int aBytes )
+{
+    m_MemSize += aBytes;
+
+    if( m_MemSize > m_MemPeak )
+        m_MemPeak = m_MemSize;
 }
 
 
@@ -445,10 +504,88 @@ void MATRIX_ROUTING_HEAD::SetCellOperation( int aLogicOp )
  */
 MATRIX_CELL MATRIX_ROUTING_HEAD::GetCell( int aRow, int aCol, int aSide )
 {
-    MATRIX_CELL* p;
+    int              index = tileIndex( aRow, aCol );
+    const CELL_TILE* tile  = m_CellTiles[aSide][index];
+
+    if( !tile && m_Base )
+        tile = m_Base->m_CellTiles[aSide][index];
+
+    if( !tile )
+        return 0;
+
+    int      cell  = tileCell( aRow, aCol );
+    int      word  = cell >> 6;
+    uint64_t mask  = (uint64_t) 1 << ( cell & 63 );
+    unsigned value = 0;
+
+    for( int bit = 0; bit < 8; bit++ )
+    {
+        if( tile->m_Planes[bit] && ( tile->m_Planes[bit][word] & mask ) )
+            value |= 1 << bit;
+    }
+
+    return (MATRIX_CELL) value;
+}
+
+
+/* write all the bits of a cell, allocating its tile and bit planes if needed
+ */
+void MATRIX_ROUTING_HEAD::storeCell( int aRow, int aCol, int aSide, MATRIX_CELL aCell )
+{
+    if( GetCell( aRow, aCol, aSide ) == aCell )
+        return;
+
+    int         index = tileIndex( aRow, aCol );
+    CELL_TILE*& tile  = m_CellTiles[aSide][index];
+    unsigned    value = (unsigned char) aCell;
+
+    if( !tile )
+    {
+        tile = new CELL_TILE;
+        memset( tile->m_Planes, 0, sizeof( tile->m_Planes ) );
+        addMemory( sizeof(CELL_TILE) );
+
+        // Overlay: start from a copy of the base tile
+        const CELL_TILE* baseTile = m_Base ? m_Base->m_CellTiles[aSide][index] : NULL;
+
+        for( int bit = 0; baseTile && bit < 8; bit++ )
+        {
+            if( baseTile->m_Planes[bit] )
+            {
+                tile->m_Planes[bit] = new uint64_t[TILE_WORDS];
+                memcpy( tile->m_Planes[bit], baseTile->m_Planes[bit],
+                        TILE_WORDS * sizeof(uint64_t) );
+                addMemory( TILE_WORDS * sizeof(uint64_t) );
+            }
+        }
+    }
+
+    m_TileStamps[aSide][index] = ++m_WriteCount;
 
-    p = RoutingMatrix.m_BoardSide[aSide];
-    return p[aRow * m_Ncols + aCol];
+    int      cell  = tileCell( aRow, aCol );
+    int      word  = cell >> 6;
+    uint64_t mask  = (uint64_t) 1 << ( cell & 63 );
+
+    for( int bit = 0; bit < 8; bit++ )
+    {
+        uint64_t* plane = tile->m_Planes[bit];
+
+        if( value & ( 1 << bit ) )
+        {
+            if( !plane )
+            {
+                plane = tile->m_Planes[bit] = new uint64_t[TILE_WORDS];
+                memset( plane, 0, TILE_WORDS * sizeof(uint64_t) );
+                addMemory( TILE_WORDS * sizeof(uint64_t) );
+            }
+
+            plane[word] |= mask;
+        }
+        else if( plane )
+        {
+            plane[word] &= ~mask;
+        }
+    }
 }
 
 
@@ -456,10 +593,7 @@ MATRIX_CELL MATRIX_ROUTING_HEAD::GetCell( int aRow, int aCol, int aSide )
  */
 void MATRIX_ROUTING_HEAD::SetCell( int aRow, int aCol, int aSide, MATRIX_CELL x )
 {
-    MATRIX_CELL* p;
-
-    p = RoutingMatrix.m_BoardSide[aSide];
-    p[aRow * m_Ncols + aCol] = x;
+    storeCell( aRow, aCol, aSide, x );
 }
 
 
@@ -467,10 +601,7 @@ void MATRIX_ROUTING_HEAD::SetCell( int aRow, int aCol, int aSide, MATRIX_CELL x
  */
 void MATRIX_ROUTING_HEAD::OrCell( int aRow, int aCol, int aSide, MATRIX_CELL x )
 {
-    MATRIX_CELL* p;
-
-    p = RoutingMatrix.m_BoardSide[aSide];
-    p[aRow * m_Ncols + aCol] |= x;
+    storeCell( aRow, aCol, aSide, GetCell( aRow, aCol, aSide ) | x );
 }
 
 
@@ -478,10 +609,7 @@ void MATRIX_ROUTING_HEAD::OrCell( int aRow, int aCol, int aSide, MATRIX_CELL x )
  */
 void MATRIX_ROUTING_HEAD::XorCell( int aRow, int aCol, int aSide, MATRIX_CELL x )
 {
-    MATRIX_CELL* p;
-
-    p = RoutingMatrix.m_BoardSide[aSide];
-    p[aRow * m_Ncols + aCol] ^= x;
+    storeCell( aRow, aCol, aSide, GetCell( aRow, aCol, aSide ) ^ x );
 }
 
 
@@ -489,10 +617,7 @@ void MATRIX_ROUTING_HEAD::XorCell( int aRow, int aCol, int aSide, MATRIX_CELL x
  */
 void MATRIX_ROUTING_HEAD::AndCell( int aRow, int aCol, int aSide, MATRIX_CELL x )
 {
-    MATRIX_CELL* p;
-
-    p = RoutingMatrix.m_BoardSide[aSide];
-    p[aRow * m_Ncols + aCol] &= x;
+    storeCell( aRow, aCol, aSide, GetCell( aRow, aCol, aSide ) & x );
 }
 
 
@@ -500,48 +625,250 @@ void MATRIX_ROUTING_HEAD::AndCell( int aRow, int aCol, int aSide, MATRIX_CELL x
  */
 void MATRIX_ROUTING_HEAD::AddCell( int aRow, int aCol, int aSide, MATRIX_CELL x )
 {
-    MATRIX_CELL* p;
+    storeCell( aRow, aCol, aSide, GetCell( aRow, aCol, aSide ) + x );
+}
+
 
-    p = RoutingMatrix.m_BoardSide[aSide];
-    p[aRow * m_Ncols + aCol] += x;
+void MATRIX_ROUTING_HEAD::CopyCells( int aSrcSide, int aDestSide )
+{
+    std::vector<CELL_TILE*>& src  = m_CellTiles[aSrcSide];
+    std::vector<CELL_TILE*>& dest = m_CellTiles[aDestSide];
+
+    for( unsigned ii = 0; ii < dest.size(); ii++ )
+    {
+        CELL_TILE* tile = dest[ii];
+
+        if( tile )
+        {
+            for( int bit = 0; bit < 8; bit++ )
+            {
+                if( tile->m_Planes[bit] )
+                {
+                    delete[] tile->m_Planes[bit];
+                    addMemory( - (int) ( TILE_WORDS * sizeof(uint64_t) ) );
+                }
+            }
+
+            delete tile;
+            addMemory( - (int) sizeof(CELL_TILE) );
+            dest[ii] = NULL;
+        }
+
+        if( !src[ii] )
+            continue;
+
+        tile = dest[ii] = new CELL_TILE;
+        addMemory( sizeof(CELL_TILE) );
+
+        for( int bit = 0; bit < 8; bit++ )
+        {
+            tile->m_Planes[bit] = NULL;
+
+            if( src[ii]->m_Planes[bit] )
+            {
+                tile->m_Planes[bit] = new uint64_t[TILE_WORDS];
+                memcpy( tile->m_Planes[bit], src[ii]->m_Planes[bit],
+                        TILE_WORDS * sizeof(uint64_t) );
+                addMemory( TILE_WORDS * sizeof(uint64_t) );
+            }
+        }
+    }
+}
+
+
+MATRIX_ROUTING_HEAD::SEARCH_TILE* MATRIX_ROUTING_HEAD::searchTile( int aRow, int aCol,
+                                                                   int aSide )
+{
+    int           index = tileIndex( aRow, aCol );
+    SEARCH_TILE*& tile  = m_SearchTiles[aSide][index];
+
+    if( tile )
+        return tile;
+
+    if( !m_FreeSearchTiles.empty() )
+    {
+        tile = m_FreeSearchTiles.back();
+        m_FreeSearchTiles.pop_back();
+    }
+    else
+    {
+        tile = new SEARCH_TILE;
+        addMemory( sizeof(SEARCH_TILE) );
+
+        memset( tile->m_Dir, FROM_NOWHERE, sizeof( tile->m_Dir ) );
+        memset( tile->m_Dist, 0xFF, sizeof( tile->m_Dist ) );     // all DIST_UNSET
+        memset( tile->m_Queued, 0, sizeof( tile->m_Queued ) );
+        tile->m_DistBase = 0;
+        tile->m_WideDist = NULL;
+    }
+
+    m_SearchTilesUsed[aSide].push_back( index );
+
+    return tile;
+}
+
+
+void MATRIX_ROUTING_HEAD::fitDist( SEARCH_TILE* aTile, int aDist )
+{
+    // Range of the distances already set in the tile
+    int dmin = aDist, dmax = aDist;
+
+    for( int ii = 0; ii < TILE_CELLS; ii++ )
+    {
+        if( aTile->m_Dist[ii] != DIST_UNSET )
+        {
+            dmin = std::min( dmin, aTile->m_DistBase + aTile->m_Dist[ii] );
+            dmax = std::max( dmax, aTile->m_DistBase + aTile->m_Dist[ii] );
+        }
+    }
+
+    if( dmax - dmin < DIST_UNSET )
+    {
+        // Leave room for lower distances, the search can still find shorter paths
+        int newBase = dmin - ( DIST_UNSET - 1 - ( dmax - dmin ) ) / 4;
+
+        for( int ii = 0; ii < TILE_CELLS; ii++ )
+        {
+            if( aTile->m_Dist[ii] != DIST_UNSET )
+                aTile->m_Dist[ii] = aTile->m_Dist[ii] + aTile->m_DistBase - newBase;
+        }
+
+        aTile->m_DistBase = newBase;
+        return;
+    }
+
+    // Too wide for 16 bits
+    aTile->m_WideDist = new int[TILE_CELLS];
+    addMemory( TILE_CELLS * sizeof(int) );
+
+    for( int ii = 0; ii < TILE_CELLS; ii++ )
+    {
+        aTile->m_WideDist[ii] = aTile->m_Dist[ii] == DIST_UNSET ?
+                                0 : aTile->m_DistBase + aTile->m_Dist[ii];
+    }
 }
 
 
 // fetch distance cell
 DIST_CELL MATRIX_ROUTING_HEAD::GetDist( int aRow, int aCol, int aSide ) // fetch distance cell
 {
-    DIST_CELL* p;
+    const SEARCH_TILE* tile = m_SearchTiles[aSide][tileIndex( aRow, aCol )];
+
+    if( !tile )
+        return 0;
 
-    p = RoutingMatrix.m_DistSide[aSide];
-    return p[aRow * m_Ncols + aCol];
+    int cell = tileCell( aRow, aCol );
+
+    if( tile->m_WideDist )
+        return tile->m_WideDist[cell];
+
+    if( tile->m_Dist[cell] == DIST_UNSET )
+        return 0;
+
+    return tile->m_DistBase + tile->m_Dist[cell];
 }
 
 
 // store distance cell
 void MATRIX_ROUTING_HEAD::SetDist( int aRow, int aCol, int aSide, DIST_CELL x )
 {
-    DIST_CELL* p;
+    SEARCH_TILE* tile = searchTile( aRow, aCol, aSide );
+    int          cell = tileCell( aRow, aCol );
+
+    if( !tile->m_WideDist )
+    {
+        if( x < tile->m_DistBase || x - tile->m_DistBase >= DIST_UNSET )
+            fitDist( tile, x );
+    }
 
-    p = RoutingMatrix.m_DistSide[aSide];
-    p[aRow * m_Ncols + aCol] = x;
+    if( tile->m_WideDist )
+        tile->m_WideDist[cell] = x;
+    else
+        tile->m_Dist[cell] = (uint16_t) ( x - tile->m_DistBase );
 }
 
 
 // fetch direction cell
 int MATRIX_ROUTING_HEAD::GetDir( int aRow, int aCol, int aSide )
 {
-    DIR_CELL* p;
+    const SEARCH_TILE* tile = m_SearchTiles[aSide][tileIndex( aRow, aCol )];
+
+    if( !tile )
+        return FROM_NOWHERE;
 
-    p = RoutingMatrix.m_DirSide[aSide];
-    return (int) (p[aRow * m_Ncols + aCol]);
+    int cell = tileCell( aRow, aCol );
+
+    return ( tile->m_Dir[cell >> 1] >> ( ( cell & 1 ) << 2 ) ) & 0x0F;
 }
 
 
 // store direction cell
 void MATRIX_ROUTING_HEAD::SetDir( int aRow, int aCol, int aSide, int x )
 {
-    DIR_CELL* p;
+    SEARCH_TILE*   tile  = searchTile( aRow, aCol, aSide );
+    int            cell  = tileCell( aRow, aCol );
+    int            shift = ( cell & 1 ) << 2;
+    unsigned char& dirs  = tile->m_Dir[cell >> 1];
+
+    dirs = ( dirs & ~( 0x0F << shift ) ) | ( ( x & 0x0F ) << shift );
+}
+
+
+bool MATRIX_ROUTING_HEAD::IsQueued( int aRow, int aCol, int aSide )
+{
+    const SEARCH_TILE* tile = m_SearchTiles[aSide][tileIndex( aRow, aCol )];
+
+    if( !tile )
+        return false;
+
+    int cell = tileCell( aRow, aCol );
 
-    p = RoutingMatrix.m_DirSide[aSide];
-    p[aRow * m_Ncols + aCol] = (char) x;
+    return ( tile->m_Queued[cell >> 6] >> ( cell & 63 ) ) & 1;
+}
+
+
+void MATRIX_ROUTING_HEAD::SetQueued( int aRow, int aCol, int aSide, bool aQueued )
+{
+    SEARCH_TILE* tile = searchTile( aRow, aCol, aSide );
+    int          cell = tileCell( aRow, aCol );
+    uint64_t     mask = (uint64_t) 1 << ( cell & 63 );
+
+    if( aQueued )
+        tile->m_Queued[cell >> 6] |= mask;
+    else
+        tile->m_Queued[cell >> 6] &= ~mask;
+}
+
+
+void MATRIX_ROUTING_HEAD::ClearSearch( bool aTwoSides )
+{
+    for( int side = BOTTOM; side >= TOP; side-- )
+    {
+        if( side == TOP && !aTwoSides )
+            break;
+
+        std::vector<int>& used = m_SearchTilesUsed[side];
+
+        for( unsigned ii = 0; ii < used.size(); ii++ )
+        {
+            SEARCH_TILE*& tile = m_SearchTiles[side][used[ii]];
+
+            memset( tile->m_Dir, FROM_NOWHERE, sizeof( tile->m_Dir ) );
+            memset( tile->m_Dist, 0xFF, sizeof( tile->m_Dist ) );
+            memset( tile->m_Queued, 0, sizeof( tile->m_Queued ) );
+            tile->m_DistBase = 0;
+
+            if( tile->m_WideDist )
+            {
+                delete[] tile->m_WideDist;
+                tile->m_WideDist = NULL;
+                addMemory( - (int) ( TILE_CELLS * sizeof(int) ) );
+            }
+
+            m_FreeSearchTiles.push_back( tile );
+            tile = NULL;
+        }
+
+        used.clear();
+    }
 }
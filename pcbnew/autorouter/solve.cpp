@@ -33,68 +33,53 @@
  * @file solve.cpp
  */
 
+#include <algorithm>
+
 #include <fctsys.h>
-#include <class_drawpanel.h>
-#include <confirm.h>
-#include <wxPcbStruct.h>
-#include <gr_basic.h>
 #include <macros.h>
 
 #include <class_board.h>
 #include <class_track.h>
 
 #include <pcbnew.h>
-#include <protos.h>
 #include <autorout.h>
 #include <cell.h>
 
 
-static int Autoroute_One_Track( PCB_EDIT_FRAME* pcbframe,
-                                wxDC*           DC,
-                                int             two_sides,
-                                int             row_source,
-                                int             col_source,
-                                int             row_target,
-                                int             col_target,
-                                RATSNEST_ITEM*  pt_rat );
-
-static int Retrace( PCB_EDIT_FRAME* pcbframe,
-                    wxDC*           DC,
-                    int,
-                    int,
-                    int,
-                    int,
-                    int,
-                    int              net_code );
-
-static void OrCell_Trace( BOARD* pcb,
-                          int    col,
-                          int    row,
-                          int    side,
-                          int    orient,
-                          int    current_net_code );
-
-static void AddNewTrace( PCB_EDIT_FRAME* pcbframe, wxDC* DC );
-
-
-static int            segm_oX, segm_oY;
-static int            segm_fX, segm_fY; /* Origin and position of the current
-                                         * trace segment. */
-static RATSNEST_ITEM* pt_cur_ch;
-static int            s_Clearance;  // Clearance value used in autorouter
-
-static PICKED_ITEMS_LIST s_ItemsListPicker;
-
-int OpenNodes;       // total number of nodes opened
-int ClosNodes;       // total number of nodes closed
-int MoveNodes;       // total number of nodes moved
-int MaxNodes;        // maximum number of nodes opened at one time
-
-#define NOSUCCESS       0
-#define STOP_FROM_ESC   -1
-#define ERR_MEMORY      -2
-#define SUCCESS         1
-#define TRIVIAL_SUCCESS 2
+/// An item of the work list, with the data of its search
+struct AR_ROUTE
+{
+    RATSNEST_ITEM*      m_Ratsnest;
+    int                 m_NetCode;
+    int                 m_RowSource, m_ColSource;
+    int                 m_RowTarget, m_ColTarget;
+
+    // Cells around the two pads, searched when the item is routed in a batch
+    int                 m_AreaRowMin, m_AreaColMin, m_AreaRowMax, m_AreaColMax;
+
+    // Cells searched: the area, or the whole matrix
+    int                 m_RowMin, m_ColMin, m_RowMax, m_ColMax;
+
+    MATRIX_ROUTING_HEAD m_Matrix;       // overlay of RoutingMatrix used by the search
+    bool                m_Searched;
+    int                 m_Result;
+    int                 m_TargetSide;   // side on which the search reached the target
+
+    int                 m_OpenNodes, m_ClosNodes, m_MoveNodes;
+
+    TRACK*              m_FirstTrack;   // tracks inserted in the board by the commit
+    int                 m_TrackCount;
+};
+
+
+/* Number of cells added around the pads of an item to build its area. Half of the size of
+ * the pads box is also added, so a long connection can make a longer detour.
+ */
+static const int AREA_MARGIN = 32;
+
+// Largest number of items routed in a batch
+static const unsigned MAX_BATCH = 16;
+
 
 /*
 ** visit neighboring cells like this (where [9] is on the other side):
@@ -229,24 +214,21 @@ static struct block blocking[8] =
       BLOCK_SOUTHWEST
   } };
 
+
 // mask for hole-related blocking effects
-static struct
-{
-    long trace;
-    int  present;
-} selfok2[8] =
+static const long selfok2[8] =
 {
-    { HOLE_NORTHWEST, 0 },
-    { HOLE_NORTH,     0 },
-    { HOLE_NORTHEAST, 0 },
-    { HOLE_WEST,      0 },
-    { HOLE_EAST,      0 },
-    { HOLE_SOUTHWEST, 0 },
-    { HOLE_SOUTH,     0 },
-    { HOLE_SOUTHEAST, 0 }
+    HOLE_NORTHWEST,
+    HOLE_NORTH,
+    HOLE_NORTHEAST,
+    HOLE_WEST,
+    HOLE_EAST,
+    HOLE_SOUTHWEST,
+    HOLE_SOUTH,
+    HOLE_SOUTHEAST
 };
 
-static long newmask[8] =
+static const long newmask[8] =
 {
     // patterns to mask out in neighbor cells
     0,
@@ -259,282 +241,79 @@ static long newmask[8] =
     0
 };
 
-
-/* Route all traces
- * :
- *  1 if OK
- * -1 if escape (stop being routed) request
- * -2 if default memory allocation
+/* Returns true if the areas of 2 items overlap, including the cells read around them
+ * when checking the place of a via.
  */
-int PCB_EDIT_FRAME::Solve( wxDC* DC, int aLayersCount )
+static bool areasOverlap( const AR_ROUTE& aRoute, const AR_ROUTE& aOther )
 {
-    int           current_net_code;
-    int           row_source, col_source, row_target, col_target;
-    int           success, nbsucces = 0, nbunsucces = 0;
-    NETINFO_ITEM* net;
-    bool          stop = false;
-    wxString      msg;
-    int           routedCount = 0;      // routed ratsnest count
-    bool          two_sides = aLayersCount == 2;
-
-    m_canvas->SetAbortRequest( false );
-
-    s_Clearance = GetBoard()->GetDesignSettings().GetDefault()->GetClearance();
-
-    // Prepare the undo command info
-    s_ItemsListPicker.ClearListAndDeleteItems();  // Should not be necessary, but...
-
-    // go until no more work to do
-    GetWork( &row_source, &col_source, &current_net_code,
-             &row_target, &col_target, &pt_cur_ch ); // First net to route.
-
-    for( ; row_source != ILLEGAL; GetWork( &row_source, &col_source,
-                                           &current_net_code, &row_target,
-                                           &col_target,
-                                           &pt_cur_ch ) )
-    {
-        // Test to stop routing ( escape key pressed )
-        wxYield();
-
-        if( m_canvas->GetAbortRequest() )
-        {
-            if( IsOK( this, _( "Abort routing?" ) ) )
-            {
-                success = STOP_FROM_ESC;
-                stop    = true;
-                break;
-            }
-            else
-            {
-                m_canvas->SetAbortRequest( false );
-            }
-        }
-
-        EraseMsgBox();
-
-        routedCount++;
-        net = GetBoard()->FindNet( current_net_code );
-
-        if( net )
-        {
-            msg.Printf( wxT( "[%8.8s]" ), GetChars( net->GetNetname() ) );
-            AppendMsgPanel( wxT( "Net route" ), msg, BROWN );
-            msg.Printf( wxT( "%d / %d" ), routedCount, RoutingMatrix.m_RouteCount );
-            AppendMsgPanel( wxT( "Activity" ), msg, BROWN );
-        }
-
-        segm_oX = GetBoard()->GetBoundingBox().GetX() + (RoutingMatrix.m_GridRouting * col_source);
-        segm_oY = GetBoard()->GetBoundingBox().GetY() + (RoutingMatrix.m_GridRouting * row_source);
-        segm_fX = GetBoard()->GetBoundingBox().GetX() + (RoutingMatrix.m_GridRouting * col_target);
-        segm_fY = GetBoard()->GetBoundingBox().GetY() + (RoutingMatrix.m_GridRouting * row_target);
-
-        // Draw segment.
-        GRLine( m_canvas->GetClipBox(), DC,
-                segm_oX, segm_oY, segm_fX, segm_fY,
-                0, WHITE );
-        pt_cur_ch->m_PadStart->Draw( m_canvas, DC, GR_OR | GR_HIGHLIGHT );
-        pt_cur_ch->m_PadEnd->Draw( m_canvas, DC, GR_OR | GR_HIGHLIGHT );
-
-        success = Autoroute_One_Track( this, DC,
-                                       two_sides, row_source, col_source,
-                                       row_target, col_target, pt_cur_ch );
-
-        switch( success )
-        {
-        case NOSUCCESS:
-            pt_cur_ch->m_Status |= CH_UNROUTABLE;
-            nbunsucces++;
-            break;
-
-        case STOP_FROM_ESC:
-            stop = true;
-            break;
-
-        case ERR_MEMORY:
-            stop = true;
-            break;
-
-        default:
-            nbsucces++;
-            break;
-        }
-
-        msg.Printf( wxT( "%d" ), nbsucces );
-        AppendMsgPanel( wxT( "OK" ), msg, GREEN );
-        msg.Printf( wxT( "%d" ), nbunsucces );
-        AppendMsgPanel( wxT( "Fail" ), msg, RED );
-        msg.Printf( wxT( "  %d" ), GetBoard()->GetUnconnectedNetCount() );
-        AppendMsgPanel( wxT( "Not Connected" ), msg, CYAN );
+    return aRoute.m_AreaRowMin <= aOther.m_AreaRowMax + 2
+           && aOther.m_AreaRowMin <= aRoute.m_AreaRowMax + 2
+           && aRoute.m_AreaColMin <= aOther.m_AreaColMax + 2
+           && aOther.m_AreaColMin <= aRoute.m_AreaColMax + 2;
+}
 
-        // Delete routing from display.
-        pt_cur_ch->m_PadStart->Draw( m_canvas, DC, GR_AND );
-        pt_cur_ch->m_PadEnd->Draw( m_canvas, DC, GR_AND );
 
-        if( stop )
-            break;
-    }
+/* Returns true if aPoint (a routing grid point) is inside aPad, so the pad can be
+ * reached from this point.
+ */
+static bool isGridPointInPad( D_PAD* aPad, const wxPoint& aPoint )
+{
+    int dx = aPad->GetSize().x / 2;
+    int dy = aPad->GetSize().y / 2;
+    int px = aPad->GetPosition().x;
+    int py = aPad->GetPosition().y;
 
-    SaveCopyInUndoList( s_ItemsListPicker, UR_UNSPECIFIED );
-    s_ItemsListPicker.ClearItemsList(); // s_ItemsListPicker is no more owner of picked items
+    if( ( ( int( aPad->GetOrientation() ) / 900 ) & 1 ) != 0 )
+        EXCHG( dx, dy );
 
-    return SUCCESS;
+    return ( abs( aPoint.x - px ) <= dx ) && ( abs( aPoint.y - py ) <= dy );
 }
 
 
-/* Route a trace on the BOARD.
- * Parameters:
- * 1 side / 2 sides (0 / 1)
- * Coord source (row, col)
- * Coord destination (row, col)
- * Net_code
- * Pointer to the ratsnest reference
+/* Search the path of an item on its overlay of the routing matrix, inside the rows and
+ * columns of aRoute (the via checks also read the cells just around them).
+ * This function only uses the data of aRoute and reads the (unmodified) routing matrix,
+ * so several items can be searched at the same time.
  *
  * Returns:
- * SUCCESS if routed
- * TRIVIAL_SUCCESS if pads are connected by overlay (no track needed)
- * If failure NOSUCCESS
- * Escape STOP_FROM_ESC if demand
+ * SUCCESS if a path was found, the target side is then stored in aRoute
+ * NOSUCCESS if there is no path
  * ERR_MEMORY if memory allocation failed.
  */
-static int Autoroute_One_Track( PCB_EDIT_FRAME* pcbframe,
-                                wxDC*           DC,
-                                int             two_sides,
-                                int             row_source,
-                                int             col_source,
-                                int             row_target,
-                                int             col_target,
-                                RATSNEST_ITEM*  pt_rat )
+static int searchRoute( AR_ROUTE& aRoute, bool two_sides )
 {
+    MATRIX_ROUTING_HEAD& matrix = aRoute.m_Matrix;
+    ROUTING_QUEUE queue( matrix );
     int          r, c, side, d, apx_dist, nr, nc;
     int          result, skip;
     int          i;
-    long         curcell, newcell, buddy, lastopen, lastclos, lastmove;
+    long         curcell, newcell, buddy;
     int          newdist, olddir, _self;
-    int          current_net_code;
-    int          marge;
-    LSET         padLayerMaskStart;    // Mask layers belonging to the starting pad.
-    LSET         padLayerMaskEnd;      // Mask layers belonging to the ending pad.
+    int          present[8];            // the hole of the current cell blocks this neighbor
+    int          row_source = aRoute.m_RowSource;
+    int          col_source = aRoute.m_ColSource;
+    int          row_target = aRoute.m_RowTarget;
+    int          col_target = aRoute.m_ColTarget;
+
+    LSET         padLayerMaskStart = aRoute.m_Ratsnest->m_PadStart->GetLayerSet();
+    LSET         padLayerMaskEnd = aRoute.m_Ratsnest->m_PadEnd->GetLayerSet();
 
     LSET         topLayerMask( g_Route_Layer_TOP );
 
     LSET         bottomLayerMask( g_Route_Layer_BOTTOM );
 
-    LSET         routeLayerMask;       // Mask two layers for routing.
-
     LSET         tab_mask[2];           // Enables the calculation of the mask layer being
                                         // tested. (side = TOP or BOTTOM)
-    int          start_mask_layer = 0;
-    wxString     msg;
-
-    // @todo this could be a bottle neck
-    LSET all_cu = LSET::AllCuMask( pcbframe->GetBoard()->GetCopperLayerCount() );
-
-    wxBusyCursor dummy_cursor;      // Set an hourglass cursor while routing a
-                                    // track
 
     result = NOSUCCESS;
 
-    marge = s_Clearance + ( pcbframe->GetDesignSettings().GetCurrentTrackWidth() / 2 );
-
-    // clear direction flags
-    i = RoutingMatrix.m_Nrows * RoutingMatrix.m_Ncols * sizeof(DIR_CELL);
-
-    if( two_sides )
-        memset( RoutingMatrix.m_DirSide[TOP], FROM_NOWHERE, i );
-    memset( RoutingMatrix.m_DirSide[BOTTOM], FROM_NOWHERE, i );
-
-    lastopen = lastclos = lastmove = 0;
-
     // Set tab_masque[side] for final test of routing.
     if( two_sides )
         tab_mask[TOP] = topLayerMask;
     tab_mask[BOTTOM] = bottomLayerMask;
 
-    // Set active layers mask.
-    routeLayerMask = topLayerMask | bottomLayerMask;
-
-    pt_cur_ch = pt_rat;
-
-    current_net_code  = pt_rat->GetNet();
-    padLayerMaskStart = pt_cur_ch->m_PadStart->GetLayerSet();
-
-    padLayerMaskEnd = pt_cur_ch->m_PadEnd->GetLayerSet();
-
-
-    /* First Test if routing possible ie if the pads are accessible
-     * on the routing layers.
-     */
-    if( ( routeLayerMask & padLayerMaskStart ) == 0 )
-        goto end_of_route;
-
-    if( ( routeLayerMask & padLayerMaskEnd ) == 0 )
-        goto end_of_route;
-
-    /* Then test if routing possible ie if the pads are accessible
-     * On the routing grid (1 grid point must be in the pad)
-     */
-    {
-        int cX = ( RoutingMatrix.m_GridRouting * col_source )
-                 + pcbframe->GetBoard()->GetBoundingBox().GetX();
-        int cY = ( RoutingMatrix.m_GridRouting * row_source )
-                 + pcbframe->GetBoard()->GetBoundingBox().GetY();
-        int dx = pt_cur_ch->m_PadStart->GetSize().x / 2;
-        int dy = pt_cur_ch->m_PadStart->GetSize().y / 2;
-        int px = pt_cur_ch->m_PadStart->GetPosition().x;
-        int py = pt_cur_ch->m_PadStart->GetPosition().y;
-
-        if( ( ( int( pt_cur_ch->m_PadStart->GetOrientation() ) / 900 ) & 1 ) != 0 )
-            EXCHG( dx, dy );
-
-        if( ( abs( cX - px ) > dx ) || ( abs( cY - py ) > dy ) )
-            goto end_of_route;
-
-        cX = ( RoutingMatrix.m_GridRouting * col_target )
-             + pcbframe->GetBoard()->GetBoundingBox().GetX();
-        cY = ( RoutingMatrix.m_GridRouting * row_target )
-             + pcbframe->GetBoard()->GetBoundingBox().GetY();
-        dx = pt_cur_ch->m_PadEnd->GetSize().x / 2;
-        dy = pt_cur_ch->m_PadEnd->GetSize().y / 2;
-        px = pt_cur_ch->m_PadEnd->GetPosition().x;
-        py = pt_cur_ch->m_PadEnd->GetPosition().y;
-
-        if( ( ( int( pt_cur_ch->m_PadEnd->GetOrientation() ) / 900) & 1 ) != 0 )
-            EXCHG( dx, dy );
-
-        if( ( abs( cX - px ) > dx ) || ( abs( cY - py ) > dy ) )
-            goto end_of_route;
-    }
-
-    // Test the trivial case: direct connection overlay pads.
-    if( row_source == row_target  && col_source == col_target &&
-            ( padLayerMaskEnd & padLayerMaskStart & all_cu ).any() )
-    {
-        result = TRIVIAL_SUCCESS;
-        goto end_of_route;
-    }
-
-    // Placing the bit to remove obstacles on 2 pads to a link.
-    pcbframe->SetStatusText( wxT( "Gen Cells" ) );
-
-    PlacePad( pt_cur_ch->m_PadStart, CURRENT_PAD, marge, WRITE_OR_CELL );
-    PlacePad( pt_cur_ch->m_PadEnd, CURRENT_PAD, marge, WRITE_OR_CELL );
-
-    // Regenerates the remaining barriers (which may encroach on the
-    // placement bits precedent)
-    i = pcbframe->GetBoard()->GetPadCount();
-
-    for( unsigned ii = 0; ii < pcbframe->GetBoard()->GetPadCount(); ii++ )
-    {
-        D_PAD* ptr = pcbframe->GetBoard()->GetPad( ii );
-
-        if( ( pt_cur_ch->m_PadStart != ptr ) && ( pt_cur_ch->m_PadEnd != ptr ) )
-        {
-            PlacePad( ptr, ~CURRENT_PAD, marge, WRITE_AND_CELL );
-        }
-    }
-
-    InitQueue(); // initialize the search queue
-    apx_dist = RoutingMatrix.GetApxDist( row_source, col_source, row_target, col_target );
+    queue.InitQueue(); // initialize the search queue
+    apx_dist = matrix.GetApxDist( row_source, col_source, row_target, col_target );
 
     // Initialize first search.
     if( two_sides )   // Preferred orientation.
@@ -543,10 +322,8 @@ static int Autoroute_One_Track( PCB_EDIT_FRAME* pcbframe,
         {
             if( ( padLayerMaskStart & topLayerMask ).any() )
             {
-                start_mask_layer = 2;
-
-                if( SetQueue( row_source, col_source, TOP, 0, apx_dist,
-                              row_target, col_target ) == 0 )
+                if( queue.SetQueue( row_source, col_source, TOP, 0, apx_dist,
+                                    row_target, col_target ) == 0 )
                 {
                     return ERR_MEMORY;
                 }
@@ -554,10 +331,8 @@ static int Autoroute_One_Track( PCB_EDIT_FRAME* pcbframe,
 
             if( ( padLayerMaskStart & bottomLayerMask ).any() )
             {
-                start_mask_layer |= 1;
-
-                if( SetQueue( row_source, col_source, BOTTOM, 0, apx_dist,
-                              row_target, col_target ) == 0 )
+                if( queue.SetQueue( row_source, col_source, BOTTOM, 0, apx_dist,
+                                    row_target, col_target ) == 0 )
                 {
                     return ERR_MEMORY;
                 }
@@ -567,10 +342,8 @@ static int Autoroute_One_Track( PCB_EDIT_FRAME* pcbframe,
         {
             if( ( padLayerMaskStart & bottomLayerMask ).any() )
             {
-                start_mask_layer = 1;
-
-                if( SetQueue( row_source, col_source, BOTTOM, 0, apx_dist,
-                              row_target, col_target ) == 0 )
+                if( queue.SetQueue( row_source, col_source, BOTTOM, 0, apx_dist,
+                                    row_target, col_target ) == 0 )
                 {
                     return ERR_MEMORY;
                 }
@@ -578,10 +351,8 @@ static int Autoroute_One_Track( PCB_EDIT_FRAME* pcbframe,
 
             if( ( padLayerMaskStart & topLayerMask ).any() )
             {
-                start_mask_layer |= 2;
-
-                if( SetQueue( row_source, col_source, TOP, 0, apx_dist,
-                              row_target, col_target ) == 0 )
+                if( queue.SetQueue( row_source, col_source, TOP, 0, apx_dist,
+                                    row_target, col_target ) == 0 )
                 {
                     return ERR_MEMORY;
                 }
@@ -590,20 +361,19 @@ static int Autoroute_One_Track( PCB_EDIT_FRAME* pcbframe,
     }
     else if( ( padLayerMaskStart & bottomLayerMask ).any() )
     {
-        start_mask_layer = 1;
-
-        if( SetQueue( row_source, col_source, BOTTOM, 0, apx_dist, row_target, col_target ) == 0 )
+        if( queue.SetQueue( row_source, col_source, BOTTOM, 0, apx_dist,
+                            row_target, col_target ) == 0 )
         {
             return ERR_MEMORY;
         }
     }
 
     // search until success or we exhaust all possibilities
-    GetQueue( &r, &c, &side, &d, &apx_dist );
+    queue.GetQueue( &r, &c, &side, &d, &apx_dist );
 
-    for( ; r != ILLEGAL; GetQueue( &r, &c, &side, &d, &apx_dist ) )
+    for( ; r != ILLEGAL; queue.GetQueue( &r, &c, &side, &d, &apx_dist ) )
     {
-        curcell = RoutingMatrix.GetCell( r, c, side );
+        curcell = matrix.GetCell( r, c, side );
 
         if( curcell & CURRENT_PAD )
             curcell &= ~HOLE;
@@ -611,48 +381,11 @@ static int Autoroute_One_Track( PCB_EDIT_FRAME* pcbframe,
         if( (r == row_target) && (c == col_target)  // success if layer OK
            && (tab_mask[side] & padLayerMaskEnd).any() )
         {
-            // Remove link.
-            GRSetDrawMode( DC, GR_XOR );
-            GRLine( pcbframe->GetCanvas()->GetClipBox(),
-                    DC,
-                    segm_oX,
-                    segm_oY,
-                    segm_fX,
-                    segm_fY,
-                    0,
-                    WHITE );
-
-            // Generate trace.
-            if( Retrace( pcbframe, DC, row_source, col_source,
-                         row_target, col_target, side, current_net_code ) )
-            {
-                result = SUCCESS;   // Success : Route OK
-            }
-
+            aRoute.m_TargetSide = side;
+            result = SUCCESS;       // Success : Route OK
             break;                  // Routing complete.
         }
 
-        if( pcbframe->GetCanvas()->GetAbortRequest() )
-        {
-            result = STOP_FROM_ESC;
-            break;
-        }
-
-        // report every COUNT new nodes or so
-        #define COUNT 20000
-
-        if( ( OpenNodes - lastopen > COUNT )
-           || ( ClosNodes - lastclos > COUNT )
-           || ( MoveNodes - lastmove > COUNT ) )
-        {
-            lastopen = OpenNodes;
-            lastclos = ClosNodes;
-            lastmove = MoveNodes;
-            msg.Printf( wxT( "Activity: Open %d   Closed %d   Moved %d" ),
-                        OpenNodes, ClosNodes, MoveNodes );
-            pcbframe->SetStatusText( msg );
-        }
-
         _self = 0;
 
         if( curcell & HOLE )
@@ -662,10 +395,10 @@ static int Autoroute_One_Track( PCB_EDIT_FRAME* pcbframe,
             // set 'present' bits
             for( i = 0; i < 8; i++ )
             {
-                selfok2[i].present = 0;
+                present[i] = 0;
 
-                if( curcell & selfok2[i].trace )
-                    selfok2[i].present = 1;
+                if( curcell & selfok2[i] )
+                    present[i] = 1;
             }
         }
 
@@ -675,14 +408,14 @@ static int Autoroute_One_Track( PCB_EDIT_FRAME* pcbframe,
             nc = c + delta[i][1];
 
             // off the edge?
-            if( nr < 0 || nr >= RoutingMatrix.m_Nrows ||
-                nc < 0 || nc >= RoutingMatrix.m_Ncols )
+            if( nr < aRoute.m_RowMin || nr > aRoute.m_RowMax ||
+                nc < aRoute.m_ColMin || nc > aRoute.m_ColMax )
                 continue;  // off the edge
 
-            if( _self == 5 && selfok2[i].present )
+            if( _self == 5 && present[i] )
                 continue;
 
-            newcell = RoutingMatrix.GetCell( nr, nc, side );
+            newcell = matrix.GetCell( nr, nc, side );
 
             if( newcell & CURRENT_PAD )
                 newcell &= ~HOLE;
@@ -703,7 +436,7 @@ static int Autoroute_One_Track( PCB_EDIT_FRAME* pcbframe,
             if( delta[i][0] && delta[i][1] )
             {
                 // check first buddy
-                buddy = RoutingMatrix.GetCell( r + blocking[i].r1, c + blocking[i].c1, side );
+                buddy = matrix.GetCell( r + blocking[i].r1, c + blocking[i].c1, side );
 
                 if( buddy & CURRENT_PAD )
                     buddy &= ~HOLE;
@@ -713,7 +446,7 @@ static int Autoroute_One_Track( PCB_EDIT_FRAME* pcbframe,
 
 //              if (buddy & (blocking[i].b1)) continue;
                 // check second buddy
-                buddy = RoutingMatrix.GetCell( r + blocking[i].r2, c + blocking[i].c2, side );
+                buddy = matrix.GetCell( r + blocking[i].r2, c + blocking[i].c2, side );
 
                 if( buddy & CURRENT_PAD )
                     buddy &= ~HOLE;
@@ -724,39 +457,39 @@ static int Autoroute_One_Track( PCB_EDIT_FRAME* pcbframe,
 //              if (buddy & (blocking[i].b2)) continue;
             }
 
-            olddir  = RoutingMatrix.GetDir( r, c, side );
-            newdist = d + RoutingMatrix.CalcDist( ndir[i], olddir,
+            olddir  = matrix.GetDir( r, c, side );
+            newdist = d + matrix.CalcDist( ndir[i], olddir,
                                     ( olddir == FROM_OTHERSIDE ) ?
-                                    RoutingMatrix.GetDir( r, c, 1 - side ) : 0, side );
+                                    matrix.GetDir( r, c, 1 - side ) : 0, side );
 
             // if (a) not visited yet, or (b) we have
             // found a better path, add it to queue
-            if( !RoutingMatrix.GetDir( nr, nc, side ) )
+            if( !matrix.GetDir( nr, nc, side ) )
             {
-                RoutingMatrix.SetDir( nr, nc, side, ndir[i] );
-                RoutingMatrix.SetDist( nr, nc, side, newdist );
+                matrix.SetDir( nr, nc, side, ndir[i] );
+                matrix.SetDist( nr, nc, side, newdist );
 
-                if( SetQueue( nr, nc, side, newdist,
-                              RoutingMatrix.GetApxDist( nr, nc, row_target, col_target ),
-                              row_target, col_target ) == 0 )
+                if( queue.SetQueue( nr, nc, side, newdist,
+                                    matrix.GetApxDist( nr, nc, row_target, col_target ),
+                                    row_target, col_target ) == 0 )
                 {
                     return ERR_MEMORY;
                 }
             }
-            else if( newdist < RoutingMatrix.GetDist( nr, nc, side ) )
+            else if( newdist < matrix.GetDist( nr, nc, side ) )
             {
-                RoutingMatrix.SetDir( nr, nc, side, ndir[i] );
-                RoutingMatrix.SetDist( nr, nc, side, newdist );
-                ReSetQueue( nr, nc, side, newdist,
-                            RoutingMatrix.GetApxDist( nr, nc, row_target, col_target ),
-                            row_target, col_target );
+                matrix.SetDir( nr, nc, side, ndir[i] );
+                matrix.SetDist( nr, nc, side, newdist );
+                queue.ReSetQueue( nr, nc, side, newdist,
+                                  matrix.GetApxDist( nr, nc, row_target, col_target ),
+                                  row_target, col_target );
             }
         }
 
         //* Test the other layer. *
         if( two_sides )
         {
-            olddir = RoutingMatrix.GetDir( r, c, side );
+            olddir = matrix.GetDir( r, c, side );
 
             if( olddir == FROM_OTHERSIDE )
                 continue;   // useless move, so don't bother
@@ -765,7 +498,7 @@ static int Autoroute_One_Track( PCB_EDIT_FRAME* pcbframe,
                 continue;
 
             // check for holes or traces on other side
-            if( ( newcell = RoutingMatrix.GetCell( r, c, 1 - side ) ) != 0 )
+            if( ( newcell = matrix.GetCell( r, c, 1 - side ) ) != 0 )
                 continue;
 
             // check for nearby holes or traces on both sides
@@ -773,17 +506,17 @@ static int Autoroute_One_Track( PCB_EDIT_FRAME* pcbframe,
             {
                 nr = r + delta[i][0]; nc = c + delta[i][1];
 
-                if( nr < 0 || nr >= RoutingMatrix.m_Nrows ||
-                    nc < 0 || nc >= RoutingMatrix.m_Ncols )
+                if( nr < 0 || nr >= matrix.m_Nrows ||
+                    nc < 0 || nc >= matrix.m_Ncols )
                     continue;  // off the edge !!
 
-                if( RoutingMatrix.GetCell( nr, nc, side ) /* & blocking2[i] */ )
+                if( matrix.GetCell( nr, nc, side ) /* & blocking2[i] */ )
                 {
                     skip = 1; // can't drill via here
                     break;
                 }
 
-                if( RoutingMatrix.GetCell( nr, nc, 1 - side ) /* & blocking2[i] */ )
+                if( matrix.GetCell( nr, nc, 1 - side ) /* & blocking2[i] */ )
                 {
                     skip = 1; // can't drill via here
                     break;
@@ -793,47 +526,362 @@ static int Autoroute_One_Track( PCB_EDIT_FRAME* pcbframe,
             if( skip )      // neighboring hole or trace?
                 continue;   // yes, can't drill via here
 
-            newdist = d + RoutingMatrix.CalcDist( FROM_OTHERSIDE, olddir, 0, side );
+            newdist = d + matrix.CalcDist( FROM_OTHERSIDE, olddir, 0, side );
 
             /*  if (a) not visited yet,
              *  or (b) we have found a better path,
              *  add it to queue */
-            if( !RoutingMatrix.GetDir( r, c, 1 - side ) )
+            if( !matrix.GetDir( r, c, 1 - side ) )
             {
-                RoutingMatrix.SetDir( r, c, 1 - side, FROM_OTHERSIDE );
-                RoutingMatrix.SetDist( r, c, 1 - side, newdist );
+                matrix.SetDir( r, c, 1 - side, FROM_OTHERSIDE );
+                matrix.SetDist( r, c, 1 - side, newdist );
 
-                if( SetQueue( r, c, 1 - side, newdist, apx_dist, row_target, col_target ) == 0 )
+                if( queue.SetQueue( r, c, 1 - side, newdist, apx_dist,
+                                    row_target, col_target ) == 0 )
                 {
                     return ERR_MEMORY;
                 }
             }
-            else if( newdist < RoutingMatrix.GetDist( r, c, 1 - side ) )
+            else if( newdist < matrix.GetDist( r, c, 1 - side ) )
             {
-                RoutingMatrix.SetDir( r, c, 1 - side, FROM_OTHERSIDE );
-                RoutingMatrix.SetDist( r, c, 1 - side, newdist );
-                ReSetQueue( r, c,
-                            1 - side,
-                            newdist,
-                            apx_dist,
-                            row_target,
-                            col_target );
+                matrix.SetDir( r, c, 1 - side, FROM_OTHERSIDE );
+                matrix.SetDist( r, c, 1 - side, newdist );
+                queue.ReSetQueue( r, c,
+                                  1 - side,
+                                  newdist,
+                                  apx_dist,
+                                  row_target,
+                                  col_target );
             }
         }     // Finished attempt to route on other layer.
     }
 
-end_of_route:
-    PlacePad( pt_cur_ch->m_PadStart, ~CURRENT_PAD, marge, WRITE_AND_CELL );
-    PlacePad( pt_cur_ch->m_PadEnd, ~CURRENT_PAD, marge, WRITE_AND_CELL );
-
-    msg.Printf( wxT( "Activity: Open %d   Closed %d   Moved %d"),
-                OpenNodes, ClosNodes, MoveNodes );
-    pcbframe->SetStatusText( msg );
+    aRoute.m_OpenNodes = queue.m_OpenNodes;
+    aRoute.m_ClosNodes = queue.m_ClosNodes;
+    aRoute.m_MoveNodes = queue.m_MoveNodes;
 
     return result;
 }
 
 
+AR_SOLVER::AR_SOLVER( BOARD* aBoard ) :
+    m_RoutedCount( 0 ),
+    m_FailedCount( 0 ),
+    m_RetryCount( 0 ),
+    m_MemPeak( 0 ),
+    m_OpenNodes( 0 ),
+    m_ClosNodes( 0 ),
+    m_MoveNodes( 0 ),
+    m_board( aBoard ),
+    m_twoSides( false ),
+    m_clearance( 0 ),
+    m_marge( 0 ),
+    m_viaMarge( 0 )
+{
+}
+
+
+AR_SOLVER::~AR_SOLVER()
+{
+}
+
+
+int AR_SOLVER::Solve( int aLayersCount, bool aConcurrent )
+{
+    std::vector<AR_ROUTE*> batch;
+    int    status = SUCCESS;
+
+    m_twoSides  = aLayersCount == 2;
+    m_origin    = m_board->GetBoundingBox().GetOrigin();
+    m_clearance = m_board->GetDesignSettings().GetDefault()->GetClearance();
+    m_marge     = m_clearance + ( m_board->GetDesignSettings().GetCurrentTrackWidth() / 2 );
+    m_viaMarge  = m_clearance + ( m_board->GetDesignSettings().GetCurrentViaSize() / 2 );
+
+    // go until no more work to do
+    AR_ROUTE* next = nextRoute();
+
+    while( next && status == SUCCESS )
+    {
+        // Take the next items of the work list as long as their areas are separate
+        batch.clear();
+        batch.push_back( next );
+        next = nextRoute();
+
+        while( aConcurrent && next && batch.size() < MAX_BATCH )
+        {
+            unsigned ii;
+
+            for( ii = 0; ii < batch.size(); ii++ )
+            {
+                if( areasOverlap( *batch[ii], *next ) )
+                    break;
+            }
+
+            if( ii < batch.size() )
+                break;
+
+            batch.push_back( next );
+            next = nextRoute();
+        }
+
+        // A batch of 1 item is searched on the whole matrix, like without batches
+        bool     confined = batch.size() > 1;
+        unsigned batchStart = RoutingMatrix.GetWriteCount();
+        int      count = batch.size();
+        int      ii;
+
+        for( ii = 0; ii < count; ii++ )
+            batch[ii]->m_Searched = prepare( *batch[ii], confined );
+
+#ifdef USE_OPENMP
+        #pragma omp parallel for schedule(dynamic, 1) private(ii)
+#endif /* USE_OPENMP */
+        for( ii = 0; ii < count; ii++ )
+        {
+            if( batch[ii]->m_Searched )
+                batch[ii]->m_Result = searchRoute( *batch[ii], m_twoSides );
+        }
+
+        updateMemPeak( batch );
+
+        // Commit the items in the work list order
+        for( ii = 0; ii < count && status == SUCCESS; ii++ )
+        {
+            AR_ROUTE& route = *batch[ii];
+            wxPoint   start( m_origin.x + RoutingMatrix.m_GridRouting * route.m_ColSource,
+                             m_origin.y + RoutingMatrix.m_GridRouting * route.m_RowSource );
+            wxPoint   end( m_origin.x + RoutingMatrix.m_GridRouting * route.m_ColTarget,
+                           m_origin.y + RoutingMatrix.m_GridRouting * route.m_RowTarget );
+
+            if( !onStartItem( route.m_Ratsnest, start, end ) )
+            {
+                status = STOP_FROM_ESC;
+                break;
+            }
+
+            /* Search the item again on the whole matrix if it was not found in its area,
+             * or if the tracks committed before it changed the cells read by its search.
+             */
+            if( confined && route.m_Searched
+                && ( route.m_Result == NOSUCCESS
+                     || RoutingMatrix.IsModifiedSince( route.m_AreaRowMin - 1,
+                                                       route.m_AreaColMin - 1,
+                                                       route.m_AreaRowMax + 1,
+                                                       route.m_AreaColMax + 1,
+                                                       batchStart ) ) )
+            {
+                m_RetryCount++;
+
+                if( prepare( route, false ) )
+                {
+                    route.m_Result = searchRoute( route, m_twoSides );
+                    updateMemPeak( batch );
+                }
+            }
+
+            if( route.m_Result == SUCCESS && !commit( route ) )
+                route.m_Result = NOSUCCESS;
+
+            m_OpenNodes = route.m_OpenNodes;
+            m_ClosNodes = route.m_ClosNodes;
+            m_MoveNodes = route.m_MoveNodes;
+
+            switch( route.m_Result )
+            {
+            case NOSUCCESS:
+                route.m_Ratsnest->m_Status |= CH_UNROUTABLE;
+                m_FailedCount++;
+                break;
+
+            case ERR_MEMORY:
+                status = ERR_MEMORY;
+                break;
+
+            default:
+                m_RoutedCount++;
+                break;
+            }
+
+            onItemDone( route.m_Ratsnest, route.m_Result, route.m_FirstTrack,
+                        route.m_TrackCount );
+
+            // The search data is no more needed
+            route.m_Matrix.UnInitRoutingMatrix();
+        }
+
+        for( ii = 0; ii < count; ii++ )
+            delete batch[ii];
+    }
+
+    delete next;
+
+    return status;
+}
+
+
+AR_ROUTE* AR_SOLVER::nextRoute()
+{
+    AR_ROUTE* route = new AR_ROUTE;
+
+    GetWork( &route->m_RowSource, &route->m_ColSource, &route->m_NetCode,
+             &route->m_RowTarget, &route->m_ColTarget, &route->m_Ratsnest );
+
+    if( route->m_RowSource == ILLEGAL )
+    {
+        delete route;
+        return NULL;
+    }
+
+    route->m_Searched   = false;
+    route->m_Result     = NOSUCCESS;
+    route->m_TargetSide = BOTTOM;
+    route->m_OpenNodes  = route->m_ClosNodes = route->m_MoveNodes = 0;
+    route->m_FirstTrack = NULL;
+    route->m_TrackCount = 0;
+
+    // The area: the cells of the 2 pads and their clearance, plus a margin for the detours
+    EDA_RECT box = route->m_Ratsnest->m_PadStart->GetBoundingBox();
+
+    box.Merge( route->m_Ratsnest->m_PadEnd->GetBoundingBox() );
+    box.Inflate( m_marge );
+
+    int grid   = RoutingMatrix.m_GridRouting;
+    int margin = AREA_MARGIN + ( box.GetWidth() + box.GetHeight() ) / ( 4 * grid );
+
+    route->m_AreaRowMin = std::min( route->m_RowSource, route->m_RowTarget );
+    route->m_AreaColMin = std::min( route->m_ColSource, route->m_ColTarget );
+    route->m_AreaRowMax = std::max( route->m_RowSource, route->m_RowTarget );
+    route->m_AreaColMax = std::max( route->m_ColSource, route->m_ColTarget );
+
+    route->m_AreaRowMin = std::min( route->m_AreaRowMin, ( box.GetY() - m_origin.y ) / grid );
+    route->m_AreaColMin = std::min( route->m_AreaColMin, ( box.GetX() - m_origin.x ) / grid );
+    route->m_AreaRowMax = std::max( route->m_AreaRowMax, ( box.GetBottom() - m_origin.y ) / grid );
+    route->m_AreaColMax = std::max( route->m_AreaColMax, ( box.GetRight() - m_origin.x ) / grid );
+
+    route->m_AreaRowMin = std::max( route->m_AreaRowMin - margin, 0 );
+    route->m_AreaColMin = std::max( route->m_AreaColMin - margin, 0 );
+    route->m_AreaRowMax = std::min( route->m_AreaRowMax + margin, RoutingMatrix.m_Nrows - 1 );
+    route->m_AreaColMax = std::min( route->m_AreaColMax + margin, RoutingMatrix.m_Ncols - 1 );
+
+    return route;
+}
+
+
+bool AR_SOLVER::prepare( AR_ROUTE& aRoute, bool aConfined )
+{
+    RATSNEST_ITEM* rat = aRoute.m_Ratsnest;
+    LSET           padLayerMaskStart = rat->m_PadStart->GetLayerSet();
+    LSET           padLayerMaskEnd = rat->m_PadEnd->GetLayerSet();
+    LSET           routeLayerMask = LSET( g_Route_Layer_TOP ) | LSET( g_Route_Layer_BOTTOM );
+    LSET           all_cu = LSET::AllCuMask( m_board->GetCopperLayerCount() );
+    int            grid = RoutingMatrix.m_GridRouting;
+
+    aRoute.m_Result = NOSUCCESS;
+
+    /* First Test if routing possible ie if the pads are accessible
+     * on the routing layers.
+     */
+    if( ( routeLayerMask & padLayerMaskStart ) == 0 )
+        return false;
+
+    if( ( routeLayerMask & padLayerMaskEnd ) == 0 )
+        return false;
+
+    /* Then test if routing possible ie if the pads are accessible
+     * On the routing grid (1 grid point must be in the pad)
+     */
+    if( !isGridPointInPad( rat->m_PadStart,
+                           wxPoint( m_origin.x + grid * aRoute.m_ColSource,
+                                    m_origin.y + grid * aRoute.m_RowSource ) ) )
+        return false;
+
+    if( !isGridPointInPad( rat->m_PadEnd,
+                           wxPoint( m_origin.x + grid * aRoute.m_ColTarget,
+                                    m_origin.y + grid * aRoute.m_RowTarget ) ) )
+        return false;
+
+    // Test the trivial case: direct connection overlay pads.
+    if( aRoute.m_RowSource == aRoute.m_RowTarget && aRoute.m_ColSource == aRoute.m_ColTarget
+        && ( padLayerMaskEnd & padLayerMaskStart & all_cu ).any() )
+    {
+        aRoute.m_Result = TRIVIAL_SUCCESS;
+        return false;
+    }
+
+    if( aConfined )
+    {
+        aRoute.m_RowMin = aRoute.m_AreaRowMin;
+        aRoute.m_ColMin = aRoute.m_AreaColMin;
+        aRoute.m_RowMax = aRoute.m_AreaRowMax;
+        aRoute.m_ColMax = aRoute.m_AreaColMax;
+    }
+    else
+    {
+        aRoute.m_RowMin = aRoute.m_ColMin = 0;
+        aRoute.m_RowMax = RoutingMatrix.m_Nrows - 1;
+        aRoute.m_ColMax = RoutingMatrix.m_Ncols - 1;
+    }
+
+    // The pads of the item are drawn on its overlay, RoutingMatrix is not modified
+    aRoute.m_Matrix.InitOverlay( RoutingMatrix );
+    RoutingMatrix.SetWriteTarget( &aRoute.m_Matrix );
+
+    // Placing the bit to remove obstacles on 2 pads to a link.
+    PlacePad( rat->m_PadStart, CURRENT_PAD, m_marge, WRITE_OR_CELL );
+    PlacePad( rat->m_PadEnd, CURRENT_PAD, m_marge, WRITE_OR_CELL );
+
+    // Regenerates the remaining barriers (which may encroach on the
+    // placement bits precedent). Only the pads near the 2 pads can do it.
+    EDA_RECT padsBox = rat->m_PadStart->GetBoundingBox();
+
+    padsBox.Merge( rat->m_PadEnd->GetBoundingBox() );
+    padsBox.Inflate( m_marge + grid );
+
+    for( unsigned ii = 0; ii < m_board->GetPadCount(); ii++ )
+    {
+        D_PAD* ptr = m_board->GetPad( ii );
+
+        if( ( rat->m_PadStart == ptr ) || ( rat->m_PadEnd == ptr ) )
+            continue;
+
+        EDA_RECT padBox = ptr->GetBoundingBox();
+
+        if( padBox.Inflate( m_marge ).Intersects( padsBox ) )
+            PlacePad( ptr, ~CURRENT_PAD, m_marge, WRITE_AND_CELL );
+    }
+
+    RoutingMatrix.SetWriteTarget( NULL );
+
+    return true;
+}
+
+
+bool AR_SOLVER::commit( AR_ROUTE& aRoute )
+{
+    wxASSERT( m_newTracks.GetCount() == 0 );
+
+    if( !retrace( aRoute ) )
+    {
+        m_newTracks.DeleteAll();
+        return false;
+    }
+
+    addNewTrace( aRoute );
+    return true;
+}
+
+
+void AR_SOLVER::updateMemPeak( const std::vector<AR_ROUTE*>& aBatch )
+{
+    int memSize = RoutingMatrix.m_MemSize;
+
+    for( unsigned ii = 0; ii < aBatch.size(); ii++ )
+        memSize += aBatch[ii]->m_Matrix.m_MemSize;
+
+    m_MemPeak = std::max( m_MemPeak, memSize );
+}
+
+
 static long bit[8][9] =
 {
     // OT=Otherside
@@ -935,27 +983,25 @@ static long bit[8][9] =
     }
 };
 
-
 /* work from target back to source, actually laying the traces
  *  Parameters:
- *      start on side target_side, of coordinates row_target, col_target.
+ *      start on the target side of aRoute, of coordinates row_target, col_target.
  *      arrive on side masque_layer_start, coordinate row_source, col_source
  * The search is done in reverse routing, the point of arrival (target) to
  * the starting point (source)
  * The router.
  *
- * Target_side = symbol (TOP / BOTTOM) of departure
- * = Mask_layer_source mask layers Arrival
- *
  * Returns:
  * 0 if error
  * > 0 if Ok
  */
-static int Retrace( PCB_EDIT_FRAME* pcbframe, wxDC* DC,
-                    int row_source, int col_source,
-                    int row_target, int col_target, int target_side,
-                    int current_net_code )
+int AR_SOLVER::retrace( AR_ROUTE& aRoute )
 {
+    MATRIX_ROUTING_HEAD& matrix = aRoute.m_Matrix;
+    int  row_source = aRoute.m_RowSource;
+    int  col_source = aRoute.m_ColSource;
+    int  row_target = aRoute.m_RowTarget;
+    int  col_target = aRoute.m_ColTarget;
     int  r0, c0, s0;
     int  r1, c1, s1;    // row, col, starting side.
     int  r2, c2, s2;    // row, col, ending side.
@@ -964,16 +1010,14 @@ static int Retrace( PCB_EDIT_FRAME* pcbframe, wxDC* DC,
 
     r1 = row_target;
     c1 = col_target;    // start point is target ( end point is source )
-    s1 = target_side;
+    s1 = aRoute.m_TargetSide;
     r0 = c0 = s0 = ILLEGAL;
 
-    wxASSERT( g_CurrentTrackList.GetCount() == 0 );
-
     do
     {
         // find where we came from to get here
         r2 = r1; c2 = c1; s2 = s1;
-        x  = RoutingMatrix.GetDir( r1, c1, s1 );
+        x  = matrix.GetDir( r1, c1, s1 );
 
         switch( x )
         {
@@ -1018,12 +1062,12 @@ static int Retrace( PCB_EDIT_FRAME* pcbframe, wxDC* DC,
             break;
 
         default:
-            wxMessageBox( wxT( "Retrace: internal error: no way back" ) );
+            onError( wxT( "Retrace: internal error: no way back" ) );
             return 0;
         }
 
         if( r0 != ILLEGAL )
-            y = RoutingMatrix.GetDir( r0, c0, s0 );
+            y = matrix.GetDir( r0, c0, s0 );
 
         // see if target or hole
         if( ( ( r1 == row_target ) && ( c1 == col_target ) ) || ( s1 != s0 ) )
@@ -1066,11 +1110,11 @@ static int Retrace( PCB_EDIT_FRAME* pcbframe, wxDC* DC,
 
             case FROM_OTHERSIDE:
             default:
-                DisplayError( pcbframe, wxT( "Retrace: error 1" ) );
+                onError( wxT( "Retrace: error 1" ) );
                 return 0;
             }
 
-            OrCell_Trace( pcbframe->GetBoard(), r1, c1, s1, p_dir, current_net_code );
+            orCellTrace( aRoute, r1, c1, s1, p_dir );
         }
         else
         {
@@ -1085,14 +1129,14 @@ static int Retrace( PCB_EDIT_FRAME* pcbframe, wxDC* DC,
                     || x == FROM_OTHERSIDE )
                && ( ( b = bit[y - 1][x - 1] ) != 0 ) )
             {
-                OrCell_Trace( pcbframe->GetBoard(), r1, c1, s1, b, current_net_code );
+                orCellTrace( aRoute, r1, c1, s1, b );
 
                 if( b & HOLE )
-                    OrCell_Trace( pcbframe->GetBoard(), r2, c2, s2, HOLE, current_net_code );
+                    orCellTrace( aRoute, r2, c2, s2, HOLE );
             }
             else
             {
-                wxMessageBox( wxT( "Retrace: error 2" ) );
+                onError( wxT( "Retrace: error 2" ) );
                 return 0;
             }
         }
@@ -1137,11 +1181,11 @@ static int Retrace( PCB_EDIT_FRAME* pcbframe, wxDC* DC,
 
             case FROM_OTHERSIDE:
             default:
-                wxMessageBox( wxT( "Retrace: error 3" ) );
+                onError( wxT( "Retrace: error 3" ) );
                 return 0;
             }
 
-            OrCell_Trace( pcbframe->GetBoard(), r2, c2, s2, p_dir, current_net_code );
+            orCellTrace( aRoute, r2, c2, s2, p_dir );
         }
 
         // move to next cell
@@ -1153,111 +1197,107 @@ static int Retrace( PCB_EDIT_FRAME* pcbframe, wxDC* DC,
         s1 = s2;
     } while( !( ( r2 == row_source ) && ( c2 == col_source ) ) );
 
-    AddNewTrace( pcbframe, DC );
     return 1;
 }
 
 
-/* This function is used by Retrace and read the autorouting matrix data cells to create
+/* This function is used by retrace and read the autorouting matrix data cells to create
  * the real track on the physical board
  */
-static void OrCell_Trace( BOARD* pcb, int col, int row,
-                          int side, int orient, int current_net_code )
+void AR_SOLVER::orCellTrace( AR_ROUTE& aRoute, int col, int row, int side, int orient )
 {
+    BOARD* pcb = m_board;
+    int    grid = RoutingMatrix.m_GridRouting;
+    TRACK* lastTrack;
+
     if( orient == HOLE )  // placement of a via
     {
         VIA *newVia = new VIA( pcb );
 
-        g_CurrentTrackList.PushBack( newVia );
+        m_newTracks.PushBack( newVia );
 
-        g_CurrentTrackSegment->SetState( TRACK_AR, true );
-        g_CurrentTrackSegment->SetLayer( F_Cu );
+        newVia->SetState( TRACK_AR, true );
+        newVia->SetLayer( F_Cu );
 
-        g_CurrentTrackSegment->SetStart(wxPoint( pcb->GetBoundingBox().GetX() +
-                                                ( RoutingMatrix.m_GridRouting * row ),
-                                                pcb->GetBoundingBox().GetY() +
-                                                ( RoutingMatrix.m_GridRouting * col )));
-        g_CurrentTrackSegment->SetEnd( g_CurrentTrackSegment->GetStart() );
+        newVia->SetStart( wxPoint( m_origin.x + ( grid * row ), m_origin.y + ( grid * col ) ) );
+        newVia->SetEnd( newVia->GetStart() );
 
-        g_CurrentTrackSegment->SetWidth( pcb->GetDesignSettings().GetCurrentViaSize() );
+        newVia->SetWidth( pcb->GetDesignSettings().GetCurrentViaSize() );
         newVia->SetViaType( pcb->GetDesignSettings().m_CurrentViaType );
 
-        g_CurrentTrackSegment->SetNetCode( current_net_code );
+        newVia->SetNetCode( aRoute.m_NetCode );
     }
     else    // placement of a standard segment
     {
-        TRACK *newTrack = new TRACK( pcb );
-        int    dx0, dy0, dx1, dy1;
-
+        TRACK*  newTrack = new TRACK( pcb );
+        int     dx0, dy0, dx1, dy1;
+        D_PAD*  padEnd = aRoute.m_Ratsnest->m_PadEnd;
 
-        g_CurrentTrackList.PushBack( newTrack );
+        m_newTracks.PushBack( newTrack );
+        lastTrack = newTrack;
 
-        g_CurrentTrackSegment->SetLayer( g_Route_Layer_BOTTOM );
+        lastTrack->SetLayer( g_Route_Layer_BOTTOM );
 
         if( side == TOP )
-            g_CurrentTrackSegment->SetLayer( g_Route_Layer_TOP );
+            lastTrack->SetLayer( g_Route_Layer_TOP );
 
-        g_CurrentTrackSegment->SetState( TRACK_AR, true );
-        g_CurrentTrackSegment->SetEnd( wxPoint( pcb->GetBoundingBox().GetX() +
-                                         ( RoutingMatrix.m_GridRouting * row ),
-                                         pcb->GetBoundingBox().GetY() +
-                                         ( RoutingMatrix.m_GridRouting * col )));
-        g_CurrentTrackSegment->SetNetCode( current_net_code );
+        lastTrack->SetState( TRACK_AR, true );
+        lastTrack->SetEnd( wxPoint( m_origin.x + ( grid * row ), m_origin.y + ( grid * col ) ) );
+        lastTrack->SetNetCode( aRoute.m_NetCode );
 
-        if( g_CurrentTrackSegment->Back() == NULL ) // Start trace.
+        if( lastTrack->Back() == NULL ) // Start trace.
         {
-            g_CurrentTrackSegment->SetStart( wxPoint( segm_fX, segm_fY ) );
+            lastTrack->SetStart( wxPoint( m_origin.x + grid * aRoute.m_ColTarget,
+                                          m_origin.y + grid * aRoute.m_RowTarget ) );
 
             // Placement on the center of the pad if outside grid.
-            dx1 = g_CurrentTrackSegment->GetEnd().x - g_CurrentTrackSegment->GetStart().x;
-            dy1 = g_CurrentTrackSegment->GetEnd().y - g_CurrentTrackSegment->GetStart().y;
+            dx1 = lastTrack->GetEnd().x - lastTrack->GetStart().x;
+            dy1 = lastTrack->GetEnd().y - lastTrack->GetStart().y;
 
-            dx0 = pt_cur_ch->m_PadEnd->GetPosition().x - g_CurrentTrackSegment->GetStart().x;
-            dy0 = pt_cur_ch->m_PadEnd->GetPosition().y - g_CurrentTrackSegment->GetStart().y;
+            dx0 = padEnd->GetPosition().x - lastTrack->GetStart().x;
+            dy0 = padEnd->GetPosition().y - lastTrack->GetStart().y;
 
             // If aligned, change the origin point.
             if( abs( dx0 * dy1 ) == abs( dx1 * dy0 ) )
             {
-                g_CurrentTrackSegment->SetStart( pt_cur_ch->m_PadEnd->GetPosition() );
+                lastTrack->SetStart( padEnd->GetPosition() );
             }
             else    // Creation of a supplemental segment
             {
-                g_CurrentTrackSegment->SetStart( pt_cur_ch->m_PadEnd->GetPosition() );
+                lastTrack->SetStart( padEnd->GetPosition() );
 
-                newTrack = (TRACK*)g_CurrentTrackSegment->Clone();
-                newTrack->SetStart( g_CurrentTrackSegment->GetEnd());
+                newTrack = (TRACK*) lastTrack->Clone();
+                newTrack->SetStart( lastTrack->GetEnd() );
 
-                g_CurrentTrackList.PushBack( newTrack );
+                m_newTracks.PushBack( newTrack );
+                lastTrack = newTrack;
             }
         }
         else
         {
-            if( g_CurrentTrackSegment->Back() )
-            {
-                g_CurrentTrackSegment->SetStart( g_CurrentTrackSegment->Back()->GetEnd() );
-            }
+            lastTrack->SetStart( lastTrack->Back()->GetEnd() );
         }
 
-        g_CurrentTrackSegment->SetWidth( pcb->GetDesignSettings().GetCurrentTrackWidth() );
+        lastTrack->SetWidth( pcb->GetDesignSettings().GetCurrentTrackWidth() );
 
-        if( g_CurrentTrackSegment->GetStart() != g_CurrentTrackSegment->GetEnd() )
+        if( lastTrack->GetStart() != lastTrack->GetEnd() )
         {
             // Reduce aligned segments by one.
-            TRACK* oldTrack = g_CurrentTrackSegment->Back();
+            TRACK* oldTrack = lastTrack->Back();
 
             if( oldTrack &&  oldTrack->Type() != PCB_VIA_T )
             {
-                dx1 = g_CurrentTrackSegment->GetEnd().x - g_CurrentTrackSegment->GetStart().x;
-                dy1 = g_CurrentTrackSegment->GetEnd().y - g_CurrentTrackSegment->GetStart().y;
+                dx1 = lastTrack->GetEnd().x - lastTrack->GetStart().x;
+                dy1 = lastTrack->GetEnd().y - lastTrack->GetStart().y;
 
                 dx0 = oldTrack->GetEnd().x - oldTrack->GetStart().x;
                 dy0 = oldTrack->GetEnd().y - oldTrack->GetStart().y;
 
                 if( abs( dx0 * dy1 ) == abs( dx1 * dy0 ) )
                 {
-                    oldTrack->SetEnd( g_CurrentTrackSegment->GetEnd() );
+                    oldTrack->SetEnd( lastTrack->GetEnd() );
 
-                    delete g_CurrentTrackList.PopBack();
+                    delete m_newTracks.PopBack();
                 }
             }
         }
@@ -1270,79 +1310,64 @@ static void OrCell_Trace( BOARD* pcb, int col, int row,
  * connected
  * Center on pads even if they are off grid.
  */
-static void AddNewTrace( PCB_EDIT_FRAME* pcbframe, wxDC* DC )
+void AR_SOLVER::addNewTrace( AR_ROUTE& aRoute )
 {
-    if( g_FirstTrackSegment == NULL )
+    if( m_newTracks.GetFirst() == NULL )
         return;
 
-    int dx0, dy0, dx1, dy1;
-    int marge, via_marge;
-    EDA_DRAW_PANEL* panel = pcbframe->GetCanvas();
-    PCB_SCREEN* screen = pcbframe->GetScreen();
+    int     dx0, dy0, dx1, dy1;
+    TRACK*  lastTrack = m_newTracks.GetLast();
+    TRACK*  firstTrack = m_newTracks.GetFirst();
+    D_PAD*  padStart = aRoute.m_Ratsnest->m_PadStart;
 
-    marge = s_Clearance + ( pcbframe->GetDesignSettings().GetCurrentTrackWidth() / 2 );
-    via_marge = s_Clearance + ( pcbframe->GetDesignSettings().GetCurrentViaSize() / 2 );
-
-    dx1 = g_CurrentTrackSegment->GetEnd().x - g_CurrentTrackSegment->GetStart().x;
-    dy1 = g_CurrentTrackSegment->GetEnd().y - g_CurrentTrackSegment->GetStart().y;
+    dx1 = lastTrack->GetEnd().x - lastTrack->GetStart().x;
+    dy1 = lastTrack->GetEnd().y - lastTrack->GetStart().y;
 
     // Place on center of pad if off grid.
-    dx0 = pt_cur_ch->m_PadStart->GetPosition().x - g_CurrentTrackSegment->GetStart().x;
-    dy0 = pt_cur_ch->m_PadStart->GetPosition().y - g_CurrentTrackSegment->GetStart().y;
+    dx0 = padStart->GetPosition().x - lastTrack->GetStart().x;
+    dy0 = padStart->GetPosition().y - lastTrack->GetStart().y;
 
     // If aligned, change the origin point.
     if( abs( dx0 * dy1 ) == abs( dx1 * dy0 ) )
     {
-        g_CurrentTrackSegment->SetEnd( pt_cur_ch->m_PadStart->GetPosition() );
+        lastTrack->SetEnd( padStart->GetPosition() );
     }
     else
     {
-        TRACK* newTrack = (TRACK*)g_CurrentTrackSegment->Clone();
+        TRACK* newTrack = (TRACK*) lastTrack->Clone();
 
-        newTrack->SetEnd( pt_cur_ch->m_PadStart->GetPosition() );
-        newTrack->SetStart( g_CurrentTrackSegment->GetEnd() );
+        newTrack->SetEnd( padStart->GetPosition() );
+        newTrack->SetStart( lastTrack->GetEnd() );
 
-        g_CurrentTrackList.PushBack( newTrack );
+        m_newTracks.PushBack( newTrack );
+        lastTrack = newTrack;
     }
 
-    g_FirstTrackSegment->start = pcbframe->GetBoard()->GetPad( g_FirstTrackSegment,
-            ENDPOINT_START );
+    firstTrack->start = m_board->GetPad( firstTrack, ENDPOINT_START );
 
-    if( g_FirstTrackSegment->start )
-        g_FirstTrackSegment->SetState( BEGIN_ONPAD, true );
+    if( firstTrack->start )
+        firstTrack->SetState( BEGIN_ONPAD, true );
 
-    g_CurrentTrackSegment->end = pcbframe->GetBoard()->GetPad( g_CurrentTrackSegment,
-            ENDPOINT_END );
+    lastTrack->end = m_board->GetPad( lastTrack, ENDPOINT_END );
 
-    if( g_CurrentTrackSegment->end )
-        g_CurrentTrackSegment->SetState( END_ONPAD, true );
+    if( lastTrack->end )
+        lastTrack->SetState( END_ONPAD, true );
 
     // Out the new track on the matrix board
-    for( TRACK* track = g_FirstTrackSegment; track; track = track->Next() )
+    for( TRACK* track = firstTrack; track; track = track->Next() )
     {
-        TraceSegmentPcb( track, HOLE, marge, WRITE_CELL );
-        TraceSegmentPcb( track, VIA_IMPOSSIBLE, via_marge, WRITE_OR_CELL );
+        TraceSegmentPcb( track, HOLE, m_marge, WRITE_CELL );
+        TraceSegmentPcb( track, VIA_IMPOSSIBLE, m_viaMarge, WRITE_OR_CELL );
     }
 
     // Insert new segments in  real board
-    int    netcode    = g_FirstTrackSegment->GetNetCode();
-    TRACK* firstTrack = g_FirstTrackSegment;
-    int    newCount   = g_CurrentTrackList.GetCount();
+    aRoute.m_FirstTrack = firstTrack;
+    aRoute.m_TrackCount = m_newTracks.GetCount();
 
     // Put entire new current segment list in BOARD
     TRACK* track;
-    TRACK* insertBeforeMe = g_CurrentTrackSegment->GetBestInsertPoint( pcbframe->GetBoard() );
-
-    while( ( track = g_CurrentTrackList.PopFront() ) != NULL )
-    {
-        ITEM_PICKER picker( track, UR_NEW );
-        s_ItemsListPicker.PushItem( picker );
-        pcbframe->GetBoard()->m_Track.Insert( track, insertBeforeMe );
-    }
-
-    DrawTraces( panel, DC, firstTrack, newCount, GR_OR );
-
-    pcbframe->TestNetConnection( DC, netcode );
+    TRACK* insertBeforeMe = lastTrack->GetBestInsertPoint( m_board );
 
-    screen->SetModify();
+    while( ( track = m_newTracks.PopFront() ) != NULL )
+        m_board->m_Track.Insert( track, insertBeforeMe );
 }
@@ -32,6 +32,7 @@
 
 #include <limits.h>
 #include <algorithm>
+#include <boost/bind.hpp>
 
 #include <fctsys.h>
 #include <common.h>
@@ -1367,6 +1368,47 @@ void BOARD::RedrawFilledAreas( EDA_DRAW_PANEL* panel, wxDC* aDC, GR_DRAWMODE aDr
 }
 
 
+void BOARD::CacheAreasTriangulation() const
+{
+    int areaCount = GetAreaCount();
+    int ii;
+
+#ifdef USE_OPENMP
+    #pragma omp parallel for schedule(dynamic, 1) private(ii)
+#endif /* USE_OPENMP */
+    for( ii = 0; ii < areaCount; ii++ )
+        GetArea( ii )->CacheTriangulation();
+}
+
+
+static void appendViewItem( std::vector<KIGFX::VIEW_ITEM*>* aItems, BOARD_ITEM* aItem )
+{
+    aItems->push_back( aItem );
+}
+
+
+void BOARD::GetViewItems( std::vector<KIGFX::VIEW_ITEM*>& aItems ) const
+{
+    for( int i = 0; i < GetAreaCount(); ++i )
+        aItems.push_back( GetArea( i ) );
+
+    for( BOARD_ITEM* drawing = m_Drawings; drawing; drawing = drawing->Next() )
+        aItems.push_back( drawing );
+
+    for( TRACK* track = m_Track; track; track = track->Next() )
+        aItems.push_back( track );
+
+    for( MODULE* module = m_Modules; module; module = module->Next() )
+    {
+        module->RunOnChildren( boost::bind( appendViewItem, &aItems, _1 ) );
+        aItems.push_back( module );
+    }
+
+    for( SEGZONE* zone = m_Zone; zone; zone = zone->Next() )
+        aItems.push_back( zone );
+}
+
+
 ZONE_CONTAINER* BOARD::HitTestForAnyFilledArea( const wxPoint& aRefPos,
     LAYER_ID aStartLayer, LAYER_ID aEndLayer,  int aNetCode )
 {
@@ -1008,6 +1008,20 @@ public:
     void RedrawFilledAreas( EDA_DRAW_PANEL* aPanel, wxDC* aDC, GR_DRAWMODE aDrawMode,
                             LAYER_ID aLayer );
 
+    /**
+     * Function CacheAreasTriangulation
+     * Splits filled areas of all zones into triangles (see
+     * ZONE_CONTAINER::CacheTriangulation()). Zones are processed in parallel.
+     */
+    void CacheAreasTriangulation() const;
+
+    /**
+     * Function GetViewItems
+     * Appends to \a aItems the items of the board shown by a VIEW: zones, drawings, tracks,
+     * modules with their children (see MODULE::RunOnChildren()) and segzones.
+     */
+    void GetViewItems( std::vector<KIGFX::VIEW_ITEM*>& aItems ) const;
+
     /**
      * Function SetAreasNetCodesFromNetNames
      * Set the .m_NetCode member of all copper areas, according to the area Net Name
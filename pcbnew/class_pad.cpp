@@ -957,6 +957,52 @@ void D_PAD::ViewGetLayers( int aLayers[], int& aCount ) const
 }
 
 
+bool D_PAD::ViewGetInstance( int aLayer, KIGFX::VIEW_INSTANCE& aInstance ) const
+{
+    // Netnames differ between pads, so they cannot be shared
+    if( IsNetnameLayer( aLayer ) )
+        return false;
+
+    int* shape = aInstance.shape;
+    std::fill( shape, shape + KIGFX::VIEW_INSTANCE::SHAPE_PARAMS, 0 );
+
+    // Values below have to cover everything that affects the pad drawing on a given layer
+    if( aLayer == ITEM_GAL_LAYER( PADS_HOLES_VISIBLE ) )
+    {
+        shape[0] = m_drillShape;
+        shape[1] = m_Drill.x;
+        shape[2] = m_Drill.y;
+    }
+    else
+    {
+        shape[0] = m_padShape;
+        shape[1] = m_Size.x;
+        shape[2] = m_Size.y;
+        shape[3] = m_Offset.x;
+        shape[4] = m_Offset.y;
+        shape[5] = m_DeltaSize.x;
+        shape[6] = m_DeltaSize.y;
+
+        if( aLayer == F_Mask || aLayer == B_Mask )
+        {
+            shape[7] = GetSolderMaskMargin();
+        }
+        else if( aLayer == F_Paste || aLayer == B_Paste )
+        {
+            wxSize margin = GetSolderPasteMargin();
+            shape[7] = margin.x;
+            shape[8] = margin.y;
+        }
+    }
+
+    aInstance.offset = VECTOR2D( m_Pos );
+    aInstance.angle  = -m_Orient * M_PI / 1800.0;
+    aInstance.size   = std::max( m_Size.x, m_Size.y );
+
+    return true;
+}
+
+
 unsigned int D_PAD::ViewGetLOD( int aLayer ) const
 {
     // Netnames will be shown only if zoom is appropriate
@@ -444,6 +444,9 @@ public:
     /// @copydoc VIEW_ITEM::ViewGetLOD()
     virtual unsigned int ViewGetLOD( int aLayer ) const;
 
+    /// @copydoc VIEW_ITEM::ViewGetInstance()
+    virtual bool ViewGetInstance( int aLayer, KIGFX::VIEW_INSTANCE& aInstance ) const;
+
     /// @copydoc VIEW_ITEM::ViewBBox()
     virtual const BOX2I ViewBBox() const;
 
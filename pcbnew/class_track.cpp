@@ -1007,6 +1007,34 @@ void VIA::ViewGetLayers( int aLayers[], int& aCount ) const
 }
 
 
+bool VIA::ViewGetInstance( int aLayer, KIGFX::VIEW_INSTANCE& aInstance ) const
+{
+    BOARD* board = GetBoard();
+
+    // Vias crossing only hidden layers are not drawn at all
+    if( IsNetnameLayer( aLayer ) || !board || !( board->GetVisibleLayers() & GetLayerSet() ).any() )
+        return false;
+
+    LAYER_ID layerTop, layerBottom;
+    LayerPair( &layerTop, &layerBottom );
+
+    int* shape = aInstance.shape;
+    std::fill( shape, shape + KIGFX::VIEW_INSTANCE::SHAPE_PARAMS, 0 );
+
+    shape[0] = GetViaType();
+    shape[1] = m_Width;
+    shape[2] = GetDrillValue();
+    shape[3] = layerTop;
+    shape[4] = layerBottom;
+
+    aInstance.offset = VECTOR2D( m_Start );
+    aInstance.angle  = 0.0;
+    aInstance.size   = m_Width;
+
+    return true;
+}
+
+
 // see class_track.h
 void TRACK::GetMsgPanelInfo( std::vector< MSG_PANEL_ITEM >& aList )
 {
@@ -433,6 +433,9 @@ public:
     /// @copydoc VIEW_ITEM::ViewGetLayers()
     virtual void ViewGetLayers( int aLayers[], int& aCount ) const;
 
+    /// @copydoc VIEW_ITEM::ViewGetInstance()
+    virtual bool ViewGetInstance( int aLayer, KIGFX::VIEW_INSTANCE& aInstance ) const;
+
     virtual void Flip( const wxPoint& aCentre );
 
 #if defined (DEBUG)
@@ -64,6 +64,8 @@ ZONE_CONTAINER::ZONE_CONTAINER( BOARD* aBoard ) :
     SetDoNotAllowVias( true );                  // has meaning only if m_isKeepout == true
     SetDoNotAllowTracks( true );                // has meaning only if m_isKeepout == true
     m_cornerRadius = 0;
+    m_FilledPolysRevision = 1;
+    m_FilledTrianglesRevision = 0;
     SetLocalFlags( 0 );                         // flags tempoarry used in zone calculations
     m_Poly     = new CPolyLine();               // Outlines
     aBoard->GetZoneSettings().ExportSetting( *this );
@@ -92,6 +94,9 @@ ZONE_CONTAINER::ZONE_CONTAINER( const ZONE_CONTAINER& aZone ) :
     m_ThermalReliefCopperBridge = aZone.m_ThermalReliefCopperBridge;
     m_FilledPolysList.Append( aZone.m_FilledPolysList );
     m_FillSegmList = aZone.m_FillSegmList;      // vector <> copy
+    m_FilledTriangles = aZone.m_FilledTriangles;
+    m_FilledPolysRevision = aZone.m_FilledPolysRevision;
+    m_FilledTrianglesRevision = aZone.m_FilledTrianglesRevision;
 
     m_isKeepout = aZone.m_isKeepout;
     m_doNotAllowCopperPour = aZone.m_doNotAllowCopperPour;
@@ -124,6 +129,7 @@ bool ZONE_CONTAINER::UnFill()
                   ( m_FillSegmList.size() > 0 );
 
     m_FilledPolysList.RemoveAllContours();
+    m_FilledPolysRevision++;
     m_FillSegmList.clear();
     m_IsFilled = false;
 
@@ -696,6 +702,8 @@ void ZONE_CONTAINER::Move( const wxPoint& offset )
         m_FilledPolysList.SetY( ic, m_FilledPolysList.GetY( ic ) + offset.y );
     }
 
+    m_FilledPolysRevision++;
+
     for( unsigned ic = 0; ic < m_FillSegmList.size(); ic++ )
     {
         m_FillSegmList[ic].m_Start += offset;
@@ -749,6 +757,8 @@ void ZONE_CONTAINER::Rotate( const wxPoint& centre, double angle )
         m_FilledPolysList.SetY( ic, pos.y );
     }
 
+    m_FilledPolysRevision++;
+
     for( unsigned ic = 0; ic < m_FillSegmList.size(); ic++ )
     {
         RotatePoint( &m_FillSegmList[ic].m_Start, centre, angle );
@@ -783,6 +793,8 @@ void ZONE_CONTAINER::Mirror( const wxPoint& mirror_ref )
         m_FilledPolysList.SetY( ic, py + mirror_ref.y );
     }
 
+    m_FilledPolysRevision++;
+
     for( unsigned ic = 0; ic < m_FillSegmList.size(); ic++ )
     {
         m_FillSegmList[ic].m_Start.y -= mirror_ref.y;
@@ -817,6 +829,7 @@ void ZONE_CONTAINER::Copy( ZONE_CONTAINER* src )
     m_Poly->m_HatchLines = src->m_Poly->m_HatchLines;   // Copy vector <CSegment>
     m_FilledPolysList.RemoveAllContours();
     m_FilledPolysList.Append( src->m_FilledPolysList );
+    m_FilledPolysRevision++;
     m_FillSegmList.clear();
     m_FillSegmList = src->m_FillSegmList;
 }
@@ -487,6 +487,7 @@ public:
     void ClearFilledPolysList()
     {
         m_FilledPolysList.RemoveAllContours();
+        m_FilledPolysRevision++;
     }
 
    /**
@@ -506,6 +507,42 @@ public:
     void AddFilledPolysList( CPOLYGONS_LIST& aPolysList )
     {
         m_FilledPolysList = aPolysList;
+        m_FilledPolysRevision++;
+    }
+
+    /**
+     * Function CacheTriangulation
+     * splits the filled areas into triangles, so they can be drawn without tesselating
+     * the polygons every time the zone is cached for display. Nothing is done if the cached
+     * triangles still correspond to the filled areas.
+     * The function modifies only the triangle cache, so it may be called for many zones
+     * in parallel.
+     */
+    void CacheTriangulation() const;
+
+    /**
+     * Function IsTriangulationUpToDate
+     * @return true if the cached triangles correspond to the current filled areas.
+     */
+    bool IsTriangulationUpToDate() const;
+
+    /**
+     * Function CreateTriangulationJob
+     * returns a job that triangulates a copy of the filled areas on a worker thread of
+     * the VIEW, and stores the triangles in the zone when it is finished.
+     * @return the job, or NULL if the cached triangles are up to date.
+     */
+    KIGFX::VIEW_ITEM_JOB* CreateTriangulationJob() const;
+
+    /**
+     * Function GetFilledTriangles
+     * returns corners of triangles covering the filled areas, 3 consecutive points
+     * per triangle. CacheTriangulation() has to be called before, otherwise the returned
+     * list may be outdated.
+     */
+    const std::vector<wxPoint>& GetFilledTriangles() const
+    {
+        return m_FilledTriangles;
     }
 
     /**
@@ -540,6 +577,7 @@ public:
     void AddFilledPolygon( CPOLYGONS_LIST& aPolygon )
     {
         m_FilledPolysList.Append( aPolygon );
+        m_FilledPolysRevision++;
     }
 
     void AddFillSegments( std::vector< SEGMENT >& aSegments )
@@ -573,6 +611,8 @@ public:
 
 
 private:
+    friend class ZONE_TRIANGULATION_JOB;
+
     CPolyLine*            m_Poly;                ///< Outline of the zone.
     CPolyLine*            m_smoothedPoly;        // Corner-smoothed version of m_Poly
     int                   m_cornerSmoothingType;
@@ -640,6 +680,15 @@ private:
      * described by m_Poly can have many filled areas
      */
     CPOLYGONS_LIST m_FilledPolysList;
+
+    /// Triangles covering m_FilledPolysList, 3 corners per triangle (see CacheTriangulation()).
+    mutable std::vector<wxPoint> m_FilledTriangles;
+
+    /// Incremented by every change of m_FilledPolysList.
+    unsigned int                 m_FilledPolysRevision;
+
+    /// Value of m_FilledPolysRevision when m_FilledTriangles were computed.
+    mutable unsigned int         m_FilledTrianglesRevision;
 };
 
 
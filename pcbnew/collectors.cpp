@@ -29,6 +29,18 @@
 #include <class_pad.h>
 #include <class_track.h>
 #include <class_marker_pcb.h>
+#include <class_board.h>
+#include <convert_to_biu.h>
+#include <view/view.h>
+
+#include <algorithm>
+
+
+/* Margin added around the reference position when looking for items in the
+ * spatial index. Some items are hit when the reference position is slightly outside
+ * of their bounding boxes (eg. zone outlines).
+ */
+#define VIEW_QUERY_MARGIN_MM 0.5
 
 
 /*  This module contains out of line member functions for classes given in
@@ -459,10 +471,18 @@ void GENERAL_COLLECTOR::Collect( BOARD_ITEM* aItem, const KICAD_T aScanList[],
     // the Inspect() function.
     SetRefPos( aRefPos );
 
-    // visit the board or module with the INSPECTOR (me).
-    aItem->Visit(   this,       // INSPECTOR* inspector
-                    NULL,       // const void* testData, not used here
-                    m_ScanTypes );
+    if( m_view && aItem->Type() == PCB_T )
+    {
+        // look for candidates in the spatial index instead of visiting all the items
+        collectFromView( static_cast<BOARD*>( aItem ) );
+    }
+    else
+    {
+        // visit the board or module with the INSPECTOR (me).
+        aItem->Visit(   this,       // INSPECTOR* inspector
+                        NULL,       // const void* testData, not used here
+                        m_ScanTypes );
+    }
 
     SetTimeNow();               // when snapshot was taken
 
@@ -477,6 +497,59 @@ void GENERAL_COLLECTOR::Collect( BOARD_ITEM* aItem, const KICAD_T aScanList[],
 }
 
 
+void GENERAL_COLLECTOR::collectFromView( BOARD* aBoard )
+{
+    int margin = Millimeter2iu( VIEW_QUERY_MARGIN_MM );
+    BOX2I area( VECTOR2I( m_RefPos.x - margin, m_RefPos.y - margin ),
+                VECTOR2I( 2 * margin, 2 * margin ) );
+
+    // Selected items are hidden in the VIEW (the selection group draws them), but they
+    // must still be found, e.g. to be deselected. Inspect() does the visibility checks.
+    std::vector<KIGFX::VIEW::LAYER_ITEM_PAIR> found;
+    m_view->Query( area, found, false );
+
+    // The VIEW holds also items that are not a part of the board (VIEW_GROUPs used for
+    // selection and previews, ratsnest, worksheet, etc.), they are skipped. Items placed
+    // on many layers are reported once per layer, only their first hit is kept.
+    std::vector<BOARD_ITEM*> candidates;
+    std::set<BOARD_ITEM*> seen;
+    candidates.reserve( found.size() );
+
+    for( unsigned i = 0; i < found.size(); ++i )
+    {
+        BOARD_ITEM* item = dynamic_cast<BOARD_ITEM*>( found[i].first );
+
+        if( item && seen.insert( item ).second )
+            candidates.push_back( item );
+    }
+
+    // Inspect the candidates in the order of types in the scan list, as Visit() does
+    for( const KICAD_T* type = m_ScanTypes; *type != EOT; ++type )
+    {
+        if( *type == PCB_MARKER_T )
+        {
+            // Markers are not stored in the VIEW
+            for( int i = 0; i < aBoard->GetMARKERCount(); ++i )
+            {
+                if( Inspect( aBoard->GetMARKER( i ), NULL ) == SEARCH_QUIT )
+                    return;
+            }
+
+            continue;
+        }
+
+        for( unsigned i = 0; i < candidates.size(); ++i )
+        {
+            if( candidates[i]->Type() != *type )
+                continue;
+
+            if( Inspect( candidates[i], NULL ) == SEARCH_QUIT )
+                return;
+        }
+    }
+}
+
+
 // see collectors.h
 SEARCH_RESULT PCB_TYPE_COLLECTOR::Inspect( EDA_ITEM* testItem, const void* testData )
 {
@@ -40,6 +40,12 @@
 
 
 class BOARD_ITEM;
+class BOARD;
+
+namespace KIGFX
+{
+class VIEW;
+}
 
 
 /**
@@ -233,6 +239,22 @@ protected:
     int                         m_PrimaryLength;
 
 
+    /**
+     * VIEW whose spatial index is used to find the items to be inspected,
+     * or NULL if all the items should be visited.
+     */
+    const KIGFX::VIEW*          m_view;
+
+
+    /**
+     * Function collectFromView
+     * runs Inspect() for the items that are close to the reference position,
+     * found using the spatial index of m_view.
+     * @param aBoard is the BOARD that is displayed by m_view.
+     */
+    void collectFromView( BOARD* aBoard );
+
+
 public:
 
     /**
@@ -297,7 +319,8 @@ public:
     /**
      * Constructor GENERALCOLLECTOR
      */
-    GENERAL_COLLECTOR()
+    GENERAL_COLLECTOR() :
+        m_view( NULL )
     {
         SetScanTypes( AllBoardItems );
     }
@@ -321,6 +344,18 @@ public:
     void SetGuide( const COLLECTORS_GUIDE* aGuide ) { m_Guide = aGuide; }
 
 
+    /**
+     * Function SetView
+     * sets the VIEW whose spatial index is used to find items to be collected from
+     * a BOARD. Then only items whose bounding boxes are close to the reference position
+     * are hit tested, instead of all the items of the board.
+     * The VIEW has to contain all the items of the board, so it should be used only
+     * when the GAL canvas is active.
+     * @param aView is the VIEW, or NULL to visit all the items.
+     */
+    void SetView( const KIGFX::VIEW* aView ) { m_view = aView; }
+
+
     /**
      * Function operator[int]
      * overloads COLLECTOR::operator[](int) to return a BOARD_ITEM* instead of
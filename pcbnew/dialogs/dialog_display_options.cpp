@@ -199,7 +199,7 @@ void DIALOG_DISPLAY_OPTIONS::OnOkClick(wxCommandEvent& event)
     KIGFX::PCB_RENDER_SETTINGS* settings =
             static_cast<KIGFX::PCB_RENDER_SETTINGS*>( painter->GetSettings() );
     settings->LoadDisplayOptions( DisplayOpt );
-    view->RecacheAllItems( true );
+    view->RecacheAllItems( false );
 
     m_Parent->GetCanvas()->Refresh();
 
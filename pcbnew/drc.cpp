@@ -42,6 +42,7 @@
 #include <class_draw_panel_gal.h>
 #include <view/view.h>
 #include <geometry/seg.h>
+#include <profile_trace.h>
 
 #include <pcbnew.h>
 #include <drc_stuff.h>
@@ -169,6 +170,8 @@ int DRC::Drc( ZONE_CONTAINER* aArea, int aCornerIndex )
 
 void DRC::RunTests( wxTextCtrl* aMessages )
 {
+    PROF_SCOPE( "DRC::RunTests" );
+
     // Ensure ratsnest is up to date:
     if( (m_pcb->m_Status_Pcb & LISTE_RATSNEST_ITEM_OK) == 0 )
     {
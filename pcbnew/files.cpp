@@ -41,6 +41,7 @@
 #include <pgm_base.h>
 #include <msgpanel.h>
 #include <fp_lib_table.h>
+#include <profile_trace.h>
 
 #include <pcbnew.h>
 #include <pcbnew_id.h>
@@ -484,7 +485,10 @@ bool PCB_EDIT_FRAME::OpenProjectFiles( const std::vector<wxString>& aFileSet, in
             unsigned startTime = GetRunningMicroSecs();
 #endif
 
-            loadedBoard = pi->Load( fullFileName, NULL, &props );
+            {
+                PROF_SCOPE( "PLUGIN::Load" );
+                loadedBoard = pi->Load( fullFileName, NULL, &props );
+            }
 
 #if USE_INSTRUMENTATION
             unsigned stopTime = GetRunningMicroSecs();
@@ -691,6 +695,7 @@ bool PCB_EDIT_FRAME::SavePcbFile( const wxString& aFileName, bool aCreateBackupF
 
         wxASSERT( pcbFileName.IsAbsolute() );
 
+        PROF_SCOPE( "PLUGIN::Save" );
         pi->Save( pcbFileName.GetFullPath(), GetBoard(), NULL );
     }
     catch( const IO_ERROR& ioe )
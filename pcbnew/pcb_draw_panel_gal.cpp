@@ -33,8 +33,7 @@
 #include <class_board.h>
 #include <class_module.h>
 #include <class_track.h>
-
-#include <boost/bind.hpp>
+#include <class_zone.h>
 
 const LAYER_NUM GAL_LAYER_ORDER[] =
 {
@@ -164,28 +163,16 @@ void PCB_DRAW_PANEL_GAL::DisplayBoard( const BOARD* aBoard )
 {
     m_view->Clear();
 
-    // Load zones
-    for( int i = 0; i < aBoard->GetAreaCount(); ++i )
-        m_view->Add( (KIGFX::VIEW_ITEM*) ( aBoard->GetArea( i ) ) );
-
-    // Load drawings
-    for( BOARD_ITEM* drawing = aBoard->m_Drawings; drawing; drawing = drawing->Next() )
-        m_view->Add( drawing );
-
-    // Load tracks
-    for( TRACK* track = aBoard->m_Track; track; track = track->Next() )
-        m_view->Add( track );
+    // Filled areas of zones are triangulated in parallel before they are cached
+    if( m_gal->IsTriangulationPreferred() )
+        aBoard->CacheAreasTriangulation();
 
-    // Load modules and its additional elements
-    for( MODULE* module = aBoard->m_Modules; module; module = module->Next() )
-    {
-        module->RunOnChildren( boost::bind( &KIGFX::VIEW::Add, m_view, _1 ) );
-        m_view->Add( module );
-    }
+    // All the board items are collected first and added at once,
+    // so the view can bulk load its spatial index
+    std::vector<KIGFX::VIEW_ITEM*> items;
 
-    // Segzones (equivalent of ZONE_CONTAINER for legacy boards)
-    for( SEGZONE* zone = aBoard->m_Zone; zone; zone = zone->Next() )
-        m_view->Add( zone );
+    aBoard->GetViewItems( items );
+    m_view->AddItems( items );
 
     // Ratsnest
     if( m_ratsnest )
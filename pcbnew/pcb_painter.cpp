@@ -267,6 +267,22 @@ bool PCB_PAINTER::Draw( const VIEW_ITEM* aItem, int aLayer )
 }
 
 
+VIEW_ITEM_JOB* PCB_PAINTER::CreateJob( const VIEW_ITEM* aItem )
+{
+    const EDA_ITEM* item = static_cast<const EDA_ITEM*>( aItem );
+
+    // Filled zones drawn as triangles are triangulated on a worker thread
+    if( item->Type() == PCB_ZONE_AREA_T &&
+        m_pcbSettings.m_displayZoneMode == PCB_RENDER_SETTINGS::DZ_SHOW_FILLED &&
+        m_gal->IsTriangulationPreferred() )
+    {
+        return static_cast<const ZONE_CONTAINER*>( item )->CreateTriangulationJob();
+    }
+
+    return NULL;
+}
+
+
 void PCB_PAINTER::draw( const TRACK* aTrack, int aLayer )
 {
     VECTOR2D start( aTrack->GetStart() );
@@ -871,7 +887,7 @@ void PCB_PAINTER::draw( const ZONE_CONTAINER* aZone )
     // Draw the filling
     if( displayMode != PCB_RENDER_SETTINGS::DZ_HIDE_FILLED )
     {
-        const std::vector<CPolyPt> polyPoints = aZone->GetFilledPolysList().GetList();
+        const std::vector<CPolyPt>& polyPoints = aZone->GetFilledPolysList().GetList();
         if( polyPoints.size() == 0 )  // Nothing to draw
             return;
 
@@ -890,6 +906,20 @@ void PCB_PAINTER::draw( const ZONE_CONTAINER* aZone )
             m_gal->SetIsStroke( true );
         }
 
+        // Use the cached triangulation instead of tesselating filled polygons
+        bool useTriangles = displayMode == PCB_RENDER_SETTINGS::DZ_SHOW_FILLED &&
+                            m_gal->IsTriangulationPreferred();
+
+        if( useTriangles )
+        {
+            aZone->CacheTriangulation();
+
+            const std::vector<wxPoint>& triangles = aZone->GetFilledTriangles();
+            std::vector<VECTOR2D> points( triangles.begin(), triangles.end() );
+
+            m_gal->DrawTriangles( points );
+        }
+
         std::vector<CPolyPt>::const_iterator polyIterator;
         for( polyIterator = polyPoints.begin(); polyIterator != polyPoints.end(); polyIterator++ )
         {
@@ -900,7 +930,9 @@ void PCB_PAINTER::draw( const ZONE_CONTAINER* aZone )
             {
                 if( displayMode == PCB_RENDER_SETTINGS::DZ_SHOW_FILLED )
                 {
-                    m_gal->DrawPolygon( corners );
+                    if( !useTriangles )
+                        m_gal->DrawPolygon( corners );
+
                     m_gal->DrawPolyline( corners );
                 }
                 else if( displayMode == PCB_RENDER_SETTINGS::DZ_SHOW_OUTLINED )
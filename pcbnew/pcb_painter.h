@@ -197,6 +197,9 @@ public:
     /// @copydoc PAINTER::Draw()
     virtual bool Draw( const VIEW_ITEM* aItem, int aLayer );
 
+    /// @copydoc PAINTER::CreateJob()
+    virtual VIEW_ITEM_JOB* CreateJob( const VIEW_ITEM* aItem );
+
 protected:
     PCB_RENDER_SETTINGS m_pcbSettings;
 
@@ -32,6 +32,7 @@
 #endif /* USE_OPENMP */
 
 #include <ratsnest_data.h>
+#include <profile_trace.h>
 
 #include <class_board.h>
 #include <class_module.h>
@@ -1016,6 +1017,8 @@ void RN_DATA::ProcessBoard()
 
 void RN_DATA::Recalculate( int aNet )
 {
+    PROF_SCOPE( "RN_DATA::Recalculate" );
+
     unsigned int netCount = m_board->GetNetCount();
 
     if( netCount > m_nets.size() )
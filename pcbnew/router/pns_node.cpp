@@ -26,7 +26,10 @@
 #include <geometry/seg.h>
 #include <geometry/shape.h>
 #include <geometry/shape_line_chain.h>
+#include <geometry/shape_segment.h>
+#include <geometry/shape_circle.h>
 #include <geometry/shape_index.h>
+#include <geometry/seg_batch.h>
 
 #include "trace.h"
 #include "pns_item.h"
@@ -176,6 +179,9 @@ struct PNS_NODE::OBSTACLE_VISITOR
 	///> additional clearance 
 	int m_extraClearance;
 
+    ///> segments of m_item when it is a line, built once for all the candidates
+    SEG_BATCH m_lineSegs;
+
     OBSTACLE_VISITOR( PNS_NODE::OBSTACLES& aTab, const PNS_ITEM* aItem, int aKindMask ) :
         m_tab( aTab ),
         m_item( aItem ),
@@ -184,9 +190,64 @@ struct PNS_NODE::OBSTACLE_VISITOR
         m_matchCount( 0 ),
 		m_extraClearance( 0 )
     {
-	   if( aItem->Kind() == PNS_ITEM::LINE )
-            m_extraClearance += static_cast<const PNS_LINE*>( aItem )->Width() / 2;
-	}
+        if( aItem->Kind() == PNS_ITEM::LINE )
+        {
+            const PNS_LINE* line = static_cast<const PNS_LINE*>( aItem );
+
+            m_extraClearance += line->Width() / 2;
+            m_lineSegs.Add( line->CLine() );
+        }
+    }
+
+    /**
+     * Function collide()
+     * Same as aItem->Collide( m_item, aClearance ). When m_item is a line, segments and vias
+     * are tested against its segment batch instead of walking the line chain each time.
+     */
+    bool collide( const PNS_ITEM* aItem, int aClearance ) const
+    {
+        if( !m_lineSegs.Size() )
+            return aItem->Collide( m_item, aClearance );
+
+        const PNS_LINE* line = static_cast<const PNS_LINE*>( m_item );
+
+        if( aItem->Net() != line->Net() && aItem->LayersOverlap( line ) )
+        {
+            const SHAPE* shape = aItem->Shape();
+            bool hit;
+
+            switch( shape->Type() )
+            {
+            case SH_SEGMENT:
+            {
+                const SHAPE_SEGMENT* seg = static_cast<const SHAPE_SEGMENT*>( shape );
+                hit = m_lineSegs.Collide( seg->GetSeg(), aClearance + seg->GetWidth() / 2 ) >= 0;
+                break;
+            }
+
+            case SH_CIRCLE:
+            {
+                const SHAPE_CIRCLE* circle = static_cast<const SHAPE_CIRCLE*>( shape );
+                hit = m_lineSegs.CollideCircle( circle->GetCenter(),
+                                                circle->GetRadius() + aClearance ) >= 0;
+                break;
+            }
+
+            default:
+                hit = shape->Collide( line->Shape(), aClearance );
+                break;
+            }
+
+            if( hit )
+                return true;
+        }
+
+        // the via at the end of the line, as PNS_ITEM::Collide() does
+        if( line->EndsWithVia() )
+            return aItem->Collide( &line->Via(), aClearance - line->Width() / 2 );
+
+        return false;
+    }
 
     void SetCountLimit( int aLimit )
     {
@@ -214,7 +275,7 @@ struct PNS_NODE::OBSTACLE_VISITOR
         if( aItem->Kind() == PNS_ITEM::LINE )
             clearance += static_cast<PNS_LINE *>(aItem)->Width() / 2;
 
-        if( !aItem->Collide( m_item, clearance ) )
+        if( !collide( aItem, clearance ) )
             return true;
 
         PNS_OBSTACLE obs;
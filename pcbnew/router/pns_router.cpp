@@ -23,6 +23,7 @@
 
 #include <boost/foreach.hpp>
 
+#include <profile_trace.h>
 #include <view/view.h>
 #include <view/view_item.h>
 #include <view/view_group.h>
@@ -538,6 +539,8 @@ void PNS_ROUTER::DisplayDebugPoint( const VECTOR2I aPos, int aType )
 
 void PNS_ROUTER::Move( const VECTOR2I& aP, PNS_ITEM* endItem )
 {
+    PROF_SCOPE( "PNS_ROUTER::Move" );
+
     m_currentEnd = aP;
     m_currentEndItem = endItem;
 
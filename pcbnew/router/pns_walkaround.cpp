@@ -49,6 +49,8 @@ PNS_WALKAROUND::WALKAROUND_STATUS PNS_WALKAROUND::singleStep( PNS_LINE& aPath,
         aWindingDirection ? m_currentObstacle[0] : m_currentObstacle[1];
 
     bool& prev_recursive = aWindingDirection ? m_recursiveCollision[0] : m_recursiveCollision[1];
+    int& blockage_count = aWindingDirection ? m_recursiveBlockageCount[0] :
+                                              m_recursiveBlockageCount[1];
 
     if( !current_obs )
         return DONE;
@@ -59,9 +61,9 @@ PNS_WALKAROUND::WALKAROUND_STATUS PNS_WALKAROUND::singleStep( PNS_LINE& aPath,
 
     if( ( current_obs->m_hull ).PointInside( last ) || ( current_obs->m_hull ).PointOnEdge( last ) )
     {
-        m_recursiveBlockageCount++;
+        blockage_count++;
 
-        if( m_recursiveBlockageCount < 3 )
+        if( blockage_count < 3 )
             aPath.Line().Append( current_obs->m_hull.NearestPoint( last ) );
         else
         {
@@ -76,12 +78,17 @@ PNS_WALKAROUND::WALKAROUND_STATUS PNS_WALKAROUND::singleStep( PNS_LINE& aPath,
                       path_post[1], !aWindingDirection );
 
 #ifdef DEBUG
-    m_logger.NewGroup( aWindingDirection ? "walk-cw" : "walk-ccw", m_iteration );
-    m_logger.Log( &path_walk[0], 0, "path-walk" );
-    m_logger.Log( &path_pre[0], 1, "path-pre" );
-    m_logger.Log( &path_post[0], 4, "path-post" );
-    m_logger.Log( &current_obs->m_hull, 2, "hull" );
-    m_logger.Log( current_obs->m_item, 3, "item" );
+#ifdef USE_OPENMP
+    #pragma omp critical( pns_walkaround_log )
+#endif /* USE_OPENMP */
+    {
+        m_logger.NewGroup( aWindingDirection ? "walk-cw" : "walk-ccw", m_iteration );
+        m_logger.Log( &path_walk[0], 0, "path-walk" );
+        m_logger.Log( &path_pre[0], 1, "path-pre" );
+        m_logger.Log( &path_post[0], 4, "path-post" );
+        m_logger.Log( &current_obs->m_hull, 2, "hull" );
+        m_logger.Log( current_obs->m_item, 3, "item" );
+    }
 #endif
 
     int len_pre = path_walk[0].Length();
@@ -132,55 +139,72 @@ PNS_WALKAROUND::WALKAROUND_STATUS PNS_WALKAROUND::singleStep( PNS_LINE& aPath,
 }
 
 
+int PNS_WALKAROUND::walkDirection( PNS_LINE& aPath, bool aWindingDirection, int& aFirstDone )
+{
+    for( int i = 0; i < m_iterationLimit; i++ )
+    {
+        bool cancelled = false;
+
+        // The opposite direction finished at an earlier iteration: it wins regardless of
+        // what this one finds, unless the longer of both paths has been requested.
+        if( !m_forceLongerPath )
+        {
+#ifdef USE_OPENMP
+            #pragma omp critical( pns_walkaround_done )
+#endif /* USE_OPENMP */
+            cancelled = ( i > aFirstDone );
+        }
+
+        if( cancelled )
+            break;
+
+        if( singleStep( aPath, aWindingDirection ) == DONE )
+        {
+#ifdef USE_OPENMP
+            #pragma omp critical( pns_walkaround_done )
+#endif /* USE_OPENMP */
+            aFirstDone = std::min( aFirstDone, i );
+
+            return i;
+        }
+    }
+
+    return m_iterationLimit;
+}
+
+
 PNS_WALKAROUND::WALKAROUND_STATUS PNS_WALKAROUND::Route( const PNS_LINE& aInitialPath,
         PNS_LINE& aWalkPath, bool aOptimize )
 {
-    PNS_LINE path_cw( aInitialPath ), path_ccw( aInitialPath );
-    WALKAROUND_STATUS s_cw = IN_PROGRESS, s_ccw = IN_PROGRESS;
-    SHAPE_LINE_CHAIN best_path;
+    // index 0 walks clockwise, index 1 counterclockwise
+    PNS_LINE path[2] = { aInitialPath, aInitialPath };
+    int finishedAt[2];
+    int firstDone;
 
     start( aInitialPath );
 
     m_currentObstacle[0] = m_currentObstacle[1] = nearestObstacle( aInitialPath );
-    m_recursiveBlockageCount = 0;
+    m_recursiveCollision[0] = m_recursiveCollision[1] = false;
+    m_recursiveBlockageCount[0] = m_recursiveBlockageCount[1] = 0;
+    firstDone = m_iterationLimit;
 
     aWalkPath = aInitialPath;
 
-    while( m_iteration < m_iterationLimit )
-    {
-        if( s_cw != STUCK )
-            s_cw = singleStep( path_cw, true );
-
-        if( s_ccw != STUCK )
-            s_ccw = singleStep( path_ccw, false );
+    // Both directions only read the world, so they are evaluated concurrently.
+    // The loser is cancelled as soon as it gets past the iteration the winner finished at,
+    // which keeps the result identical to walking both directions in lockstep.
+#ifdef USE_OPENMP
+    #pragma omp parallel for num_threads( 2 ) schedule( static, 1 )
+#endif /* USE_OPENMP */
+    for( int dir = 0; dir < 2; dir++ )
+        finishedAt[dir] = walkDirection( path[dir], dir == 0, firstDone );
 
-        if( ( s_cw == DONE && s_ccw == DONE ) || ( s_cw == STUCK && s_ccw == STUCK ) )
-        {
-            int len_cw  = path_cw.CLine().Length();
-            int len_ccw = path_ccw.CLine().Length();
+    m_iteration = std::max( finishedAt[0], finishedAt[1] );
 
-            if( m_forceLongerPath )
-                aWalkPath = (len_cw > len_ccw ? path_cw : path_ccw);
-            else
-                aWalkPath = (len_cw < len_ccw ? path_cw : path_ccw);
+    const PNS_LINE& path_cw = path[0];
+    const PNS_LINE& path_ccw = path[1];
 
-            break;
-        }
-        else if( s_cw == DONE && !m_forceLongerPath )
-        {
-            aWalkPath = path_cw;
-            break;
-        }
-        else if( s_ccw == DONE && !m_forceLongerPath )
-        {
-            aWalkPath = path_ccw;
-            break;
-        }
-
-        m_iteration++;
-    }
-
-    if( m_iteration == m_iterationLimit )
+    if( m_forceLongerPath || finishedAt[0] == finishedAt[1] )
     {
         int len_cw  = path_cw.CLine().Length();
         int len_ccw = path_ccw.CLine().Length();
@@ -190,6 +214,10 @@ PNS_WALKAROUND::WALKAROUND_STATUS PNS_WALKAROUND::Route( const PNS_LINE& aInitia
         else
             aWalkPath = ( len_cw < len_ccw ? path_cw : path_ccw );
     }
+    else
+    {
+        aWalkPath = ( finishedAt[0] < finishedAt[1] ? path_cw : path_ccw );
+    }
 
     if( m_cursorApproachMode )
     {
@@ -236,7 +264,7 @@ PNS_WALKAROUND::WALKAROUND_STATUS PNS_WALKAROUND::Route( const PNS_LINE& aInitia
     if( aWalkPath.CPoint( 0 ) != aInitialPath.CPoint( 0 ) )
         return STUCK;
 
-    WALKAROUND_STATUS st = s_ccw == DONE || s_cw == DONE ? DONE : STUCK;
+    WALKAROUND_STATUS st = firstDone < m_iterationLimit ? DONE : STUCK;
 
     if( aOptimize && st == DONE )
        PNS_OPTIMIZER::Optimize( &aWalkPath, PNS_OPTIMIZER::MERGE_OBTUSE, m_world );
@@ -99,12 +99,26 @@ public:
 private:
     void start( const PNS_LINE& aInitialPath );
 
+    /**
+     * Function walkDirection()
+     *
+     * Walks aPath around the obstacles in a single winding direction until it is done, the
+     * iteration limit is hit or the opposite direction has already finished at an earlier
+     * iteration (and thus has won). Touches only the state of its own direction, so both
+     * directions can be evaluated concurrently.
+     * @param aPath the path to walk (modified)
+     * @param aWindingDirection true for clockwise
+     * @param aFirstDone iteration at which the first of the two directions finished (shared)
+     * @return the iteration at which the walk finished, or m_iterationLimit if it did not.
+     */
+    int walkDirection( PNS_LINE& aPath, bool aWindingDirection, int& aFirstDone );
+
     WALKAROUND_STATUS singleStep( PNS_LINE& aPath, bool aWindingDirection );
     PNS_NODE::OPT_OBSTACLE nearestObstacle( const PNS_LINE& aPath );
 
     PNS_NODE* m_world;
 
-    int m_recursiveBlockageCount;
+    int m_recursiveBlockageCount[2];
     int m_iteration;
     int m_iterationLimit;
     int m_itemMask;
@@ -229,6 +229,7 @@ int MODULE_TOOLS::EnumeratePads( TOOL_EVENT& aEvent )
     MODULE* module = m_board->m_Modules;
 
     GENERAL_COLLECTOR collector;
+    collector.SetView( getView() );
     const KICAD_T types[] = { PCB_PAD_T, EOT };
 
     GENERAL_COLLECTORS_GUIDE guide = m_frame->GetCollectorsGuide();
@@ -171,7 +171,7 @@ int PCB_EDITOR_CONTROL::ZoneFill( TOOL_EVENT& aEvent )
         ZONE_CONTAINER* zone = selection.Item<ZONE_CONTAINER>( i );
         m_frame->Fill_Zone( zone );
         zone->SetIsFilled( true );
-        zone->ViewUpdate();
+        zone->ViewUpdate( KIGFX::VIEW_ITEM::GEOMETRY );     // layers are not changed
     }
 
     setTransitions();
@@ -189,7 +189,7 @@ int PCB_EDITOR_CONTROL::ZoneFillAll( TOOL_EVENT& aEvent )
         ZONE_CONTAINER* zone = board->GetArea( i );
         m_frame->Fill_Zone( zone );
         zone->SetIsFilled( true );
-        zone->ViewUpdate();
+        zone->ViewUpdate( KIGFX::VIEW_ITEM::GEOMETRY );     // layers are not changed
     }
 
     setTransitions();
@@ -261,6 +261,9 @@ bool SELECTION_TOOL::selectCursor( const VECTOR2I& aWhere, bool aAllowDisambigua
     GENERAL_COLLECTORS_GUIDE guide = m_frame->GetCollectorsGuide();
     GENERAL_COLLECTOR collector;
 
+    // Candidates are looked up in the VIEW spatial index
+    collector.SetView( getView() );
+
     // Preferred types (they have the priority when if they are covered by a bigger item)
     const KICAD_T types[] = { PCB_TRACE_T, PCB_VIA_T, PCB_LINE_T,
                               PCB_MODULE_EDGE_T, PCB_MODULE_TEXT_T, EOT };
@@ -856,6 +859,8 @@ void SELECTION_TOOL::highlightNet( const VECTOR2I& aPoint )
     GENERAL_COLLECTOR collector;
     int net = -1;
 
+    collector.SetView( getView() );
+
     // Find a connected item for which we are going to highlight a net
     collector.Collect( getModel<BOARD>(), GENERAL_COLLECTOR::PadsTracksOrZones,
                        wxPoint( aPoint.x, aPoint.y ), guide );
@@ -57,7 +57,10 @@
 bool ZONE_CONTAINER::BuildFilledSolidAreasPolygons( BOARD* aPcb, CPOLYGONS_LIST* aCornerBuffer )
 {
     if( aCornerBuffer == NULL )
+    {
         m_FilledPolysList.RemoveAllContours();
+        m_FilledPolysRevision++;
+    }
 
     /* convert outlines + holes to outlines without holes (adding extra segments if necessary)
      * m_Poly data is expected normalized, i.e. NormalizeAreaOutlines was used after building
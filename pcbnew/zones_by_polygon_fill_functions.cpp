@@ -31,8 +31,11 @@
 #include <fctsys.h>
 #include <pgm_base.h>
 #include <class_drawpanel.h>
+#include <class_draw_panel_gal.h>
+#include <gal/graphics_abstraction_layer.h>
 #include <wxPcbStruct.h>
 #include <macros.h>
+#include <profile_trace.h>
 
 #include <class_board.h>
 #include <class_track.h>
@@ -87,6 +90,8 @@ void PCB_EDIT_FRAME::Delete_OldZone_Fill( SEGZONE* aZone, time_t aTimestamp )
 
 int PCB_EDIT_FRAME::Fill_Zone( ZONE_CONTAINER* aZone )
 {
+    PROF_SCOPE( "PCB_EDIT_FRAME::Fill_Zone" );
+
     aZone->ClearFilledPolysList();
     aZone->UnFill();
 
@@ -122,6 +127,8 @@ int PCB_EDIT_FRAME::Fill_Zone( ZONE_CONTAINER* aZone )
 
 int PCB_EDIT_FRAME::Fill_All_Zones( wxWindow * aActiveWindow, bool aVerbose )
 {
+    PROF_SCOPE( "PCB_EDIT_FRAME::Fill_All_Zones" );
+
     int errorLevel = 0;
     int areaCount = GetBoard()->GetAreaCount();
     wxBusyCursor dummyCursor;
@@ -164,6 +171,10 @@ int PCB_EDIT_FRAME::Fill_All_Zones( wxWindow * aActiveWindow, bool aVerbose )
             break;
     }
 
+    // Prepare filled areas to be drawn by GAL, if it draws triangles faster than polygons
+    if( GetGalCanvas() && GetGalCanvas()->GetGAL()->IsTriangulationPreferred() )
+        GetBoard()->CacheAreasTriangulation();
+
     if( progressDialog )
         progressDialog->Update( ii+2, _( "Updating ratsnest..." ) );
     TestConnections();
@@ -48,6 +48,7 @@
 
 #include <fctsys.h>
 #include <polygons_defs.h>
+#include <profile_trace.h>
 #include <wxPcbStruct.h>
 #include <trigo.h>
 
@@ -469,6 +470,7 @@ void ZONE_CONTAINER::CopyPolygonsFromKiPolygonListToFilledPolysList( KI_POLYGON_
 {
     m_FilledPolysList.RemoveAllContours();
     m_FilledPolysList.ImportFrom( aKiPolyList );
+    m_FilledPolysRevision++;
 }
 
 
@@ -476,3 +478,116 @@ void ZONE_CONTAINER::CopyPolygonsFromFilledPolysListToKiPolygonList( KI_POLYGON_
 {
     m_FilledPolysList.ExportTo( aKiPolyList );
 }
+
+
+bool ZONE_CONTAINER::IsTriangulationUpToDate() const
+{
+    return m_FilledTrianglesRevision == m_FilledPolysRevision;
+}
+
+
+/* Splits aPolys into triangles, 3 consecutive corners per triangle.
+ */
+static void triangulateFilledPolys( const CPOLYGONS_LIST& aPolys,
+                                    std::vector<wxPoint>& aTriangles )
+{
+    aTriangles.clear();
+
+    if( aPolys.GetCornersCount() == 0 )
+        return;
+
+    KI_POLYGON_SET polygons;
+    aPolys.ExportTo( polygons );
+
+    /* Holes in filled areas are linked to their outlines by overlapping segments,
+     * which are not accepted by sweep line triangulators (like poly2tri).
+     * boost::polygon handles them as usual and splits the areas into trapezoids,
+     * that are convex, so they are easily split into triangles.
+     */
+    bpl::polygon_set_data<int> polygonSet;
+    polygonSet.insert( polygons.begin(), polygons.end() );
+
+    KI_POLYGON_SET trapezoids;
+    polygonSet.get_trapezoids( trapezoids );
+
+    aTriangles.reserve( trapezoids.size() * 6 );
+    std::vector<wxPoint> corners;
+
+    for( unsigned ii = 0; ii < trapezoids.size(); ii++ )
+    {
+        corners.clear();
+
+        for( KI_POLYGON::iterator_type it = trapezoids[ii].begin();
+             it != trapezoids[ii].end(); ++it )
+        {
+            corners.push_back( wxPoint( it->x(), it->y() ) );
+        }
+
+        for( unsigned jj = 1; jj + 1 < corners.size(); jj++ )
+        {
+            aTriangles.push_back( corners[0] );
+            aTriangles.push_back( corners[jj] );
+            aTriangles.push_back( corners[jj + 1] );
+        }
+    }
+}
+
+
+void ZONE_CONTAINER::CacheTriangulation() const
+{
+    if( IsTriangulationUpToDate() )
+        return;
+
+    PROF_SCOPE( "ZONE_CONTAINER::CacheTriangulation" );
+
+    triangulateFilledPolys( m_FilledPolysList, m_FilledTriangles );
+    m_FilledTrianglesRevision = m_FilledPolysRevision;
+}
+
+
+/**
+ * Class ZONE_TRIANGULATION_JOB
+ * triangulates a copy of the filled areas of a zone on a worker thread of the VIEW.
+ */
+class ZONE_TRIANGULATION_JOB : public KIGFX::VIEW_ITEM_JOB
+{
+public:
+    ZONE_TRIANGULATION_JOB( const ZONE_CONTAINER* aZone ) :
+        m_polys( aZone->m_FilledPolysList ),
+        m_revision( aZone->m_FilledPolysRevision )
+    {
+    }
+
+    void Run()
+    {
+        PROF_SCOPE( "ZONE_TRIANGULATION_JOB::Run" );
+
+        triangulateFilledPolys( m_polys, m_triangles );
+    }
+
+    void Finish( KIGFX::VIEW_ITEM* aItem )
+    {
+        ZONE_CONTAINER* zone = static_cast<ZONE_CONTAINER*>( aItem );
+
+        // The filled areas may have been changed without updating the view
+        if( zone->m_FilledPolysRevision != m_revision )
+            return;
+
+        zone->m_FilledTriangles.swap( m_triangles );
+        zone->m_FilledTrianglesRevision = m_revision;
+    }
+
+private:
+    CPOLYGONS_LIST          m_polys;
+    unsigned int            m_revision;
+    std::vector<wxPoint>    m_triangles;
+};
+
+
+KIGFX::VIEW_ITEM_JOB* ZONE_CONTAINER::CreateTriangulationJob() const
+{
+    if( IsTriangulationUpToDate() )
+        return NULL;
+
+    return new ZONE_TRIANGULATION_JOB( this );
+}
@@ -109,6 +109,7 @@ void ZONE_CONTAINER::TestForCopperIslandAndRemoveInsulatedIslands( BOARD* aPcb )
             else                             // Not connected: remove this polygon
             {
                 m_FilledPolysList.DeleteCorners( indexstart, indexend );
+                m_FilledPolysRevision++;
                 indexend = indexstart;   /* indexstart points the first point of the next polygon
                                           * because the current poly is removed */
             }
@@ -0,0 +1,238 @@
+/*
+ * This program source code file is part of KiCad, a free EDA CAD application.
+ *
+ * Copyright (C) 2014 KiCad Developers, see change_log.txt for contributors.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, you may find one here:
+ * http://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+ * or you may search the http://www.gnu.org website for the version 2 license,
+ * or you may write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+/**
+ * @file autorouter_bench.cpp
+ * @brief Routes a board with the autorouter, without a frame, and reports the run time
+ * and the memory used by the routing matrix, one item at a time and by batches.
+ *
+ * Usage: autorouter_bench <board.kicad_pcb> [grid_mils]
+ *
+ * The existing tracks of the board are removed and each net gets a minimum spanning tree
+ * of its pads as ratsnest, so every connection is routed.
+ */
+
+#include <cstdio>
+#include <cstdlib>
+#include <climits>
+#include <map>
+#include <vector>
+#include <algorithm>
+
+#include <wx/init.h>
+
+#include <profile.h>
+#include <io_mgr.h>
+#include <convert_to_biu.h>
+
+#include <class_board.h>
+#include <class_track.h>
+#include <pcbnew.h>
+#include <autorout.h>
+
+
+// Globals used by the autorouter sources, normally defined by pcbnew
+MATRIX_ROUTING_HEAD RoutingMatrix;
+LAYER_ID            g_Route_Layer_TOP;
+LAYER_ID            g_Route_Layer_BOTTOM;
+
+
+static BOARD* loadBoard( const char* aFileName )
+{
+    BOARD* board = NULL;
+
+    try
+    {
+        board = IO_MGR::Load( IO_MGR::KICAD, wxString::FromUTF8( aFileName ) );
+    }
+    catch( const IO_ERROR& ioe )
+    {
+        fprintf( stderr, "%s\n", (const char*) ioe.errorText.ToUTF8() );
+        return NULL;
+    }
+
+    board->BuildListOfNets();
+
+    return board;
+}
+
+
+/* Replaces the tracks of aBoard by a ratsnest flagged to be routed: for each net, the
+ * minimum spanning tree of its pads (manhattan distance).
+ */
+static void buildRatsnest( BOARD* aBoard )
+{
+    std::map< int, std::vector<D_PAD*> > nets;
+
+    aBoard->m_Track.DeleteAll();
+    aBoard->m_FullRatsnest.clear();
+
+    for( unsigned ii = 0; ii < aBoard->GetPadCount(); ii++ )
+    {
+        D_PAD* pad = aBoard->GetPad( ii );
+
+        if( pad->GetNetCode() > 0 )
+            nets[ pad->GetNetCode() ].push_back( pad );
+    }
+
+    for( std::map< int, std::vector<D_PAD*> >::iterator net = nets.begin();
+         net != nets.end(); ++net )
+    {
+        std::vector<D_PAD*>& pads = net->second;
+        std::vector<int>     best( pads.size(), INT_MAX );
+        std::vector<int>     from( pads.size(), 0 );
+        std::vector<bool>    done( pads.size(), false );
+        int                  current = 0;
+
+        for( unsigned count = 1; count < pads.size(); count++ )
+        {
+            int next = -1;
+
+            done[current] = true;
+
+            for( unsigned ii = 0; ii < pads.size(); ii++ )
+            {
+                if( done[ii] )
+                    continue;
+
+                wxPoint delta = pads[ii]->GetPosition() - pads[current]->GetPosition();
+                int     dist  = abs( delta.x ) + abs( delta.y );
+
+                if( dist < best[ii] )
+                {
+                    best[ii] = dist;
+                    from[ii] = current;
+                }
+
+                if( next < 0 || best[ii] < best[next] )
+                    next = ii;
+            }
+
+            RATSNEST_ITEM item;
+
+            item.SetNet( net->first );
+            item.m_Status   = CH_ACTIF | CH_ROUTE_REQ;
+            item.m_PadStart = pads[ from[next] ];
+            item.m_PadEnd   = pads[next];
+            item.m_Lenght   = best[next];
+            aBoard->m_FullRatsnest.push_back( item );
+
+            current = next;
+        }
+    }
+}
+
+
+/* Routes aBoard like PCB_EDIT_FRAME::Autoroute( ROUTE_ALL ) and prints the results.
+ */
+static void routeBoard( BOARD* aBoard, int aGrid, bool aConcurrent )
+{
+    if( aBoard->GetCopperLayerCount() > 1 )
+    {
+        g_Route_Layer_TOP    = F_Cu;
+        g_Route_Layer_BOTTOM = B_Cu;
+    }
+    else
+    {
+        g_Route_Layer_TOP = g_Route_Layer_BOTTOM = B_Cu;
+    }
+
+    prof_counter mapTime;
+    prof_start( &mapTime );
+
+    RoutingMatrix.m_GridRouting = aGrid;
+    RoutingMatrix.ComputeMatrixSize( aBoard );
+
+    RoutingMatrix.m_RoutingLayersCount = 1;
+
+    if( g_Route_Layer_TOP != g_Route_Layer_BOTTOM )
+        RoutingMatrix.m_RoutingLayersCount = 2;
+
+    RoutingMatrix.InitRoutingMatrix();
+    PlaceCells( aBoard, -1, FORCE_PADS );
+    RoutingMatrix.m_RouteCount = Build_Work( aBoard );
+
+    prof_end( &mapTime );
+
+    AR_SOLVER    solver( aBoard );
+    prof_counter routeTime;
+
+    prof_start( &routeTime );
+    solver.Solve( RoutingMatrix.m_RoutingLayersCount, aConcurrent );
+    prof_end( &routeTime );
+
+    // Size of the former dense matrix: a MATRIX_CELL, a DIST_CELL and a DIR_CELL per cell
+    double denseSize = (double) RoutingMatrix.m_Nrows * RoutingMatrix.m_Ncols
+                       * RoutingMatrix.m_RoutingLayersCount
+                       * ( sizeof( MATRIX_CELL ) + sizeof( DIST_CELL ) + sizeof( DIR_CELL ) );
+    int    peak = std::max( RoutingMatrix.m_MemPeak, solver.m_MemPeak );
+
+    printf( "%-8s map %8.2f ms  route %10.2f ms  items %5d  routed %5d  failed %5d"
+            "  retried %5d\n",
+            aConcurrent ? "batched" : "serial", mapTime.msecs(), routeTime.msecs(),
+            RoutingMatrix.m_RouteCount, solver.m_RoutedCount, solver.m_FailedCount,
+            solver.m_RetryCount );
+    printf( "%-8s matrix %d x %d x %d  peak %8d KB  dense %8.0f KB\n",
+            "", RoutingMatrix.m_Nrows, RoutingMatrix.m_Ncols,
+            RoutingMatrix.m_RoutingLayersCount, peak / 1024, denseSize / 1024 );
+
+    InitWork();
+    RoutingMatrix.UnInitRoutingMatrix();
+}
+
+
+int main( int argc, char** argv )
+{
+    if( argc < 2 )
+    {
+        fprintf( stderr, "usage: %s <board.kicad_pcb> [grid_mils]\n", argv[0] );
+        return 1;
+    }
+
+    wxInitializer initializer;
+
+    if( !initializer.IsOk() )
+    {
+        fprintf( stderr, "Failed to initialize wxWidgets\n" );
+        return 1;
+    }
+
+    // The autorouter does not route on a grid smaller than 5 mils
+    int grid = Mils2iu( std::max( argc > 2 ? atoi( argv[2] ) : 25, 5 ) );
+
+    // Each pass routes a freshly loaded board, so both route the same connections
+    for( int pass = 0; pass < 2; pass++ )
+    {
+        BOARD* board = loadBoard( argv[1] );
+
+        if( !board )
+            return 1;
+
+        buildRatsnest( board );
+        routeBoard( board, grid, pass == 1 );
+
+        delete board;
+    }
+
+    return 0;
+}
@@ -0,0 +1,273 @@
+/*
+ * This program source code file is part of KiCad, a free EDA CAD application.
+ *
+ * Copyright (C) 2014 KiCad Developers, see change_log.txt for contributors.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, you may find one here:
+ * http://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+ * or you may search the http://www.gnu.org website for the version 2 license,
+ * or you may write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+/**
+ * @file cached_container_test.cpp
+ * @brief Allocates, edits and frees random items in a CACHED_CONTAINER, then checks that
+ * no item lost its vertices or overlaps another one, and that the incremental compaction
+ * keeps the free space in one piece. Does not need an OpenGL context.
+ *
+ * Usage: cached_container_test [item_count] [rounds]
+ */
+
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+#include <algorithm>
+
+#include <wx/init.h>
+
+#include <gal/opengl/cached_container.h>
+#include <gal/opengl/vertex_manager.h>
+#include <gal/opengl/vertex_item.h>
+
+using namespace KIGFX;
+
+// Fragmentation that starts the compaction (CACHED_CONTAINER::COMPACTION_THRESHOLD)
+static const double MAX_FRAGMENTATION = 0.5;
+
+// Number of finished items allowed for the compaction to bring the fragmentation back down
+static const int SETTLE_ITEMS = 1000;
+
+
+struct TEST_ITEM
+{
+    VERTEX_ITEM*    item;
+    unsigned int    id;         ///< stored in every vertex of the item
+    unsigned int    size;       ///< expected number of vertices
+};
+
+
+/* Appends aCount vertices to aItem, a few at a time as the painters do, and marks them
+ * with the item id.
+ */
+static bool addVertices( CACHED_CONTAINER& aContainer, TEST_ITEM& aItem, unsigned int aCount )
+{
+    aContainer.SetItem( aItem.item );
+
+    while( aCount > 0 )
+    {
+        unsigned int count = std::min( aCount, 1u + rand() % 12 );
+        VERTEX*      vertices = aContainer.Allocate( count );
+
+        if( !vertices )
+            return false;
+
+        for( unsigned int i = 0; i < count; ++i )
+            vertices[i].x = aItem.id;
+
+        aCount -= count;
+        aItem.size += count;
+    }
+
+    aContainer.FinishItem();
+
+    return true;
+}
+
+
+static void removeItem( CACHED_CONTAINER& aContainer, TEST_ITEM& aItem )
+{
+    // A VERTEX_ITEM is also registered in the container of its manager. It is taken out of
+    // the tested container first, so the manager has no vertices to free for it.
+    aContainer.Delete( aItem.item );
+    delete aItem.item;
+    aItem.item = NULL;
+}
+
+
+static int checkItems( const CACHED_CONTAINER& aContainer, const std::vector<TEST_ITEM>& aItems )
+{
+    std::vector< std::pair<unsigned int, unsigned int> > chunks;
+    int errors = 0;
+
+    for( unsigned int i = 0; i < aItems.size(); ++i )
+    {
+        const TEST_ITEM& item = aItems[i];
+
+        if( !item.item )
+            continue;
+
+        if( item.item->GetSize() != item.size )
+        {
+            printf( "item %u: %u vertices instead of %u\n", item.id, item.item->GetSize(),
+                    item.size );
+            errors++;
+            continue;
+        }
+
+        const VERTEX* vertices = aContainer.GetVertices( item.item );
+
+        for( unsigned int v = 0; v < item.size; ++v )
+        {
+            if( vertices[v].x != item.id )
+            {
+                printf( "item %u: vertex %u was overwritten\n", item.id, v );
+                errors++;
+                break;
+            }
+        }
+
+        chunks.push_back( std::make_pair( item.item->GetOffset(), item.size ) );
+    }
+
+    std::sort( chunks.begin(), chunks.end() );
+
+    for( unsigned int i = 0; i < chunks.size(); ++i )
+    {
+        unsigned int end = chunks[i].first + chunks[i].second;
+
+        if( end > aContainer.GetSize() || ( i + 1 < chunks.size() && end > chunks[i + 1].first ) )
+        {
+            printf( "item at offset %u (size %u) overlaps its neighbour or the end\n",
+                    chunks[i].first, chunks[i].second );
+            errors++;
+        }
+    }
+
+    return errors;
+}
+
+
+int main( int argc, char** argv )
+{
+    wxInitializer initializer;
+
+    if( !initializer.IsOk() )
+    {
+        fprintf( stderr, "Failed to initialize wxWidgets\n" );
+        return 1;
+    }
+
+    int itemCount = argc > 1 ? atoi( argv[1] ) : 20000;
+    int rounds    = argc > 2 ? atoi( argv[2] ) : 20;
+    int errors    = 0;
+    unsigned int nextId = 1;
+
+    VERTEX_MANAGER          manager( true );
+    CACHED_CONTAINER        container;
+    std::vector<TEST_ITEM>  items( itemCount );
+
+    srand( 1 );
+
+    for( int i = 0; i < itemCount; ++i )
+    {
+        TEST_ITEM item = { new VERTEX_ITEM( manager ), nextId++, 0 };
+        items[i] = item;
+
+        if( !addVertices( container, items[i], 3 * ( 1 + rand() % 100 ) ) )
+        {
+            printf( "allocation failed\n" );
+            return 1;
+        }
+    }
+
+    errors += checkItems( container, items );
+
+    for( int round = 0; round < rounds; ++round )
+    {
+        // Free a part of the items, grow some others and add new ones in the holes
+        for( int i = 0; i < itemCount; ++i )
+        {
+            int action = rand() % 10;
+
+            if( action < 3 )
+            {
+                removeItem( container, items[i] );
+
+                TEST_ITEM item = { new VERTEX_ITEM( manager ), nextId++, 0 };
+                items[i] = item;
+
+                if( !addVertices( container, items[i], 3 * ( 1 + rand() % 100 ) ) )
+                {
+                    printf( "allocation failed\n" );
+                    return 1;
+                }
+            }
+            else if( action == 3 )
+            {
+                if( !addVertices( container, items[i], 3 * ( 1 + rand() % 20 ) ) )
+                {
+                    printf( "allocation failed\n" );
+                    return 1;
+                }
+            }
+        }
+
+        errors += checkItems( container, items );
+
+        const CACHED_CONTAINER::ALLOCATOR_STATS& stats = container.GetStats();
+
+        printf( "round %2d: size %8u  fragmentation %.3f  reallocations %7u  resizes %3u"
+                "  defragmentations %3u  compacted %7u items %9u vertices\n",
+                round, container.GetSize(), container.GetFragmentation(), stats.reallocations,
+                stats.resizes, stats.defragmentations, stats.compactedItems,
+                stats.compactedVertices );
+    }
+
+    // Free half of the items at random, which leaves the free space scattered
+    for( int i = 0; i < itemCount; ++i )
+    {
+        if( rand() % 2 )
+            removeItem( container, items[i] );
+    }
+
+    // Each finished item does a step of compaction, until the free space is merged again
+    std::vector<TEST_ITEM> extra;
+    extra.reserve( SETTLE_ITEMS );
+
+    for( int i = 0; i < SETTLE_ITEMS && container.GetFragmentation() > MAX_FRAGMENTATION; ++i )
+    {
+        TEST_ITEM item = { new VERTEX_ITEM( manager ), nextId++, 0 };
+        extra.push_back( item );
+        addVertices( container, extra.back(), 3 );
+    }
+
+    items.insert( items.end(), extra.begin(), extra.end() );
+    errors += checkItems( container, items );
+
+    printf( "final:    size %8u  fragmentation %.3f after %d items\n",
+            container.GetSize(), container.GetFragmentation(), (int) extra.size() );
+
+    if( container.GetFragmentation() > MAX_FRAGMENTATION )
+    {
+        printf( "the free space was not compacted\n" );
+        errors++;
+    }
+
+    if( container.GetStats().compactedItems == 0 )
+    {
+        printf( "the compaction was never used\n" );
+        errors++;
+    }
+
+    for( unsigned int i = 0; i < items.size(); ++i )
+    {
+        if( items[i].item )
+            removeItem( container, items[i] );
+    }
+
+    printf( "%d errors\n", errors );
+
+    return errors ? 1 : 0;
+}
@@ -0,0 +1,226 @@
+/*
+ * This program source code file is part of KiCad, a free EDA CAD application.
+ *
+ * Copyright (C) 2014 KiCad Developers, see change_log.txt for contributors.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, you may find one here:
+ * http://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+ * or you may search the http://www.gnu.org website for the version 2 license,
+ * or you may write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+/**
+ * @file render_bench.cpp
+ * @brief Measures VIEW + PCB_PAINTER frame times for a board, rendered offscreen with Cairo.
+ *
+ * Usage: render_bench <board.kicad_pcb> [frames] [output.png]
+ */
+
+#include <cstdio>
+#include <cstdlib>
+#include <cmath>
+#include <vector>
+#include <algorithm>
+
+#include <wx/init.h>
+
+#include <profile.h>
+#include <view/view.h>
+#include <gal/cairo/cairo_gal.h>
+#include <pcb_painter.h>
+#include <io_mgr.h>
+
+#include <class_board.h>
+
+using namespace KIGFX;
+
+static const int SCREEN_WIDTH   = 1600;
+static const int SCREEN_HEIGHT  = 1200;
+
+
+/**
+ * Structure BENCH_STATS
+ * accumulates frame times of a single benchmark pass.
+ */
+struct BENCH_STATS
+{
+    BENCH_STATS() : frames( 0 ), total( 0.0 ), min( 1e9 ), max( 0.0 ) {}
+
+    void Add( double aTime )
+    {
+        frames++;
+        total += aTime;
+        min = std::min( min, aTime );
+        max = std::max( max, aTime );
+    }
+
+    void Print( const char* aName ) const
+    {
+        if( frames == 0 )
+            return;
+
+        printf( "%-8s %5d frames  avg %8.2f ms  min %8.2f ms  max %8.2f ms\n",
+                aName, frames, total / frames, min, max );
+    }
+
+    int     frames;
+    double  total;
+    double  min;
+    double  max;
+};
+
+
+static double renderFrame( VIEW& aView, GAL& aGal, PAINTER& aPainter )
+{
+    prof_counter frameTime;
+    prof_start( &frameTime );
+
+    aView.UpdateItems();
+    aGal.BeginDrawing();
+    aGal.ClearScreen( aPainter.GetSettings()->GetBackgroundColor() );
+    aView.ClearTargets();
+    aView.Redraw();
+    aGal.EndDrawing();
+
+    prof_end( &frameTime );
+
+    return frameTime.msecs();
+}
+
+
+static void zoomToBoard( VIEW& aView, GAL& aGal, BOARD* aBoard )
+{
+    aBoard->ComputeBoundingBox();
+    BOX2I boardBBox = aBoard->ViewBBox();
+
+    if( boardBBox.GetWidth() == 0 || boardBBox.GetHeight() == 0 )
+        return;
+
+    double iuPerX = (double) boardBBox.GetWidth() / SCREEN_WIDTH;
+    double iuPerY = (double) boardBBox.GetHeight() / SCREEN_HEIGHT;
+    double zoomFactor = aGal.GetWorldScale() / aGal.GetZoomFactor();
+
+    aView.SetScale( 1.0 / ( zoomFactor * std::max( iuPerX, iuPerY ) ) );
+    aView.SetCenter( boardBBox.Centre() );
+}
+
+
+int main( int argc, char** argv )
+{
+    if( argc < 2 )
+    {
+        fprintf( stderr, "usage: %s <board.kicad_pcb> [frames] [output.png]\n", argv[0] );
+        return 1;
+    }
+
+    wxInitializer initializer;
+
+    if( !initializer.IsOk() )
+    {
+        fprintf( stderr, "Failed to initialize wxWidgets\n" );
+        return 1;
+    }
+
+    int frames = argc > 2 ? std::max( atoi( argv[2] ), 1 ) : 20;
+
+    BOARD* board = NULL;
+
+    try
+    {
+        prof_counter loadTime;
+        prof_start( &loadTime );
+
+        board = IO_MGR::Load( IO_MGR::KICAD, wxString::FromUTF8( argv[1] ) );
+
+        prof_end( &loadTime );
+        printf( "load     %8.2f ms\n", loadTime.msecs() );
+    }
+    catch( const IO_ERROR& ioe )
+    {
+        fprintf( stderr, "%s\n", (const char*) ioe.errorText.ToUTF8() );
+        return 1;
+    }
+
+    CAIRO_OFFSCREEN_GAL gal( SCREEN_WIDTH, SCREEN_HEIGHT );
+    PCB_PAINTER         painter( &gal );
+    VIEW                view( true );
+
+    view.SetPainter( &painter );
+    view.SetGAL( &gal );
+    painter.GetSettings()->ImportLegacyColors( board->GetColorsSettings() );
+
+    std::vector<VIEW_ITEM*> items;
+    board->GetViewItems( items );
+
+    prof_counter addTime;
+    prof_start( &addTime );
+    view.AddItems( items );
+    prof_end( &addTime );
+    printf( "add      %8.2f ms (%d items)\n", addTime.msecs(), (int) items.size() );
+
+    zoomToBoard( view, gal, board );
+
+    // The first frame caches items, so it is reported separately
+    printf( "first    %8.2f ms\n", renderFrame( view, gal, painter ) );
+
+    BENCH_STATS redraw, pan, zoom;
+
+    for( int i = 0; i < frames; ++i )
+    {
+        view.MarkTargetDirty( TARGET_CACHED );
+        redraw.Add( renderFrame( view, gal, painter ) );
+    }
+
+    // Pan back and forth by a tenth of the screen width
+    VECTOR2D center = view.GetCenter();
+    VECTOR2D step   = view.ToWorld( VECTOR2D( SCREEN_WIDTH / 10, 0 ), false );
+
+    for( int i = 0; i < frames; ++i )
+    {
+        view.SetCenter( center + step * (double) ( ( i % 10 ) - 5 ) );
+        pan.Add( renderFrame( view, gal, painter ) );
+    }
+
+    view.SetCenter( center );
+
+    // Zoom in up to 8 levels, then back out
+    double scale = view.GetScale();
+
+    for( int i = 0; i < frames; ++i )
+    {
+        int level = i % 16 < 8 ? i % 16 : 16 - i % 16;
+        view.SetScale( scale * pow( 1.3, level ) );
+        zoom.Add( renderFrame( view, gal, painter ) );
+    }
+
+    redraw.Print( "redraw" );
+    pan.Print( "pan" );
+    zoom.Print( "zoom" );
+
+    if( argc > 3 )
+    {
+        view.SetScale( scale );
+        view.SetCenter( center );
+        renderFrame( view, gal, painter );
+
+        if( !gal.SaveImage( argv[3] ) )
+            fprintf( stderr, "Failed to write %s\n", argv[3] );
+    }
+
+    view.Clear();
+    delete board;
+
+    return 0;
+}
@@ -0,0 +1,181 @@
+/*
+ * This program source code file is part of KiCad, a free EDA CAD application.
+ *
+ * Copyright (C) 2014 KiCad Developers, see change_log.txt for contributors.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, you may find one here:
+ * http://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+ * or you may search the http://www.gnu.org website for the version 2 license,
+ * or you may write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+/**
+ * @file seg_batch_test.cpp
+ * @brief Checks SEG_BATCH against SHAPE_LINE_CHAIN::Collide() and SHAPE_CIRCLE::Collide()
+ * on random line chains, and compares their run times.
+ *
+ * Usage: seg_batch_test [chain_count]
+ */
+
+#include <cstdio>
+#include <cstdlib>
+
+#include <profile.h>
+
+#include <geometry/seg_batch.h>
+#include <geometry/shape_line_chain.h>
+#include <geometry/shape_circle.h>
+
+
+// Coordinates stay within +/- RANGE, so squared distances do not overflow 64 bits
+#define RANGE       1000000
+#define QUERIES     200
+
+
+static int randomCoord( int aRange )
+{
+    return rand() % ( 2 * aRange + 1 ) - aRange;
+}
+
+
+static const VECTOR2I randomPoint( int aRange )
+{
+    return VECTOR2I( randomCoord( aRange ), randomCoord( aRange ) );
+}
+
+
+/* A random walk with steps of all directions, including null and axis-parallel ones
+ * which give degenerate bounding boxes.
+ */
+static const SHAPE_LINE_CHAIN randomChain( int aPointCount )
+{
+    SHAPE_LINE_CHAIN chain;
+    VECTOR2I         p = randomPoint( RANGE / 2 );
+
+    chain.Append( p );
+
+    for( int i = 1; i < aPointCount; i++ )
+    {
+        VECTOR2I step = randomPoint( RANGE / 20 );
+
+        switch( rand() % 4 )
+        {
+        case 0: step.x = 0; break;
+        case 1: step.y = 0; break;
+        default: break;
+        }
+
+        p += step;
+        chain.Append( p );
+    }
+
+    return chain;
+}
+
+
+int main( int argc, char** argv )
+{
+    int chainCount = argc > 1 ? atoi( argv[1] ) : 1000;
+    int errors = 0;
+    int hits = 0;
+    uint64_t chainTime = 0;
+    uint64_t batchTime = 0;
+
+    srand( 1 );
+
+    for( int n = 0; n < chainCount; n++ )
+    {
+        const SHAPE_LINE_CHAIN chain = randomChain( 2 + rand() % 300 );
+        const SEG_BATCH        batch( chain );
+        SEG                    segs[QUERIES];
+        int                    clearances[QUERIES];
+        bool                   expected[QUERIES];
+        int                    found[QUERIES];
+
+        if( batch.Size() != chain.SegmentCount() )
+        {
+            printf( "chain %d: batch holds %d segments instead of %d\n", n, batch.Size(),
+                    chain.SegmentCount() );
+            return 1;
+        }
+
+        for( int q = 0; q < QUERIES; q++ )
+        {
+            segs[q] = SEG( randomPoint( RANGE ), randomPoint( RANGE / 10 ) );
+            segs[q].B += segs[q].A;
+            clearances[q] = rand() % ( RANGE / 50 );
+        }
+
+        prof_counter cnt;
+
+        prof_start( &cnt );
+
+        for( int q = 0; q < QUERIES; q++ )
+            expected[q] = chain.Collide( segs[q], clearances[q] );
+
+        prof_end( &cnt );
+        chainTime += cnt.usecs();
+
+        prof_start( &cnt );
+
+        for( int q = 0; q < QUERIES; q++ )
+            found[q] = batch.Collide( segs[q], clearances[q] );
+
+        prof_end( &cnt );
+        batchTime += cnt.usecs();
+
+        for( int q = 0; q < QUERIES; q++ )
+        {
+            if( expected[q] != ( found[q] >= 0 ) ||
+                ( found[q] >= 0 && !chain.CSegment( found[q] ).Collide( segs[q],
+                                                                         clearances[q] ) ) )
+            {
+                printf( "chain %d, segment query %d: batch %d, line chain %d\n", n, q,
+                        found[q], expected[q] );
+                errors++;
+            }
+
+            hits += expected[q];
+
+            // the same query as a circle, checked against each segment of the chain
+            const SHAPE_CIRCLE circle( segs[q].A, clearances[q] );
+            int clearance = rand() % ( RANGE / 50 );
+            int first = -1;
+
+            for( int s = 0; s < chain.SegmentCount() && first < 0; s++ )
+            {
+                if( circle.Collide( chain.CSegment( s ), clearance ) )
+                    first = s;
+            }
+
+            int circleHit = batch.CollideCircle( circle.GetCenter(),
+                                                 circle.GetRadius() + clearance );
+
+            if( circleHit != first )
+            {
+                printf( "chain %d, circle query %d: batch %d, circle %d\n", n, q, circleHit,
+                        first );
+                errors++;
+            }
+        }
+    }
+
+    printf( "%d chains, %d queries, %d hits, %d errors\n", chainCount, chainCount * QUERIES,
+            hits, errors );
+    printf( "SHAPE_LINE_CHAIN::Collide %.2f ms, SEG_BATCH::Collide %.2f ms\n",
+            chainTime / 1000.0, batchTime / 1000.0 );
+
+    return errors ? 1 : 0;
+}
@@ -0,0 +1,252 @@
+/*
+ * This program source code file is part of KiCad, a free EDA CAD application.
+ *
+ * Copyright (C) 2014 KiCad Developers, see change_log.txt for contributors.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, you may find one here:
+ * http://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+ * or you may search the http://www.gnu.org website for the version 2 license,
+ * or you may write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+/**
+ * @file xstream_bench.cpp
+ * @brief Compares runtime and peak memory of writing a large generic netlist through an
+ * XNODE tree and through XSTREAM.
+ *
+ * Usage: xstream_bench <sexpr|xml> <tree|stream> <output file> [components]
+ *
+ * Run each mode in its own process, so the reported peak memory belongs to that mode only.
+ * Both modes must produce identical files, which can be checked with cmp.
+ */
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <algorithm>
+
+#include <sys/resource.h>
+
+#include <wx/init.h>
+
+#include <profile.h>
+#include <xnode.h>
+#include <xstream.h>
+
+static const int PINS_PER_COMPONENT = 16;
+
+
+static XNODE* node( const wxString& aName, const wxString& aTextualContent = wxEmptyString )
+{
+    XNODE* n = new XNODE( wxXML_ELEMENT_NODE, aName );
+
+    if( aTextualContent.Len() > 0 )
+        n->AddChild( new XNODE( wxXML_TEXT_NODE, wxEmptyString, aTextualContent ) );
+
+    return n;
+}
+
+
+static wxString reference( int aIndex )
+{
+    return wxString::Format( wxT( "U%d" ), aIndex + 1 );
+}
+
+
+/// Builds a document shaped like the generic netlist export, nets connect pins of 4 components
+static XNODE* buildTree( int aComponents )
+{
+    XNODE* xroot = node( wxT( "export" ) );
+    xroot->AddAttribute( wxT( "version" ), wxT( "D" ) );
+
+    XNODE* xcomps = node( wxT( "components" ) );
+    xroot->AddChild( xcomps );
+
+    for( int i = 0; i < aComponents; ++i )
+    {
+        XNODE* xcomp = node( wxT( "comp" ) );
+        xcomps->AddChild( xcomp );
+        xcomp->AddAttribute( wxT( "ref" ), reference( i ) );
+        xcomp->AddChild( node( wxT( "value" ), wxT( "74LS00 <quad & \"nand\">" ) ) );
+        xcomp->AddChild( node( wxT( "footprint" ), wxT( "Housings_DIP:DIP-14_W7.62mm" ) ) );
+
+        XNODE* xlibsource = node( wxT( "libsource" ) );
+        xcomp->AddChild( xlibsource );
+        xlibsource->AddAttribute( wxT( "lib" ), wxT( "74xx" ) );
+        xlibsource->AddAttribute( wxT( "part" ), wxT( "74LS00" ) );
+
+        XNODE* xsheetpath = node( wxT( "sheetpath" ) );
+        xcomp->AddChild( xsheetpath );
+        xsheetpath->AddAttribute( wxT( "names" ), wxT( "/" ) );
+        xsheetpath->AddAttribute( wxT( "tstamps" ), wxT( "/" ) );
+
+        xcomp->AddChild( node( wxT( "tstamp" ), wxString::Format( wxT( "%8.8X" ), i ) ) );
+    }
+
+    XNODE* xnets = node( wxT( "nets" ) );
+    xroot->AddChild( xnets );
+
+    for( int net = 0; net < aComponents * PINS_PER_COMPONENT / 4; ++net )
+    {
+        XNODE* xnet = node( wxT( "net" ) );
+        xnets->AddChild( xnet );
+        xnet->AddAttribute( wxT( "code" ), wxString::Format( wxT( "%d" ), net + 1 ) );
+        xnet->AddAttribute( wxT( "name" ), wxString::Format( wxT( "/Net-(U%d-Pad1)" ), net ) );
+
+        for( int i = 0; i < 4; ++i )
+        {
+            XNODE* xnode = node( wxT( "node" ) );
+            xnet->AddChild( xnode );
+            xnode->AddAttribute( wxT( "ref" ), reference( ( net * 4 + i ) % aComponents ) );
+            xnode->AddAttribute( wxT( "pin" ), wxString::Format( wxT( "%d" ), net % 14 + 1 ) );
+        }
+    }
+
+    return xroot;
+}
+
+
+/// Writes the same document as buildTree() without building it
+static void writeStream( XSTREAM& aOut, int aComponents )
+{
+    aOut.StartElement( wxT( "export" ) );
+    aOut.AddAttribute( wxT( "version" ), wxT( "D" ) );
+
+    aOut.StartElement( wxT( "components" ) );
+
+    for( int i = 0; i < aComponents; ++i )
+    {
+        aOut.StartElement( wxT( "comp" ) );
+        aOut.AddAttribute( wxT( "ref" ), reference( i ) );
+        aOut.AddElement( wxT( "value" ), wxT( "74LS00 <quad & \"nand\">" ) );
+        aOut.AddElement( wxT( "footprint" ), wxT( "Housings_DIP:DIP-14_W7.62mm" ) );
+
+        aOut.StartElement( wxT( "libsource" ) );
+        aOut.AddAttribute( wxT( "lib" ), wxT( "74xx" ) );
+        aOut.AddAttribute( wxT( "part" ), wxT( "74LS00" ) );
+        aOut.EndElement();
+
+        aOut.StartElement( wxT( "sheetpath" ) );
+        aOut.AddAttribute( wxT( "names" ), wxT( "/" ) );
+        aOut.AddAttribute( wxT( "tstamps" ), wxT( "/" ) );
+        aOut.EndElement();
+
+        aOut.AddElement( wxT( "tstamp" ), wxString::Format( wxT( "%8.8X" ), i ) );
+        aOut.EndElement();
+    }
+
+    aOut.EndElement();
+
+    aOut.StartElement( wxT( "nets" ) );
+
+    for( int net = 0; net < aComponents * PINS_PER_COMPONENT / 4; ++net )
+    {
+        aOut.StartElement( wxT( "net" ) );
+        aOut.AddAttribute( wxT( "code" ), wxString::Format( wxT( "%d" ), net + 1 ) );
+        aOut.AddAttribute( wxT( "name" ), wxString::Format( wxT( "/Net-(U%d-Pad1)" ), net ) );
+
+        for( int i = 0; i < 4; ++i )
+        {
+            aOut.StartElement( wxT( "node" ) );
+            aOut.AddAttribute( wxT( "ref" ), reference( ( net * 4 + i ) % aComponents ) );
+            aOut.AddAttribute( wxT( "pin" ), wxString::Format( wxT( "%d" ), net % 14 + 1 ) );
+            aOut.EndElement();
+        }
+
+        aOut.EndElement();
+    }
+
+    aOut.EndElement();
+
+    aOut.EndElement();
+}
+
+
+int main( int argc, char** argv )
+{
+    if( argc < 4 || ( strcmp( argv[1], "sexpr" ) && strcmp( argv[1], "xml" ) )
+                 || ( strcmp( argv[2], "tree" ) && strcmp( argv[2], "stream" ) ) )
+    {
+        fprintf( stderr, "usage: %s <sexpr|xml> <tree|stream> <output file> [components]\n",
+                 argv[0] );
+        return 1;
+    }
+
+    wxInitializer initializer;
+
+    if( !initializer.IsOk() )
+    {
+        fprintf( stderr, "Failed to initialize wxWidgets\n" );
+        return 1;
+    }
+
+    bool        xml = !strcmp( argv[1], "xml" );
+    bool        tree = !strcmp( argv[2], "tree" );
+    wxString    fileName = wxString::FromUTF8( argv[3] );
+    int         components = argc > 4 ? std::max( atoi( argv[4] ), 1 ) : 100000;
+
+    prof_counter writeTime;
+    prof_start( &writeTime );
+
+    try
+    {
+        if( tree && xml )
+        {
+            wxXmlDocument xdoc;
+
+            xdoc.SetRoot( buildTree( components ) );
+
+            if( !xdoc.Save( fileName, 2 ) )
+                THROW_IO_ERROR( wxT( "Failed to save the XML document" ) );
+        }
+        else if( tree )
+        {
+            std::auto_ptr<XNODE>    xroot( buildTree( components ) );
+            FILE_OUTPUTFORMATTER    formatter( fileName );
+
+            xroot->Format( &formatter, 0 );
+        }
+        else if( xml )
+        {
+            FILE_OUTPUTFORMATTER    formatter( fileName, wxT( "wb" ) );
+            XSTREAM_XML             out( &formatter, 2 );
+
+            writeStream( out, components );
+        }
+        else
+        {
+            FILE_OUTPUTFORMATTER    formatter( fileName );
+            XSTREAM_SEXPR           out( &formatter );
+
+            writeStream( out, components );
+        }
+    }
+    catch( const IO_ERROR& ioe )
+    {
+        fprintf( stderr, "%s\n", (const char*) ioe.errorText.ToUTF8() );
+        return 1;
+    }
+
+    prof_end( &writeTime );
+
+    struct rusage usage;
+    getrusage( RUSAGE_SELF, &usage );
+
+    printf( "%-6s %-6s %8d components  %10.2f ms  peak %8ld kB\n", argv[1], argv[2],
+            components, writeTime.msecs(), (long) usage.ru_maxrss );
+
+    return 0;
+}